@@ -13,6 +13,11 @@
 #include <device.h>
 #include <drivers/sensor.h>
 
+#if CONFIG_DESKTOP_MOTION_SENSOR_SYNC_CONN_EVENT
+  #include <bluetooth/hci.h>
+  #include "sdc_hci_vs.h"
+#endif
+
 #include "motion_sensor.h"
 
 #include "event_manager.h"
@@ -36,6 +41,23 @@ LOG_MODULE_REGISTER(MODULE, CONFIG_DESKTOP_MOTION_LOG_LEVEL);
 
 #define MAX_KEY_LEN 20
 
+#ifdef CONFIG_DESKTOP_MOTION_SENSOR_SYNC_CONN_EVENT
+  #define SYNC_OFFSET_US CONFIG_DESKTOP_MOTION_SENSOR_SYNC_CONN_EVENT_OFFSET_US
+#else
+  #define SYNC_OFFSET_US 0
+#endif
+
+#ifdef CONFIG_DESKTOP_MOTION_SENSOR_LATENCY_STATS
+  #define STATS_LOG_PERIOD K_MSEC(CONFIG_DESKTOP_MOTION_SENSOR_LATENCY_STATS_PERIOD)
+#else
+  #define STATS_LOG_PERIOD K_NO_WAIT
+#endif
+
+/* Synchronization is lost if no connection event was reported for
+ * the given number of connection intervals.
+ */
+#define SYNC_LOST_INTERVALS	3
+
 enum state {
 	STATE_DISABLED,
 	STATE_DISABLED_SUSPENDED,
@@ -66,6 +88,28 @@ enum sensor_opt {
 	SENSOR_OPT_COUNT
 };
 
+struct conn_event_sync {
+	struct k_timer sample_timer;
+	uint32_t timestamp;
+	uint32_t interval;
+	uint16_t event_counter;
+	uint16_t conn_handle;
+	bool tracking;
+};
+
+struct latency_stats {
+	struct k_delayed_work log;
+	uint32_t sample_timestamp;
+	uint32_t sent_timestamp;
+	bool sample_pending;
+	bool sent_pending;
+
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint64_t sum;
+};
+
 static K_SEM_DEFINE(sem, 1, 1);
 static K_THREAD_STACK_DEFINE(thread_stack, THREAD_STACK_SIZE);
 static struct k_thread thread;
@@ -73,6 +117,8 @@ static struct k_thread thread;
 static const struct device *sensor_dev;
 
 static struct sensor_state state;
+static struct conn_event_sync sync;
+static struct latency_stats stats;
 
 static const char * const opt_descr[] = {
 	[SENSOR_OPT_VARIANT] = OPT_DESCR_MODULE_VARIANT,
@@ -219,13 +265,218 @@ static void data_ready_handler(const struct device *dev, struct sensor_trigger *
 	k_spin_unlock(&state.lock, key);
 }
 
+static void latency_sample_taken(uint32_t timestamp)
+{
+	k_spinlock_key_t key = k_spin_lock(&state.lock);
+
+	/* Track the oldest sample that is not yet part of a HID report. */
+	if (!stats.sample_pending) {
+		stats.sample_timestamp = timestamp;
+		stats.sample_pending = true;
+	}
+
+	k_spin_unlock(&state.lock, key);
+}
+
+static void latency_report_submitted(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&state.lock);
+
+	/* HID report contains all the samples taken so far. */
+	if (!stats.sent_pending && stats.sample_pending) {
+		stats.sent_timestamp = stats.sample_timestamp;
+		stats.sent_pending = true;
+		stats.sample_pending = false;
+	}
+
+	k_spin_unlock(&state.lock, key);
+}
+
+static void latency_report_sent(bool error)
+{
+	uint32_t latency = 0;
+	bool valid;
+
+	k_spinlock_key_t key = k_spin_lock(&state.lock);
+
+	valid = stats.sent_pending && !error;
+	if (valid) {
+		latency = k_cyc_to_us_floor32(k_cycle_get_32() -
+					      stats.sent_timestamp);
+	}
+	stats.sent_pending = false;
+
+	k_spin_unlock(&state.lock, key);
+
+	if (!valid) {
+		return;
+	}
+
+	if ((stats.count == 0) || (latency < stats.min)) {
+		stats.min = latency;
+	}
+	stats.max = MAX(stats.max, latency);
+	stats.sum += latency;
+	stats.count++;
+}
+
+static void latency_log_fn(struct k_work *work)
+{
+	if (stats.count > 0) {
+		LOG_INF("Sample to air latency [us] min %" PRIu32 " avg %"
+			PRIu32 " max %" PRIu32 " (%" PRIu32 " reports)",
+			stats.min, (uint32_t)(stats.sum / stats.count),
+			stats.max, stats.count);
+	}
+
+	stats.count = 0;
+	stats.min = 0;
+	stats.max = 0;
+	stats.sum = 0;
+
+	k_delayed_work_submit(&stats.log, STATS_LOG_PERIOD);
+}
+
+static void sync_sample_timer_handler(struct k_timer *timer)
+{
+	k_spinlock_key_t key = k_spin_lock(&state.lock);
+
+	if (state.state == STATE_FETCHING) {
+		state.sample = true;
+		k_sem_give(&sem);
+	}
+
+	k_spin_unlock(&state.lock, key);
+}
+
+static bool is_sync_active(uint32_t timestamp)
+{
+	/* Must be called with state lock held. */
+	return (sync.interval > 0) &&
+	       ((timestamp - sync.timestamp) <
+		(SYNC_LOST_INTERVALS * sync.interval));
+}
+
+#if CONFIG_DESKTOP_MOTION_SENSOR_SYNC_CONN_EVENT
+static void sync_conn_event_done(uint16_t conn_handle, uint16_t event_counter)
+{
+	uint32_t timestamp = k_cycle_get_32();
+	uint32_t delay = 0;
+
+	k_spinlock_key_t key = k_spin_lock(&state.lock);
+
+	bool active = is_sync_active(timestamp);
+	uint16_t events = event_counter - sync.event_counter;
+
+	if (active && (conn_handle != sync.conn_handle)) {
+		/* Only one connection is followed. */
+		k_spin_unlock(&state.lock, key);
+		return;
+	}
+
+	if (sync.tracking && (sync.conn_handle == conn_handle) &&
+	    (events > 0) && (events <= SYNC_LOST_INTERVALS)) {
+		uint32_t interval = (timestamp - sync.timestamp) / events;
+
+		/* Filter out the jitter of the event reporting. */
+		if (sync.interval == 0) {
+			sync.interval = interval;
+		} else {
+			sync.interval = (7 * sync.interval + interval + 4) / 8;
+		}
+	} else {
+		sync.interval = 0;
+	}
+
+	sync.tracking = true;
+	sync.conn_handle = conn_handle;
+	sync.event_counter = event_counter;
+	sync.timestamp = timestamp;
+
+	if (sync.interval > 0) {
+		uint32_t offset = k_us_to_cyc_ceil32(SYNC_OFFSET_US);
+
+		if (sync.interval > offset) {
+			delay = sync.interval - offset;
+		}
+	}
+
+	k_spin_unlock(&state.lock, key);
+
+	if (delay > 0) {
+		/* Sample before the next connection event. */
+		k_timer_start(&sync.sample_timer,
+			      K_USEC(k_cyc_to_us_floor32(delay)), K_NO_WAIT);
+	}
+}
+
+static bool on_vs_evt(struct net_buf_simple *buf)
+{
+	uint8_t *subevent_code;
+	sdc_hci_subevent_vs_qos_conn_event_report_t *evt;
+
+	subevent_code = net_buf_simple_pull_mem(buf, sizeof(*subevent_code));
+
+	if (*subevent_code != SDC_HCI_SUBEVENT_VS_QOS_CONN_EVENT_REPORT) {
+		return false;
+	}
+
+	evt = (void *)buf->data;
+	sync_conn_event_done(evt->conn_handle, evt->event_counter);
+
+	return true;
+}
+
+static void sync_enable(void)
+{
+	sdc_hci_cmd_vs_qos_conn_event_report_enable_t *cmd_enable;
+	struct net_buf *buf;
+
+	int err = bt_hci_register_vnd_evt_cb(on_vs_evt);
+
+	if (err) {
+		LOG_ERR("Failed to register HCI VS callback (err:%d)", err);
+		return;
+	}
+
+	buf = bt_hci_cmd_create(SDC_HCI_OPCODE_CMD_VS_QOS_CONN_EVENT_REPORT_ENABLE,
+				sizeof(*cmd_enable));
+	if (!buf) {
+		LOG_ERR("Failed to create HCI command");
+		return;
+	}
+
+	cmd_enable = net_buf_add(buf, sizeof(*cmd_enable));
+	cmd_enable->enable = 1;
+
+	err = bt_hci_cmd_send_sync(SDC_HCI_OPCODE_CMD_VS_QOS_CONN_EVENT_REPORT_ENABLE,
+				   buf, NULL);
+	if (err) {
+		LOG_ERR("Failed to enable connection event reports (err:%d)",
+			err);
+	}
+}
+#else
+static void sync_enable(void)
+{
+}
+#endif /* CONFIG_DESKTOP_MOTION_SENSOR_SYNC_CONN_EVENT */
+
 static int motion_read(bool send_event)
 {
 	struct sensor_value value_x;
 	struct sensor_value value_y;
+	uint32_t timestamp = k_cycle_get_32();
 
 	int err = sensor_sample_fetch(sensor_dev);
 
+	if (err == -EBUSY) {
+		/* Asynchronous read is in progress, the sensor driver
+		 * reports its motion data after the data ready trigger.
+		 */
+		return -ENODATA;
+	}
+
 	if (!err) {
 		err = sensor_channel_get(sensor_dev, SENSOR_CHAN_POS_DX,
 					 &value_x);
@@ -252,6 +503,10 @@ static int motion_read(bool send_event)
 		nodata = 0;
 	}
 
+	if (IS_ENABLED(CONFIG_DESKTOP_MOTION_SENSOR_LATENCY_STATS)) {
+		latency_sample_taken(timestamp);
+	}
+
 	struct motion_event *event = new_motion_event();
 
 	event->dx = value_x.val1;
@@ -536,8 +791,17 @@ static bool event_handler(const struct event_header *eh)
 
 		if ((event->report_id == REPORT_ID_MOUSE) ||
 		    (event->report_id == REPORT_ID_BOOT_MOUSE)) {
+			if (IS_ENABLED(CONFIG_DESKTOP_MOTION_SENSOR_LATENCY_STATS)) {
+				latency_report_sent(event->error);
+			}
+
 			k_spinlock_key_t key = k_spin_lock(&state.lock);
-			if (state.state == STATE_FETCHING) {
+			/* Sampled before connection events if synced. */
+			bool synced =
+				IS_ENABLED(CONFIG_DESKTOP_MOTION_SENSOR_SYNC_CONN_EVENT) &&
+				is_sync_active(k_cycle_get_32());
+
+			if ((state.state == STATE_FETCHING) && !synced) {
 				state.sample = true;
 				k_sem_give(&sem);
 			}
@@ -547,6 +811,19 @@ static bool event_handler(const struct event_header *eh)
 		return false;
 	}
 
+	if (IS_ENABLED(CONFIG_DESKTOP_MOTION_SENSOR_LATENCY_STATS) &&
+	    is_hid_report_event(eh)) {
+		const struct hid_report_event *event = cast_hid_report_event(eh);
+		uint8_t report_id = event->dyndata.data[0];
+
+		if ((report_id == REPORT_ID_MOUSE) ||
+		    (report_id == REPORT_ID_BOOT_MOUSE)) {
+			latency_report_submitted();
+		}
+
+		return false;
+	}
+
 	if (is_hid_report_subscription_event(eh)) {
 		const struct hid_report_subscription_event *event =
 			cast_hid_report_subscription_event(eh);
@@ -607,12 +884,29 @@ static bool event_handler(const struct event_header *eh)
 		const struct module_state_event *event =
 			cast_module_state_event(eh);
 
+		if (IS_ENABLED(CONFIG_DESKTOP_MOTION_SENSOR_SYNC_CONN_EVENT) &&
+		    check_state(event, MODULE_ID(ble_state),
+				MODULE_STATE_READY)) {
+			sync_enable();
+
+			return false;
+		}
+
 		if (check_state(event, MODULE_ID(main), MODULE_STATE_READY)) {
 			/* Start state machine thread */
 			__ASSERT_NO_MSG(state.state == STATE_DISABLED);
 
 			set_default_configuration();
 
+			k_timer_init(&sync.sample_timer,
+				     sync_sample_timer_handler, NULL);
+
+			if (IS_ENABLED(CONFIG_DESKTOP_MOTION_SENSOR_LATENCY_STATS)) {
+				k_delayed_work_init(&stats.log, latency_log_fn);
+				k_delayed_work_submit(&stats.log,
+						      STATS_LOG_PERIOD);
+			}
+
 			k_thread_create(&thread, thread_stack,
 					THREAD_STACK_SIZE,
 					(k_thread_entry_t)motion_thread_fn,
@@ -710,6 +1004,9 @@ EVENT_SUBSCRIBE(MODULE, module_state_event);
 EVENT_SUBSCRIBE(MODULE, wake_up_event);
 EVENT_SUBSCRIBE(MODULE, hid_report_sent_event);
 EVENT_SUBSCRIBE(MODULE, hid_report_subscription_event);
+#if CONFIG_DESKTOP_MOTION_SENSOR_LATENCY_STATS
+EVENT_SUBSCRIBE(MODULE, hid_report_event);
+#endif
 #if CONFIG_DESKTOP_CONFIG_CHANNEL_ENABLE
 EVENT_SUBSCRIBE_EARLY(MODULE, config_event);
 #endif
@@ -36,6 +36,8 @@ LOG_MODULE_REGISTER(MODULE, CONFIG_DESKTOP_BLE_BOND_LOG_LEVEL);
 #define ON_START_CLICK(CLICK)		(CLICK + CLICK_COUNT)
 #define ON_START_CLICK_UPTIME_MAX	(6 * MSEC_PER_SEC)
 
+#define PEER_ID_STORE_DELAY		K_MSEC(CONFIG_DESKTOP_BLE_PEER_ID_STORE_DELAY)
+
 
 enum state {
 	STATE_DISABLED,
@@ -110,6 +112,7 @@ const static char * const opt_descr[] = {
 static enum state state;
 static uint8_t cur_peer_id;
 static bool cur_peer_id_valid;
+static uint8_t stored_peer_id;
 static uint8_t tmp_peer_id;
 static bool dongle_peer_selected_on_init;
 static bool erase_adv_was_extended;
@@ -135,6 +138,10 @@ static bool bt_stack_id_lut_valid;
 
 
 static struct k_delayed_work timeout;
+static struct k_delayed_work peer_id_store;
+
+static uint32_t switch_start;
+static bool switch_measure;
 
 static int settings_set(const char *key, size_t len_rd,
 			settings_read_cb read_cb, void *cb_arg)
@@ -152,6 +159,7 @@ static int settings_set(const char *key, size_t len_rd,
 
 		if (rc == sizeof(cur_peer_id)) {
 			cur_peer_id_valid = true;
+			stored_peer_id = cur_peer_id;
 		} else {
 			cur_peer_id_valid = false;
 
@@ -370,9 +378,69 @@ static int store_peer_id(uint8_t peer_id)
 		}
 	}
 
+	stored_peer_id = peer_id;
+
+	return 0;
+}
+
+static void peer_id_store_fn(struct k_work *work)
+{
+	int err = store_peer_id(cur_peer_id);
+
+	if (err) {
+		module_set_state(MODULE_STATE_ERROR);
+	}
+}
+
+static int peer_id_store_request(void)
+{
+	/* Peer can be switched back before the delayed write is done. */
+	if (cur_peer_id == stored_peer_id) {
+		k_delayed_work_cancel(&peer_id_store);
+		return 0;
+	}
+
+	if (CONFIG_DESKTOP_BLE_PEER_ID_STORE_DELAY == 0) {
+		return store_peer_id(cur_peer_id);
+	}
+
+	/* Resubmitting restarts the delay, so that subsequent peer switches
+	 * result in a single write.
+	 */
+	k_delayed_work_submit(&peer_id_store, PEER_ID_STORE_DELAY);
+
 	return 0;
 }
 
+static void peer_id_store_flush(void)
+{
+	/* Cancel succeeds only if the write is pending. */
+	if (!k_delayed_work_cancel(&peer_id_store)) {
+		peer_id_store_fn(NULL);
+	}
+}
+
+static void switch_measure_start(void)
+{
+	if (IS_ENABLED(CONFIG_DESKTOP_BLE_PEER_SWITCH_LATENCY_LOG)) {
+		switch_start = k_cycle_get_32();
+		switch_measure = true;
+	}
+}
+
+static void switch_measure_end(void)
+{
+	if (IS_ENABLED(CONFIG_DESKTOP_BLE_PEER_SWITCH_LATENCY_LOG) &&
+	    switch_measure) {
+		uint32_t latency = k_cyc_to_us_floor32(k_cycle_get_32() -
+						       switch_start);
+
+		LOG_INF("Peer switch to advertising start: %" PRIu32 " us",
+			latency);
+		switch_measure = false;
+	}
+}
+
 static void select_confirm(void)
 {
 	LOG_INF("Select peer");
@@ -380,10 +448,12 @@ static void select_confirm(void)
 	enum peer_operation op;
 
 	if (tmp_peer_id != cur_peer_id) {
+		switch_measure_start();
+
 		cur_peer_id = tmp_peer_id;
 		op = PEER_OPERATION_SELECTED;
 
-		int err = store_peer_id(cur_peer_id);
+		int err = peer_id_store_request();
 
 		if (err) {
 			module_set_state(MODULE_STATE_ERROR);
@@ -708,6 +778,8 @@ static int init(void)
 		k_delayed_work_init(&timeout, timeout_handler);
 	}
 
+	k_delayed_work_init(&peer_id_store, peer_id_store_fn);
+
 	load_identities();
 
 	if (IS_ENABLED(CONFIG_BT_PERIPHERAL) &&
@@ -826,6 +898,7 @@ static void selector_event_handler(const struct selector_event *event)
 			/* Fall-through */
 		case STATE_IDLE:
 		case STATE_STANDBY:
+			switch_measure_start();
 			select_dongle_peer();
 			break;
 		default:
@@ -848,6 +921,7 @@ static void selector_event_handler(const struct selector_event *event)
 			/* Fall-through */
 		case STATE_DONGLE_CONN:
 		case STATE_DONGLE_CONN_STANDBY:
+			switch_measure_start();
 			select_ble_peers();
 			break;
 		default:
@@ -916,11 +990,13 @@ static bool handle_power_down_event(const struct power_down_event *event)
 		/* Fall-through */
 
 	case STATE_IDLE:
+		peer_id_store_flush();
 		state = STATE_STANDBY;
 		module_set_state(MODULE_STATE_OFF);
 		break;
 
 	case STATE_DONGLE_CONN:
+		peer_id_store_flush();
 		state = STATE_DONGLE_CONN_STANDBY;
 		module_set_state(MODULE_STATE_OFF);
 		break;
@@ -1011,6 +1087,15 @@ static bool event_handler(const struct event_header *eh)
 		return ble_peer_event_handler(cast_ble_peer_event(eh));
 	}
 
+	if (IS_ENABLED(CONFIG_DESKTOP_BLE_PEER_SWITCH_LATENCY_LOG) &&
+	    is_ble_peer_search_event(eh)) {
+		if (cast_ble_peer_search_event(eh)->active) {
+			switch_measure_end();
+		}
+
+		return false;
+	}
+
 	if (IS_ENABLED(CONFIG_DESKTOP_BLE_PEER_CONTROL) &&
 	    is_click_event(eh)) {
 		return click_event_handler(cast_click_event(eh));
@@ -1045,6 +1130,9 @@ EVENT_SUBSCRIBE(MODULE, module_state_event);
 #if CONFIG_BT_PERIPHERAL
 EVENT_SUBSCRIBE(MODULE, ble_peer_event);
 #endif
+#if CONFIG_DESKTOP_BLE_PEER_SWITCH_LATENCY_LOG
+EVENT_SUBSCRIBE(MODULE, ble_peer_search_event);
+#endif
 #if CONFIG_DESKTOP_CONFIG_CHANNEL_ENABLE
 EVENT_SUBSCRIBE_EARLY(MODULE, config_event);
 #endif
@@ -27,6 +27,19 @@
 LOG_MODULE_REGISTER(MODULE, CONFIG_DESKTOP_HID_FORWARD_LOG_LEVEL);
 
 #define MAX_ENQUEUED_ITEMS CONFIG_DESKTOP_HID_FORWARD_MAX_ENQUEUED_REPORTS
+
+#ifdef CONFIG_DESKTOP_USB_HID_IN_FLIGHT_REPORTS
+  #define MAX_IN_FLIGHT_REPORTS CONFIG_DESKTOP_USB_HID_IN_FLIGHT_REPORTS
+#else
+  #define MAX_IN_FLIGHT_REPORTS 1
+#endif
+
+#ifdef CONFIG_DESKTOP_HID_FORWARD_STATS
+  #define STATS_LOG_PERIOD K_MSEC(CONFIG_DESKTOP_HID_FORWARD_STATS_PERIOD)
+#else
+  #define STATS_LOG_PERIOD K_NO_WAIT
+#endif
+
 #define CFG_CHAN_RSP_READ_DELAY		K_MSEC(15)
 #define CFG_CHAN_MAX_RSP_POLL_CNT	50
 #define CFG_CHAN_UNUSED_PEER_ID		UINT8_MAX
@@ -39,6 +52,7 @@ BUILD_ASSERT(CFG_CHAN_MAX_RSP_POLL_CNT <= UCHAR_MAX);
 struct enqueued_report {
 	sys_snode_t node;
 	struct hid_report_event *report;
+	uint32_t timestamp;
 };
 
 struct counted_list {
@@ -55,7 +69,9 @@ struct subscriber {
 	const void *id;
 	uint32_t enabled_reports_bm;
 	struct enqueued_reports enqueued_reports;
-	bool busy;
+	uint32_t in_flight_timestamp[MAX_IN_FLIGHT_REPORTS];
+	uint8_t in_flight_idx;
+	uint8_t in_flight_cnt;
 	uint8_t last_peripheral_id;
 };
 
@@ -76,6 +92,16 @@ static bt_addr_le_t peripheral_address[CONFIG_BT_MAX_PAIRED];
 static struct hids_peripheral peripherals[CONFIG_BT_MAX_CONN];
 static bool suspended;
 
+static struct {
+	uint32_t sent;
+	uint32_t merged;
+	uint32_t dropped;
+	uint32_t latency_min;
+	uint32_t latency_max;
+	uint64_t latency_sum;
+} stats;
+static struct k_delayed_work stats_log;
+
 
 #if CONFIG_USB_HID_DEVICE_COUNT > 1
 static void verify_data(const struct bt_bond_info *info, void *user_data)
@@ -179,6 +205,72 @@ static bool is_report_enabled(struct subscriber *sub, uint8_t report_id)
 	return (sub->enabled_reports_bm & BIT(report_id)) != 0;
 }
 
+static bool is_subscriber_busy(const struct subscriber *sub)
+{
+	return (sub->in_flight_cnt >= MAX_IN_FLIGHT_REPORTS);
+}
+
+static void stats_latency_update(uint32_t timestamp)
+{
+	if (!IS_ENABLED(CONFIG_DESKTOP_HID_FORWARD_STATS)) {
+		return;
+	}
+
+	uint32_t latency = k_cyc_to_us_floor32(k_cycle_get_32() - timestamp);
+
+	if ((stats.sent == 0) || (latency < stats.latency_min)) {
+		stats.latency_min = latency;
+	}
+	stats.latency_max = MAX(stats.latency_max, latency);
+	stats.latency_sum += latency;
+	stats.sent++;
+}
+
+static void stats_log_fn(struct k_work *work)
+{
+	if (stats.sent > 0) {
+		LOG_INF("Sent %" PRIu32 " merged %" PRIu32 " dropped %" PRIu32,
+			stats.sent, stats.merged, stats.dropped);
+		LOG_INF("Latency [us] min %" PRIu32 " avg %" PRIu32
+			" max %" PRIu32, stats.latency_min,
+			(uint32_t)(stats.latency_sum / stats.sent),
+			stats.latency_max);
+	}
+
+	memset(&stats, 0, sizeof(stats));
+	k_delayed_work_submit(&stats_log, STATS_LOG_PERIOD);
+}
+
+static void submit_hid_report(struct subscriber *sub,
+			      struct hid_report_event *report,
+			      uint32_t timestamp)
+{
+	__ASSERT_NO_MSG(!is_subscriber_busy(sub));
+
+	size_t idx = (sub->in_flight_idx + sub->in_flight_cnt) %
+		     MAX_IN_FLIGHT_REPORTS;
+
+	/* USB sends the reports of a subscriber in order of submission. */
+	sub->in_flight_timestamp[idx] = timestamp;
+	sub->in_flight_cnt++;
+
+	EVENT_SUBMIT(report);
+}
+
+static void hid_report_sent(struct subscriber *sub, bool error)
+{
+	__ASSERT_NO_MSG(sub->in_flight_cnt > 0);
+
+	uint32_t timestamp = sub->in_flight_timestamp[sub->in_flight_idx];
+
+	sub->in_flight_idx = next_id(sub->in_flight_idx, MAX_IN_FLIGHT_REPORTS);
+	sub->in_flight_cnt--;
+
+	if (!error) {
+		stats_latency_update(timestamp);
+	}
+}
+
 static bool is_report_enqueued(struct enqueued_reports *enqueued_reports,
 			       size_t irep_idx)
 {
@@ -305,9 +397,78 @@ static void migrate_enqueued_reports(struct enqueued_reports *dst_reports,
 	}
 }
 
+static void mouse_report_xy_get(const uint8_t *data, int *x, int *y)
+{
+	uint16_t x_raw = data[2] | ((data[3] & 0x0f) << 8);
+	uint16_t y_raw = (data[3] >> 4) | (data[4] << 4);
+
+	/* Sign extend 12-bit values. */
+	*x = (x_raw & BIT(11)) ? ((int)x_raw - 0x1000) : x_raw;
+	*y = (y_raw & BIT(11)) ? ((int)y_raw - 0x1000) : y_raw;
+}
+
+static bool merge_mouse_report(struct enqueued_reports *enqueued_reports,
+			       size_t irep_idx, const uint8_t *data,
+			       size_t size)
+{
+	BUILD_ASSERT(REPORT_SIZE_MOUSE == 5, "Invalid report size");
+
+	struct counted_list *reports = &enqueued_reports->reports[irep_idx];
+	sys_snode_t *node = sys_slist_peek_tail(&reports->list);
+
+	if (!node || (size != REPORT_SIZE_MOUSE)) {
+		return false;
+	}
+
+	/* Merge with the newest enqueued report. */
+	struct enqueued_report *item = CONTAINER_OF(node, __typeof__(*item),
+						    node);
+	uint8_t *queued = &item->report->dyndata.data[1];
+
+	if (item->report->dyndata.size != (size + sizeof(uint8_t))) {
+		return false;
+	}
+
+	/* Button release must not be lost. */
+	if (queued[0] & ~data[0]) {
+		return false;
+	}
+
+	int queued_x, queued_y;
+	int x, y;
+
+	mouse_report_xy_get(queued, &queued_x, &queued_y);
+	mouse_report_xy_get(data, &x, &y);
+
+	int wheel = (int8_t)queued[1] + (int8_t)data[1];
+
+	x += queued_x;
+	y += queued_y;
+
+	/* Keep reports separate rather than lose motion. */
+	if ((x < MOUSE_REPORT_XY_MIN) || (x > MOUSE_REPORT_XY_MAX) ||
+	    (y < MOUSE_REPORT_XY_MIN) || (y > MOUSE_REPORT_XY_MAX) ||
+	    (wheel < MOUSE_REPORT_WHEEL_MIN) ||
+	    (wheel > MOUSE_REPORT_WHEEL_MAX)) {
+		return false;
+	}
+
+	uint16_t x_raw = x;
+	uint16_t y_raw = y;
+
+	queued[0] |= data[0];
+	queued[1] = wheel;
+	queued[2] = x_raw & 0xff;
+	queued[3] = ((y_raw & 0x0f) << 4) | ((x_raw >> 8) & 0x0f);
+	queued[4] = (y_raw >> 4) & 0xff;
+
+	return true;
+}
+
 static void enqueue_hid_report(struct enqueued_reports *enqueued_reports,
 			       size_t irep_idx,
-			       struct hid_report_event *report)
+			       struct hid_report_event *report,
+			       uint32_t timestamp)
 {
 	__ASSERT_NO_MSG(irep_idx < ARRAY_SIZE(enqueued_reports->reports));
 
@@ -321,6 +482,7 @@ static void enqueue_hid_report(struct enqueued_reports *enqueued_reports,
 		LOG_WRN("Enqueue dropped the oldest report");
 		item = get_enqueued_report(enqueued_reports, irep_idx);
 		k_free(item->report);
+		stats.dropped++;
 	}
 
 	if (!item) {
@@ -329,6 +491,7 @@ static void enqueue_hid_report(struct enqueued_reports *enqueued_reports,
 		__ASSERT_NO_MSG(false);
 	} else {
 		item->report = report;
+		item->timestamp = timestamp;
 		sys_slist_append(&reports->list, &item->node);
 		reports->count++;
 	}
@@ -338,6 +501,7 @@ static void forward_hid_report(struct hids_peripheral *per, uint8_t report_id,
 			       const uint8_t *data, size_t size)
 {
 	struct subscriber *sub = get_subscriber(per);
+	uint32_t timestamp = k_cycle_get_32();
 
 	if (report_id >= __CHAR_BIT__ * sizeof(sub->enabled_reports_bm)) {
 		__ASSERT_NO_MSG(false);
@@ -362,6 +526,13 @@ static void forward_hid_report(struct hids_peripheral *per, uint8_t report_id,
 		return;
 	}
 
+	if (IS_ENABLED(CONFIG_DESKTOP_HID_FORWARD_MERGE_MOUSE_REPORTS) &&
+	    (report_id == REPORT_ID_MOUSE) && is_subscriber_busy(sub) &&
+	    merge_mouse_report(&per->enqueued_reports, irep_idx, data, size)) {
+		stats.merged++;
+		return;
+	}
+
 	struct hid_report_event *report = new_hid_report_event(size + sizeof(report_id));
 
 	report->subscriber = sub->id;
@@ -370,14 +541,14 @@ static void forward_hid_report(struct hids_peripheral *per, uint8_t report_id,
 	report->dyndata.data[0] = report_id;
 	memcpy(&report->dyndata.data[1], data, size);
 
-	if (!sub->busy) {
+	if (!is_subscriber_busy(sub)) {
 		__ASSERT_NO_MSG(!is_report_enqueued(&per->enqueued_reports, irep_idx));
 
-		EVENT_SUBMIT(report);
+		submit_hid_report(sub, report, timestamp);
 		per->enqueued_reports.last_idx = irep_idx;
-		sub->busy = true;
 	} else {
-		enqueue_hid_report(&per->enqueued_reports, irep_idx, report);
+		enqueue_hid_report(&per->enqueued_reports, irep_idx, report,
+				   timestamp);
 	}
 }
 
@@ -980,14 +1151,15 @@ static void init(void)
 	}
 
 	reset_peripheral_address();
-}
 
-static void send_enqueued_report(struct subscriber *sub)
-{
-	if (sub->busy) {
-		return;
+	if (IS_ENABLED(CONFIG_DESKTOP_HID_FORWARD_STATS)) {
+		k_delayed_work_init(&stats_log, stats_log_fn);
+		k_delayed_work_submit(&stats_log, STATS_LOG_PERIOD);
 	}
+}
 
+static struct enqueued_report *next_subscriber_report(struct subscriber *sub)
+{
 	struct enqueued_report *item;
 
 	/* First try to send report left at subscriber. */
@@ -1014,12 +1186,21 @@ static void send_enqueued_report(struct subscriber *sub)
 		}
 	}
 
-	if (item) {
-		EVENT_SUBMIT(item->report);
+	return item;
+}
 
-		k_free(item);
+static void send_enqueued_report(struct subscriber *sub)
+{
+	while (!is_subscriber_busy(sub)) {
+		struct enqueued_report *item = next_subscriber_report(sub);
 
-		sub->busy = true;
+		if (!item) {
+			break;
+		}
+
+		submit_hid_report(sub, item->report, item->timestamp);
+
+		k_free(item);
 	}
 }
 
@@ -1038,7 +1219,7 @@ static bool event_handler(const struct event_header *eh)
 		}
 		__ASSERT_NO_MSG(sub);
 
-		sub->busy = false;
+		hid_report_sent(sub, event->error);
 		send_enqueued_report(sub);
 
 		return false;
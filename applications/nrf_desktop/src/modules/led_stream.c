@@ -19,6 +19,7 @@ LOG_MODULE_REGISTER(MODULE, CONFIG_DESKTOP_LED_STREAM_LOG_LEVEL);
 #define INCOMING_LED_COLOR_COUNT 3
 #define LED_STREAM_DATA_SIZE 8
 #define FETCH_CONFIG_SIZE 2
+#define SUBSTEP_COUNT_POS INCOMING_LED_COLOR_COUNT
 #define LED_ID_POS 7
 
 #define LED_ID(led) ((led) - &leds[0])
@@ -40,6 +41,7 @@ static bool initialized;
 enum led_stream_opt {
 	LED_STREAM_OPT_SET_LED_EFFECT,
 	LED_STREAM_OPT_GET_LEDS_STATE,
+	LED_STREAM_OPT_SET_LED_EFFECTS,
 
 	LED_STREAM_OPT_COUNT,
 };
@@ -47,6 +49,7 @@ enum led_stream_opt {
 const static char * const opt_descr[] = {
 	[LED_STREAM_OPT_SET_LED_EFFECT] = "set_led_effect",
 	[LED_STREAM_OPT_GET_LEDS_STATE] = "get_leds_state",
+	[LED_STREAM_OPT_SET_LED_EFFECTS] = "set_led_effects",
 };
 
 
@@ -155,6 +158,18 @@ static void send_data_from_queue(struct led *led)
 	}
 }
 
+static void stream_start(struct led *led)
+{
+	if (!led->streaming) {
+		LOG_DBG("Sending first led effect for led %zu",
+			(size_t)LED_ID(led));
+
+		led->streaming = true;
+
+		send_data_from_queue(led);
+	}
+}
+
 static void handle_incoming_step(const uint8_t *data, const size_t size)
 {
 	if (!initialized) {
@@ -175,12 +190,61 @@ static void handle_incoming_step(const uint8_t *data, const size_t size)
 		return;
 	}
 
-	if (!led->streaming) {
-		LOG_DBG("Sending first led effect for led %zu", led_id);
+	stream_start(led);
+}
 
-		led->streaming = true;
+static void handle_incoming_steps(const uint8_t *data, const size_t size)
+{
+	if (!initialized) {
+		LOG_WRN("Not initialized");
+		return;
+	}
 
-		send_data_from_queue(led);
+	if ((size == 0) || ((size % LED_STREAM_DATA_SIZE) != 0)) {
+		LOG_WRN("Invalid stream data size (%zu)", size);
+		return;
+	}
+
+	size_t step_count[ARRAY_SIZE(leds)] = {0};
+
+	/* Validate the whole batch first, so that it is either queued or
+	 * dropped as a whole and the host can simply send it again.
+	 */
+	for (size_t pos = 0; pos < size; pos += LED_STREAM_DATA_SIZE) {
+		size_t led_id = data[pos + LED_ID_POS];
+
+		if (led_id >= ARRAY_SIZE(leds)) {
+			LOG_WRN("Wrong LED ID: %zu, effects ignored", led_id);
+			return;
+		}
+
+		if (sys_get_le16(&data[pos + SUBSTEP_COUNT_POS]) == 0) {
+			LOG_WRN("Dropped led_effects with substep count equal 0");
+			return;
+		}
+
+		step_count[led_id]++;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(leds); i++) {
+		if (step_count[i] > count_free_places(&leds[i])) {
+			LOG_WRN("Queue is full - drop incoming steps");
+			return;
+		}
+	}
+
+	for (size_t pos = 0; pos < size; pos += LED_STREAM_DATA_SIZE) {
+		struct led *led = &leds[data[pos + LED_ID_POS]];
+		bool queued = queue_data(&data[pos], LED_STREAM_DATA_SIZE, led);
+
+		__ASSERT_NO_MSG(queued);
+		ARG_UNUSED(queued);
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(leds); i++) {
+		if (step_count[i] > 0) {
+			stream_start(&leds[i]);
+		}
 	}
 }
 
@@ -191,6 +255,10 @@ static void config_set(const uint8_t opt_id, const uint8_t *data, const size_t s
 		handle_incoming_step(data, size);
 		break;
 
+	case LED_STREAM_OPT_SET_LED_EFFECTS:
+		handle_incoming_steps(data, size);
+		break;
+
 	default:
 		LOG_WRN("Unknown config set: %" PRIu8, opt_id);
 		break;
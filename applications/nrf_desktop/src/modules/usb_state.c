@@ -49,11 +49,23 @@ LOG_MODULE_REGISTER(MODULE, CONFIG_DESKTOP_USB_STATE_LOG_LEVEL);
   #error Too few USB IN Endpoints enabled. Modify dts.overlay file.
 #endif
 
+#define INPUT_REPORT_SIZE_MAX						\
+	MAX(MAX(REPORT_SIZE_MOUSE, REPORT_SIZE_KEYBOARD_KEYS),		\
+	    MAX(REPORT_SIZE_SYSTEM_CTRL, REPORT_SIZE_CONSUMER_CTRL))
+
+struct queued_report {
+	uint8_t size;
+	uint8_t data[sizeof(uint8_t) + INPUT_REPORT_SIZE_MAX];
+};
+
 struct usb_hid_device {
 	const struct device *dev;
 	uint32_t report_bm;
 	uint8_t hid_protocol;
 	uint8_t sent_report_id;
+	struct queued_report queue[CONFIG_DESKTOP_USB_HID_IN_FLIGHT_REPORTS];
+	uint8_t queue_idx;
+	uint8_t queue_cnt;
 	bool report_enabled[REPORT_ID_COUNT];
 	bool enabled;
 };
@@ -61,6 +73,7 @@ struct usb_hid_device {
 
 static enum usb_state state;
 static struct usb_hid_device usb_hid_device[CONFIG_USB_HID_DEVICE_COUNT];
+static struct k_spinlock report_lock;
 
 static struct config_channel_transport cfg_chan_transport;
 
@@ -187,26 +200,108 @@ static int set_report(const struct device *dev, struct usb_setup_packet *setup,
 	return 0;
 }
 
-static void report_sent(const struct device *dev, bool error)
+static void report_sent(struct usb_hid_device *usb_hid, uint8_t report_id,
+			bool error)
 {
-	struct usb_hid_device *usb_hid = dev_to_hid(dev);
-
-	__ASSERT_NO_MSG(usb_hid->sent_report_id != REPORT_ID_COUNT);
-
 	struct hid_report_sent_event *event = new_hid_report_sent_event();
 
-	event->report_id = usb_hid->sent_report_id;
+	event->report_id = report_id;
 	event->subscriber = usb_hid;
 	event->error = error;
 	EVENT_SUBMIT(event);
+}
 
-	/* Used to assert if previous report was sent before sending new one. */
-	usb_hid->sent_report_id = REPORT_ID_COUNT;
+static bool report_queue_pop(struct usb_hid_device *usb_hid,
+			     struct queued_report *report)
+{
+	/* Must be called with report_lock held. */
+	if (usb_hid->queue_cnt == 0) {
+		return false;
+	}
+
+	*report = usb_hid->queue[usb_hid->queue_idx];
+	usb_hid->queue_idx = (usb_hid->queue_idx + 1) % ARRAY_SIZE(usb_hid->queue);
+	usb_hid->queue_cnt--;
+
+	return true;
+}
+
+static bool report_queue_get(struct usb_hid_device *usb_hid,
+			     struct queued_report *report)
+{
+	k_spinlock_key_t key = k_spin_lock(&report_lock);
+	bool found = false;
+
+	/* Only one report can be written to the endpoint at a time. */
+	if ((usb_hid->sent_report_id == REPORT_ID_COUNT) &&
+	    report_queue_pop(usb_hid, report)) {
+		usb_hid->sent_report_id = report->data[0];
+		found = true;
+	}
+
+	k_spin_unlock(&report_lock, key);
+
+	return found;
+}
+
+static bool report_write(struct usb_hid_device *usb_hid,
+			 const uint8_t *report_buffer, size_t report_size)
+{
+	if (usb_hid->hid_protocol != HID_PROTOCOL_REPORT) {
+		if ((IS_ENABLED(CONFIG_DESKTOP_HID_BOOT_INTERFACE_MOUSE) &&
+		     (report_buffer[0] == REPORT_ID_BOOT_MOUSE)) ||
+		    (IS_ENABLED(CONFIG_DESKTOP_HID_BOOT_INTERFACE_KEYBOARD) &&
+		     (report_buffer[0] == REPORT_ID_BOOT_KEYBOARD))) {
+			/* For boot protocol omit the first byte. */
+			report_buffer++;
+			report_size--;
+			__ASSERT_NO_MSG(report_size > 0);
+		} else {
+			/* Boot protocol is not supported or this is not a
+			 * boot report.
+			 */
+			return false;
+		}
+	}
+
+	int err = hid_int_ep_write(usb_hid->dev, report_buffer, report_size,
+				   NULL);
+
+	if (err) {
+		LOG_ERR("Cannot send report (%d)", err);
+		return false;
+	}
+
+	return true;
+}
+
+static void report_queue_process(struct usb_hid_device *usb_hid)
+{
+	struct queued_report report;
+
+	while (report_queue_get(usb_hid, &report)) {
+		if (report_write(usb_hid, report.data, report.size)) {
+			break;
+		}
+
+		usb_hid->sent_report_id = REPORT_ID_COUNT;
+		report_sent(usb_hid, report.data[0], true);
+	}
 }
 
 static void report_sent_cb(const struct device *dev)
 {
-	report_sent(dev, false);
+	struct usb_hid_device *usb_hid = dev_to_hid(dev);
+	uint8_t report_id = usb_hid->sent_report_id;
+
+	__ASSERT_NO_MSG(report_id != REPORT_ID_COUNT);
+
+	/* Used to assert if previous report was sent before sending new one. */
+	usb_hid->sent_report_id = REPORT_ID_COUNT;
+
+	/* Write the next buffered report before the host polls again. */
+	report_queue_process(usb_hid);
+	report_sent(usb_hid, report_id, false);
 }
 
 static void send_hid_report(const struct hid_report_event *event)
@@ -232,42 +327,38 @@ static void send_hid_report(const struct hid_report_event *event)
 
 	if (state != USB_STATE_ACTIVE) {
 		/* USB not connected. */
-		usb_hid->sent_report_id = event->dyndata.data[0];
-		report_sent(usb_hid->dev, true);
+		report_sent(usb_hid, report_buffer[0], true);
 		return;
 	}
 
-	__ASSERT_NO_MSG(usb_hid->sent_report_id == REPORT_ID_COUNT);
+	if (report_size > sizeof(usb_hid->queue[0].data)) {
+		LOG_ERR("Report %" PRIu8 " too long", report_buffer[0]);
+		report_sent(usb_hid, report_buffer[0], true);
+		return;
+	}
 
-	if (usb_hid->hid_protocol != HID_PROTOCOL_REPORT) {
-		if ((IS_ENABLED(CONFIG_DESKTOP_HID_BOOT_INTERFACE_MOUSE) &&
-		     (report_buffer[0] == REPORT_ID_BOOT_MOUSE)) ||
-		    (IS_ENABLED(CONFIG_DESKTOP_HID_BOOT_INTERFACE_KEYBOARD) &&
-		     (report_buffer[0] == REPORT_ID_BOOT_KEYBOARD))) {
-			usb_hid->sent_report_id = event->dyndata.data[0];
-			/* For boot protocol omit the first byte. */
-			report_buffer++;
-			report_size--;
-			__ASSERT_NO_MSG(report_size > 0);
-		} else {
-			/* Boot protocol is not supported or this is not a
-			 * boot report.
-			 */
-			usb_hid->sent_report_id = event->dyndata.data[0];
-			report_sent(usb_hid->dev, true);
-			return;
-		}
-	} else {
-		usb_hid->sent_report_id = event->dyndata.data[0];
+	k_spinlock_key_t key = k_spin_lock(&report_lock);
+	bool queued = (usb_hid->queue_cnt < ARRAY_SIZE(usb_hid->queue));
+
+	if (queued) {
+		size_t idx = (usb_hid->queue_idx + usb_hid->queue_cnt) %
+			     ARRAY_SIZE(usb_hid->queue);
+
+		memcpy(usb_hid->queue[idx].data, report_buffer, report_size);
+		usb_hid->queue[idx].size = report_size;
+		usb_hid->queue_cnt++;
 	}
 
-	int err = hid_int_ep_write(usb_hid->dev, event->dyndata.data,
-				   event->dyndata.size, NULL);
+	k_spin_unlock(&report_lock, key);
 
-	if (err) {
-		LOG_ERR("Cannot send report (%d)", err);
-		report_sent(usb_hid->dev, true);
+	if (!queued) {
+		/* Subscriber exceeded the number of reports in flight. */
+		__ASSERT_NO_MSG(false);
+		report_sent(usb_hid, report_buffer[0], true);
+		return;
 	}
+
+	report_queue_process(usb_hid);
 }
 
 static void broadcast_usb_state(void)
@@ -295,10 +386,28 @@ static void broadcast_usb_hid(struct usb_hid_device *usb_hid, bool enabled)
 
 static void reset_pending_report(struct usb_hid_device *usb_hid)
 {
+	struct queued_report report;
+	bool found;
+
 	if (usb_hid->sent_report_id != REPORT_ID_COUNT) {
+		uint8_t report_id = usb_hid->sent_report_id;
+
 		LOG_WRN("USB clear report notification waiting flag");
-		report_sent(usb_hid->dev, true);
+		usb_hid->sent_report_id = REPORT_ID_COUNT;
+		report_sent(usb_hid, report_id, true);
 	}
+
+	/* Drop the reports that were not written to the endpoint yet. */
+	do {
+		k_spinlock_key_t key = k_spin_lock(&report_lock);
+
+		found = report_queue_pop(usb_hid, &report);
+		k_spin_unlock(&report_lock, key);
+
+		if (found) {
+			report_sent(usb_hid, report.data[0], true);
+		}
+	} while (found);
 }
 
 static void broadcast_subscription_change(struct usb_hid_device *usb_hid)
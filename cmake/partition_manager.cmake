@@ -193,6 +193,16 @@ set(pm_out_partition_file ${APPLICATION_BINARY_DIR}/partitions${UNDERSCORE_DOMAI
 set(pm_out_region_file ${APPLICATION_BINARY_DIR}/regions${UNDERSCORE_DOMAIN}.yml)
 set(pm_out_dotconf_file ${APPLICATION_BINARY_DIR}/pm${UNDERSCORE_DOMAIN}.config)
 
+# Reuse the regions solved by earlier invocations with identical input,
+# e.g. when the same layout is configured for several images or builds.
+if (NOT DEFINED PM_CACHE_DIR AND DEFINED ENV{PM_CACHE_DIR})
+  set(PM_CACHE_DIR $ENV{PM_CACHE_DIR})
+endif()
+
+if (PM_CACHE_DIR)
+  set(pm_cache_argument --cache-dir ${PM_CACHE_DIR} --timing)
+endif()
+
 set(pm_cmd
   ${PYTHON_EXECUTABLE}
   ${NRF_DIR}/scripts/partition_manager.py
@@ -202,6 +212,7 @@ set(pm_cmd
   --output-regions ${pm_out_region_file}
   ${dynamic_partition_argument}
   ${static_configuration}
+  ${pm_cache_argument}
   ${region_arguments}
   )
 
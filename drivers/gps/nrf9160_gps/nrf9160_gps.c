@@ -13,6 +13,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <logging/log.h>
+#include <sys/timeutil.h>
 #include <nrf_socket.h>
 #include <net/socket.h>
 #ifdef CONFIG_NRF9160_GPS_HANDLE_MODEM_CONFIGURATION
@@ -61,6 +62,12 @@ struct gps_drv_data {
 	struct k_delayed_work stop_work;
 	struct k_delayed_work timeout_work;
 	struct k_delayed_work blocked_work;
+	/* Batched mode state, only accessed from the GPS thread. Other
+	 * threads request a reset of the batch through batch_reset.
+	 */
+	atomic_t batch_reset;
+	uint16_t batch_count;
+	int64_t batch_start;
 };
 
 struct nrf9160_gps_config {
@@ -133,6 +140,49 @@ static bool is_fix(nrf_gnss_pvt_data_frame_t *pvt)
 		== NRF_GNSS_PVT_FLAG_FIX_VALID_BIT);
 }
 
+static uint16_t saturate_u16(float value)
+{
+	if (value <= 0.0f) {
+		return 0;
+	} else if (value >= UINT16_MAX) {
+		return UINT16_MAX;
+	}
+
+	return (uint16_t)value;
+}
+
+static void copy_pvt_sample(struct gps_pvt_sample *dest,
+			    nrf_gnss_pvt_data_frame_t *src)
+{
+	struct tm datetime = {
+		.tm_year = src->datetime.year - 1900,
+		.tm_mon = src->datetime.month - 1,
+		.tm_mday = src->datetime.day,
+		.tm_hour = src->datetime.hour,
+		.tm_min = src->datetime.minute,
+		.tm_sec = src->datetime.seconds,
+	};
+	uint8_t sv_used = 0;
+
+	for (size_t i = 0; i < NRF_GNSS_MAX_SATELLITES; i++) {
+		if (src->sv[i].flags & NRF_GNSS_SV_FLAG_USED_IN_FIX) {
+			sv_used++;
+		}
+	}
+
+	dest->time = (uint32_t)timeutil_timegm64(&datetime);
+	dest->latitude = (int32_t)(src->latitude * 1e7);
+	dest->longitude = (int32_t)(src->longitude * 1e7);
+	dest->altitude = (int16_t)CLAMP(src->altitude, INT16_MIN, INT16_MAX);
+	dest->accuracy = saturate_u16(src->accuracy * 10.0f);
+	dest->speed = saturate_u16(src->speed * 100.0f);
+	dest->heading = saturate_u16(src->heading * 100.0f);
+	dest->hdop = (uint8_t)MIN(saturate_u16(src->hdop * 10.0f), UINT8_MAX);
+	dest->sv_used = sv_used;
+	dest->flags = is_fix(src) ? GPS_PVT_SAMPLE_FLAG_FIX : 0;
+	dest->reserved = 0;
+}
+
 /**@brief Checks if GPS operation is blocked due to insufficient time windows */
 static bool has_no_time_window(nrf_gnss_pvt_data_frame_t *pvt)
 {
@@ -191,6 +241,68 @@ static void notify_event(const struct device *dev, struct gps_event *evt)
 	}
 }
 
+/**@brief Drops the collected samples if a reset of the batch was requested. */
+static void batch_reset_check(struct gps_drv_data *drv_data)
+{
+	if (atomic_cas(&drv_data->batch_reset, 1, 0)) {
+		drv_data->batch_count = 0;
+	}
+}
+
+/**@brief Delivers the samples collected in batched mode. */
+static void batch_flush(const struct device *dev)
+{
+	struct gps_drv_data *drv_data = dev->data;
+	struct gps_event evt = {
+		.type = GPS_EVT_PVT_BATCH,
+		.pvt_batch = {
+			.samples = drv_data->current_cfg.batch.buf,
+		},
+	};
+
+	batch_reset_check(drv_data);
+
+	if (drv_data->batch_count == 0) {
+		return;
+	}
+
+	evt.pvt_batch.count = drv_data->batch_count;
+	notify_event(dev, &evt);
+
+	drv_data->batch_count = 0;
+}
+
+/**@brief Stores a PVT estimate in the batch, and delivers the batch when one
+ *	  of the thresholds is reached.
+ */
+static void batch_add(const struct device *dev,
+		      nrf_gnss_pvt_data_frame_t *pvt)
+{
+	struct gps_drv_data *drv_data = dev->data;
+	struct gps_batch_config *batch = &drv_data->current_cfg.batch;
+	int64_t now = k_uptime_get();
+
+	batch_reset_check(drv_data);
+
+	if (!is_fix(pvt) && !batch->include_no_fix) {
+		return;
+	}
+
+	if (drv_data->batch_count == 0) {
+		drv_data->batch_start = now;
+	}
+
+	copy_pvt_sample(&batch->buf[drv_data->batch_count], pvt);
+	drv_data->batch_count++;
+
+	if ((drv_data->batch_count >= batch->size) ||
+	    ((batch->max_age > 0) &&
+	     ((now - drv_data->batch_start) >=
+	      (int64_t)batch->max_age * MSEC_PER_SEC))) {
+		batch_flush(dev);
+	}
+}
+
 static int open_socket(struct gps_drv_data *drv_data)
 {
 	drv_data->socket = nrf_socket(NRF_AF_LOCAL, NRF_SOCK_DGRAM,
@@ -300,11 +412,13 @@ wait:
 		if (len <= 0) {
 			/* Is the GPS stopped, causing this error? */
 			if (!atomic_get(&drv_data->is_active)) {
+				batch_flush(dev);
 				goto wait;
 			}
 
 			if (errno == EHOSTDOWN) {
 				LOG_DBG("GPS host is going down, sleeping");
+				batch_flush(dev);
 				cancel_works(drv_data);
 				atomic_clear(&drv_data->is_active);
 				atomic_set(&drv_data->is_shutdown, 1);
@@ -382,8 +496,6 @@ wait:
 				k_delayed_work_cancel(&drv_data->blocked_work);
 			}
 
-			copy_pvt(&evt.pvt, &raw_gps_data.pvt);
-
 			if (is_fix(&raw_gps_data.pvt)) {
 				LOG_DBG("PVT: Position fix");
 
@@ -394,7 +506,13 @@ wait:
 				evt.type = GPS_EVT_PVT;
 			}
 
-			notify_event(dev, &evt);
+			if (drv_data->current_cfg.batch.buf) {
+				batch_add(dev, &raw_gps_data.pvt);
+			} else {
+				copy_pvt(&evt.pvt, &raw_gps_data.pvt);
+				notify_event(dev, &evt);
+			}
+
 			print_satellite_stats(&raw_gps_data);
 
 			break;
@@ -571,7 +689,19 @@ static int parse_cfg(struct gps_config *cfg_src,
 		cfg_dst->delete_mask = 0x7F;
 	}
 
-	set_nmea_mask(&cfg_dst->nmea_mask);
+	if (cfg_src->batch.buf) {
+		if (cfg_src->batch.size == 0) {
+			LOG_ERR("Invalid batch buffer size");
+			return -EINVAL;
+		}
+
+		/* NMEA strings are not delivered in batched mode, so the
+		 * GPS is not asked to produce them.
+		 */
+		cfg_dst->nmea_mask = 0;
+	} else {
+		set_nmea_mask(&cfg_dst->nmea_mask);
+	}
 
 	if (cfg_src->power_mode == GPS_POWER_MODE_PERFORMANCE) {
 		cfg_dst->power_mode = NRF_GNSS_PSM_DUTY_CYCLING_PERFORMANCE;
@@ -727,6 +857,7 @@ set_configuration:
 
 	atomic_set(&drv_data->is_active, 1);
 	atomic_set(&drv_data->timeout_occurred, 0);
+	atomic_set(&drv_data->batch_reset, 1);
 	k_sem_give(&drv_data->thread_run_sem);
 
 	LOG_DBG("GPS operational");
@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
  */
 
+#include <string.h>
 #include <zephyr.h>
 #include <kernel.h>
 #include <drivers/sensor.h>
@@ -12,6 +13,7 @@
 #include <drivers/gpio.h>
 #include <sys/byteorder.h>
 #include <sensor/paw3212.h>
+#include <profiler.h>
 
 #include <logging/log.h>
 LOG_MODULE_REGISTER(paw3212, CONFIG_PAW3212_LOG_LEVEL);
@@ -110,6 +112,32 @@ enum async_init_step {
 	ASYNC_INIT_STEP_COUNT
 };
 
+/* Registers read to fetch a motion sample, in order of reading. */
+enum motion_data {
+	MOTION_DATA_STATUS,
+	MOTION_DATA_X_LOW,
+	MOTION_DATA_Y_LOW,
+	MOTION_DATA_XY_HIGH,
+
+	MOTION_DATA_COUNT
+};
+
+#define MOTION_DATA_READ_COUNT							\
+	(IS_ENABLED(CONFIG_PAW3212_12_BIT_MODE) ?				\
+	 MOTION_DATA_COUNT : MOTION_DATA_XY_HIGH)
+
+#ifdef CONFIG_PAW3212_ASYNC_READ
+enum read_state {
+	READ_STATE_IDLE,
+	READ_STATE_SYNC,
+	READ_STATE_ADDR,
+	READ_STATE_SRAD,
+	READ_STATE_DATA,
+	READ_STATE_SRX,
+	READ_STATE_DONE,
+};
+#endif
+
 struct paw3212_data {
 	const struct device          *cs_gpio_dev;
 	const struct device          *irq_gpio_dev;
@@ -124,6 +152,20 @@ struct paw3212_data {
 	enum async_init_step         async_init_step;
 	int                          err;
 	bool                         ready;
+#ifdef CONFIG_PAW3212_ASYNC_READ
+	atomic_t                     read_state;
+	size_t                       read_idx;
+	uint8_t                      read_addr;
+	uint8_t                      read_data[MOTION_DATA_COUNT];
+	struct spi_buf               read_buf;
+	struct spi_buf_set           read_buf_set;
+	struct k_poll_signal         spi_signal;
+	struct k_poll_event          spi_event;
+	struct k_work_poll           spi_work;
+	struct k_timer               read_timer;
+	struct k_work                read_work;
+	uint32_t                     read_start;
+#endif
 };
 
 static const struct spi_config spi_cfg = {
@@ -152,6 +194,14 @@ static int (* const async_init_fn[ASYNC_INIT_STEP_COUNT])(struct paw3212_data *d
 };
 
 
+static const uint8_t motion_data_reg[MOTION_DATA_COUNT] = {
+	[MOTION_DATA_STATUS]  = PAW3212_REG_MOTION,
+	[MOTION_DATA_X_LOW]   = PAW3212_REG_DELTA_X_LOW,
+	[MOTION_DATA_Y_LOW]   = PAW3212_REG_DELTA_Y_LOW,
+	[MOTION_DATA_XY_HIGH] = PAW3212_REG_DELTA_XY_HIGH,
+};
+
+
 static struct paw3212_data paw3212_data;
 
 static int16_t expand_s12(int16_t x)
@@ -550,7 +600,7 @@ static void irq_handler(const struct device *gpiob, struct gpio_callback *cb,
 	k_work_submit(&paw3212_data.trigger_handler_work);
 }
 
-static void trigger_handler(struct k_work *work)
+static void data_ready_notify(void)
 {
 	sensor_trigger_handler_t handler;
 	int err = 0;
@@ -584,6 +634,270 @@ static void trigger_handler(struct k_work *work)
 	}
 }
 
+#ifdef CONFIG_PAW3212_PROFILER_ENABLED
+static uint16_t motion_read_event_id;
+
+static void profile_motion_read(uint32_t start, bool async)
+{
+	if (!is_profiling_enabled(motion_read_event_id)) {
+		return;
+	}
+
+	struct log_event_buf buf;
+
+	profiler_log_start(&buf);
+	profiler_log_encode_u32(&buf,
+				k_cyc_to_us_floor32(k_cycle_get_32() - start));
+	profiler_log_encode_u8(&buf, async);
+	profiler_log_send(&buf, motion_read_event_id);
+}
+
+static void register_profiler_events(void)
+{
+	static const char *arg_names[] = {"duration_us", "async"};
+	static const enum profiler_arg arg_types[] = {PROFILER_ARG_U32,
+						      PROFILER_ARG_U8};
+
+	motion_read_event_id = profiler_register_event_type("paw3212_motion_read",
+							    arg_names, arg_types,
+							    ARRAY_SIZE(arg_types));
+}
+#else
+static void profile_motion_read(uint32_t start, bool async) {}
+static void register_profiler_events(void) {}
+#endif /* CONFIG_PAW3212_PROFILER_ENABLED */
+
+#ifdef CONFIG_PAW3212_ASYNC_READ
+static bool bus_claim(struct paw3212_data *dev_data)
+{
+	return atomic_cas(&dev_data->read_state, READ_STATE_IDLE,
+			  READ_STATE_SYNC);
+}
+
+static void bus_release(struct paw3212_data *dev_data)
+{
+	atomic_set(&dev_data->read_state, READ_STATE_IDLE);
+}
+
+static bool read_data_take(struct paw3212_data *dev_data, uint8_t *data)
+{
+	if (!atomic_cas(&dev_data->read_state, READ_STATE_DONE,
+			READ_STATE_SYNC)) {
+		return false;
+	}
+
+	memcpy(data, dev_data->read_data, sizeof(dev_data->read_data));
+	bus_release(dev_data);
+
+	return true;
+}
+
+/* Drop motion data of an asynchronous read that was not fetched and claim
+ * the bus.
+ */
+static bool read_data_drop(struct paw3212_data *dev_data)
+{
+	return atomic_cas(&dev_data->read_state, READ_STATE_DONE,
+			  READ_STATE_SYNC);
+}
+
+static int read_transfer_start(struct paw3212_data *dev_data, bool read)
+{
+	int err;
+
+	k_poll_signal_reset(&dev_data->spi_signal);
+	dev_data->spi_event.state = K_POLL_STATE_NOT_READY;
+
+	if (read) {
+		dev_data->read_buf.buf = &dev_data->read_data[dev_data->read_idx];
+		dev_data->read_buf.len = 1;
+		err = spi_transceive_async(dev_data->spi_dev, &spi_cfg, NULL,
+					   &dev_data->read_buf_set,
+					   &dev_data->spi_signal);
+	} else {
+		dev_data->read_addr = motion_data_reg[dev_data->read_idx];
+		dev_data->read_buf.buf = &dev_data->read_addr;
+		dev_data->read_buf.len = 1;
+		err = spi_transceive_async(dev_data->spi_dev, &spi_cfg,
+					   &dev_data->read_buf_set, NULL,
+					   &dev_data->spi_signal);
+	}
+
+	if (!err) {
+		err = k_work_poll_submit(&dev_data->spi_work,
+					 &dev_data->spi_event, 1, K_FOREVER);
+	}
+
+	return err;
+}
+
+static int read_reg_start(struct paw3212_data *dev_data)
+{
+	atomic_set(&dev_data->read_state, READ_STATE_ADDR);
+
+	int err = spi_cs_ctrl(dev_data, true);
+
+	if (!err) {
+		err = read_transfer_start(dev_data, false);
+	}
+
+	return err;
+}
+
+static void read_async_done(struct paw3212_data *dev_data, int err)
+{
+	if (err) {
+		LOG_ERR("Asynchronous motion read failed (err %d)", err);
+		spi_cs_ctrl(dev_data, false);
+		bus_release(dev_data);
+	} else {
+		profile_motion_read(dev_data->read_start, true);
+		atomic_set(&dev_data->read_state, READ_STATE_DONE);
+	}
+
+	data_ready_notify();
+}
+
+static int read_async_start(struct paw3212_data *dev_data)
+{
+	if (!atomic_cas(&dev_data->read_state, READ_STATE_IDLE,
+			READ_STATE_ADDR)) {
+		return -EBUSY;
+	}
+
+	dev_data->read_start = k_cycle_get_32();
+	dev_data->read_idx = MOTION_DATA_STATUS;
+	memset(dev_data->read_data, 0, sizeof(dev_data->read_data));
+
+	int err = read_reg_start(dev_data);
+
+	if (err) {
+		LOG_ERR("Cannot start asynchronous motion read");
+		spi_cs_ctrl(dev_data, false);
+		bus_release(dev_data);
+	}
+
+	return err;
+}
+
+static void spi_work_handler(struct k_work *work)
+{
+	struct paw3212_data *dev_data = &paw3212_data;
+	unsigned int signaled;
+	int result;
+
+	ARG_UNUSED(work);
+
+	k_poll_signal_check(&dev_data->spi_signal, &signaled, &result);
+	__ASSERT_NO_MSG(signaled);
+
+	if (result) {
+		read_async_done(dev_data, result);
+		return;
+	}
+
+	if (atomic_get(&dev_data->read_state) == READ_STATE_ADDR) {
+		/* Wait for register value without blocking the work queue. */
+		atomic_set(&dev_data->read_state, READ_STATE_SRAD);
+		k_timer_start(&dev_data->read_timer, K_USEC(T_SRAD), K_NO_WAIT);
+		return;
+	}
+
+	__ASSERT_NO_MSG(atomic_get(&dev_data->read_state) == READ_STATE_DATA);
+
+	int err = spi_cs_ctrl(dev_data, false);
+
+	if (err) {
+		read_async_done(dev_data, err);
+		return;
+	}
+
+	/* Delta registers are read only if motion was detected. */
+	const uint8_t status = dev_data->read_data[MOTION_DATA_STATUS];
+
+	dev_data->read_idx++;
+
+	if ((dev_data->read_idx == MOTION_DATA_READ_COUNT) ||
+	    ((status & PAW3212_MOTION_STATUS_MOTION) == 0)) {
+		read_async_done(dev_data, 0);
+	} else {
+		atomic_set(&dev_data->read_state, READ_STATE_SRX);
+		k_timer_start(&dev_data->read_timer, K_USEC(T_SRX), K_NO_WAIT);
+	}
+}
+
+static void read_timer_handler(struct k_timer *timer)
+{
+	k_work_submit(&paw3212_data.read_work);
+}
+
+static void read_work_handler(struct k_work *work)
+{
+	struct paw3212_data *dev_data = &paw3212_data;
+	int err;
+
+	ARG_UNUSED(work);
+
+	if (atomic_get(&dev_data->read_state) == READ_STATE_SRAD) {
+		atomic_set(&dev_data->read_state, READ_STATE_DATA);
+		err = read_transfer_start(dev_data, true);
+	} else {
+		__ASSERT_NO_MSG(atomic_get(&dev_data->read_state) ==
+				READ_STATE_SRX);
+		err = read_reg_start(dev_data);
+	}
+
+	if (err) {
+		read_async_done(dev_data, err);
+	}
+}
+
+static void read_async_init(struct paw3212_data *dev_data)
+{
+	dev_data->read_buf_set.buffers = &dev_data->read_buf;
+	dev_data->read_buf_set.count = 1;
+
+	k_poll_signal_init(&dev_data->spi_signal);
+	k_poll_event_init(&dev_data->spi_event, K_POLL_TYPE_SIGNAL,
+			  K_POLL_MODE_NOTIFY_ONLY, &dev_data->spi_signal);
+	k_work_poll_init(&dev_data->spi_work, spi_work_handler);
+	k_timer_init(&dev_data->read_timer, read_timer_handler, NULL);
+	k_work_init(&dev_data->read_work, read_work_handler);
+}
+#else
+static bool bus_claim(struct paw3212_data *dev_data) { return true; }
+static void bus_release(struct paw3212_data *dev_data) {}
+
+static bool read_data_take(struct paw3212_data *dev_data, uint8_t *data)
+{
+	return false;
+}
+
+static bool read_data_drop(struct paw3212_data *dev_data)
+{
+	return false;
+}
+
+static int read_async_start(struct paw3212_data *dev_data)
+{
+	return -ENOTSUP;
+}
+
+static void read_async_init(struct paw3212_data *dev_data) {}
+#endif /* CONFIG_PAW3212_ASYNC_READ */
+
+static void trigger_handler(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	/* With asynchronous reads the handler is notified after motion
+	 * data is read.
+	 */
+	if (read_async_start(&paw3212_data)) {
+		data_ready_notify();
+	}
+}
+
 static int paw3212_async_init_power_up(struct paw3212_data *dev_data)
 {
 	return reg_write(dev_data, PAW3212_REG_CONFIGURATION,
@@ -744,6 +1058,8 @@ static int paw3212_init(const struct device *dev)
 	__ASSERT_NO_MSG(-1 == expand_s12(0xFFF));
 
 	k_work_init(&dev_data->trigger_handler_work, trigger_handler);
+	read_async_init(dev_data);
+	register_profiler_events();
 
 	err = paw3212_init_cs(dev_data);
 	if (err) {
@@ -769,11 +1085,33 @@ static int paw3212_init(const struct device *dev)
 	return err;
 }
 
+static int motion_read(struct paw3212_data *dev_data, uint8_t *data)
+{
+	for (size_t i = 0; i < MOTION_DATA_READ_COUNT; i++) {
+		int err = reg_read(dev_data, motion_data_reg[i], &data[i]);
+
+		if (err) {
+			LOG_ERR("Cannot read motion register 0x%02x",
+				motion_data_reg[i]);
+			return err;
+		}
+
+		/* Delta registers are read only if motion was detected. */
+		if ((i == MOTION_DATA_STATUS) &&
+		    ((data[i] & PAW3212_MOTION_STATUS_MOTION) == 0)) {
+			break;
+		}
+	}
+
+	return 0;
+}
+
 static int paw3212_sample_fetch(const struct device *dev, enum sensor_channel chan)
 {
 	struct paw3212_data *dev_data = &paw3212_data;
+	uint8_t data[MOTION_DATA_COUNT] = {0};
 	uint8_t motion_status;
-	int err;
+	int err = 0;
 
 	ARG_UNUSED(dev);
 
@@ -786,15 +1124,30 @@ static int paw3212_sample_fetch(const struct device *dev, enum sensor_channel ch
 		return -EBUSY;
 	}
 
-	err = reg_read(dev_data, PAW3212_REG_MOTION, &motion_status);
-	if (err) {
-		LOG_ERR("Cannot read motion");
-		return err;
+	if (bus_claim(dev_data)) {
+		uint32_t start = k_cycle_get_32();
+
+		err = motion_read(dev_data, data);
+		bus_release(dev_data);
+
+		if (err) {
+			return err;
+		}
+
+		profile_motion_read(start, false);
+	} else if (!read_data_take(dev_data, data)) {
+		/* Asynchronous read is in progress. Its motion data is
+		 * reported after the next data ready trigger.
+		 */
+		LOG_DBG("Motion read in progress");
+		return -EBUSY;
 	}
 
+	motion_status = data[MOTION_DATA_STATUS];
+
 	if ((motion_status & PAW3212_MOTION_STATUS_MOTION) != 0) {
-		uint8_t x_low;
-		uint8_t y_low;
+		uint8_t x_low = data[MOTION_DATA_X_LOW];
+		uint8_t y_low = data[MOTION_DATA_Y_LOW];
 
 		if ((motion_status & PAW3212_MOTION_STATUS_DXOVF) != 0) {
 			LOG_WRN("X delta overflowed");
@@ -803,27 +1156,8 @@ static int paw3212_sample_fetch(const struct device *dev, enum sensor_channel ch
 			LOG_WRN("Y delta overflowed");
 		}
 
-		err = reg_read(dev_data, PAW3212_REG_DELTA_X_LOW, &x_low);
-		if (err) {
-			LOG_ERR("Cannot read X delta");
-			return err;
-		}
-
-		err = reg_read(dev_data, PAW3212_REG_DELTA_Y_LOW, &y_low);
-		if (err) {
-			LOG_ERR("Cannot read Y delta");
-			return err;
-		}
-
 		if (IS_ENABLED(CONFIG_PAW3212_12_BIT_MODE)) {
-			uint8_t xy_high;
-
-			err = reg_read(dev_data, PAW3212_REG_DELTA_XY_HIGH,
-				       &xy_high);
-			if (err) {
-				LOG_ERR("Cannot read XY delta high");
-				return err;
-			}
+			uint8_t xy_high = data[MOTION_DATA_XY_HIGH];
 
 			dev_data->x = PAW3212_DELTA_X(xy_high, x_low);
 			dev_data->y = PAW3212_DELTA_Y(xy_high, y_low);
@@ -930,6 +1264,14 @@ static int paw3212_attr_set(const struct device *dev, enum sensor_channel chan,
 		return -EBUSY;
 	}
 
+	/* Motion data that was read asynchronously, but not fetched,
+	 * would keep the bus claimed.
+	 */
+	if (unlikely(!bus_claim(dev_data) && !read_data_drop(dev_data))) {
+		LOG_DBG("Motion read in progress");
+		return -EBUSY;
+	}
+
 	switch ((uint32_t)attr) {
 	case PAW3212_ATTR_CPI:
 		err = update_cpi(dev_data, PAW3212_SVALUE_TO_CPI(*val));
@@ -980,9 +1322,12 @@ static int paw3212_attr_set(const struct device *dev, enum sensor_channel chan,
 
 	default:
 		LOG_ERR("Unknown attribute");
-		return -ENOTSUP;
+		err = -ENOTSUP;
+		break;
 	}
 
+	bus_release(dev_data);
+
 	return err;
 }
 
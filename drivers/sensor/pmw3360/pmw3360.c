@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
  */
 
+#include <string.h>
 #include <zephyr.h>
 #include <kernel.h>
 #include <drivers/sensor.h>
@@ -12,6 +13,7 @@
 #include <drivers/gpio.h>
 #include <sys/byteorder.h>
 #include <sensor/pmw3360.h>
+#include <profiler.h>
 
 #include <logging/log.h>
 LOG_MODULE_REGISTER(pmw3360, CONFIG_PMW3360_LOG_LEVEL);
@@ -128,6 +130,17 @@ enum async_init_step {
 	ASYNC_INIT_STEP_COUNT
 };
 
+#ifdef CONFIG_PMW3360_ASYNC_BURST
+enum burst_state {
+	BURST_STATE_IDLE,
+	BURST_STATE_SYNC,
+	BURST_STATE_ADDR,
+	BURST_STATE_DATA,
+	BURST_STATE_EXIT,
+	BURST_STATE_DONE,
+};
+#endif
+
 struct pmw3360_data {
 	const struct device          *cs_gpio_dev;
 	const struct device          *irq_gpio_dev;
@@ -143,6 +156,19 @@ struct pmw3360_data {
 	int                          err;
 	bool                         ready;
 	bool                         last_read_burst;
+#ifdef CONFIG_PMW3360_ASYNC_BURST
+	atomic_t                     burst_state;
+	uint8_t                      burst_addr;
+	uint8_t                      burst_data[PMW3360_BURST_SIZE];
+	struct spi_buf               burst_buf;
+	struct spi_buf_set           burst_buf_set;
+	struct k_poll_signal         spi_signal;
+	struct k_poll_event          spi_event;
+	struct k_work_poll           spi_work;
+	struct k_timer               burst_timer;
+	struct k_work                burst_work;
+	uint32_t                     burst_start;
+#endif
 };
 
 static const struct spi_config spi_cfg = {
@@ -691,7 +717,7 @@ static void irq_handler(const struct device *gpiob, struct gpio_callback *cb,
 	k_work_submit(&pmw3360_data.trigger_handler_work);
 }
 
-static void trigger_handler(struct k_work *work)
+static void data_ready_notify(void)
 {
 	sensor_trigger_handler_t handler;
 	int err = 0;
@@ -725,6 +751,259 @@ static void trigger_handler(struct k_work *work)
 	}
 }
 
+#ifdef CONFIG_PMW3360_PROFILER_ENABLED
+static uint16_t motion_read_event_id;
+
+static void profile_motion_read(uint32_t start, bool async)
+{
+	if (!is_profiling_enabled(motion_read_event_id)) {
+		return;
+	}
+
+	struct log_event_buf buf;
+
+	profiler_log_start(&buf);
+	profiler_log_encode_u32(&buf,
+				k_cyc_to_us_floor32(k_cycle_get_32() - start));
+	profiler_log_encode_u8(&buf, async);
+	profiler_log_send(&buf, motion_read_event_id);
+}
+
+static void register_profiler_events(void)
+{
+	static const char *arg_names[] = {"duration_us", "async"};
+	static const enum profiler_arg arg_types[] = {PROFILER_ARG_U32,
+						      PROFILER_ARG_U8};
+
+	motion_read_event_id = profiler_register_event_type("pmw3360_motion_read",
+							    arg_names, arg_types,
+							    ARRAY_SIZE(arg_types));
+}
+#else
+static void profile_motion_read(uint32_t start, bool async) {}
+static void register_profiler_events(void) {}
+#endif /* CONFIG_PMW3360_PROFILER_ENABLED */
+
+#ifdef CONFIG_PMW3360_ASYNC_BURST
+static bool bus_claim(struct pmw3360_data *dev_data)
+{
+	return atomic_cas(&dev_data->burst_state, BURST_STATE_IDLE,
+			  BURST_STATE_SYNC);
+}
+
+static void bus_release(struct pmw3360_data *dev_data)
+{
+	atomic_set(&dev_data->burst_state, BURST_STATE_IDLE);
+}
+
+static bool burst_data_take(struct pmw3360_data *dev_data, uint8_t *data)
+{
+	if (!atomic_cas(&dev_data->burst_state, BURST_STATE_DONE,
+			BURST_STATE_SYNC)) {
+		return false;
+	}
+
+	memcpy(data, dev_data->burst_data, sizeof(dev_data->burst_data));
+	bus_release(dev_data);
+
+	return true;
+}
+
+/* Drop motion data of an asynchronous burst that was not fetched and claim
+ * the bus.
+ */
+static bool burst_data_drop(struct pmw3360_data *dev_data)
+{
+	return atomic_cas(&dev_data->burst_state, BURST_STATE_DONE,
+			  BURST_STATE_SYNC);
+}
+
+static int burst_transfer_start(struct pmw3360_data *dev_data, bool read)
+{
+	int err;
+
+	k_poll_signal_reset(&dev_data->spi_signal);
+	dev_data->spi_event.state = K_POLL_STATE_NOT_READY;
+
+	if (read) {
+		dev_data->burst_buf.buf = dev_data->burst_data;
+		dev_data->burst_buf.len = sizeof(dev_data->burst_data);
+		err = spi_transceive_async(dev_data->spi_dev, &spi_cfg, NULL,
+					   &dev_data->burst_buf_set,
+					   &dev_data->spi_signal);
+	} else {
+		dev_data->burst_buf.buf = &dev_data->burst_addr;
+		dev_data->burst_buf.len = sizeof(dev_data->burst_addr);
+		err = spi_transceive_async(dev_data->spi_dev, &spi_cfg,
+					   &dev_data->burst_buf_set, NULL,
+					   &dev_data->spi_signal);
+	}
+
+	if (!err) {
+		err = k_work_poll_submit(&dev_data->spi_work,
+					 &dev_data->spi_event, 1, K_FOREVER);
+	}
+
+	return err;
+}
+
+static void burst_async_done(struct pmw3360_data *dev_data, int err)
+{
+	int cs_err = spi_cs_ctrl(dev_data, false);
+
+	if (!err) {
+		err = cs_err;
+	}
+
+	if (err) {
+		LOG_ERR("Asynchronous motion burst failed (err %d)", err);
+		dev_data->last_read_burst = false;
+		bus_release(dev_data);
+		data_ready_notify();
+		return;
+	}
+
+	/* Wait for burst exit without blocking the work queue. */
+	atomic_set(&dev_data->burst_state, BURST_STATE_EXIT);
+	k_timer_start(&dev_data->burst_timer, K_USEC(T_BEXIT), K_NO_WAIT);
+}
+
+static int burst_async_start(struct pmw3360_data *dev_data)
+{
+	int err;
+
+	/* The motion burst register must be written after any other SPI
+	 * transmission, synchronous read is used in that case.
+	 */
+	if (!dev_data->last_read_burst) {
+		return -EAGAIN;
+	}
+
+	if (!atomic_cas(&dev_data->burst_state, BURST_STATE_IDLE,
+			BURST_STATE_ADDR)) {
+		return -EBUSY;
+	}
+
+	dev_data->burst_start = k_cycle_get_32();
+
+	err = spi_cs_ctrl(dev_data, true);
+	if (!err) {
+		err = burst_transfer_start(dev_data, false);
+	}
+
+	if (err) {
+		LOG_ERR("Cannot start asynchronous motion burst");
+		spi_cs_ctrl(dev_data, false);
+		dev_data->last_read_burst = false;
+		bus_release(dev_data);
+	}
+
+	return err;
+}
+
+static void spi_work_handler(struct k_work *work)
+{
+	struct pmw3360_data *dev_data = &pmw3360_data;
+	unsigned int signaled;
+	int result;
+
+	ARG_UNUSED(work);
+
+	k_poll_signal_check(&dev_data->spi_signal, &signaled, &result);
+	__ASSERT_NO_MSG(signaled);
+
+	if (result) {
+		burst_async_done(dev_data, result);
+		return;
+	}
+
+	if (atomic_get(&dev_data->burst_state) == BURST_STATE_ADDR) {
+		/* Wait for motion data without blocking the work queue. */
+		k_timer_start(&dev_data->burst_timer, K_USEC(T_SRAD_MOTBR),
+			      K_NO_WAIT);
+	} else {
+		__ASSERT_NO_MSG(atomic_get(&dev_data->burst_state) ==
+				BURST_STATE_DATA);
+		burst_async_done(dev_data, 0);
+	}
+}
+
+static void burst_timer_handler(struct k_timer *timer)
+{
+	k_work_submit(&pmw3360_data.burst_work);
+}
+
+static void burst_work_handler(struct k_work *work)
+{
+	struct pmw3360_data *dev_data = &pmw3360_data;
+
+	ARG_UNUSED(work);
+
+	if (atomic_get(&dev_data->burst_state) == BURST_STATE_EXIT) {
+		profile_motion_read(dev_data->burst_start, true);
+		atomic_set(&dev_data->burst_state, BURST_STATE_DONE);
+		data_ready_notify();
+		return;
+	}
+
+	__ASSERT_NO_MSG(atomic_get(&dev_data->burst_state) ==
+			BURST_STATE_ADDR);
+	atomic_set(&dev_data->burst_state, BURST_STATE_DATA);
+
+	int err = burst_transfer_start(dev_data, true);
+
+	if (err) {
+		burst_async_done(dev_data, err);
+	}
+}
+
+static void burst_async_init(struct pmw3360_data *dev_data)
+{
+	dev_data->burst_addr = PMW3360_REG_MOTION_BURST;
+	dev_data->burst_buf_set.buffers = &dev_data->burst_buf;
+	dev_data->burst_buf_set.count = 1;
+
+	k_poll_signal_init(&dev_data->spi_signal);
+	k_poll_event_init(&dev_data->spi_event, K_POLL_TYPE_SIGNAL,
+			  K_POLL_MODE_NOTIFY_ONLY, &dev_data->spi_signal);
+	k_work_poll_init(&dev_data->spi_work, spi_work_handler);
+	k_timer_init(&dev_data->burst_timer, burst_timer_handler, NULL);
+	k_work_init(&dev_data->burst_work, burst_work_handler);
+}
+#else
+static bool bus_claim(struct pmw3360_data *dev_data) { return true; }
+static void bus_release(struct pmw3360_data *dev_data) {}
+
+static bool burst_data_take(struct pmw3360_data *dev_data, uint8_t *data)
+{
+	return false;
+}
+
+static bool burst_data_drop(struct pmw3360_data *dev_data)
+{
+	return false;
+}
+
+static int burst_async_start(struct pmw3360_data *dev_data)
+{
+	return -ENOTSUP;
+}
+
+static void burst_async_init(struct pmw3360_data *dev_data) {}
+#endif /* CONFIG_PMW3360_ASYNC_BURST */
+
+static void trigger_handler(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	/* With asynchronous bursts the handler is notified after motion
+	 * data is read.
+	 */
+	if (burst_async_start(&pmw3360_data)) {
+		data_ready_notify();
+	}
+}
+
 static int pmw3360_async_init_power_up(struct pmw3360_data *dev_data)
 {
 	/* Reset sensor */
@@ -855,6 +1134,8 @@ static int pmw3360_init(const struct device *dev)
 	ARG_UNUSED(dev);
 
 	k_work_init(&dev_data->trigger_handler_work, trigger_handler);
+	burst_async_init(dev_data);
+	register_profiler_events();
 
 	err = pmw3360_init_cs(dev_data);
 	if (err) {
@@ -884,6 +1165,7 @@ static int pmw3360_sample_fetch(const struct device *dev, enum sensor_channel ch
 {
 	struct pmw3360_data *dev_data = &pmw3360_data;
 	uint8_t data[PMW3360_BURST_SIZE];
+	int err = 0;
 
 	ARG_UNUSED(dev);
 
@@ -892,7 +1174,22 @@ static int pmw3360_sample_fetch(const struct device *dev, enum sensor_channel ch
 		return -EBUSY;
 	}
 
-	int err = motion_burst_read(dev_data, data, sizeof(data));
+	if (bus_claim(dev_data)) {
+		uint32_t start = k_cycle_get_32();
+
+		err = motion_burst_read(dev_data, data, sizeof(data));
+		bus_release(dev_data);
+
+		if (!err) {
+			profile_motion_read(start, false);
+		}
+	} else if (!burst_data_take(dev_data, data)) {
+		/* Asynchronous burst is in progress. Its motion data is
+		 * reported after the next data ready trigger.
+		 */
+		LOG_DBG("Motion burst in progress");
+		err = -EBUSY;
+	}
 
 	if (!err) {
 		int16_t x = sys_get_le16(&data[PMW3360_DX_POS]);
@@ -1007,6 +1304,14 @@ static int pmw3360_attr_set(const struct device *dev, enum sensor_channel chan,
 		return -EBUSY;
 	}
 
+	/* Motion data that was read asynchronously, but not fetched,
+	 * would keep the bus claimed.
+	 */
+	if (unlikely(!bus_claim(dev_data) && !burst_data_drop(dev_data))) {
+		LOG_DBG("Motion burst in progress");
+		return -EBUSY;
+	}
+
 	switch ((uint32_t)attr) {
 	case PMW3360_ATTR_CPI:
 		err = update_cpi(dev_data, PMW3360_SVALUE_TO_CPI(*val));
@@ -1059,9 +1364,12 @@ static int pmw3360_attr_set(const struct device *dev, enum sensor_channel chan,
 
 	default:
 		LOG_ERR("Unknown attribute");
-		return -ENOTSUP;
+		err = -ENOTSUP;
+		break;
 	}
 
+	bus_release(dev_data);
+
 	return err;
 }
 
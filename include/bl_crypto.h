@@ -97,6 +97,53 @@ int bl_root_of_trust_verify_external(const uint8_t *public_key,
 				     const uint32_t firmware_len);
 
 
+/**
+ * @brief Calculate a SHA-256 digest in one operation.
+ *
+ * Unlike the EXT_API safe functions, this function can use the large static
+ * buffers of the bootloader. It is not available through EXT_API.
+ *
+ * @param[in]  data      The data to hash.
+ * @param[in]  data_len  The length of @p data.
+ * @param[out] output    Where to put the resulting digest. Must be at least
+ *                       32 bytes long.
+ *
+ * @retval 0  On success.
+ * @return Any error code from @ref bl_sha256_init, @ref bl_sha256_update, or
+ *         @ref bl_sha256_finalize if something went wrong.
+ */
+int bl_sha256_digest(const uint8_t *data, uint32_t data_len, uint8_t *output);
+
+
+/**
+ * @brief Verify a signature over an already calculated firmware digest.
+ *
+ * Same as @ref bl_root_of_trust_verify, but takes the SHA-256 digest of the
+ * firmware instead of the firmware itself. This allows the caller to measure
+ * and reuse the digest calculation. This function is not available through
+ * EXT_API.
+ *
+ * @param[in]  public_key       Public key.
+ * @param[in]  public_key_hash  Expected hash of the public key. This is the
+ *                              root of trust.
+ * @param[in]  signature        Firmware signature.
+ * @param[in]  firmware_digest  SHA-256 digest of the firmware.
+ *
+ * @retval 0          On success.
+ * @retval -EHASHINV  If public_key_hash didn't match public_key.
+ * @retval -ESIGINV   If signature validation failed.
+ * @return Any error code from @ref bl_sha256_init, @ref bl_sha256_update,
+ *         @ref bl_sha256_finalize, or @ref bl_secp256r1_validate if something
+ *         else went wrong.
+ *
+ * @remark No parameter can be NULL.
+ */
+int bl_root_of_trust_verify_digest(const uint8_t *public_key,
+				   const uint8_t *public_key_hash,
+				   const uint8_t *signature,
+				   const uint8_t *firmware_digest);
+
+
 /**
  * @brief Initialize a sha256 operation context variable.
  *
@@ -264,9 +264,17 @@ const struct bt_gatt_dm_attr *bt_gatt_dm_desc_next(
  * This function is asynchronous. Discovery results are passed through
  * the supplied callback.
  *
- * @note Only one discovery procedure can be started simultaneously. To start
- * another one, wait for the result of the previous procedure to finish
- * and call @ref bt_gatt_dm_data_release if it was successful.
+ * @note Only one discovery procedure can be started simultaneously on a given
+ * connection. To start another one, wait for the result of the previous
+ * procedure to finish and call @ref bt_gatt_dm_data_release if it was
+ * successful. Procedures on different connections can run simultaneously
+ * if CONFIG_BT_GATT_DM_MAX_INSTANCES allows it. When all instances are in
+ * use, an instance of another connection whose data was released is taken
+ * over, so the discovery on that connection can no longer be continued.
+ *
+ * @note If CONFIG_BT_GATT_DM_CACHE is enabled, @p svc_uuid is set and the
+ * peer is bonded, the service may be restored from the cache without
+ * discovering it.
  *
  * @param[in]     conn Connection object.
  * @param[in]     svc_uuid UUID of target service
@@ -280,7 +288,10 @@ const struct bt_gatt_dm_attr *bt_gatt_dm_desc_next(
  * To process the next service, call @ref bt_gatt_dm_continue.
  *
  * @retval 0 If the operation was successful.
- *           Otherwise, a (negative) error code is returned.
+ * @retval -EALREADY If a discovery procedure is already running on
+ *         the connection.
+ * @retval -ENOMEM If no Discovery Manager instance is available.
+ * @return Other negative error code if the discovery could not be started.
  */
 int bt_gatt_dm_start(struct bt_conn *conn,
 		     const struct bt_uuid *svc_uuid,
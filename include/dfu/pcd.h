@@ -17,6 +17,11 @@
  * The cores communicate through a command structure (CMD) which is stored in
  * a shared memory location.
  *
+ * The image can either be read by the peripheral core directly from its
+ * location in flash, or be streamed through slots placed in the shared memory
+ * after the CMD. Streaming lets the generic core provide the image from any
+ * source, for example from external flash.
+ *
  * The nRF5340 is an example of a system with these properties.
  */
 
@@ -43,6 +48,14 @@ extern "C" {
 
 #endif
 
+/** Size of a single stream slot. Must be a multiple of the flash page size
+ *  of the peripheral core.
+ */
+#define PCD_STREAM_SLOT_SIZE 2048
+
+/** Number of stream slots in the shared memory. */
+#define PCD_STREAM_SLOT_CNT 2
+
 enum pcd_status {
 	PCD_STATUS_COPY = 0,
 	PCD_STATUS_COPY_DONE = 1,
@@ -61,6 +74,37 @@ enum pcd_status {
  */
 int pcd_network_core_update(const void *src_addr, size_t len);
 
+/** @brief Read callback used for streamed updates.
+ *
+ * @param ctx User context passed to @ref pcd_network_core_update_stream.
+ * @param offset Offset of the data within the image.
+ * @param buf Buffer to read the data into.
+ * @param len Number of bytes to read.
+ *
+ * @retval 0 on success, negative errno code on failure.
+ */
+typedef int (*pcd_stream_read_t)(void *ctx, size_t offset, void *buf,
+				 size_t len);
+
+/** @brief Update the network core, streaming the image through shared memory.
+ *
+ * The image is read in chunks of @ref PCD_STREAM_SLOT_SIZE with the provided
+ * callback while the network core programs the previous chunks. The image
+ * does not need to be readable by the network core.
+ *
+ * The image is not validated by the network core before it is copied, so it
+ * must be validated by the caller.
+ *
+ * @param read Callback used to read the image.
+ * @param ctx User context passed to the callback.
+ * @param len Length of the image.
+ *
+ * @retval 0 on success, negative errno code or PCD_STATUS_COPY_FAILED on
+ *         failure.
+ */
+int pcd_network_core_update_stream(pcd_stream_read_t read, void *ctx,
+				   size_t len);
+
 /** @brief Lock the RAM section used for IPC with the network core bootloader.
  */
 void pcd_lock_ram(void);
@@ -84,14 +128,22 @@ enum pcd_status pcd_fw_copy_status_get(void);
 
 /** @brief Get value of 'data' member of pcd cmd.
  *
- * @retval value of 'data' member.
+ * @retval value of 'data' member, NULL if the image is streamed.
  */
 const void *pcd_cmd_data_ptr_get(void);
 
+/** @brief Get the number of bytes copied by the ongoing or last transfer.
+ *
+ * @retval Number of bytes copied.
+ */
+size_t pcd_fw_copy_progress_get(void);
+
 /** @brief Perform the DFU image transfer.
  *
  * Use the information in the PCD CMD to load a DFU image to the
- * provided flash device.
+ * provided flash device. The image is copied page by page. Pages which
+ * already hold the image data are not erased, so an interrupted transfer
+ * only programs the remaining pages when it is started again.
  *
  * @param fdev The flash device to transfer the DFU image to.
  *
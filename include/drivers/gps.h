@@ -65,6 +65,50 @@ struct gps_pvt {
 	struct gps_sv sv[GPS_PVT_MAX_SV_COUNT];
 };
 
+/* Flags of a compact PVT sample. */
+#define GPS_PVT_SAMPLE_FLAG_FIX		BIT(0)
+
+/* Compact fixed-point representation of a PVT estimate, used in batched mode.
+ */
+struct gps_pvt_sample {
+	uint32_t time;		/**< UTC time, seconds since the Unix epoch. */
+	int32_t latitude;	/**< Latitude in 1e-7 degrees. */
+	int32_t longitude;	/**< Longitude in 1e-7 degrees. */
+	int16_t altitude;	/**< Altitude in meters. */
+	uint16_t accuracy;	/**< Accuracy in decimeters. */
+	uint16_t speed;		/**< Horizontal speed in cm/s. */
+	uint16_t heading;	/**< Heading in 0.01 degrees. */
+	uint8_t hdop;		/**< Horizontal dilution of precision * 10. */
+	uint8_t sv_used;	/**< Number of satellites used in the fix. */
+	uint8_t flags;		/**< GPS_PVT_SAMPLE_FLAG_* flags. */
+	uint8_t reserved;
+};
+
+/* Batched PVT delivery configuration. Values that do not fit a field of
+ * struct gps_pvt_sample are saturated.
+ */
+struct gps_batch_config {
+	/* Buffer for the samples, provided by the application. NULL disables
+	 * batching, in which case every PVT estimate is delivered as a
+	 * separate event.
+	 */
+	struct gps_pvt_sample *buf;
+
+	/* Number of samples the buffer can hold. GPS_EVT_PVT_BATCH is sent
+	 * when the buffer is full.
+	 */
+	uint16_t size;
+
+	/* GPS_EVT_PVT_BATCH is also sent when a sample is added and the
+	 * oldest sample in the batch is at least this many seconds old.
+	 * 0 disables the age threshold.
+	 */
+	uint16_t max_age;
+
+	/* Store also PVT estimates without a valid fix. */
+	bool include_no_fix;
+};
+
 enum gps_nav_mode {
 	/* Search will be stopped after first fix. */
 	GPS_NAV_MODE_SINGLE_FIX,
@@ -146,6 +190,12 @@ struct gps_config {
 	 * case of nRF9160.
 	 */
 	bool priority;
+
+	/* Batched PVT delivery. When enabled, PVT estimates are stored in the
+	 * provided buffer instead of being delivered one by one, and NMEA
+	 * strings are not produced.
+	 */
+	struct gps_batch_config batch;
 };
 
 /* Flags indicating which AGPS assistance data set is written to the GPS module.
@@ -193,6 +243,7 @@ enum gps_event_type {
 	GPS_EVT_OPERATION_UNBLOCKED,
 	GPS_EVT_AGPS_DATA_NEEDED,
 	GPS_EVT_ERROR,
+	GPS_EVT_PVT_BATCH,
 };
 
 /**
@@ -202,10 +253,19 @@ enum gps_error {
 	GPS_ERROR_GPS_DISABLED,
 };
 
+/* Batch of PVT samples. The samples point to the buffer provided in
+ * struct gps_batch_config and are valid only until the event handler returns.
+ */
+struct gps_pvt_batch {
+	const struct gps_pvt_sample *samples;
+	size_t count;
+};
+
 struct gps_event {
 	enum gps_event_type type;
 	union {
 		struct gps_pvt pvt;
+		struct gps_pvt_batch pvt_batch;
 		struct gps_nmea nmea;
 		struct gps_agps_request agps_request;
 		enum gps_error error;
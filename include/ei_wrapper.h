@@ -34,6 +34,124 @@ extern "C" {
 typedef void (*ei_wrapper_result_ready_cb)(int err);
 
 
+struct ei_wrapper_model;
+
+/**
+ * @typedef ei_wrapper_model_run_t
+ * @brief Function executed by the wrapper to process the input window.
+ *
+ * The function is called from one of the wrapper's threads. Use
+ * @ref ei_wrapper_model_get_data to read the input window.
+ *
+ * @param[in] model Model to be run.
+ *
+ * @return Zero (if operation was successful) or error code that is passed to
+ *         the result ready callback.
+ */
+typedef int (*ei_wrapper_model_run_t)(struct ei_wrapper_model *model);
+
+/**
+ * @typedef ei_wrapper_model_result_ready_cb
+ * @brief Callback executed by the wrapper after the model is run.
+ *
+ * @param[in] model Model that was run.
+ * @param[in] err   Value returned by the model's run function.
+ */
+typedef void (*ei_wrapper_model_result_ready_cb)(struct ei_wrapper_model *model,
+						 int err);
+
+/**
+ * @brief Model processing the input data.
+ *
+ * All of the models registered in the wrapper share the input data buffer.
+ * Every model has its own input window position, so the models can process
+ * the same input data with different window sizes and window shifts.
+ *
+ * The structure must be zero-initialized before the public members are set.
+ */
+struct ei_wrapper_model {
+	/** Size of the input frame, expressed as a number of floating-point
+	 *  values.
+	 */
+	size_t frame_size;
+
+	/** Size of the input window, expressed as a number of floating-point
+	 *  values. Must be divisible by the input frame size.
+	 */
+	size_t window_size;
+
+	/** Model priority. If more models are ready to be run, the model with
+	 *  lower value is run first.
+	 */
+	uint8_t priority;
+
+	/** Function that runs the model. */
+	ei_wrapper_model_run_t run;
+
+	/** Callback executed after the model is run. */
+	ei_wrapper_model_result_ready_cb result_ready_cb;
+
+	/* Private fields used by the wrapper. */
+	sys_snode_t node;
+	sys_snode_t ready_node;
+	size_t process_idx;
+	size_t wait_data_size;
+	k_tid_t thread;
+	uint8_t state;
+	bool data_ready;
+	bool resubmit;
+};
+
+
+/** Register a model in the wrapper.
+ *
+ * The model processes only the input data added after the registration.
+ * The input data is kept in the buffer until the input windows of all of
+ * the registered models are shifted past it.
+ *
+ * @param[in] model Model to be registered.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int ei_wrapper_model_register(struct ei_wrapper_model *model);
+
+
+/** Start a prediction using the given model.
+ *
+ * See @ref ei_wrapper_start_prediction for details.
+ *
+ * @param[in] model         Registered model.
+ * @param[in] window_shift  Number of windows the input window is shifted before
+ *                          prediction.
+ * @param[in] frame_shift   Number of frames the input window is shifted before
+ *                          prediction.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int ei_wrapper_model_start_prediction(struct ei_wrapper_model *model,
+				      size_t window_shift, size_t frame_shift);
+
+
+/** Read the input window of a model.
+ *
+ * This function can be executed only from the model's run function.
+ * Otherwise, it returns a (negative) error code.
+ *
+ * @param[in]  model   Model that is run.
+ * @param[in]  offset  Offset in the input window, expressed as a number of
+ *                     floating-point values.
+ * @param[in]  length  Number of floating-point values to read.
+ * @param[out] out_ptr Pointer to the buffer for the read values.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int ei_wrapper_model_get_data(const struct ei_wrapper_model *model,
+			      size_t offset, size_t length, float *out_ptr);
+
+
 /** Check if classifier calculates anomaly value.
  *
  * @retval true If the classifier calculates the anomaly value.
@@ -58,9 +176,18 @@ size_t ei_wrapper_get_frame_size(void);
 size_t ei_wrapper_get_window_size(void);
 
 
+/** Get the size of memory used by the input data buffer.
+ *
+ * @return Size of the input data buffer, expressed in bytes.
+ */
+size_t ei_wrapper_get_data_buf_mem_size(void);
+
+
 /** Add input data for the library.
  *
- * Size of the added data must be divisible by input frame size.
+ * Size of the added data must be divisible by input frame size of every
+ * registered model. The data is rejected with -ENOENT if no model is
+ * registered.
  *
  * @param[in] data       Pointer to the buffer with input data.
  * @param[in] data_size  Size of the data (number of floating-point values).
@@ -72,6 +199,8 @@ int ei_wrapper_add_data(const float *data, size_t data_size);
 
 
 /** Clear all buffered data.
+ *
+ * The input windows of all of the registered models are reset.
  *
  * @retval 0 If the operation was successful.
  *           Otherwise, a (negative) error code is returned.
@@ -143,6 +272,10 @@ int ei_wrapper_get_timing(int *dsp_time, int *classification_time,
 
 
 /** Initialize the Edge Impulse wrapper.
+ *
+ * The function registers the Edge Impulse impulse built into the application
+ * as a model. Functions that do not take the model as a parameter refer to
+ * this model.
  *
  * @param[in] cb Callback used to receive results.
  *
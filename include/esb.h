@@ -209,12 +209,44 @@ struct esb_payload {
 	uint8_t data[CONFIG_ESB_MAX_PAYLOAD_LENGTH]; /**< The payload data. */
 };
 
+/** @brief Enhanced ShockBurst payload buffer.
+ *
+ *  The buffer is loaned from the module, so that the radio transmits or
+ *  receives the payload data without it being copied.
+ */
+struct esb_buf {
+	uint8_t *data;  /**< The payload data, stored in the module. */
+	uint8_t length; /**< Length of the payload data. */
+	uint8_t pipe;   /**< Pipe used for this payload. */
+	int8_t rssi;    /**< RSSI for the received packet. */
+	uint8_t noack;  /**< Flag indicating that this packet will not be
+			 *  acknowledged. Flag is ignored when selective auto
+			 *  ack is enabled.
+			 */
+	uint8_t pid;    /**< PID assigned during communication. */
+};
+
 /** @brief Enhanced ShockBurst event. */
 struct esb_evt {
 	enum esb_evt_id evt_id;	/**< Enhanced ShockBurst event ID. */
 	uint32_t tx_attempts;	/**< Number of TX retransmission attempts. */
 };
 
+/** @brief Link statistics of a frequency hopping channel. */
+struct esb_chn_stats {
+	uint8_t channel;	/**< Radio channel. */
+	bool enabled;		/**< The channel is used for hopping. */
+	uint8_t per;		/**< Packet error rate in percent, measured
+				 *  in the last evaluation window.
+				 */
+	uint32_t tx_attempts;	/**< Transmission attempts that required an
+				 *  acknowledgment.
+				 */
+	uint32_t tx_success;	/**< Acknowledged transmission attempts. */
+	uint32_t rx_packets;	/**< Packets received with a valid CRC. */
+	uint32_t rx_crc_errors;	/**< Packets received with a CRC error. */
+};
+
 /** @brief Event handler prototype. */
 typedef void (*esb_event_handler)(const struct esb_evt *event);
 
@@ -308,6 +340,63 @@ int esb_write_payload(const struct esb_payload *payload);
  */
 int esb_read_rx_payload(struct esb_payload *payload);
 
+/** @brief Allocate a buffer for transmission or acknowledgement.
+ *
+ *  The payload data is written directly to the buffer that is used by the
+ *  radio, instead of being copied from an @ref esb_payload structure.
+ *  Only one buffer can be allocated at a time, and @ref esb_write_payload
+ *  cannot be used until the buffer is submitted or discarded. Flushing the
+ *  TX buffer also discards the allocated buffer.
+ *
+ *  @param[out] buf	The allocated buffer.
+ *
+ * @retval 0 If successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int esb_tx_buf_alloc(struct esb_buf *buf);
+
+/** @brief Queue an allocated buffer for transmission or acknowledgement.
+ *
+ *  Before calling this function, set the payload length, the pipe, and the
+ *  noack flag of the buffer.
+ *
+ *  @param[in] buf	The buffer allocated with @ref esb_tx_buf_alloc.
+ *
+ * @retval 0 If successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int esb_tx_buf_submit(const struct esb_buf *buf);
+
+/** @brief Discard an allocated buffer without queuing it.
+ *
+ *  @param[in] buf	The buffer allocated with @ref esb_tx_buf_alloc.
+ *
+ * @retval 0 If successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int esb_tx_buf_discard(const struct esb_buf *buf);
+
+/** @brief Get the oldest received payload without copying it.
+ *
+ *  The buffer points to the data received by the radio. The buffer stays
+ *  in the RX buffer until it is released with @ref esb_rx_buf_release.
+ *
+ *  @param[out] buf	The received buffer.
+ *
+ * @retval 0 If successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int esb_rx_buf_get(struct esb_buf *buf);
+
+/** @brief Release a received buffer.
+ *
+ *  @param[in] buf	The buffer obtained with @ref esb_rx_buf_get.
+ *
+ * @retval 0 If successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int esb_rx_buf_release(const struct esb_buf *buf);
+
 /** @brief Start transmitting data.
  *
  * @retval 0 If successful.
@@ -432,6 +521,66 @@ int esb_update_prefix(uint8_t pipe, uint8_t prefix);
  */
 int esb_set_rf_channel(uint32_t channel);
 
+/** @brief Set the channels used for frequency hopping.
+ *
+ *  Both the PTX and the PRX must use the same channels in the same order,
+ *  and the same retransmit delay. The PTX moves to the next channel after
+ *  @option{CONFIG_ESB_HOP_ATTEMPTS} failed transmission attempts on the
+ *  current channel. The PRX stays on its channel as long as it receives
+ *  packets, and moves to the next channel if no packet is received for
+ *  long enough for the PTX to try all channels. The retransmit count of
+ *  the PTX should therefore allow trying several channels.
+ *
+ *  The PTX stops using the channels with a high packet error rate for a
+ *  while. The channel statistics are reset when this function is called.
+ *
+ *  Available only if @option{CONFIG_ESB_HOPPING} is enabled.
+ *
+ *  @param[in] channels	Radio channels (between 0 and 100), or NULL to
+ *			disable frequency hopping.
+ *  @param[in] count	Number of channels, zero to disable frequency
+ *			hopping.
+ *
+ * @retval 0 If successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int esb_hop_channels_set(const uint8_t *channels, uint8_t count);
+
+/** @brief Set the channel map used for frequency hopping.
+ *
+ *  The channel map can be used, for example, to apply the same channel
+ *  selection on the PRX and the PTX.
+ *
+ *  @param[in] chmap	Bitmask of the enabled channels, where bit n
+ *			refers to the channel with index n given in
+ *			@ref esb_hop_channels_set.
+ *
+ * @retval 0 If successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int esb_hop_chmap_set(uint32_t chmap);
+
+/** @brief Get the channel map used for frequency hopping.
+ *
+ *  @return Bitmask of the channels that are currently used, including the
+ *          changes made because of a high packet error rate.
+ */
+uint32_t esb_hop_chmap_get(void);
+
+/** @brief Get the link statistics of a frequency hopping channel.
+ *
+ *  @param[in]  idx	Index of the channel given in
+ *			@ref esb_hop_channels_set.
+ *  @param[out] stats	Channel statistics.
+ *
+ * @retval 0 If successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int esb_chn_stats_get(uint8_t idx, struct esb_chn_stats *stats);
+
+/** @brief Reset the link statistics of all frequency hopping channels. */
+void esb_chn_stats_reset(void);
+
 /** @brief Get the current radio channel.
  *
  *  @param[in, out] channel	Channel number.
@@ -73,6 +73,64 @@ int nrf_cloud_agps_get_last_cell_location(double *const lat,
  */
 int nrf_cloud_agps_process(const char *buf, size_t buf_len, const int *socket);
 
+/**@brief Starts incremental processing of binary A-GPS data.
+ *
+ * Use this together with @ref nrf_cloud_agps_process_chunk and
+ * @ref nrf_cloud_agps_process_finish when the A-GPS data is received in
+ * fragments, for example from a download client. Each element is injected
+ * into the modem as soon as it has been fully received, so the complete
+ * A-GPS payload never needs to be buffered.
+ *
+ * @param socket Pointer to GNSS socket to which A-GPS data will be injected.
+ *		 If NULL, the nRF9160 GPS driver is used to inject the data.
+ *
+ * @return 0 if successful, otherwise a (negative) error code.
+ */
+int nrf_cloud_agps_process_start(const int *socket);
+
+/**@brief Processes a fragment of binary A-GPS data received from nRF Cloud.
+ *
+ * Fragments must be passed in the order they were received. An element that
+ * is split between two fragments is carried over internally and injected
+ * once its remaining bytes arrive.
+ *
+ * @param buf Pointer to the fragment.
+ * @param buf_len Length of the fragment.
+ *
+ * @retval 0 if successful.
+ * @retval -EPERM if @ref nrf_cloud_agps_process_start was not called.
+ * @retval -EBADMSG if the data uses an unsupported schema version.
+ * @retval -EMSGSIZE if an element does not fit the carry-over buffer.
+ * @return Otherwise a (negative) error code. Processing must then be
+ *	   restarted with @ref nrf_cloud_agps_process_start.
+ */
+int nrf_cloud_agps_process_chunk(const char *buf, size_t buf_len);
+
+/**@brief Finishes incremental processing of binary A-GPS data.
+ *
+ * @retval 0 if all received data was processed.
+ * @retval -EBADMSG if the data ended in the middle of an element.
+ * @retval -EPERM if processing was not started.
+ */
+int nrf_cloud_agps_process_finish(void);
+
+/**@brief Handler for A-GPS data that has been written to the GPS module.
+ *
+ * @param type A-GPS data type.
+ * @param data Pointer to the data in the format used by the GPS module.
+ * @param data_len Length of @p data.
+ */
+typedef void (*nrf_cloud_agps_data_handler_t)(enum gps_agps_type type,
+					      const void *data,
+					      size_t data_len);
+
+/**@brief Sets a handler that receives every A-GPS element after it has been
+ *	  written to the GPS module, for example to store it.
+ *
+ * @param handler Handler to be called, or NULL to remove the handler.
+ */
+void nrf_cloud_agps_data_handler_set(nrf_cloud_agps_data_handler_t handler);
+
 /** @} */
 
 #ifdef __cplusplus
@@ -104,7 +104,19 @@ enum nfc_t4t_isodep_fsd {
 	NFC_T4T_ISODEP_FSD_128,
 
 	/** 256-byte frame size. */
-	NFC_T4T_ISODEP_FSD_256
+	NFC_T4T_ISODEP_FSD_256,
+
+	/** 512-byte frame size. */
+	NFC_T4T_ISODEP_FSD_512,
+
+	/** 1024-byte frame size. */
+	NFC_T4T_ISODEP_FSD_1024,
+
+	/** 2048-byte frame size. */
+	NFC_T4T_ISODEP_FSD_2048,
+
+	/** 4096-byte frame size. */
+	NFC_T4T_ISODEP_FSD_4096
 };
 
 /**@brief ISO-DEP Protocol callback structure.
@@ -168,13 +180,26 @@ struct nfc_t4t_isodep_cb {
  *                communication with one Listener.
  *
  * @note According to NFC Forum Digital Specification 2.0, FSD
- *       must be set to 256 bytes.
+ *       must be set to 256 bytes. Frame sizes above 256 bytes are
+ *       defined in ISO/IEC 14443-4:2016 and can be used with Listeners
+ *       that support them.
  *
  * @retval 0 If the operation was successful.
  *           Otherwise, a (negative) error code is returned.
  */
 int nfc_t4t_isodep_rats_send(enum nfc_t4t_isodep_fsd fsd, uint8_t did);
 
+/**@brief Get the largest frame size for the Reader/Writer.
+ *
+ * This function returns the largest FSD that fits in the TX buffer
+ * passed to @ref nfc_t4t_isodep_init. The NFC Reader RX buffer
+ * must be at least as large as the returned frame size.
+ *
+ * @return Largest frame size that can be used in
+ *         @ref nfc_t4t_isodep_rats_send.
+ */
+enum nfc_t4t_isodep_fsd nfc_t4t_isodep_fsd_max_get(void);
+
 /**@brief Send a Deselect command.
  *
  * Function for sending S(DESELECT) frame according to NFC Forum
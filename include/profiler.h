@@ -24,14 +24,18 @@
 #define CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS 0
 #endif
 
+/** Number of 32-bit words used for the event type profiling flags. */
+#define PROFILER_ENABLED_EVENTS_WORDS \
+	MAX(1, ceiling_fraction(CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS, 32))
+
 /** @brief Set of flags for enabling/disabling profiling for given event types.
  */
-extern uint32_t profiler_enabled_events;
+extern uint32_t profiler_enabled_events[PROFILER_ENABLED_EVENTS_WORDS];
 
 
 /** @brief Number of event types registered in the Profiler.
  */
-extern uint8_t profiler_num_events;
+extern uint16_t profiler_num_events;
 
 
 /** @brief Data types for profiling.
@@ -104,7 +108,8 @@ static inline bool is_profiling_enabled(size_t profiler_event_id)
 {
 	if (IS_ENABLED(CONFIG_PROFILER)) {
 		__ASSERT_NO_MSG(profiler_event_id < CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS);
-		return (profiler_enabled_events & BIT(profiler_event_id)) != 0;
+		return (profiler_enabled_events[profiler_event_id / 32] &
+			BIT(profiler_event_id % 32)) != 0;
 	}
 	return false;
 }
@@ -159,6 +164,105 @@ static inline void profiler_log_encode_u32(struct log_event_buf *buf,
 #endif
 
 
+/** @brief Encode and add uint8_t data to a buffer.
+ *
+ * @warning The buffer must be initialized with @ref profiler_log_start
+ *          before calling this function.
+ *
+ * @param data Data to add to the buffer.
+ * @param buf Pointer to the data buffer.
+ */
+#ifdef CONFIG_PROFILER
+void profiler_log_encode_u8(struct log_event_buf *buf, uint8_t data);
+#else
+static inline void profiler_log_encode_u8(struct log_event_buf *buf,
+					  uint8_t data) {}
+#endif
+
+
+/** @brief Encode and add int8_t data to a buffer.
+ *
+ * @warning The buffer must be initialized with @ref profiler_log_start
+ *          before calling this function.
+ *
+ * @param data Data to add to the buffer.
+ * @param buf Pointer to the data buffer.
+ */
+#ifdef CONFIG_PROFILER
+void profiler_log_encode_s8(struct log_event_buf *buf, int8_t data);
+#else
+static inline void profiler_log_encode_s8(struct log_event_buf *buf,
+					  int8_t data) {}
+#endif
+
+
+/** @brief Encode and add uint16_t data to a buffer.
+ *
+ * @warning The buffer must be initialized with @ref profiler_log_start
+ *          before calling this function.
+ *
+ * @param data Data to add to the buffer.
+ * @param buf Pointer to the data buffer.
+ */
+#ifdef CONFIG_PROFILER
+void profiler_log_encode_u16(struct log_event_buf *buf, uint16_t data);
+#else
+static inline void profiler_log_encode_u16(struct log_event_buf *buf,
+					   uint16_t data) {}
+#endif
+
+
+/** @brief Encode and add int16_t data to a buffer.
+ *
+ * @warning The buffer must be initialized with @ref profiler_log_start
+ *          before calling this function.
+ *
+ * @param data Data to add to the buffer.
+ * @param buf Pointer to the data buffer.
+ */
+#ifdef CONFIG_PROFILER
+void profiler_log_encode_s16(struct log_event_buf *buf, int16_t data);
+#else
+static inline void profiler_log_encode_s16(struct log_event_buf *buf,
+					   int16_t data) {}
+#endif
+
+
+/** @brief Encode and add int32_t data to a buffer.
+ *
+ * @warning The buffer must be initialized with @ref profiler_log_start
+ *          before calling this function.
+ *
+ * @param data Data to add to the buffer.
+ * @param buf Pointer to the data buffer.
+ */
+#ifdef CONFIG_PROFILER
+void profiler_log_encode_s32(struct log_event_buf *buf, int32_t data);
+#else
+static inline void profiler_log_encode_s32(struct log_event_buf *buf,
+					   int32_t data) {}
+#endif
+
+
+/** @brief Encode and add a string to a buffer.
+ *
+ * The string is truncated if it does not fit in the buffer.
+ *
+ * @warning The buffer must be initialized with @ref profiler_log_start
+ *          before calling this function.
+ *
+ * @param string Null-terminated string to add to the buffer.
+ * @param buf Pointer to the data buffer.
+ */
+#ifdef CONFIG_PROFILER
+void profiler_log_encode_string(struct log_event_buf *buf,
+				const char *string);
+#else
+static inline void profiler_log_encode_string(struct log_event_buf *buf,
+					      const char *string) {}
+#endif
+
+
 /** @brief Encode and add the event's address in memory to the buffer.
  *
  * This information is used for event identification.
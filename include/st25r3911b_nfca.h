@@ -113,6 +113,46 @@ struct st25r3911b_nfca_crc {
 	uint8_t crc[ST25R3911B_NFCA_CRC_LEN];
 };
 
+/** @brief NFC-A transfer statistics.
+ *
+ *  @details Available if @option{CONFIG_ST25R3911B_LIB_STATS} is enabled.
+ *           The transfer latency is measured from the start of
+ *           the transmission to the end of the reception.
+ */
+struct st25r3911b_nfca_stats {
+	/** Number of completed transfers. */
+	uint32_t transfers;
+
+	/** Number of transfers completed with an error. */
+	uint32_t errors;
+
+	/** Number of transfers without a response from the tag. */
+	uint32_t timeouts;
+
+	/** Number of transfers started directly from the transfer
+	 *  completion callback.
+	 */
+	uint32_t chained;
+
+	/** Number of FIFO water level reloads. */
+	uint32_t fifo_reloads;
+
+	/** Number of transmitted bytes. */
+	uint32_t tx_bytes;
+
+	/** Number of received bytes. */
+	uint32_t rx_bytes;
+
+	/** Latency of the last transfer, in microseconds. */
+	uint32_t last_latency_us;
+
+	/** Maximum transfer latency, in microseconds. */
+	uint32_t max_latency_us;
+
+	/** Sum of all transfer latencies, in microseconds. */
+	uint64_t total_latency_us;
+};
+
 /** @brief NFC-A callback.
  *
  *  This structure is used for tracking and synchronized NFC-A operation.
@@ -288,6 +328,23 @@ static inline int st25r3911b_nfca_transfer_without_crc(const struct st25r3911b_n
  */
 int st25r3911b_nfca_tag_sleep(void);
 
+/** @brief Get the NFC-A transfer statistics.
+ *
+ *  @details Available if @option{CONFIG_ST25R3911B_LIB_STATS} is enabled.
+ *
+ *  @param[out] stats Transfer statistics.
+ *
+ *  @retval 0 If the operation was successful.
+ *            Otherwise, a (negative) error code is returned.
+ */
+int st25r3911b_nfca_stats_get(struct st25r3911b_nfca_stats *stats);
+
+/** @brief Reset the NFC-A transfer statistics.
+ *
+ *  @details Available if @option{CONFIG_ST25R3911B_LIB_STATS} is enabled.
+ */
+void st25r3911b_nfca_stats_reset(void);
+
 /** @brief Calculate CRC 16 for NFC-A payload.
  *
  *  @details This function generates an NFC-A CRC (according to
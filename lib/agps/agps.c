@@ -19,14 +19,21 @@
 #include <net/nrf_cloud_agps.h>
 #endif
 
+#if defined(CONFIG_AGPS_CACHE)
+#include "agps_cache.h"
+#endif
+
 LOG_MODULE_REGISTER(agps, CONFIG_AGPS_LOG_LEVEL);
 
+#if defined(CONFIG_AGPS_SRC_SUPL) || defined(CONFIG_AGPS_CACHE)
+static const struct device *gps_dev;
+static int gnss_fd;
+#endif
+
 #if defined(CONFIG_AGPS_SRC_SUPL)
 /* Number of DNS lookup attempts */
 #define DNS_ATTEMPT_COUNT  3
 
-static const struct device *gps_dev;
-static int gnss_fd;
 static int supl_fd;
 #endif /* CONFIG_AGPS_SRC_SUPL */
 
@@ -50,7 +57,27 @@ static inline enum gps_agps_type type_socket2gps(nrf_gnss_agps_data_type_t type)
 	return type_lookup_socket2gps[type];
 }
 
-#if defined(CONFIG_AGPS_SRC_SUPL)
+#if defined(CONFIG_AGPS_SRC_SUPL) || defined(CONFIG_AGPS_CACHE)
+static int output_init(int socket)
+{
+	if (socket) {
+		LOG_DBG("Using user-provided socket, fd %d", socket);
+
+		gps_dev = NULL;
+		gnss_fd = socket;
+	} else {
+		gps_dev = device_get_binding("NRF9160_GPS");
+		if (gps_dev == NULL) {
+			LOG_ERR("Could not get binding to nRF9160 GPS");
+			return -ENODEV;
+		}
+
+		LOG_DBG("Using GPS driver to input assistance data");
+	}
+
+	return 0;
+}
+
 static int send_to_modem(void *data, size_t data_len,
 			 nrf_gnss_agps_data_type_t type)
 {
@@ -74,7 +101,51 @@ static int send_to_modem(void *data, size_t data_len,
 
 	return err;
 }
+#endif /* CONFIG_AGPS_SRC_SUPL || CONFIG_AGPS_CACHE */
+
+#if defined(CONFIG_AGPS_CACHE)
+/* Convert GPS API A-GPS type to nrf_socket type. */
+static nrf_gnss_agps_data_type_t type_gps2socket(enum gps_agps_type type)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(type_lookup_socket2gps); i++) {
+		if (type_lookup_socket2gps[i] == type) {
+			return i;
+		}
+	}
+
+	return 0;
+}
+
+static int inject_cached(enum gps_agps_type type, void *data,
+			 size_t data_len)
+{
+	return send_to_modem(data, data_len, type_gps2socket(type));
+}
+
+static bool request_pending(const struct gps_agps_request *request)
+{
+	return request->sv_mask_ephe || request->sv_mask_alm ||
+	       request->utc || request->klobuchar || request->nequick ||
+	       request->system_time_tow || request->position ||
+	       request->integrity;
+}
+
+static int cache_inject(struct gps_agps_request *request, int socket)
+{
+#if !defined(CONFIG_AGPS_SRC_SUPL)
+	/* With SUPL, the output is initialized together with the client. */
+	int err = output_init(socket);
+
+	if (err) {
+		return err;
+	}
+#endif
+
+	return agps_cache_inject(request, inject_cached);
+}
+#endif /* CONFIG_AGPS_CACHE */
 
+#if defined(CONFIG_AGPS_SRC_SUPL)
 static int inject_agps_type(void *agps,
 			    size_t agps_size,
 			    nrf_gnss_agps_data_type_t type,
@@ -90,6 +161,10 @@ static int inject_agps_type(void *agps,
 		return err;
 	}
 
+#if defined(CONFIG_AGPS_CACHE)
+	agps_cache_store(type_socket2gps(type), agps, agps_size);
+#endif
+
 	LOG_DBG("Injected AGPS data, type: %d, size: %d", type, agps_size);
 
 	return 0;
@@ -263,19 +338,9 @@ static int init_supl(int socket)
 		return err;
 	}
 
-	if (socket) {
-		LOG_DBG("Using user-provided socket, fd %d", socket);
-
-		gps_dev = NULL;
-		gnss_fd = socket;
-	} else {
-		gps_dev = device_get_binding("NRF9160_GPS");
-		if (gps_dev == NULL) {
-			LOG_ERR("Could not get binding to nRF9160 GPS");
-			return -ENODEV;
-		}
-
-		LOG_DBG("Using GPS driver to input assistance data");
+	err = output_init(socket);
+	if (err) {
+		return err;
 	}
 
 	LOG_INF("SUPL is initialized");
@@ -343,7 +408,21 @@ int gps_agps_request(struct gps_agps_request request, int socket)
 
 		supl_is_init = true;
 	}
+#endif /* CONFIG_AGPS_SRC_SUPL */
 
+#if defined(CONFIG_AGPS_CACHE)
+	err = cache_inject(&request, socket);
+	if (err) {
+		LOG_WRN("Failed to inject cached A-GPS data, error: %d", err);
+	}
+
+	if (!request_pending(&request)) {
+		LOG_INF("All requested A-GPS data injected from cache");
+		return 0;
+	}
+#endif /* CONFIG_AGPS_CACHE */
+
+#if defined(CONFIG_AGPS_SRC_SUPL)
 	err = supl_start(request);
 	if (err) {
 		LOG_ERR("SUPL request failed, error: %d", err);
@@ -372,6 +451,10 @@ int gps_process_agps_data(const uint8_t *buf, size_t len)
 
 #if defined(CONFIG_AGPS_SRC_NRF_CLOUD) && defined(CONFIG_NRF_CLOUD_AGPS)
 
+#if defined(CONFIG_AGPS_CACHE)
+	nrf_cloud_agps_data_handler_set(agps_cache_store);
+#endif
+
 	err = nrf_cloud_agps_process(buf, len, NULL);
 	if (err) {
 		LOG_ERR("A-GPS failed, error: %d", err);
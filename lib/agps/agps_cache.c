@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <logging/log.h>
+#include <settings/settings.h>
+#include <date_time.h>
+#include <nrf_socket.h>
+
+#include "agps_cache.h"
+
+LOG_MODULE_DECLARE(agps, CONFIG_AGPS_LOG_LEVEL);
+
+#define SETTINGS_KEY_AGPS_CACHE "agps_cache"
+#define SETTINGS_KEY_MAX_LEN sizeof(SETTINGS_KEY_AGPS_CACHE "/255/255")
+
+#define SV_ID_MIN 1
+#define SV_ID_MAX 32
+
+/* Largest stored data type. */
+#define ENTRY_DATA_MAX_LEN						\
+	MAX(MAX(sizeof(nrf_gnss_agps_data_ephemeris_t),			\
+		sizeof(nrf_gnss_agps_data_almanac_t)),			\
+	    MAX(MAX(sizeof(nrf_gnss_agps_data_utc_t),			\
+		    sizeof(nrf_gnss_agps_data_location_t)),		\
+		MAX(sizeof(nrf_gnss_agps_data_klobuchar_t),		\
+		    sizeof(nrf_gnss_agps_data_nequick_t))))
+
+struct cache_entry {
+	int64_t timestamp; /* Unix time of reception in milliseconds */
+	uint8_t data[ENTRY_DATA_MAX_LEN];
+};
+
+#define ENTRY_HDR_LEN offsetof(struct cache_entry, data)
+
+struct inject_ctx {
+	struct gps_agps_request *request;
+	agps_cache_inject_t inject;
+	int64_t now;
+	size_t count;
+	int err;
+};
+
+/* Maximum age of the stored data, zero if the type is not stored. */
+static int64_t max_age_ms_get(enum gps_agps_type type)
+{
+	switch (type) {
+	case GPS_AGPS_EPHEMERIDES:
+		return (int64_t)CONFIG_AGPS_CACHE_EPHE_MAX_AGE * MSEC_PER_SEC;
+	case GPS_AGPS_ALMANAC:
+		return (int64_t)CONFIG_AGPS_CACHE_ALM_MAX_AGE * MSEC_PER_SEC;
+	case GPS_AGPS_UTC_PARAMETERS:
+	case GPS_AGPS_KLOBUCHAR_CORRECTION:
+	case GPS_AGPS_NEQUICK_CORRECTION:
+	case GPS_AGPS_LOCATION:
+		return (int64_t)CONFIG_AGPS_CACHE_MAX_AGE * MSEC_PER_SEC;
+	default:
+		return 0;
+	}
+}
+
+/* Ephemerides and almanacs are stored per satellite, other types once. */
+static uint8_t entry_id_get(enum gps_agps_type type, const void *data)
+{
+	switch (type) {
+	case GPS_AGPS_EPHEMERIDES:
+		return ((const nrf_gnss_agps_data_ephemeris_t *)data)->sv_id;
+	case GPS_AGPS_ALMANAC:
+		return ((const nrf_gnss_agps_data_almanac_t *)data)->sv_id;
+	default:
+		return 0;
+	}
+}
+
+static bool request_has(const struct gps_agps_request *request,
+			enum gps_agps_type type, unsigned long id)
+{
+	switch (type) {
+	case GPS_AGPS_EPHEMERIDES:
+		return (id >= SV_ID_MIN) && (id <= SV_ID_MAX) &&
+		       (request->sv_mask_ephe & BIT(id - SV_ID_MIN));
+	case GPS_AGPS_ALMANAC:
+		return (id >= SV_ID_MIN) && (id <= SV_ID_MAX) &&
+		       (request->sv_mask_alm & BIT(id - SV_ID_MIN));
+	case GPS_AGPS_UTC_PARAMETERS:
+		return request->utc;
+	case GPS_AGPS_KLOBUCHAR_CORRECTION:
+		return request->klobuchar;
+	case GPS_AGPS_NEQUICK_CORRECTION:
+		return request->nequick;
+	case GPS_AGPS_LOCATION:
+		return request->position;
+	default:
+		return false;
+	}
+}
+
+static void request_clear(struct gps_agps_request *request,
+			  enum gps_agps_type type, unsigned long id)
+{
+	switch (type) {
+	case GPS_AGPS_EPHEMERIDES:
+		request->sv_mask_ephe &= ~BIT(id - SV_ID_MIN);
+		break;
+	case GPS_AGPS_ALMANAC:
+		request->sv_mask_alm &= ~BIT(id - SV_ID_MIN);
+		break;
+	case GPS_AGPS_UTC_PARAMETERS:
+		request->utc = 0;
+		break;
+	case GPS_AGPS_KLOBUCHAR_CORRECTION:
+		request->klobuchar = 0;
+		break;
+	case GPS_AGPS_NEQUICK_CORRECTION:
+		request->nequick = 0;
+		break;
+	case GPS_AGPS_LOCATION:
+		request->position = 0;
+		break;
+	default:
+		break;
+	}
+}
+
+static int entry_inject(const char *key, size_t len, settings_read_cb read_cb,
+			void *cb_arg, void *param)
+{
+	struct inject_ctx *ctx = param;
+	struct cache_entry entry;
+	enum gps_agps_type type;
+	unsigned long id;
+	char *end;
+	ssize_t rc;
+	int err;
+
+	/* Key format is <type>/<id>. */
+	type = strtoul(key, &end, 10);
+	if (*end != '/') {
+		return 0;
+	}
+
+	id = strtoul(end + 1, NULL, 10);
+
+	if (!request_has(ctx->request, type, id)) {
+		return 0;
+	}
+
+	if ((len <= ENTRY_HDR_LEN) || (len > sizeof(entry))) {
+		LOG_WRN("Invalid cached A-GPS entry: %s", log_strdup(key));
+		return 0;
+	}
+
+	rc = read_cb(cb_arg, &entry, len);
+	if (rc != len) {
+		LOG_WRN("Failed to read cached A-GPS entry: %d", rc);
+		return 0;
+	}
+
+	if ((entry.timestamp > ctx->now) ||
+	    ((ctx->now - entry.timestamp) > max_age_ms_get(type))) {
+		LOG_DBG("Cached A-GPS data expired, type: %d, id: %lu",
+			type, id);
+		return 0;
+	}
+
+	err = ctx->inject(type, entry.data, len - ENTRY_HDR_LEN);
+	if (err) {
+		LOG_ERR("Failed to inject cached data, type: %d (err: %d)",
+			type, err);
+		ctx->err = err;
+		return 0;
+	}
+
+	request_clear(ctx->request, type, id);
+	ctx->count++;
+
+	return 0;
+}
+
+void agps_cache_store(enum gps_agps_type type, const void *data,
+		      size_t data_len)
+{
+	char key[SETTINGS_KEY_MAX_LEN];
+	struct cache_entry entry;
+	int err;
+
+	if ((max_age_ms_get(type) == 0) || (data_len > sizeof(entry.data))) {
+		return;
+	}
+
+	err = date_time_now(&entry.timestamp);
+	if (err) {
+		LOG_DBG("Time not known, A-GPS data not cached");
+		return;
+	}
+
+	err = settings_subsys_init();
+	if (err) {
+		LOG_ERR("Failed to initialize settings, error: %d", err);
+		return;
+	}
+
+	memcpy(entry.data, data, data_len);
+
+	snprintf(key, sizeof(key), SETTINGS_KEY_AGPS_CACHE "/%d/%d", type,
+		 entry_id_get(type, data));
+
+	err = settings_save_one(key, &entry, ENTRY_HDR_LEN + data_len);
+	if (err) {
+		LOG_WRN("Failed to cache A-GPS data, type: %d (err: %d)",
+			type, err);
+	}
+}
+
+int agps_cache_inject(struct gps_agps_request *request,
+		      agps_cache_inject_t inject)
+{
+	struct inject_ctx ctx = {
+		.request = request,
+		.inject = inject,
+	};
+	int err;
+
+	err = settings_subsys_init();
+	if (err) {
+		LOG_ERR("Failed to initialize settings, error: %d", err);
+		return err;
+	}
+
+	err = date_time_now(&ctx.now);
+	if (err) {
+		LOG_DBG("Time not known, cached A-GPS data not used");
+		return 0;
+	}
+
+	err = settings_load_subtree_direct(SETTINGS_KEY_AGPS_CACHE,
+					   entry_inject, &ctx);
+	if (err) {
+		LOG_ERR("Failed to load cached A-GPS data, error: %d", err);
+		return err;
+	}
+
+	LOG_INF("Injected %d cached A-GPS elements", ctx.count);
+
+	return ctx.err;
+}
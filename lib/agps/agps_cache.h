@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef AGPS_CACHE_H_
+#define AGPS_CACHE_H_
+
+#include <zephyr/types.h>
+#include <drivers/gps.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Function used to write cached A-GPS data to the GPS module.
+ *
+ * @param type A-GPS data type.
+ * @param data Pointer to the data.
+ * @param data_len Length of @p data.
+ *
+ * @return Zero on success or (negative) error code otherwise.
+ */
+typedef int (*agps_cache_inject_t)(enum gps_agps_type type, void *data,
+				   size_t data_len);
+
+/**
+ * @brief Store A-GPS data that was written to the GPS module.
+ *
+ * Ephemerides and almanacs are stored per satellite. GPS system time and
+ * integrity data are not stored, as they are only valid for a short time.
+ *
+ * @param type A-GPS data type.
+ * @param data Pointer to the data.
+ * @param data_len Length of @p data.
+ */
+void agps_cache_store(enum gps_agps_type type, const void *data,
+		      size_t data_len);
+
+/**
+ * @brief Write the still valid cached A-GPS data to the GPS module.
+ *
+ * Only the data that is requested is written. The data that was written is
+ * removed from the request, so that the remaining request only contains
+ * the missing or expired data.
+ *
+ * @param request A-GPS request to be updated.
+ * @param inject Function used to write the data.
+ *
+ * @return Zero on success or (negative) error code otherwise.
+ */
+int agps_cache_inject(struct gps_agps_request *request,
+		      agps_cache_inject_t inject);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AGPS_CACHE_H_ */
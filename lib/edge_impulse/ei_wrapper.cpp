@@ -21,8 +21,17 @@ BUILD_ASSERT(CONFIG_EI_WRAPPER_THREAD_STACK_SIZE > 0);
 #define DATA_BUFFER_SIZE	CONFIG_EI_WRAPPER_DATA_BUF_SIZE
 #define THREAD_STACK_SIZE	CONFIG_EI_WRAPPER_THREAD_STACK_SIZE
 #define THREAD_PRIORITY 	CONFIG_EI_WRAPPER_THREAD_PRIORITY
+#define THREAD_COUNT		CONFIG_EI_WRAPPER_THREAD_COUNT
 #define DEBUG_MODE		IS_ENABLED(CONFIG_EI_WRAPPER_DEBUG_MODE)
 
+#ifdef CONFIG_EI_WRAPPER_DATA_BUF_INT16
+#define SAMPLE_SCALE	((float)INT16_MAX / CONFIG_EI_WRAPPER_DATA_BUF_INT16_RANGE)
+
+typedef int16_t sample_t;
+#else
+typedef float sample_t;
+#endif
+
 enum state {
 	STATE_DISABLED,
 	STATE_PROCESSING,
@@ -30,21 +39,24 @@ enum state {
 };
 
 struct data_buffer {
-	float buf[DATA_BUFFER_SIZE];
-	size_t process_idx;
+	sample_t buf[DATA_BUFFER_SIZE];
 	size_t append_idx;
-	size_t wait_data_size;
+	/* Registered models, each with its own processing index. */
+	sys_slist_t models;
+	/* Models ready for processing, sorted by priority. */
+	sys_slist_t ready;
 	struct k_spinlock lock;
-	enum state state;
 };
 
-static K_THREAD_STACK_DEFINE(thread_stack, THREAD_STACK_SIZE);
-static struct k_thread thread;
-static k_tid_t ei_thread_id;
+static K_THREAD_STACK_ARRAY_DEFINE(thread_stacks, THREAD_COUNT,
+				   THREAD_STACK_SIZE);
+static struct k_thread threads[THREAD_COUNT];
+static bool threads_started;
 
-static K_SEM_DEFINE(ei_sem, 0, 1);
+static K_SEM_DEFINE(ei_sem, 0, K_SEM_MAX_LIMIT);
 
 static struct data_buffer ei_input;
+static struct ei_wrapper_model ei_model;
 static ei_impulse_result_t ei_result;
 static ei_wrapper_result_ready_cb user_cb;
 
@@ -53,31 +65,122 @@ BUILD_ASSERT(DATA_BUFFER_SIZE > INPUT_WINDOW_SIZE);
 BUILD_ASSERT(INPUT_WINDOW_SIZE % INPUT_FRAME_SIZE == 0);
 
 
-static size_t buf_get_collected_data_count(const struct data_buffer *b)
+#ifdef CONFIG_EI_WRAPPER_DATA_BUF_INT16
+static sample_t sample_encode(float value)
+{
+	float scaled = value * SAMPLE_SCALE;
+
+	if (scaled >= INT16_MAX) {
+		return INT16_MAX;
+	} else if (scaled <= -INT16_MAX) {
+		return -INT16_MAX;
+	}
+
+	return (sample_t)((scaled >= 0) ? (scaled + 0.5f) : (scaled - 0.5f));
+}
+
+static void samples_store(sample_t *dst, const float *src, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+		dst[i] = sample_encode(src[i]);
+	}
+}
+
+static void samples_load(float *dst, const sample_t *src, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+		dst[i] = src[i] / SAMPLE_SCALE;
+	}
+}
+#else
+static void samples_store(sample_t *dst, const float *src, size_t len)
+{
+	memcpy(dst, src, len * sizeof(dst[0]));
+}
+
+static void samples_load(float *dst, const sample_t *src, size_t len)
+{
+	memcpy(dst, src, len * sizeof(dst[0]));
+}
+#endif /* CONFIG_EI_WRAPPER_DATA_BUF_INT16 */
+
+static size_t buf_get_collected_data_count(const struct data_buffer *b,
+					   const struct ei_wrapper_model *m)
 {
-	if (b->append_idx >= b->process_idx) {
-		return b->append_idx - b->process_idx;
+	if (b->append_idx >= m->process_idx) {
+		return b->append_idx - m->process_idx;
 	}
 
-	return (ARRAY_SIZE(b->buf) - b->process_idx) + b->append_idx;
+	return (ARRAY_SIZE(b->buf) - m->process_idx) + b->append_idx;
 }
 
-static size_t buf_calc_free_space(const struct data_buffer *b)
+static size_t buf_calc_free_space(const struct data_buffer *b,
+				  const struct ei_wrapper_model *m)
 {
-	if (b->wait_data_size > 0) {
-		return b->wait_data_size + ARRAY_SIZE(b->buf) -
-		       INPUT_WINDOW_SIZE - 1;
+	if (m->wait_data_size > 0) {
+		return m->wait_data_size + ARRAY_SIZE(b->buf) -
+		       m->window_size - 1;
 	}
 
-	return ARRAY_SIZE(b->buf) - buf_get_collected_data_count(b) - 1;
+	return ARRAY_SIZE(b->buf) - buf_get_collected_data_count(b, m) - 1;
 }
 
-static void buf_processing_end(struct data_buffer *b)
+/* Data can be overwritten only if no model needs it anymore. */
+static size_t buf_calc_min_free_space(const struct data_buffer *b)
+{
+	size_t free_space = ARRAY_SIZE(b->buf) - 1;
+	struct ei_wrapper_model *m;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&b->models, m, node) {
+		free_space = MIN(free_space, buf_calc_free_space(b, m));
+	}
+
+	return free_space;
+}
+
+/* Must be called with the buffer lock held. Returns true if the model was
+ * added to the ready list. The caller must then give the semaphore after
+ * the lock is released.
+ */
+static bool model_ready(struct data_buffer *b, struct ei_wrapper_model *m)
+{
+	if (m->thread) {
+		/* The worker that finishes the model's result callback
+		 * submits the model again.
+		 */
+		m->resubmit = true;
+		return false;
+	}
+
+	sys_snode_t *prev = NULL;
+	struct ei_wrapper_model *cur;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&b->ready, cur, ready_node) {
+		if (cur->priority > m->priority) {
+			break;
+		}
+		prev = &cur->ready_node;
+	}
+
+	sys_slist_insert(&b->ready, prev, &m->ready_node);
+
+	return true;
+}
+
+static void models_submit(size_t cnt)
+{
+	for (size_t i = 0; i < cnt; i++) {
+		k_sem_give(&ei_sem);
+	}
+}
+
+static void buf_processing_end(struct data_buffer *b,
+			       struct ei_wrapper_model *m)
 {
 	k_spinlock_key_t key = k_spin_lock(&b->lock);
 
-	__ASSERT_NO_MSG(b->state == STATE_PROCESSING);
-	b->state = STATE_READY;
+	__ASSERT_NO_MSG(m->state == STATE_PROCESSING);
+	m->state = STATE_READY;
 
 	k_spin_unlock(&b->lock, key);
 }
@@ -85,16 +188,24 @@ static void buf_processing_end(struct data_buffer *b)
 static int buf_cleanup(struct data_buffer *b)
 {
 	int err = 0;
+	struct ei_wrapper_model *m;
 
 	k_spinlock_key_t key = k_spin_lock(&b->lock);
 
-	if (b->state == STATE_PROCESSING) {
-		err = -EBUSY;
-	} else {
-		b->process_idx = 0;
+	SYS_SLIST_FOR_EACH_CONTAINER(&b->models, m, node) {
+		if (m->state == STATE_PROCESSING) {
+			err = -EBUSY;
+			break;
+		}
+	}
+
+	if (!err) {
 		b->append_idx = 0;
-		b->wait_data_size = 0;
-		b->state = STATE_READY;
+
+		SYS_SLIST_FOR_EACH_CONTAINER(&b->models, m, node) {
+			m->process_idx = 0;
+			m->wait_data_size = 0;
+		}
 	}
 
 	k_spin_unlock(&b->lock, key);
@@ -102,14 +213,29 @@ static int buf_cleanup(struct data_buffer *b)
 	return err;
 }
 
-static int buf_append(struct data_buffer *b, const float *data, size_t len,
-		      bool *process_buf)
+static int buf_append(struct data_buffer *b, const float *data, size_t len)
 {
-	*process_buf = false;
+	struct ei_wrapper_model *m;
+	size_t submit_cnt = 0;
 
 	k_spinlock_key_t key = k_spin_lock(&b->lock);
 
-	if (buf_calc_free_space(b) < len) {
+	/* Without a model there is no frame size to validate the data against
+	 * and the data would not be processed anyway.
+	 */
+	if (sys_slist_is_empty(&b->models)) {
+		k_spin_unlock(&b->lock, key);
+		return -ENOENT;
+	}
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&b->models, m, node) {
+		if (len % m->frame_size) {
+			k_spin_unlock(&b->lock, key);
+			return -EINVAL;
+		}
+	}
+
+	if (buf_calc_min_free_space(b) < len) {
 		k_spin_unlock(&b->lock, key);
 		return -ENOMEM;
 	}
@@ -118,15 +244,6 @@ static int buf_append(struct data_buffer *b, const float *data, size_t len,
 	size_t new_idx = b->append_idx + len;
 	bool looped = false;
 
-	if (b->wait_data_size > 0) {
-		if (b->wait_data_size > len) {
-			b->wait_data_size -= len;
-		} else {
-			b->wait_data_size = 0;
-			*process_buf = true;
-		}
-	}
-
 	if (new_idx >= ARRAY_SIZE(b->buf)) {
 		new_idx -= ARRAY_SIZE(b->buf);
 		looped = true;
@@ -134,79 +251,216 @@ static int buf_append(struct data_buffer *b, const float *data, size_t len,
 
 	b->append_idx = new_idx;
 
+	SYS_SLIST_FOR_EACH_CONTAINER(&b->models, m, node) {
+		if (m->wait_data_size > 0) {
+			if (m->wait_data_size > len) {
+				m->wait_data_size -= len;
+			} else {
+				m->wait_data_size = 0;
+				m->data_ready = true;
+			}
+		}
+	}
+
 	k_spin_unlock(&b->lock, key);
 
 	if (looped) {
 		size_t copy_cnt = ARRAY_SIZE(b->buf) - cur_idx;
 
-		memcpy(&b->buf[cur_idx], data, copy_cnt * sizeof(b->buf[0]));
-		memcpy(&b->buf[0], data + copy_cnt,
-		      (len - copy_cnt) * sizeof(b->buf[0]));
+		samples_store(&b->buf[cur_idx], data, copy_cnt);
+		samples_store(&b->buf[0], data + copy_cnt, len - copy_cnt);
 	} else {
-		memcpy(&b->buf[cur_idx], data, len * sizeof(b->buf[0]));
+		samples_store(&b->buf[cur_idx], data, len);
 	}
 
+	/* Models waiting for the data are submitted after it is stored. */
+	key = k_spin_lock(&b->lock);
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&b->models, m, node) {
+		if (m->data_ready) {
+			m->data_ready = false;
+			submit_cnt += model_ready(b, m);
+		}
+	}
+
+	k_spin_unlock(&b->lock, key);
+
+	models_submit(submit_cnt);
+
 	return 0;
 }
 
-static void buf_get(const struct data_buffer *b, float *b_res, size_t offset,
-		    size_t len)
+static void buf_get(const struct data_buffer *b,
+		    const struct ei_wrapper_model *m, float *b_res,
+		    size_t offset, size_t len)
 {
-	__ASSERT_NO_MSG((offset + len) <= INPUT_WINDOW_SIZE);
+	__ASSERT_NO_MSG((offset + len) <= m->window_size);
 
 	/* Processing index cannot change while processing is done. */
-	__ASSERT_NO_MSG(b->state == STATE_PROCESSING);
+	__ASSERT_NO_MSG(m->state == STATE_PROCESSING);
 
-	size_t read_start = b->process_idx + offset;
+	size_t read_start = m->process_idx + offset;
 	size_t read_end = read_start + len;
 
 	if ((read_end > ARRAY_SIZE(b->buf)) && (read_start < ARRAY_SIZE(b->buf))) {
 		size_t copy_cnt = ARRAY_SIZE(b->buf) - read_start;
 
-		memcpy(b_res, &b->buf[read_start],
-		       copy_cnt * sizeof(b->buf[0]));
-		memcpy(b_res + copy_cnt, &b->buf[0],
-		       (len - copy_cnt) * sizeof(b->buf[0]));
+		samples_load(b_res, &b->buf[read_start], copy_cnt);
+		samples_load(b_res + copy_cnt, &b->buf[0], len - copy_cnt);
 	} else {
 		if (read_start >= ARRAY_SIZE(b->buf)) {
 			read_start -= ARRAY_SIZE(b->buf);
 		}
-		memcpy(b_res, &b->buf[read_start], len * sizeof(b->buf[0]));
+		samples_load(b_res, &b->buf[read_start], len);
 	}
 }
 
-static int buf_processing_move(struct data_buffer *b, size_t move,
-			       bool *process_buf)
+static int buf_processing_move(struct data_buffer *b,
+			       struct ei_wrapper_model *m, size_t move)
 {
-	*process_buf = false;
+	bool submit = false;
 
 	k_spinlock_key_t key = k_spin_lock(&b->lock);
 
-	if (b->state == STATE_READY) {
-		b->state = STATE_PROCESSING;
+	if (m->state == STATE_READY) {
+		m->state = STATE_PROCESSING;
 	} else {
-		__ASSERT_NO_MSG(b->state != STATE_DISABLED);
 		k_spin_unlock(&b->lock, key);
-		return -EBUSY;
+		return (m->state == STATE_DISABLED) ? -EINVAL : -EBUSY;
 	}
 
-	size_t max_move = buf_get_collected_data_count(b);
+	size_t max_move = buf_get_collected_data_count(b, m);
 
-	b->process_idx += move;
-	if (b->process_idx >= ARRAY_SIZE(b->buf)) {
-		b->process_idx -= ARRAY_SIZE(b->buf);
+	m->process_idx += move;
+	if (m->process_idx >= ARRAY_SIZE(b->buf)) {
+		m->process_idx -= ARRAY_SIZE(b->buf);
 	}
 
-	size_t processing_end_move = move + INPUT_WINDOW_SIZE;
+	size_t processing_end_move = move + m->window_size;
 
 	if (processing_end_move > max_move) {
-		b->wait_data_size = processing_end_move - max_move;
+		m->wait_data_size = processing_end_move - max_move;
 	} else {
-		*process_buf = true;
+		submit = model_ready(b, m);
 	}
 
 	k_spin_unlock(&b->lock, key);
 
+	models_submit(submit);
+
+	return 0;
+}
+
+static void ei_thread_fn(void)
+{
+	while (true) {
+		k_sem_take(&ei_sem, K_FOREVER);
+
+		k_spinlock_key_t key = k_spin_lock(&ei_input.lock);
+		sys_snode_t *node = sys_slist_get(&ei_input.ready);
+
+		__ASSERT_NO_MSG(node);
+		struct ei_wrapper_model *m = CONTAINER_OF(node,
+						struct ei_wrapper_model,
+						ready_node);
+
+		m->thread = k_current_get();
+
+		k_spin_unlock(&ei_input.lock, key);
+
+		int err = m->run(m);
+
+		buf_processing_end(&ei_input, m);
+		m->result_ready_cb(m, err);
+
+		bool submit = false;
+
+		key = k_spin_lock(&ei_input.lock);
+
+		m->thread = NULL;
+		if (m->resubmit) {
+			m->resubmit = false;
+			submit = model_ready(&ei_input, m);
+		}
+
+		k_spin_unlock(&ei_input.lock, key);
+
+		models_submit(submit);
+	}
+}
+
+static void threads_start(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(threads); i++) {
+		k_thread_create(&threads[i], thread_stacks[i],
+				K_THREAD_STACK_SIZEOF(thread_stacks[i]),
+				(k_thread_entry_t)ei_thread_fn,
+				NULL, NULL, NULL,
+				THREAD_PRIORITY, 0, K_NO_WAIT);
+		k_thread_name_set(&threads[i], "edge_impulse_thread");
+	}
+}
+
+int ei_wrapper_model_register(struct ei_wrapper_model *model)
+{
+	if (!model || !model->run || !model->result_ready_cb ||
+	    (model->frame_size == 0) ||
+	    (model->window_size % model->frame_size) ||
+	    (model->window_size >= DATA_BUFFER_SIZE)) {
+		return -EINVAL;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&ei_input.lock);
+
+	if (model->state != STATE_DISABLED) {
+		k_spin_unlock(&ei_input.lock, key);
+		return -EALREADY;
+	}
+
+	/* New model sees only data appended after the registration. */
+	model->process_idx = ei_input.append_idx;
+	model->wait_data_size = 0;
+	model->thread = NULL;
+	model->data_ready = false;
+	model->resubmit = false;
+	model->state = STATE_READY;
+	sys_slist_append(&ei_input.models, &model->node);
+
+	bool start = !threads_started;
+
+	threads_started = true;
+
+	k_spin_unlock(&ei_input.lock, key);
+
+	if (start) {
+		threads_start();
+	}
+
+	return 0;
+}
+
+int ei_wrapper_model_start_prediction(struct ei_wrapper_model *model,
+				      size_t window_shift, size_t frame_shift)
+{
+	size_t sample_shift = window_shift * model->window_size +
+			      frame_shift * model->frame_size;
+
+	return buf_processing_move(&ei_input, model, sample_shift);
+}
+
+int ei_wrapper_model_get_data(const struct ei_wrapper_model *model,
+			      size_t offset, size_t length, float *out_ptr)
+{
+	if (model->thread != k_current_get()) {
+		return -EACCES;
+	}
+
+	if ((offset + length) > model->window_size) {
+		return -EINVAL;
+	}
+
+	buf_get(&ei_input, model, out_ptr, offset, length);
+
 	return 0;
 }
 
@@ -225,20 +479,14 @@ size_t ei_wrapper_get_window_size(void)
 	return INPUT_WINDOW_SIZE;
 }
 
-int ei_wrapper_add_data(const float *data, size_t data_size)
+size_t ei_wrapper_get_data_buf_mem_size(void)
 {
-	if (data_size % INPUT_FRAME_SIZE) {
-		return -EINVAL;
-	}
-
-	bool process_buf;
-	int err = buf_append(&ei_input, data, data_size, &process_buf);
-
-	if (!err && process_buf) {
-		k_sem_give(&ei_sem);
-	}
+	return sizeof(ei_input.buf);
+}
 
-	return err;
+int ei_wrapper_add_data(const float *data, size_t data_size)
+{
+	return buf_append(&ei_input, data, data_size);
 }
 
 int ei_wrapper_clear_data(void)
@@ -248,60 +496,46 @@ int ei_wrapper_clear_data(void)
 
 int ei_wrapper_start_prediction(size_t window_shift, size_t frame_shift)
 {
-	size_t sample_shift = window_shift * ei_wrapper_get_window_size() +
-			      frame_shift * ei_wrapper_get_frame_size();
-
-	bool process_buf;
-	int err = buf_processing_move(&ei_input, sample_shift, &process_buf);
-
-	if (!err && process_buf) {
-		k_sem_give(&ei_sem);
-	}
-
-	return err;
+	return ei_wrapper_model_start_prediction(&ei_model, window_shift,
+						 frame_shift);
 }
 
 static int raw_feature_get_data(size_t offset, size_t length, float *out_ptr)
 {
-	buf_get(&ei_input, out_ptr, offset, length);
+	buf_get(&ei_input, &ei_model, out_ptr, offset, length);
 
 	return 0;
 }
 
-static void processing_finished(int err)
-{
-	__ASSERT_NO_MSG(user_cb);
-
-	buf_processing_end(&ei_input);
-	user_cb(err);
-}
-
-static void edge_impulse_thread_fn(void)
+static int ei_model_run(struct ei_wrapper_model *model)
 {
 	signal_t features_signal;
 
-	while (true) {
-		k_sem_take(&ei_sem, K_FOREVER);
+	features_signal.get_data = &raw_feature_get_data;
+	features_signal.total_length = INPUT_WINDOW_SIZE;
 
-		features_signal.get_data = &raw_feature_get_data;
-		features_signal.total_length = INPUT_WINDOW_SIZE;
+	/* Invoke the impulse. */
+	EI_IMPULSE_ERROR err = run_classifier(&features_signal, &ei_result,
+					      DEBUG_MODE);
 
-		/* Invoke the impulse. */
-		EI_IMPULSE_ERROR err = run_classifier(&features_signal,
-						      &ei_result, DEBUG_MODE);
+	if (err) {
+		LOG_ERR("run_classifier err=%d", err);
+	}
 
-		if (err) {
-			LOG_ERR("run_classifier err=%d", err);
-		}
+	return err;
+}
 
-		processing_finished(err);
-	}
+static void ei_model_result_ready(struct ei_wrapper_model *model, int err)
+{
+	__ASSERT_NO_MSG(user_cb);
+
+	user_cb(err);
 }
 
 static bool can_read_result(void)
 {
 	/* User is allowed to access results only from the result ready callback. */
-	return (k_current_get() == ei_thread_id);
+	return (k_current_get() == ei_model.thread);
 }
 
 int ei_wrapper_get_classification_results(const char **label, float *value,
@@ -365,16 +599,15 @@ int ei_wrapper_init(ei_wrapper_result_ready_cb cb)
 
 	user_cb = cb;
 
-	int err = buf_cleanup(&ei_input);
+	ei_model.frame_size = INPUT_FRAME_SIZE;
+	ei_model.window_size = INPUT_WINDOW_SIZE;
+	ei_model.priority = CONFIG_EI_WRAPPER_IMPULSE_PRIORITY;
+	ei_model.run = ei_model_run;
+	ei_model.result_ready_cb = ei_model_result_ready;
 
-	__ASSERT_NO_MSG(!err);
-	ARG_UNUSED(err);
+	int err = ei_wrapper_model_register(&ei_model);
 
-	ei_thread_id = k_thread_create(&thread, thread_stack, THREAD_STACK_SIZE,
-				       (k_thread_entry_t)edge_impulse_thread_fn,
-				       NULL, NULL, NULL,
-				       THREAD_PRIORITY, 0, K_NO_WAIT);
-	k_thread_name_set(&thread, "edge_impulse_thread");
+	__ASSERT_NO_MSG(!err);
 
-	return 0;
+	return err;
 }
@@ -107,6 +107,8 @@ struct nfc_transfer {
 	size_t received_byte;
 	bool auto_crc;
 	int error;
+	uint32_t cfg_fdt;
+	bool cfg_valid;
 };
 
 struct fifo_water_lvl {
@@ -137,6 +139,48 @@ static struct k_poll_event *nfca_events;
 static struct k_delayed_work timeout_work;
 static struct st25r3911b_nfca nfca;
 
+#if defined(CONFIG_ST25R3911B_LIB_STATS)
+static struct st25r3911b_nfca_stats stats;
+static uint32_t transfer_start_cyc;
+
+#define STATS_INC(_field) (stats._field++)
+#define STATS_ADD(_field, _val) (stats._field += (_val))
+
+static void stats_transfer_start(size_t tx_len)
+{
+	transfer_start_cyc = k_cycle_get_32();
+	stats.tx_bytes += tx_len;
+}
+
+static void stats_transfer_end(size_t rx_len, int err)
+{
+	uint32_t latency;
+
+	latency = k_cyc_to_us_floor32(k_cycle_get_32() - transfer_start_cyc);
+
+	stats.transfers++;
+	stats.rx_bytes += rx_len;
+	stats.last_latency_us = latency;
+	stats.max_latency_us = MAX(stats.max_latency_us, latency);
+	stats.total_latency_us += latency;
+
+	if (err) {
+		stats.errors++;
+	}
+}
+#else
+#define STATS_INC(_field)
+#define STATS_ADD(_field, _val)
+
+static void stats_transfer_start(size_t tx_len)
+{
+}
+
+static void stats_transfer_end(size_t rx_len, int err)
+{
+}
+#endif /* defined(CONFIG_ST25R3911B_LIB_STATS) */
+
 enum {
 	STATE_IDLE,
 	STATE_FIELD_ON,
@@ -168,6 +212,14 @@ static void clear_local_data(void)
 	nfca.transfer.received_byte = 0;
 }
 
+/* Force the next transfer to write its full configuration. Must be called
+ * by every operation which changes the registers set by transfer_config().
+ */
+static void transfer_cfg_invalidate(void)
+{
+	nfca.transfer.cfg_valid = false;
+}
+
 static void nfca_event_init(struct k_poll_event *events)
 {
 	k_poll_event_init(&events[NFCA_IRQ_EVENT_IDX],
@@ -195,6 +247,10 @@ static int fifo_incomplete_bit_set(uint8_t bits)
 
 static void timeout_process(void)
 {
+	if (atomic_get(&nfca.state.tag) == STATE_TRANSFER) {
+		STATS_INC(timeouts);
+	}
+
 	state_set(STATE_IDLE);
 
 	LOG_DBG("Rx timeout");
@@ -239,6 +295,8 @@ static int anticollision_transmit(uint8_t *tx_buf, size_t tx_bytes,
 	uint32_t mask_timer;
 	uint16_t no_rsp_timer;
 
+	transfer_cfg_invalidate();
+
 	if (antcl) {
 		/* Set sending anticollision frame */
 		err = st25r3911b_reg_modify(ST25R3911B_REG_ISO14443A, 0,
@@ -382,27 +440,25 @@ static uint8_t bcc_calculate(uint8_t *buf, uint8_t len)
 static int read_rx_data(uint8_t *data, size_t len)
 {
 	int err;
-	uint8_t fifo_status;
+	uint8_t fifo_status[2];
 	uint32_t received;
 
-	/* Check number of bytes in FIFO */
-	err = st25r3911b_reg_read(ST25R3911B_REG_FIFO_STATUS_1, &fifo_status);
+	/* Read number of bytes in FIFO, number of incomplete bits and
+	 * parity missing in one SPI transaction.
+	 */
+	err = st25r3911b_multiple_reg_read(ST25R3911B_REG_FIFO_STATUS_1,
+					   fifo_status,
+					   ARRAY_SIZE(fifo_status));
 	if (err) {
 		return err;
 	}
 
-	nfca.fifo.bytes_to_read = fifo_status;
+	nfca.fifo.bytes_to_read = fifo_status[0];
 	received = nfca.transfer.received_byte;
 
-	/* Check number of incomplete bit in FIFO and parity missing */
-	err = st25r3911b_reg_read(ST25R3911B_REG_FIFO_STATUS_2, &fifo_status);
-	if (err) {
-		return err;
-	}
-
-	nfca.fifo.incomplete_bits = (fifo_status & ST25R3911B_REG_FIFO_STATUS_2_FIFO_LB_MASK) >>
+	nfca.fifo.incomplete_bits = (fifo_status[1] & ST25R3911B_REG_FIFO_STATUS_2_FIFO_LB_MASK) >>
 				     ST25R3911B_REG_FIFO_STATUS_2_FIFO_LB0;
-	nfca.fifo.parity_miss    = fifo_status & ST25R3911B_REG_FIFO_STATUS_2_NP_LB;
+	nfca.fifo.parity_miss    = fifo_status[1] & ST25R3911B_REG_FIFO_STATUS_2_NP_LB;
 
 	/* Check buffer size */
 	if (len - received < nfca.fifo.bytes_to_read) {
@@ -567,6 +623,9 @@ static int on_rx_complete(void)
 
 		fifo_error_check();
 
+		stats_transfer_end(nfca.transfer.received_byte,
+				   err ? err : nfca.transfer.error);
+
 		state_set(STATE_IDLE);
 
 		if (nfca.cb->transfer_completed) {
@@ -617,6 +676,8 @@ static int on_fifo_water_lvl(uint32_t state)
 {
 	int err;
 
+	STATS_INC(fifo_reloads);
+
 	switch (state) {
 
 	case TX_STATE_START:
@@ -758,6 +819,8 @@ static int tag_detect(enum st25r3911b_nfca_detect_cmd cmd)
 	uint32_t mask_timer;
 	uint32_t no_rsp_timer;
 
+	transfer_cfg_invalidate();
+
 	/* Set sending anticollision frame */
 	err = st25r3911b_reg_modify(ST25R3911B_REG_ISO14443A, 0,
 				    ST25R3911B_REG_ISO14443A_ANTCL);
@@ -849,30 +912,58 @@ static int tag_detect(enum st25r3911b_nfca_detect_cmd cmd)
 	return 0;
 }
 
-static int transfer(const struct st25r3911b_nfca_buf *tx,
-		    const struct st25r3911b_nfca_buf *rx,
-		    uint32_t fdt, bool auto_crc)
+static int transfer_config(uint32_t fdt)
 {
 	int err;
-	uint8_t cmd;
-	uint32_t irq;
 
-	/* Do not set sending anticollision frame */
-	err = st25r3911b_reg_modify(ST25R3911B_REG_ISO14443A,
-				    ST25R3911B_REG_ISO14443A_ANTCL, 0);
-	if (err) {
-		return err;
+	/* Chained transfers, for example ISO-DEP blocks, use the same
+	 * configuration, so it is written only if something else
+	 * changed it in the meantime.
+	 */
+	if (!nfca.transfer.cfg_valid) {
+		/* Do not set sending anticollision frame */
+		err = st25r3911b_reg_modify(ST25R3911B_REG_ISO14443A,
+					    ST25R3911B_REG_ISO14443A_ANTCL, 0);
+		if (err) {
+			return err;
+		}
+
+		err = st25r3911b_reg_modify(ST25R3911B_REG_AUXILIARY,
+					    ST25R3911B_REG_AUXILIARY_NO_CRC_RX,
+					    0);
+		if (err) {
+			return err;
+		}
+
+		nfca.transfer.cfg_fdt = 0;
+		nfca.transfer.cfg_valid = true;
 	}
 
-	err = st25r3911b_reg_modify(ST25R3911B_REG_AUXILIARY,
-				    ST25R3911B_REG_AUXILIARY_NO_CRC_RX, 0);
+	if ((fdt == 0) || (fdt == nfca.transfer.cfg_fdt)) {
+		return 0;
+	}
+
+	err = transfer_fdt_set(fdt);
 	if (err) {
+		transfer_cfg_invalidate();
 		return err;
 	}
 
-	/* Read FIFO water level */
-	err = st25r3911b_fifo_reload_lvl_get(&nfca.water_lvl.tx,
-					     &nfca.water_lvl.rx);
+	nfca.transfer.cfg_fdt = fdt;
+
+	return 0;
+}
+
+static int transfer(const struct st25r3911b_nfca_buf *tx,
+		    const struct st25r3911b_nfca_buf *rx,
+		    uint32_t fdt, bool auto_crc)
+{
+	int err;
+	uint8_t cmd;
+	uint32_t irq;
+
+	/* FIFO water level is read once during the initialization. */
+	err = transfer_config(fdt);
 	if (err) {
 		return err;
 	}
@@ -886,11 +977,6 @@ static int transfer(const struct st25r3911b_nfca_buf *tx,
 
 	if (fdt != 0) {
 		irq |= ST25R3911B_IRQ_MASK_NRE | ST25R3911B_IRQ_MASK_GPE;
-
-		err = transfer_fdt_set(fdt);
-		if (err) {
-			return err;
-		}
 	}
 
 	err = transmission_prepare();
@@ -936,6 +1022,8 @@ static int transfer(const struct st25r3911b_nfca_buf *tx,
 
 	nfca.transfer.written_byte = MIN(tx->len, ST25R3911B_MAX_FIFO_LEN);
 
+	stats_transfer_start(tx->len);
+
 	return st25r3911b_cmd_execute(cmd);
 }
 
@@ -964,6 +1052,8 @@ static int user_state_process(void)
 
 	switch (atomic_get(&nfca.state.tag)) {
 	case STATE_FIELD_ON:
+		transfer_cfg_invalidate();
+
 		err = st25r3911b_field_on(ST25R3911B_NO_THRESHOLD_ANTICOLLISION,
 					  ST25R3911B_NO_THRESHOLD_ANTICOLLISION,
 					  NFCA_GT_TIME);
@@ -979,6 +1069,8 @@ static int user_state_process(void)
 		break;
 
 	case STATE_FIELD_OFF:
+		transfer_cfg_invalidate();
+
 		err = st25r3911b_rx_tx_disable();
 
 		state_set(STATE_IDLE);
@@ -1054,6 +1146,18 @@ int st25r3911b_nfca_process(void)
 		if (err) {
 			return err;
 		}
+
+		/* The next operation, for example the next ISO-DEP block, is
+		 * usually requested from the callbacks called above. Start it
+		 * right away instead of waiting for the next poll.
+		 */
+		if (k_sem_take(&user_sem, K_NO_WAIT) == 0) {
+			LOG_DBG("Chained user state process");
+
+			STATS_INC(chained);
+
+			return user_state_process();
+		}
 	}
 
 	return 0;
@@ -1222,6 +1326,24 @@ int st25r3911b_nfca_tag_sleep(void)
 	return 0;
 }
 
+#if defined(CONFIG_ST25R3911B_LIB_STATS)
+int st25r3911b_nfca_stats_get(struct st25r3911b_nfca_stats *nfca_stats)
+{
+	if (!nfca_stats) {
+		return -EINVAL;
+	}
+
+	*nfca_stats = stats;
+
+	return 0;
+}
+
+void st25r3911b_nfca_stats_reset(void)
+{
+	memset(&stats, 0, sizeof(stats));
+}
+#endif /* defined(CONFIG_ST25R3911B_LIB_STATS) */
+
 int st25r3911b_nfca_crc_calculate(const uint8_t *data, size_t len,
 				  struct st25r3911b_nfca_crc *crc_val)
 {
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <ei_wrapper.h>
+#include <wave_gen.h>
+
+#define PREDICTION_CNT		CONFIG_EI_WRAPPER_SAMPLE_BENCHMARK_PREDICTIONS
+#define SAMPLING_INTERVAL_MS	CONFIG_EI_WRAPPER_SAMPLE_BENCHMARK_SAMPLING_INTERVAL_MS
+#define MAX_FRAME_SIZE		16
+
+#ifdef CONFIG_EI_WRAPPER_DATA_BUF_INT16
+#define SAMPLE_SIZE		sizeof(int16_t)
+#else
+#define SAMPLE_SIZE		sizeof(float)
+#endif
+
+struct benchmark_stats {
+	int64_t dsp_time;
+	int64_t classification_time;
+	int64_t anomaly_time;
+	uint64_t prediction_time_us;
+	size_t prediction_cnt;
+	size_t error_cnt;
+};
+
+static const struct wave_gen_param wave_params[] = {
+	{
+		.type = WAVE_GEN_TYPE_SINE,
+		.period_ms = 1000,
+		.offset = 0.0,
+		.amplitude = 10.0,
+		.noise = 0.5,
+	},
+	{
+		.type = WAVE_GEN_TYPE_TRIANGLE,
+		.period_ms = 1500,
+		.offset = 1.0,
+		.amplitude = 5.0,
+		.noise = 0.5,
+	},
+	{
+		.type = WAVE_GEN_TYPE_SQUARE,
+		.period_ms = 2000,
+		.offset = -1.0,
+		.amplitude = 8.0,
+		.noise = 0.5,
+	},
+};
+
+static K_SEM_DEFINE(result_sem, 0, 1);
+
+static struct benchmark_stats stats;
+static uint32_t prediction_start;
+static uint32_t frame_time;
+static bool prediction_pending;
+
+
+static void result_ready_cb(int err)
+{
+	int dsp_time;
+	int classification_time;
+	int anomaly_time;
+
+	stats.prediction_time_us +=
+		k_cyc_to_us_floor64(k_cycle_get_32() - prediction_start);
+
+	if (!err) {
+		err = ei_wrapper_get_timing(&dsp_time, &classification_time,
+					    &anomaly_time);
+	}
+
+	if (err) {
+		stats.error_cnt++;
+	} else {
+		stats.dsp_time += dsp_time;
+		stats.classification_time += classification_time;
+		stats.anomaly_time += MAX(anomaly_time, 0);
+		stats.prediction_cnt++;
+	}
+
+	k_sem_give(&result_sem);
+}
+
+static int add_frames(size_t frame_cnt)
+{
+	size_t frame_size = ei_wrapper_get_frame_size();
+	float frame[MAX_FRAME_SIZE];
+
+	for (size_t i = 0; i < frame_cnt; i++) {
+		for (size_t j = 0; j < frame_size; j++) {
+			double value;
+			int err = wave_gen_generate_value(frame_time,
+				&wave_params[j % ARRAY_SIZE(wave_params)],
+				&value);
+
+			if (err) {
+				return err;
+			}
+
+			frame[j] = value;
+		}
+
+		int err = ei_wrapper_add_data(frame, frame_size);
+
+		if (err) {
+			return err;
+		}
+
+		frame_time += SAMPLING_INTERVAL_MS;
+	}
+
+	return 0;
+}
+
+static int start_prediction(size_t frame_shift)
+{
+	prediction_start = k_cycle_get_32();
+
+	int err = ei_wrapper_start_prediction(0, frame_shift);
+
+	prediction_pending = !err;
+
+	return err;
+}
+
+static void wait_for_result(void)
+{
+	k_sem_take(&result_sem, K_FOREVER);
+	prediction_pending = false;
+}
+
+static int run_benchmark(size_t frame_shift)
+{
+	size_t window_frames = ei_wrapper_get_window_size() /
+			       ei_wrapper_get_frame_size();
+	int err = ei_wrapper_clear_data();
+
+	if (err) {
+		return err;
+	}
+
+	memset(&stats, 0, sizeof(stats));
+	frame_time = 0;
+
+	err = add_frames(window_frames);
+	if (!err) {
+		err = start_prediction(0);
+	}
+
+	for (size_t i = 1; !err && (i < PREDICTION_CNT); i++) {
+		wait_for_result();
+
+		/* New data is added while the window is not processed, so
+		 * the buffer must hold the window and the shift.
+		 */
+		err = add_frames(frame_shift);
+		if (!err) {
+			err = start_prediction(frame_shift);
+		}
+	}
+
+	/* Make sure the wrapper is idle before the next benchmark run. */
+	if (prediction_pending) {
+		wait_for_result();
+	}
+
+	if (err) {
+		return err;
+	}
+
+	size_t cnt = MAX(stats.prediction_cnt, 1);
+	size_t required_mem = (ei_wrapper_get_window_size() +
+			       frame_shift * ei_wrapper_get_frame_size()) *
+			      SAMPLE_SIZE;
+
+	printk("%6zu | %8lld | %8lld | %8lld | %10llu | %8zu | %6zu\n",
+	       frame_shift,
+	       stats.dsp_time / (int64_t)cnt,
+	       stats.classification_time / (int64_t)cnt,
+	       stats.anomaly_time / (int64_t)cnt,
+	       stats.prediction_time_us / cnt,
+	       required_mem,
+	       stats.error_cnt);
+
+	return 0;
+}
+
+void main(void)
+{
+	int err = ei_wrapper_init(result_ready_cb);
+
+	if (err) {
+		printk("Edge Impulse wrapper failed to initialize (err: %d)\n",
+		       err);
+		return;
+	}
+
+	if (ei_wrapper_get_frame_size() > MAX_FRAME_SIZE) {
+		printk("Input frame too big\n");
+		return;
+	}
+
+	size_t window_frames = ei_wrapper_get_window_size() /
+			       ei_wrapper_get_frame_size();
+	const size_t frame_shifts[] = {
+		1,
+		MAX(window_frames / 4, 1),
+		MAX(window_frames / 2, 1),
+		window_frames,
+	};
+
+	printk("Edge Impulse wrapper benchmark\n");
+	printk("Window size: %zu, frame size: %zu, predictions: %d\n",
+	       ei_wrapper_get_window_size(), ei_wrapper_get_frame_size(),
+	       PREDICTION_CNT);
+	printk("Input buffer: %zu bytes (%s samples)\n",
+	       ei_wrapper_get_data_buf_mem_size(),
+	       IS_ENABLED(CONFIG_EI_WRAPPER_DATA_BUF_INT16) ?
+	       "int16" : "float");
+	printk("Average times per prediction:\n");
+	printk(" shift |  dsp[ms] | clas[ms] | anom[ms] | total [us] |"
+	       " mem [B] | errors\n");
+
+	for (size_t i = 0; i < ARRAY_SIZE(frame_shifts); i++) {
+		err = run_benchmark(frame_shifts[i]);
+		if (err == -ENOMEM) {
+			printk("%6zu | Increase CONFIG_EI_WRAPPER_DATA_BUF_SIZE\n",
+			       frame_shifts[i]);
+		} else if (err) {
+			printk("Benchmark failed (err: %d)\n", err);
+			return;
+		}
+	}
+
+	printk("Benchmark finished\n");
+}
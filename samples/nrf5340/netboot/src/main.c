@@ -33,15 +33,19 @@ void main(void)
 
 	if (pcd_fw_copy_status_get() == PCD_STATUS_COPY) {
 		/* First we validate the data where the PCD CMD tells
-		 * us that we can find it.
+		 * us that we can find it. Streamed images are not
+		 * readable before the copy, so they are only validated
+		 * by the application core.
 		 */
 		uint32_t update_addr = (uint32_t)pcd_cmd_data_ptr_get();
 
-		valid = bl_validate_firmware(s0_addr, update_addr);
-		if (!valid) {
-			printk("Unable to find valid firmware inside %p\n\r",
-				(void *)update_addr);
-			goto failure;
+		if (update_addr != 0) {
+			valid = bl_validate_firmware(s0_addr, update_addr);
+			if (!valid) {
+				printk("Unable to find valid firmware inside "
+				       "%p\n\r", (void *)update_addr);
+				goto failure;
+			}
 		}
 
 		err = pcd_fw_copy(fdev);
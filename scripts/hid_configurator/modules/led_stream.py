@@ -11,6 +11,10 @@ from NrfHidDevice import EVENT_DATA_LEN_MAX
 LED_STREAM_DATA = 0x0
 MS_PER_SEC = 1000
 
+# Chosen data layout for struct is defined using format string.
+STEP_FMT = '<BBBHHB'
+STEPS_PER_BATCH_MAX = EVENT_DATA_LEN_MAX // struct.calcsize(STEP_FMT)
+
 
 class Step:
     def __init__(self, r, g, b, substep_count, substep_time):
@@ -40,8 +44,7 @@ def validate_params(freq, led_id):
 
 
 def led_send_single_step(dev, step, led_id):
-    # Chosen data layout for struct is defined using format string.
-    event_data = struct.pack('<BBBHHB', step.r, step.g, step.b,
+    event_data = struct.pack(STEP_FMT, step.r, step.g, step.b,
                              step.substep_count, step.substep_time, led_id)
 
     success = dev.config_set('led_stream', 'set_led_effect', event_data,
@@ -50,6 +53,32 @@ def led_send_single_step(dev, step, led_id):
     return success
 
 
+def led_send_steps(dev, steps):
+    # Steps are given as a list of (step, led_id) tuples. The device queues
+    # or drops every batch as a whole.
+    assert 0 < len(steps) <= STEPS_PER_BATCH_MAX
+
+    event_data = b''.join(struct.pack(STEP_FMT, step.r, step.g, step.b,
+                                      step.substep_count, step.substep_time,
+                                      led_id)
+                          for step, led_id in steps)
+
+    success = dev.config_set('led_stream', 'set_led_effects', event_data,
+                             poll_interval=0.001)
+
+    return success
+
+
+def device_supports_batch(dev):
+    # Older firmware provides only the single step option.
+    device_config = dev.get_device_config()
+
+    if device_config is None:
+        return False
+
+    return 'set_led_effects' in device_config.get('led_stream', [])
+
+
 def fetch_free_steps_buffer_info(dev, led_id):
     success, fetched_data = dev.config_get('led_stream', 'get_leds_state',
                                            poll_interval=0.001)
@@ -92,6 +121,8 @@ def send_continuous_led_stream(dev, led_id, freq, substep_cnt = 10):
             substep_time =  MS_PER_SEC // (freq * substep_cnt)
         )
 
+        batch = device_supports_batch(dev)
+
         print('LED stream started, press Ctrl+C to interrupt')
         while True:
             success, (ready, free) = fetch_free_steps_buffer_info(dev, led_id)
@@ -105,14 +136,24 @@ def send_continuous_led_stream(dev, led_id, freq, substep_cnt = 10):
 
             while free > 0:
                 # Send steps with random color and predefined duration
-                step.generate_random_color()
-
-                success = led_send_single_step(dev, step, led_id)
+                if batch:
+                    steps = []
+                    for _ in range(min(free, STEPS_PER_BATCH_MAX)):
+                        step.generate_random_color()
+                        steps.append((Step(step.r, step.g, step.b,
+                                           step.substep_count,
+                                           step.substep_time), led_id))
+
+                    success = led_send_steps(dev, steps)
+                    free -= len(steps)
+                else:
+                    step.generate_random_color()
+
+                    success = led_send_single_step(dev, step, led_id)
+                    free -= 1
 
                 if not success:
                     break
-
-                free -= 1
     except Exception as e:
         print(e)
     except KeyboardInterrupt as e:
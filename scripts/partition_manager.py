@@ -5,9 +5,13 @@
 # SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
 
 import argparse
+import hashlib
+import json
+import os
 import yaml
 from os import path
 import sys
+import time
 from pprint import pformat
 
 PERMITTED_STR_KEYS = ['size', 'region']
@@ -852,6 +856,13 @@ This file contains all addresses and sizes of all partitions.
     parser.add_argument('--static-config', required=False, type=argparse.FileType(mode='r'),
                         help='Path static configuration.')
 
+    parser.add_argument('--cache-dir', required=False, type=str,
+                        help='Path to directory used to cache the solved regions. A region is only solved again '
+                             'if its partitions, its configuration or this script changed.')
+
+    parser.add_argument('--timing', action='store_true',
+                        help='Print the time spent on solving each region.')
+
     parser.add_argument('--regions', required=False, type=str, nargs='*',
                         help="Space separated list of regions. For each region specified here, one must specify"
                              "--{region_name}-base-addr and --{region_name}-size. If the region is associated"
@@ -907,17 +918,65 @@ def get_region_config_from_args(args, ranges_configuration):
     return regions
 
 
-def solve_region(pm_config, region, region_config, static_config):
+def region_cache_key(region_config, partitions, static_partitions):
+    # The solution only depends on the region configuration, the partitions
+    # placed in the region and the algorithm, so hash them all.
+    with open(__file__, 'rb') as f:
+        script = f.read()
+    content = json.dumps([region_config, partitions, static_partitions],
+                         sort_keys=True, default=str)
+    return hashlib.sha256(script + content.encode()).hexdigest()
+
+
+def region_cache_load(cache_dir, key):
+    cache_path = path.join(cache_dir, f'{key}.json')
+    if not path.exists(cache_path):
+        return None
+
+    try:
+        with open(cache_path, 'r') as f:
+            return json.load(f)
+    except (OSError, ValueError):
+        # Ignore a corrupted entry, it is overwritten when solved again.
+        return None
+
+
+def region_cache_store(cache_dir, key, solution):
+    os.makedirs(cache_dir, exist_ok=True)
+
+    # Write to a temporary file first, as parallel builds can share the cache.
+    cache_path = path.join(cache_dir, f'{key}.json')
+    tmp_path = f'{cache_path}.{os.getpid()}.tmp'
+    with open(tmp_path, 'w') as f:
+        json.dump(solution, f)
+    os.replace(tmp_path, cache_path)
+
+
+def solve_region(pm_config, region, region_config, static_config, cache_dir=None):
     solution = dict()
     region_config['name'] = region
     partitions = {k: v for k, v in pm_config.items() if region in v['region']}
     static_partitions = {k: v for k, v in static_config.items() if region in v['region']}
 
+    if cache_dir:
+        key = region_cache_key(region_config, partitions, static_partitions)
+        cached = region_cache_load(cache_dir, key)
+        if cached is not None:
+            # Update the input partitions as if the region was solved.
+            for name, config in {**partitions, **static_partitions}.items():
+                if name in cached:
+                    config.clear()
+                    config.update(cached[name])
+            return cached, True
+
     get_region_config(partitions, region_config, static_partitions)
 
     solution.update(partitions)
 
-    return solution
+    if cache_dir:
+        region_cache_store(cache_dir, key, solution)
+
+    return solution, False
 
 
 def load_static_configuration(args, pm_config):
@@ -945,8 +1004,14 @@ def main():
     solution = dict()
     for region, region_config in regions.items():
         try:
-            solution.update(solve_region(pm_config, region, region_config,
-                                         static_config))
+            start = time.perf_counter()
+            region_solution, cached = solve_region(pm_config, region, region_config,
+                                                   static_config, args.cache_dir)
+            solution.update(region_solution)
+            if args.timing:
+                print(f"Partition manager: region {region} "
+                      f"{'loaded from cache' if cached else 'solved'} in "
+                      f"{(time.perf_counter() - start) * 1000:.1f} ms")
         except PartitionError as e:
             print(f"Partition manager failed: {str(e)}")
             print(f"Failed to partition region {region},"
@@ -1742,6 +1807,32 @@ def test():
         failed = True
     assert failed
 
+    # Verify that a region loaded from the cache gives the same solution as when it is solved,
+    # and that a changed partition causes the region to be solved again.
+    import copy
+    import tempfile
+    pm_config = {'mcuboot': {'placement': {'before': ['app']}, 'size': 200, 'region': 'flash_primary'},
+                 'spm': {'placement': {'before': ['app']}, 'size': 300, 'region': 'flash_primary'},
+                 'app': {'region': 'flash_primary'},
+                 'settings_storage': {'placement': {'after': ['app']}, 'size': 100, 'region': 'flash_primary'}}
+    flash_region = {'placement_strategy': COMPLEX, 'size': 2000, 'base_address': 0, 'device': ''}
+    with tempfile.TemporaryDirectory() as cache_dir:
+        td = copy.deepcopy(pm_config)
+        solved, cached = solve_region(td, 'flash_primary', dict(flash_region), dict(), cache_dir)
+        assert not cached
+        td = copy.deepcopy(pm_config)
+        loaded, cached = solve_region(td, 'flash_primary', dict(flash_region), dict(), cache_dir)
+        assert cached
+        assert loaded == solved
+        assert td['settings_storage'] == solved['settings_storage']
+        expect_addr_size(loaded, 'app', 500, 1400)
+
+        td = copy.deepcopy(pm_config)
+        td['spm']['size'] = 400
+        loaded, cached = solve_region(td, 'flash_primary', dict(flash_region), dict(), cache_dir)
+        assert not cached
+        expect_addr_size(loaded, 'app', 600, 1300)
+
     print('All tests passed!')
 
 
@@ -0,0 +1,93 @@
+#
+# Copyright (c) 2021 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+
+from event_chains import EventChains, ChainEndState
+
+import argparse
+import logging
+import os
+
+
+OUTPUT_FOLDER = "data_stats/"
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Calculating end-to-end latency of event chains.')
+    parser.add_argument('dataset_name', help='Name of dataset')
+    parser.add_argument('start_event', help='Name of event starting the chain')
+    parser.add_argument('end_event', help='Name of event ending the chain')
+    parser.add_argument('--end_state',
+                        choices=[s.value for s in ChainEndState],
+                        default=ChainEndState.SUBMIT.value,
+                        help='State of end event used for measurement')
+    parser.add_argument('--start_time', type=float, default=0,
+                        help='Measurement start time[s]')
+    parser.add_argument('--end_time', type=float, default=float('inf'),
+                        help='Measurement end time[s]')
+    parser.add_argument('--hist_bin_width', type=float, default=0.1,
+                        help='Histogram bin width[ms]')
+    parser.add_argument('--percentiles', type=float, nargs='+',
+                        default=[50, 90, 99, 99.9],
+                        help='Percentiles to calculate')
+    parser.add_argument('--link', nargs=2, action='append', default=[],
+                        metavar=('SRC_EVENT', 'DST_EVENT'),
+                        help='Continue chain that reached SRC_EVENT with '
+                             'DST_EVENT submitted outside of event '
+                             'processing (e.g. from an interrupt)')
+    parser.add_argument('--plot', action='store_true',
+                        help='Plot and save the histogram')
+    parser.add_argument('--log', help='Log level')
+    args = parser.parse_args()
+
+    if args.log is not None:
+        log_lvl_number = int(getattr(logging, args.log.upper(), None))
+    else:
+        log_lvl_number = logging.INFO
+
+    chains = EventChains(args.dataset_name + ".csv",
+                         args.dataset_name + ".json", log_lvl_number)
+    hist, paths = chains.latency(args.start_event, args.end_event,
+                                 ChainEndState(args.end_state),
+                                 args.hist_bin_width, args.start_time,
+                                 args.end_time, args.link)
+
+    title = "From {} submission to {} {}".format(args.start_event,
+                                                 args.end_event,
+                                                 args.end_state)
+    print(title)
+    print(chains.prepare_stats_txt(hist, args.percentiles))
+
+    print("Event chains:")
+    for path, count in sorted(paths.items(), key=lambda x: -x[1]):
+        print("{:8d} {}".format(count, chains.path_names(path)))
+
+    if hist.count == 0:
+        return
+
+    dir_name = "{}{}/".format(OUTPUT_FOLDER, args.dataset_name)
+    if not os.path.exists(dir_name):
+        os.makedirs(dir_name)
+
+    file_name = dir_name + title.lower().replace(' ', '_')
+    EventChains.write_histogram_csv(hist, file_name + '.csv')
+
+    if args.plot:
+        import matplotlib.pyplot as plt
+
+        bins, counts = zip(*hist.items())
+        plt.figure()
+        plt.bar(bins, counts, width=hist.bin_width_ms, align='edge')
+        plt.xlabel('Duration[ms]')
+        plt.ylabel('Number of occurrences')
+        plt.title(title + ' (' + args.dataset_name + ')')
+        plt.yscale('log')
+        plt.grid(True)
+        plt.savefig(file_name + '.png')
+        plt.show()
+
+
+if __name__ == "__main__":
+    main()
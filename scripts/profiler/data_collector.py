@@ -3,7 +3,7 @@
 #
 # SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
 
-from rtt_nordic_profiler_host import RttNordicProfilerHost
+from profiler_backends import add_backend_arguments, create_profiler_host
 import sys
 import argparse
 import logging
@@ -17,6 +17,7 @@ def main():
     parser.add_argument('time', type=int, help='Time of collecting data [s]')
     parser.add_argument('dataset_name', help='Name of dataset')
     parser.add_argument('--log', help='Log level')
+    add_backend_arguments(parser)
     args = parser.parse_args()
 
     if args.log is not None:
@@ -30,7 +31,8 @@ def main():
     signal.signal(signal.SIGINT, sigint_handler)
     end_ev = threading.Event()
 
-    profiler = RttNordicProfilerHost(
+    profiler = create_profiler_host(
+                args,
                 event_filename=args.dataset_name + ".csv",
                 finish_event=end_ev,
                 event_types_filename=args.dataset_name + ".json",
@@ -0,0 +1,253 @@
+#
+# Copyright (c) 2021 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+
+from events import EventsData
+from enum import Enum
+from collections import deque
+import ast
+import csv
+import logging
+import math
+import sys
+
+
+MEM_ADDRESS_LABEL = 'mem_address'
+
+# Maximum number of chains waiting for an asynchronous continuation
+LINK_QUEUE_MAX_LEN = 1024
+
+
+class ChainEndState(Enum):
+    SUBMIT = 'submit'
+    PROC_START = 'proc_start'
+    PROC_END = 'proc_end'
+
+
+class LatencyHistogram():
+    """Fixed bin width histogram of latencies.
+
+    Memory usage does not depend on the number of samples. Percentiles are
+    approximated with the accuracy of a single bin width.
+    """
+
+    def __init__(self, bin_width_ms):
+        self.bin_width_ms = bin_width_ms
+        self.bins = {}
+        self.count = 0
+        self.sum = 0
+        self.min = float('inf')
+        self.max = float('-inf')
+
+    def add(self, latency_ms):
+        idx = int(math.floor(latency_ms / self.bin_width_ms))
+        self.bins[idx] = self.bins.get(idx, 0) + 1
+        self.count += 1
+        self.sum += latency_ms
+        self.min = min(self.min, latency_ms)
+        self.max = max(self.max, latency_ms)
+
+    def mean(self):
+        return self.sum / self.count if self.count > 0 else None
+
+    def percentile(self, p):
+        if self.count == 0:
+            return None
+
+        threshold = p / 100 * self.count
+        cumulative = 0
+        for idx in sorted(self.bins):
+            cumulative += self.bins[idx]
+            if cumulative >= threshold:
+                # Upper edge of the bin, limited by the measured maximum
+                return min((idx + 1) * self.bin_width_ms, self.max)
+
+        return self.max
+
+    def items(self):
+        for idx in sorted(self.bins):
+            yield idx * self.bin_width_ms, self.bins[idx]
+
+
+class _ChainNode():
+    __slots__ = ['type_id', 'root_type_id', 'root_timestamp', 'path']
+
+    def __init__(self, type_id, root_type_id, root_timestamp, path):
+        self.type_id = type_id
+        self.root_type_id = root_type_id
+        self.root_timestamp = root_timestamp
+        self.path = path
+
+
+class EventChains():
+    """Follows Event Manager event chains in a profiler dataset.
+
+    An event that is submitted while another event is being processed is
+    treated as derived from the processed event. The chain origin is
+    propagated through all of the derived events, so the latency from the
+    submission of the origin to any later event of the chain can be
+    measured. Events are read from the csv file one by one and only the
+    events that are not yet processed are kept in memory.
+
+    Events submitted outside of the Event Manager processing (for example,
+    from an interrupt that signals completion of an asynchronous operation)
+    start a new chain. Such a chain can be linked with an earlier one by
+    specifying a pair of event names: an event of the second type that
+    starts a new chain continues the oldest chain that reached an event of
+    the first type and was not continued yet.
+
+    Requires the dataset to be collected with the event execution tracking
+    enabled (CONFIG_DESKTOP_EVENT_MANAGER_TRACE_EVENT_EXECUTION).
+    """
+
+    def __init__(self, events_filename, events_types_filename,
+                 log_lvl=logging.WARNING):
+        self.events_filename = events_filename
+        self.types = EventsData([], {})
+        self.types._read_events_types_json(events_types_filename)
+
+        self.logger = logging.getLogger('Event Chains')
+        self.logger_console = logging.StreamHandler()
+        self.logger.setLevel(log_lvl)
+        self.log_format = logging.Formatter(
+            '[%(levelname)s] %(name)s: %(message)s')
+        self.logger_console.setFormatter(self.log_format)
+        self.logger.addHandler(self.logger_console)
+
+        self.proc_start_id = self.types.get_event_type_id(
+            'event_processing_start')
+        self.proc_end_id = self.types.get_event_type_id(
+            'event_processing_end')
+
+        if self.proc_start_id is None or self.proc_end_id is None:
+            self.logger.error("Event processing is not tracked in the dataset")
+            sys.exit()
+
+        self.tracked_types = set(
+            type_id for type_id, et in self.types.registered_events_types.items()
+            if len(et.data_descriptions) > 0
+            and et.data_descriptions[0] == MEM_ADDRESS_LABEL
+            and type_id not in (self.proc_start_id, self.proc_end_id))
+
+    def _get_type_id(self, name):
+        type_id = self.types.get_event_type_id(name)
+        if type_id is None:
+            self.logger.error("Event name not found: " + name)
+            sys.exit()
+        if type_id not in self.tracked_types:
+            self.logger.error("Event is not tracked: " + name)
+            sys.exit()
+        return type_id
+
+    def _read_events(self):
+        try:
+            with open(self.events_filename, 'r', newline='') as csvfile:
+                rd = csv.DictReader(csvfile, delimiter=',')
+                for row in rd:
+                    yield (int(row['type_id']), float(row['timestamp']),
+                           ast.literal_eval(row['data']))
+        except IOError:
+            self.logger.error("Problem with accessing file: " +
+                              self.events_filename)
+            sys.exit()
+
+    def path_names(self, path):
+        return ' -> '.join(self.types.registered_events_types[type_id].name
+                           for type_id in path)
+
+    def latency(self, start_name, end_name,
+                end_state=ChainEndState.SUBMIT, hist_bin_width_ms=0.1,
+                start_meas=0, end_meas=float('inf'), links=()):
+        """Measure latency from submission of start event to end event.
+
+        Returns a tuple of LatencyHistogram and a dictionary with number of
+        occurrences of every event chain path that led to the end event.
+        """
+        start_id = self._get_type_id(start_name)
+        end_id = self._get_type_id(end_name)
+
+        # Chains waiting for continuation, by type of the continuing event
+        link_sources = {}
+        link_queues = {}
+        for src_name, dst_name in links:
+            src_id = self._get_type_id(src_name)
+            link_sources[self._get_type_id(dst_name)] = src_id
+            link_queues[src_id] = deque(maxlen=LINK_QUEUE_MAX_LEN)
+
+        hist = LatencyHistogram(hist_bin_width_ms)
+        paths = {}
+
+        # Submitted events not yet processed, by memory address
+        pending = {}
+        # Event being processed, by memory address
+        processing = {}
+        current = None
+
+        def record(node, timestamp):
+            if node.type_id != end_id or node.root_type_id != start_id:
+                return
+            if node.root_timestamp < start_meas or timestamp > end_meas:
+                return
+            hist.add((timestamp - node.root_timestamp) * 1000)
+            paths[node.path] = paths.get(node.path, 0) + 1
+
+        for type_id, timestamp, data in self._read_events():
+            if type_id == self.proc_start_id:
+                node = pending.pop(data[0], None)
+                if node is not None:
+                    processing[data[0]] = node
+                    if end_state == ChainEndState.PROC_START:
+                        record(node, timestamp)
+                current = node
+
+            elif type_id == self.proc_end_id:
+                node = processing.pop(data[0], None)
+                if node is not None and end_state == ChainEndState.PROC_END:
+                    record(node, timestamp)
+                current = None
+
+            elif type_id in self.tracked_types:
+                parent = current
+                if parent is None and type_id in link_sources:
+                    queue = link_queues[link_sources[type_id]]
+                    if len(queue) > 0:
+                        parent = queue.popleft()
+
+                if parent is not None:
+                    node = _ChainNode(type_id, parent.root_type_id,
+                                      parent.root_timestamp,
+                                      parent.path + (type_id,))
+                else:
+                    node = _ChainNode(type_id, type_id, timestamp, (type_id,))
+
+                if type_id in link_queues:
+                    link_queues[type_id].append(node)
+
+                # Memory address may be reused after the event is freed
+                pending[data[0]] = node
+                if end_state == ChainEndState.SUBMIT:
+                    record(node, timestamp)
+
+        return hist, paths
+
+    def prepare_stats_txt(self, hist, percentiles):
+        stats_text = "Number of records: {}\n".format(hist.count)
+        if hist.count == 0:
+            return stats_text
+
+        stats_text += "Min time: {0:.3f}ms\n".format(hist.min)
+        stats_text += "Max time: {0:.3f}ms\n".format(hist.max)
+        stats_text += "Mean time: {0:.3f}ms\n".format(hist.mean())
+        for p in percentiles:
+            stats_text += "P{}: {:.3f}ms\n".format(p, hist.percentile(p))
+
+        return stats_text
+
+    @staticmethod
+    def write_histogram_csv(hist, filename):
+        with open(filename, 'w', newline='') as csvfile:
+            wr = csv.writer(csvfile, delimiter=',')
+            wr.writerow(['bin_start_ms', 'count'])
+            for bin_start, count in hist.items():
+                wr.writerow([bin_start, count])
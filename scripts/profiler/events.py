@@ -3,6 +3,7 @@
 #
 # SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
 
+import ast
 import csv
 import json
 import hashlib
@@ -113,10 +114,8 @@ class EventsData():
                     type_id = int(row['type_id'])
                     timestamp = float(row['timestamp'])
                     # reading event data from single row in csv file
-                    if (row['data'][1:-1] != ''):
-                        data = list(map(int, (row['data'][1:-1].split(','))))
-                    else:
-                        data = []
+                    # (data fields may be numbers or strings)
+                    data = ast.literal_eval(row['data'])
                     ev = Event(type_id, timestamp, data)
                     self.events.append(ev)
         except IOError:
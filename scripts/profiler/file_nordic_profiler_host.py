@@ -0,0 +1,93 @@
+#
+# Copyright (c) 2021 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+
+from rtt_nordic_profiler_host import RttNordicProfilerHost
+import sys
+
+DUMP_INFO_START = 'profiler_info_start'
+DUMP_DATA_START = 'profiler_data_start'
+DUMP_DATA_END = 'profiler_data_end'
+
+
+class FileNordicProfilerHost(RttNordicProfilerHost):
+    """Reads profiler data that was stored by the device instead of being
+    sent over RTT.
+
+    Either the files written by the host file backend (native_posix) or
+    a shell log with the output of the profiler_dump command (RAM backend)
+    can be used.
+    """
+
+    def __init__(self, info_filename=None, data_filename=None,
+                 dump_filename=None, **kwargs):
+        self.info_filename = info_filename
+        self.data_filename = data_filename
+        self.dump_filename = dump_filename
+        self.info = ''
+        self.data = bytearray()
+        self.data_offset = 0
+        super().__init__(**kwargs)
+
+    def connect(self):
+        try:
+            if self.dump_filename is not None:
+                self._parse_dump(self.dump_filename)
+            else:
+                with open(self.info_filename, 'r') as f:
+                    self.info = f.read()
+                with open(self.data_filename, 'rb') as f:
+                    self.data = f.read()
+        except IOError as e:
+            self.logger.error("Problem with accessing file: " + str(e))
+            sys.exit()
+
+        self.logger.info("Loaded {} bytes of profiler data".format(
+                         len(self.data)))
+
+    def _parse_dump(self, filename):
+        section = None
+        info = ''
+        with open(filename, 'r', errors='replace') as f:
+            for line in f:
+                line = line.strip()
+                if line.endswith(DUMP_INFO_START):
+                    # Only the last description is used
+                    section = 'info'
+                    info = ''
+                elif line.endswith(DUMP_DATA_START):
+                    section = 'data'
+                elif line.endswith(DUMP_DATA_END):
+                    section = None
+                elif section == 'info':
+                    info += line + '\n'
+                elif section == 'data' and len(line) > 0:
+                    self.data += bytes.fromhex(line)
+
+        self.info = info
+
+    def _read_data_chunk(self):
+        chunk_size = self.config['rtt_read_chunk_size']
+        chunk = self.data[self.data_offset:self.data_offset + chunk_size]
+        self.data_offset += len(chunk)
+        return chunk
+
+    def _read_info_chunk(self):
+        # Empty line terminates the descriptions if the data is truncated
+        info = self.info if len(self.info) > 0 else '\n'
+        self.info = ''
+        return info
+
+    def _write_command(self, command):
+        pass
+
+    def _close_connection(self):
+        pass
+
+    def read_events_rtt(self, time_seconds):
+        # All data is already available, so the time limit is not used.
+        self.logger.info("Processing events data")
+        self.shutdown()
+        self.logger.info("Events data saved to files")
+        sys.exit()
@@ -0,0 +1,38 @@
+#
+# Copyright (c) 2021 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+
+BACKENDS = ('rtt', 'uart', 'file', 'dump')
+
+
+def add_backend_arguments(parser):
+    parser.add_argument('--backend', choices=BACKENDS, default='rtt',
+                        help='Profiler backend used by the device '
+                             '(dump: shell log with profiler_dump output)')
+    parser.add_argument('--port', help='Serial port (uart backend)')
+    parser.add_argument('--baudrate', type=int, default=115200,
+                        help='Serial port baudrate (uart backend)')
+    parser.add_argument('--info-file', default='profiler_info.txt',
+                        help='Event descriptions file (file backend)')
+    parser.add_argument('--data-file', default='profiler_data.bin',
+                        help='Event data file (file backend)')
+    parser.add_argument('--dump-file',
+                        help='Shell log with profiler_dump output '
+                             '(dump backend)')
+
+
+def create_profiler_host(args, **kwargs):
+    if args.backend == 'uart':
+        from uart_nordic_profiler_host import UartNordicProfilerHost
+        return UartNordicProfilerHost(args.port, args.baudrate, **kwargs)
+    elif args.backend == 'file':
+        from file_nordic_profiler_host import FileNordicProfilerHost
+        return FileNordicProfilerHost(info_filename=args.info_file,
+                                      data_filename=args.data_file, **kwargs)
+    elif args.backend == 'dump':
+        from file_nordic_profiler_host import FileNordicProfilerHost
+        return FileNordicProfilerHost(dump_filename=args.dump_file, **kwargs)
+
+    from rtt_nordic_profiler_host import RttNordicProfilerHost
+    return RttNordicProfilerHost(**kwargs)
@@ -4,7 +4,7 @@
 # SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
 
 from plot_nordic import PlotNordic
-from rtt_nordic_profiler_host import RttNordicProfilerHost
+from profiler_backends import add_backend_arguments, create_profiler_host
 
 import argparse
 import threading
@@ -12,11 +12,12 @@ import queue
 import sys
 import logging
 
-def rtt_thread(queue, finish_event, event_filename, event_types_filename, log_lvl_number):
-    profiler = RttNordicProfilerHost(finish_event=finish_event, queue=queue,
-                                     event_filename=event_filename,
-                                     event_types_filename=event_types_filename,
-                                     log_lvl=log_lvl_number)
+def rtt_thread(args, queue, finish_event, event_filename, event_types_filename, log_lvl_number):
+    profiler = create_profiler_host(args, finish_event=finish_event,
+                                    queue=queue,
+                                    event_filename=event_filename,
+                                    event_types_filename=event_types_filename,
+                                    log_lvl=log_lvl_number)
     profiler.get_events_descriptions()
     profiler.read_events_rtt(-1)
 
@@ -25,6 +26,7 @@ def main():
         description='Collecting data from Nordic profiler for given time and saving to files.')
     parser.add_argument('dataset_name', help='Name of dataset')
     parser.add_argument('--log', help='Log level')
+    add_backend_arguments(parser)
     args = parser.parse_args()
 
     if args.log is not None:
@@ -36,7 +38,7 @@ def main():
     que = queue.Queue()
     t_rtt = threading.Thread(
         target=rtt_thread,
-        args=[que, ev, args.dataset_name + ".csv",
+        args=[args, que, ev, args.dataset_name + ".csv",
               args.dataset_name + ".json", log_lvl_number])
     t_rtt.start()
 
@@ -3,8 +3,13 @@
 #
 # SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
 
-from pynrfjprog.LowLevel import API
-from pynrfjprog.APIError import APIError
+try:
+    from pynrfjprog.LowLevel import API
+    from pynrfjprog.APIError import APIError
+except ImportError:
+    # pynrfjprog is only needed to use the RTT backend
+    API = None
+    APIError = OSError
 import time
 import sys
 from enum import Enum
@@ -12,12 +17,30 @@ from rtt_nordic_config import RttNordicConfig
 from events import Event, EventType, EventsData
 import logging
 
+class TransportError(Exception):
+    pass
+
+
 class Command(Enum):
     START = 1
     STOP = 2
     INFO = 3
 
 
+# Event type ID used by the compact encoding to report dropped events
+DROPPED_EVENTS_ID = 0xFFFF
+
+DATA_TYPE_BITS = {
+    'u8': 8,
+    's8': 8,
+    'u16': 16,
+    's16': 16,
+    'u32': 32,
+    's32': 32,
+    't': 32
+}
+
+
 class RttNordicProfilerHost:
 
     def __init__(self, config=RttNordicConfig, finish_event=None,
@@ -31,6 +54,9 @@ class RttNordicProfilerHost:
         self.received_events = EventsData([], {})
         self.timestamp_overflows = 0
         self.after_half = False
+        self.compact_encoding = False
+        self.timestamp_raw = None
+        self.dropped_events = 0
 
         self.desc_buf = ""
         self.bufs = list()
@@ -100,12 +126,10 @@ class RttNordicProfilerHost:
         # read remaining data to buffer
         while True:
             try:
-                buf = self.jlink.rtt_read(self.config['rtt_data_channel'],
-                                          self.config['rtt_read_chunk_size'],
-                                          encoding=None)
+                buf = self._read_data_chunk()
 
-            except APIError:
-                self.logger.error("Problem with reading RTT data.")
+            except TransportError:
+                self.logger.error("Problem with reading data.")
                 buf = []
 
             if len(buf) > 0:
@@ -115,16 +139,47 @@ class RttNordicProfilerHost:
                 break
 
         try:
-            self.jlink.rtt_stop()
-            self.jlink.disconnect_from_emu()
-            self.jlink.close()
+            self._close_connection()
 
-        except APIError:
-            self.logger.error("JLink connection lost. Saving collected data.")
+        except TransportError:
+            self.logger.error("Connection lost. Saving collected data.")
             return
 
         self.logger.info("Disconnected from device")
 
+    # Transport specific methods, overridden by hosts using other profiler
+    # backends than RTT.
+    def _read_data_chunk(self):
+        try:
+            return self.jlink.rtt_read(self.config['rtt_data_channel'],
+                                       self.config['rtt_read_chunk_size'],
+                                       encoding=None)
+        except APIError as e:
+            raise TransportError() from e
+
+    def _read_info_chunk(self):
+        try:
+            return self.jlink.rtt_read(self.config['rtt_info_channel'],
+                                       self.config['rtt_read_chunk_size'],
+                                       encoding='utf-8')
+        except APIError as e:
+            raise TransportError() from e
+
+    def _write_command(self, command):
+        try:
+            self.jlink.rtt_write(self.config['rtt_command_channel'], command,
+                                 None)
+        except APIError as e:
+            raise TransportError() from e
+
+    def _close_connection(self):
+        try:
+            self.jlink.rtt_stop()
+            self.jlink.disconnect_from_emu()
+            self.jlink.close()
+        except APIError as e:
+            raise TransportError() from e
+
     def _get_buffered_data(self, num_bytes):
         buf = bytearray()
         while len(buf) < num_bytes:
@@ -148,11 +203,9 @@ class RttNordicProfilerHost:
                 break
 
             try:
-                buf = self.jlink.rtt_read(self.config['rtt_data_channel'],
-                                          self.config['rtt_read_chunk_size'],
-                                          encoding=None)
-            except APIError:
-                self.logger.error("Problem with reading RTT data.")
+                buf = self._read_data_chunk()
+            except TransportError:
+                self.logger.error("Problem with reading data.")
                 self.shutdown()
                 sys.exit()
 
@@ -186,12 +239,10 @@ class RttNordicProfilerHost:
     def _read_single_event_description(self):
         while '\n' not in self.desc_buf:
             try:
-                buf_temp = self.jlink.rtt_read(self.config['rtt_info_channel'],
-                                      self.config['rtt_read_chunk_size'],
-                                      encoding='utf-8')
+                buf_temp = self._read_info_chunk()
 
-            except APIError:
-                self.logger.error("Problem with reading RTT data.")
+            except TransportError:
+                self.logger.error("Problem with reading data.")
                 self.shutdown()
 
             self.desc_buf += buf_temp
@@ -205,6 +256,12 @@ class RttNordicProfilerHost:
 
         desc_fields = desc.split(',')
 
+        # Lines starting with '#' describe the protocol, not an event
+        if desc_fields[0] == '#encoding':
+            self.compact_encoding = (desc_fields[1] == 'compact')
+            self.logger.info("Using {} encoding".format(desc_fields[1]))
+            return self._read_single_event_description()
+
         name = desc_fields[0]
         id = int(desc_fields[1])
         data_type = []
@@ -230,7 +287,68 @@ class RttNordicProfilerHost:
         self.logger.info("Received events descriptions")
         self.logger.info("Ready to start logging events")
 
+    def _read_varint(self):
+        value = 0
+        shift = 0
+        while True:
+            byte = self._read_bytes(1)[0]
+            value |= (byte & 0x7f) << shift
+            shift += 7
+            if not byte & 0x80:
+                return value
+
+    @staticmethod
+    def _zigzag_decode(value):
+        return (value >> 1) ^ -(value & 1)
+
+    @staticmethod
+    def _to_data_type(value, data_type):
+        bits = DATA_TYPE_BITS[data_type]
+        value &= (1 << bits) - 1
+        if data_type[0] == 's' and value & (1 << (bits - 1)):
+            value -= 1 << bits
+        return value
+
+    def _read_string(self):
+        str_len = self._read_bytes(1)[0]
+        return self._read_bytes(str_len).decode('utf-8', errors='replace')
+
+    def _read_single_event_rtt_compact(self):
+        id = self._read_varint()
+        delta = RttNordicProfilerHost._zigzag_decode(self._read_varint())
+
+        # Timestamps are sent as differences from the previous event
+        if self.timestamp_raw is None:
+            self.timestamp_raw = delta % self.config['timestamp_raw_max']
+        else:
+            self.timestamp_raw += delta
+
+        timestamp = self.config['ms_per_timestamp_tick'] * \
+                    self.timestamp_raw / 1000
+
+        if id == DROPPED_EVENTS_ID:
+            dropped = self._read_varint()
+            self.dropped_events += dropped
+            self.logger.warning("{} events dropped by device at {:.6f} s "
+                                "(total: {})".format(dropped, timestamp,
+                                                     self.dropped_events))
+            return None
+
+        et = self.received_events.registered_events_types[id]
+
+        data = []
+        for i in et.data_types:
+            if i == 's':
+                data.append(self._read_string())
+            else:
+                data.append(RttNordicProfilerHost._to_data_type(
+                                self._read_varint(), i))
+        return Event(id, timestamp, data)
+
     def _read_single_event_rtt(self):
+        if self.compact_encoding:
+            return self._read_single_event_rtt_compact()
+
         id = int.from_bytes(
             self._read_bytes(1),
             byteorder=self.config['byteorder'],
@@ -257,6 +375,9 @@ class RttNordicProfilerHost:
 
         data = []
         for i in et.data_types:
+            if i == 's':
+                data.append(self._read_string())
+                continue
             signum = False
             if i[0] == 's':
                 signum = True
@@ -269,6 +390,8 @@ class RttNordicProfilerHost:
         self.reading_data = False
         while self.bcnt != 0:
             event = self._read_single_event_rtt()
+            if event is None:
+                continue
             self.received_events.events.append(event)
             if self.queue is not None:
                 self.queue.put(event)
@@ -284,16 +407,22 @@ class RttNordicProfilerHost:
         current_time = start_time
         while current_time - start_time < time_seconds or time_seconds < 0:
             event = self._read_single_event_rtt()
+            current_time = time.time()
+            if event is None:
+                continue
             self.received_events.events.append(event)
             if self.queue is not None:
                 self.queue.put(event)
-            current_time = time.time()
         self.logger.info("Real time transmission closed")
+        if self.dropped_events > 0:
+            self.logger.warning("Total events dropped by device: {}".format(
+                                self.dropped_events))
         self.shutdown()
         self.logger.info("Events data saved to files")
         sys.exit()
 
     def start_logging_events(self):
+        self.timestamp_raw = None
         self._send_command(Command.START)
 
     def stop_logging_events(self):
@@ -303,6 +432,6 @@ class RttNordicProfilerHost:
         command = bytearray(1)
         command[0] = command_type.value
         try:
-            self.jlink.rtt_write(self.config['rtt_command_channel'], command, None)
-        except APIError:
-            self.logger.error("Problem with writing RTT data.")
+            self._write_command(command)
+        except TransportError:
+            self.logger.error("Problem with writing data.")
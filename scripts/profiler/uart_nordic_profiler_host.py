@@ -0,0 +1,88 @@
+#
+# Copyright (c) 2021 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+
+from rtt_nordic_profiler_host import RttNordicProfilerHost, TransportError
+import serial
+import sys
+
+FRAME_CHANNEL_DATA = 1
+FRAME_CHANNEL_INFO = 2
+FRAME_HEADER_SIZE = 2
+
+
+class UartNordicProfilerHost(RttNordicProfilerHost):
+    """Receives profiler data sent over UART by the UART backend.
+
+    Data and event descriptions are multiplexed on a single UART. Every
+    frame consists of a channel ID, payload length and the payload.
+    """
+
+    def __init__(self, port, baudrate=115200, **kwargs):
+        self.port = port
+        self.baudrate = baudrate
+        self.rx_buf = bytearray()
+        self.data_buf = bytearray()
+        self.info_buf = ''
+        super().__init__(**kwargs)
+
+    def connect(self):
+        try:
+            self.serial = serial.Serial(self.port, self.baudrate, timeout=0)
+        except serial.SerialException:
+            self.logger.error("Cannot open serial port " + self.port)
+            sys.exit()
+
+        self.logger.info("Connected to device via " + self.port)
+
+    def _poll(self):
+        try:
+            self.rx_buf += self.serial.read(self.serial.in_waiting or 1)
+        except serial.SerialException as e:
+            raise TransportError() from e
+
+        while len(self.rx_buf) >= FRAME_HEADER_SIZE:
+            channel = self.rx_buf[0]
+            length = self.rx_buf[1]
+
+            if channel not in (FRAME_CHANNEL_DATA, FRAME_CHANNEL_INFO):
+                # Drop data until the start of a valid frame
+                self.logger.warning("Invalid frame, resynchronizing")
+                del self.rx_buf[0]
+                continue
+
+            if len(self.rx_buf) < FRAME_HEADER_SIZE + length:
+                break
+
+            payload = self.rx_buf[FRAME_HEADER_SIZE:FRAME_HEADER_SIZE + length]
+            del self.rx_buf[:FRAME_HEADER_SIZE + length]
+
+            if channel == FRAME_CHANNEL_DATA:
+                self.data_buf += payload
+            else:
+                self.info_buf += payload.decode('utf-8', errors='replace')
+
+    def _read_data_chunk(self):
+        self._poll()
+        chunk = bytes(self.data_buf)
+        self.data_buf = bytearray()
+        return chunk
+
+    def _read_info_chunk(self):
+        self._poll()
+        info = self.info_buf
+        self.info_buf = ''
+        return info
+
+    def _write_command(self, command):
+        try:
+            self.serial.write(command)
+        except serial.SerialException as e:
+            raise TransportError() from e
+
+    def _close_connection(self):
+        try:
+            self.serial.close()
+        except serial.SerialException as e:
+            raise TransportError() from e
@@ -7,7 +7,11 @@
 #include <inttypes.h>
 #include <zephyr.h>
 #include <logging/log.h>
+#include <settings/settings.h>
+#include <net/buf.h>
 
+#include <bluetooth/bluetooth.h>
+#include <bluetooth/conn.h>
 #include <bluetooth/gatt_dm.h>
 
 LOG_MODULE_REGISTER(bt_gatt_dm, CONFIG_BT_GATT_DM_LOG_LEVEL);
@@ -26,6 +30,7 @@ BUILD_ASSERT(sizeof(struct bt_gatt_chrc) % DATA_ALIGN == 0);
 enum {
 	STATE_ATTRS_LOCKED,
 	STATE_ATTRS_RELEASE_PENDING,
+	STATE_DISCONNECTED,
 	STATE_NUM
 };
 
@@ -37,10 +42,20 @@ struct data_chunk_item {
 	uint8_t data[CHUNK_DATA_SIZE];
 };
 
+#define UUID_128_LEN 16
+#define CACHE_DB_HASH_LEN 16
+#define CACHE_HDR_LEN (CACHE_DB_HASH_LEN + sizeof(uint16_t))
+#define CACHE_KEY_BASE "gatt_dm"
+/* Base, separators, address and UUID in hexadecimal format */
+#define CACHE_KEY_LEN (sizeof(CACHE_KEY_BASE) + 2 + \
+		       2 * sizeof(bt_addr_le_t) + 2 * UUID_128_LEN)
+
 /* The instance structure real declaration */
 struct bt_gatt_dm {
 	/* Connection object */
 	struct bt_conn *conn;
+	/* Required by the sys_slist of allocated instances */
+	sys_snode_t node;
 	/* The user context */
 	void *context;
 
@@ -60,10 +75,164 @@ struct bt_gatt_dm {
 
 	/* The pointer to callback structure */
 	const struct bt_gatt_dm_cb *callback;
+
+#if CONFIG_BT_GATT_DM_CACHE
+	/* Parameters used to read the peer's database hash */
+	struct bt_gatt_read_params read_params;
+	/* Work used to restore the attributes from the settings */
+	struct k_work cache_work;
+	/* Identity address of the bonded peer */
+	bt_addr_le_t peer;
+	/* Database hash read from the peer */
+	uint8_t db_hash[CACHE_DB_HASH_LEN];
+	/* Discovery results of the bonded peer can be cached */
+	bool cache_enabled;
+	/* The database hash was read from the peer */
+	bool db_hash_valid;
+	/* The attributes were restored from the cache */
+	bool from_cache;
+#endif
 };
 
-/* Currently only one instance is supported */
-static struct bt_gatt_dm bt_gatt_dm_inst;
+#if CONFIG_BT_GATT_DM_CACHE
+/* Discovery results that are written to the settings from a work item */
+struct cache_save_item {
+	struct k_work work;
+	char key[CACHE_KEY_LEN];
+	size_t len;
+	uint8_t data[];
+};
+#endif
+
+K_MEM_SLAB_DEFINE(bt_gatt_dm_slab, sizeof(struct bt_gatt_dm),
+		  CONFIG_BT_GATT_DM_MAX_INSTANCES, 4);
+
+/* Instances allocated from the slab, protected by dm_lock */
+static sys_slist_t dm_list = SYS_SLIST_STATIC_INIT(&dm_list);
+static struct k_spinlock dm_lock;
+static atomic_t conn_cb_registered;
+
+/* Returns a locked instance for the connection.
+ *
+ * The instance that is already bound to the connection is used if it is not
+ * locked. Otherwise, a new instance is allocated. If the slab is exhausted,
+ * an idle instance of another connection is taken over. The instance holds
+ * a reference to its connection.
+ */
+static int dm_alloc(struct bt_conn *conn, struct bt_gatt_dm **dm_out)
+{
+	struct bt_gatt_dm *dm;
+	struct bt_gatt_dm *idle = NULL;
+	struct bt_conn *prev_conn = NULL;
+	int err = 0;
+	k_spinlock_key_t key = k_spin_lock(&dm_lock);
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&dm_list, dm, node) {
+		if (dm->conn == conn) {
+			break;
+		}
+
+		if (!idle &&
+		    !atomic_test_bit(dm->state_flags, STATE_ATTRS_LOCKED)) {
+			idle = dm;
+		}
+	}
+
+	if (dm) {
+		if (atomic_test_bit(dm->state_flags, STATE_ATTRS_LOCKED)) {
+			err = -EALREADY;
+		}
+	} else if (!k_mem_slab_alloc(&bt_gatt_dm_slab, (void **)&dm,
+				     K_NO_WAIT)) {
+		memset(dm, 0, sizeof(*dm));
+		dm->conn = bt_conn_ref(conn);
+		sys_slist_append(&dm_list, &dm->node);
+	} else if (idle) {
+		dm = idle;
+		prev_conn = dm->conn;
+		dm->conn = bt_conn_ref(conn);
+	} else {
+		err = -ENOMEM;
+	}
+
+	if (!err) {
+		atomic_set_bit(dm->state_flags, STATE_ATTRS_LOCKED);
+		*dm_out = dm;
+	}
+
+	k_spin_unlock(&dm_lock, key);
+
+	if (prev_conn) {
+		bt_conn_unref(prev_conn);
+	}
+
+	return err;
+}
+
+static void dm_free(struct bt_gatt_dm *dm)
+{
+	k_spinlock_key_t key = k_spin_lock(&dm_lock);
+
+	sys_slist_find_and_remove(&dm_list, &dm->node);
+
+	k_spin_unlock(&dm_lock, key);
+
+	bt_conn_unref(dm->conn);
+	dm->conn = NULL;
+
+	/* Stale instance pointer is rejected by bt_gatt_dm_continue */
+	dm->discover_params.func = NULL;
+	k_mem_slab_free(&bt_gatt_dm_slab, (void **)&dm);
+}
+
+/* Unlocks the instance, or frees it if its connection is gone */
+static void dm_unlock(struct bt_gatt_dm *dm)
+{
+	bool disconnected;
+	k_spinlock_key_t key = k_spin_lock(&dm_lock);
+
+	disconnected = atomic_test_bit(dm->state_flags, STATE_DISCONNECTED);
+	if (!disconnected) {
+		atomic_clear_bit(dm->state_flags, STATE_ATTRS_LOCKED);
+	}
+
+	k_spin_unlock(&dm_lock, key);
+
+	if (disconnected) {
+		dm_free(dm);
+	}
+}
+
+static void dm_disconnected(struct bt_conn *conn, uint8_t reason)
+{
+	struct bt_gatt_dm *dm;
+	bool idle = false;
+	k_spinlock_key_t key = k_spin_lock(&dm_lock);
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&dm_list, dm, node) {
+		if (dm->conn == conn) {
+			break;
+		}
+	}
+
+	/* Instance in use is freed when it is unlocked */
+	if (dm) {
+		atomic_set_bit(dm->state_flags, STATE_DISCONNECTED);
+		idle = !atomic_test_and_set_bit(dm->state_flags,
+						STATE_ATTRS_LOCKED);
+	}
+
+	k_spin_unlock(&dm_lock, key);
+
+	if (idle) {
+		LOG_DBG("Instance released on disconnection.");
+		dm_free(dm);
+	}
+}
+
+static struct bt_conn_cb conn_callbacks = {
+	.disconnected = dm_disconnected,
+};
 
 /* Returns pointer to newly allocated space in a dm->data_chunk */
 static void *user_data_alloc(struct bt_gatt_dm *dm,
@@ -198,6 +367,10 @@ static struct bt_uuid *uuid_store(struct bt_gatt_dm *dm,
 	size_t size = get_uuid_size(uuid);
 	void *buffer = user_data_alloc(dm, size);
 
+	if (!buffer) {
+		return NULL;
+	}
+
 	memcpy(buffer, uuid, size);
 
 	return (struct bt_uuid *)buffer;
@@ -231,9 +404,12 @@ static struct bt_gatt_dm_attr *attr_find_by_handle(
 	return NULL;
 }
 
+static void cache_store(struct bt_gatt_dm *dm);
+
 static void discovery_complete(struct bt_gatt_dm *dm)
 {
 	LOG_DBG("Discovery complete.");
+	cache_store(dm);
 	atomic_set_bit(dm->state_flags, STATE_ATTRS_RELEASE_PENDING);
 	if (dm->callback->completed) {
 		dm->callback->completed(dm, dm->context);
@@ -242,23 +418,37 @@ static void discovery_complete(struct bt_gatt_dm *dm)
 
 static void discovery_complete_not_found(struct bt_gatt_dm *dm)
 {
+	/* Connection is kept valid until the callback returns */
+	struct bt_conn *conn = bt_conn_ref(dm->conn);
+	void *context = dm->context;
+	const struct bt_gatt_dm_cb *callback = dm->callback;
+
 	LOG_DBG("Discover complete. No service found.");
 
 	svc_attr_memory_release(dm);
-	atomic_clear_bit(dm->state_flags, STATE_ATTRS_LOCKED);
+	dm_free(dm);
 
-	if (dm->callback->service_not_found) {
-		dm->callback->service_not_found(dm->conn, dm->context);
+	if (callback->service_not_found) {
+		callback->service_not_found(conn, context);
 	}
+
+	bt_conn_unref(conn);
 }
 
 static void discovery_complete_error(struct bt_gatt_dm *dm, int err)
 {
+	struct bt_conn *conn = bt_conn_ref(dm->conn);
+	void *context = dm->context;
+	const struct bt_gatt_dm_cb *callback = dm->callback;
+
 	svc_attr_memory_release(dm);
-	atomic_clear_bit(dm->state_flags, STATE_ATTRS_LOCKED);
-	if (dm->callback->error_found) {
-		dm->callback->error_found(dm->conn, err, dm->context);
+	dm_free(dm);
+
+	if (callback->error_found) {
+		callback->error_found(conn, err, context);
 	}
+
+	bt_conn_unref(conn);
 }
 
 static uint8_t discovery_process_service(struct bt_gatt_dm *dm,
@@ -406,30 +596,29 @@ static uint8_t discovery_callback(struct bt_conn *conn,
 			       const struct bt_gatt_attr *attr,
 			       struct bt_gatt_discover_params *params)
 {
+	struct bt_gatt_dm *dm = CONTAINER_OF(params, struct bt_gatt_dm,
+					     discover_params);
+
 	if (!attr) {
 		LOG_DBG("NULL attribute");
 	} else {
 		LOG_DBG("Attr: handle %u", attr->handle);
 	}
 
-	if (conn != bt_gatt_dm_inst.conn) {
+	if (conn != dm->conn) {
 		LOG_ERR("Unexpected conn object. Aborting.");
-		discovery_complete_error(&bt_gatt_dm_inst, -EFAULT);
+		discovery_complete_error(dm, -EFAULT);
 		return BT_GATT_ITER_STOP;
 	}
 
 	switch (params->type) {
 	case BT_GATT_DISCOVER_PRIMARY:
 	case BT_GATT_DISCOVER_SECONDARY:
-		return discovery_process_service(&bt_gatt_dm_inst,
-						 attr, params);
+		return discovery_process_service(dm, attr, params);
 	case BT_GATT_DISCOVER_ATTRIBUTE:
-		return discovery_process_attribute(&bt_gatt_dm_inst,
-						   attr, params);
+		return discovery_process_attribute(dm, attr, params);
 	case BT_GATT_DISCOVER_CHARACTERISTIC:
-		return discovery_process_characteristic(&bt_gatt_dm_inst,
-							attr,
-							params);
+		return discovery_process_characteristic(dm, attr, params);
 	default:
 		/* This should not be possible */
 		__ASSERT(false, "Unknown param type.");
@@ -439,6 +628,609 @@ static uint8_t discovery_callback(struct bt_conn *conn,
 	return BT_GATT_ITER_STOP;
 }
 
+#if CONFIG_BT_GATT_DM_CACHE
+
+/* The cached service is stored as the database hash and the number of
+ * attributes (2 bytes), followed by the attribute records:
+ * - handle (2 bytes), permissions (1 byte) and UUID of the attribute,
+ * - for a service: end handle (2 bytes) and service UUID,
+ * - for a characteristic: value handle (2 bytes), properties (1 byte)
+ *   and characteristic UUID.
+ * UUID is stored as its type (1 byte) followed by the value.
+ * Multi-byte values are little-endian.
+ */
+
+union cache_uuid {
+	struct bt_uuid uuid;
+	struct bt_uuid_16 u16;
+	struct bt_uuid_32 u32;
+	struct bt_uuid_128 u128;
+};
+
+struct cache_load_ctx {
+	struct bt_gatt_dm *dm;
+	int err;
+};
+
+struct bond_find_data {
+	const bt_addr_le_t *addr;
+	bool found;
+};
+
+struct cache_stale_key {
+	sys_snode_t node;
+	char key[CACHE_KEY_LEN];
+};
+
+static size_t cache_uuid_size(const struct bt_uuid *uuid)
+{
+	switch (uuid->type) {
+	case BT_UUID_TYPE_16:
+		return sizeof(uint8_t) + sizeof(uint16_t);
+	case BT_UUID_TYPE_32:
+		return sizeof(uint8_t) + sizeof(uint32_t);
+	case BT_UUID_TYPE_128:
+		return sizeof(uint8_t) + UUID_128_LEN;
+	default:
+		return 0;
+	}
+}
+
+static void cache_uuid_encode(struct net_buf_simple *buf,
+			      const struct bt_uuid *uuid)
+{
+	net_buf_simple_add_u8(buf, uuid->type);
+
+	switch (uuid->type) {
+	case BT_UUID_TYPE_16:
+		net_buf_simple_add_le16(buf, BT_UUID_16(uuid)->val);
+		break;
+	case BT_UUID_TYPE_32:
+		net_buf_simple_add_le32(buf, BT_UUID_32(uuid)->val);
+		break;
+	case BT_UUID_TYPE_128:
+		net_buf_simple_add_mem(buf, BT_UUID_128(uuid)->val,
+				       UUID_128_LEN);
+		break;
+	default:
+		__ASSERT(false, "Unsupported UUID type.");
+		break;
+	}
+}
+
+static int cache_uuid_decode(struct net_buf_simple *buf,
+			     union cache_uuid *uuid)
+{
+	if (buf->len < sizeof(uint8_t)) {
+		return -EINVAL;
+	}
+
+	uuid->uuid.type = net_buf_simple_pull_u8(buf);
+
+	size_t size = cache_uuid_size(&uuid->uuid);
+
+	if ((size == 0) || (buf->len < size - sizeof(uint8_t))) {
+		return -EINVAL;
+	}
+
+	switch (uuid->uuid.type) {
+	case BT_UUID_TYPE_16:
+		uuid->u16.val = net_buf_simple_pull_le16(buf);
+		break;
+	case BT_UUID_TYPE_32:
+		uuid->u32.val = net_buf_simple_pull_le32(buf);
+		break;
+	case BT_UUID_TYPE_128:
+		memcpy(uuid->u128.val,
+		       net_buf_simple_pull_mem(buf, UUID_128_LEN),
+		       UUID_128_LEN);
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static size_t cache_attr_size(const struct bt_gatt_dm_attr *attr)
+{
+	const struct bt_gatt_service_val *service_val =
+		bt_gatt_dm_attr_service_val(attr);
+	const struct bt_gatt_chrc *chrc = bt_gatt_dm_attr_chrc_val(attr);
+	size_t size = sizeof(attr->handle) + sizeof(attr->perm) +
+		      cache_uuid_size(attr->uuid);
+
+	if (service_val) {
+		size += sizeof(service_val->end_handle) +
+			cache_uuid_size(service_val->uuid);
+	} else if (chrc) {
+		size += sizeof(chrc->value_handle) + sizeof(chrc->properties) +
+			cache_uuid_size(chrc->uuid);
+	}
+
+	return size;
+}
+
+static void cache_attr_encode(struct net_buf_simple *buf,
+			      const struct bt_gatt_dm_attr *attr)
+{
+	const struct bt_gatt_service_val *service_val =
+		bt_gatt_dm_attr_service_val(attr);
+	const struct bt_gatt_chrc *chrc = bt_gatt_dm_attr_chrc_val(attr);
+
+	net_buf_simple_add_le16(buf, attr->handle);
+	net_buf_simple_add_u8(buf, attr->perm);
+	cache_uuid_encode(buf, attr->uuid);
+
+	if (service_val) {
+		net_buf_simple_add_le16(buf, service_val->end_handle);
+		cache_uuid_encode(buf, service_val->uuid);
+	} else if (chrc) {
+		net_buf_simple_add_le16(buf, chrc->value_handle);
+		net_buf_simple_add_u8(buf, chrc->properties);
+		cache_uuid_encode(buf, chrc->uuid);
+	}
+}
+
+static int cache_attr_decode(struct bt_gatt_dm *dm,
+			     struct net_buf_simple *buf)
+{
+	union cache_uuid uuid;
+	union cache_uuid val_uuid;
+	struct bt_gatt_attr attr = {
+		.uuid = &uuid.uuid,
+	};
+	struct bt_gatt_dm_attr *cur_attr;
+	struct bt_gatt_service_val *service_val;
+	struct bt_gatt_chrc *chrc;
+	uint16_t val_handle = 0;
+	uint8_t properties = 0;
+	size_t additional_len = 0;
+	int err;
+
+	if (buf->len < sizeof(attr.handle) + sizeof(attr.perm)) {
+		return -EINVAL;
+	}
+
+	attr.handle = net_buf_simple_pull_le16(buf);
+	attr.perm = net_buf_simple_pull_u8(buf);
+
+	err = cache_uuid_decode(buf, &uuid);
+	if (err) {
+		return err;
+	}
+
+	if ((bt_uuid_cmp(&uuid.uuid, BT_UUID_GATT_PRIMARY) == 0) ||
+	    (bt_uuid_cmp(&uuid.uuid, BT_UUID_GATT_SECONDARY) == 0)) {
+		additional_len = sizeof(*service_val);
+		if (buf->len < sizeof(val_handle)) {
+			return -EINVAL;
+		}
+		val_handle = net_buf_simple_pull_le16(buf);
+	} else if (bt_uuid_cmp(&uuid.uuid, BT_UUID_GATT_CHRC) == 0) {
+		additional_len = sizeof(*chrc);
+		if (buf->len < sizeof(val_handle) + sizeof(properties)) {
+			return -EINVAL;
+		}
+		val_handle = net_buf_simple_pull_le16(buf);
+		properties = net_buf_simple_pull_u8(buf);
+	}
+
+	if (additional_len) {
+		err = cache_uuid_decode(buf, &val_uuid);
+		if (err) {
+			return err;
+		}
+	}
+
+	/* Attributes must be sorted for the binary search */
+	if ((dm->cur_attr_id > 0) &&
+	    (dm->attrs[dm->cur_attr_id - 1].handle >= attr.handle)) {
+		return -EINVAL;
+	}
+
+	cur_attr = attr_store(dm, &attr, additional_len);
+	if (!cur_attr) {
+		return -ENOMEM;
+	}
+
+	service_val = bt_gatt_dm_attr_service_val(cur_attr);
+	chrc = bt_gatt_dm_attr_chrc_val(cur_attr);
+
+	if (service_val) {
+		service_val->end_handle = val_handle;
+		service_val->uuid = uuid_store(dm, &val_uuid.uuid);
+		if (!service_val->uuid) {
+			return -ENOMEM;
+		}
+	} else if (chrc) {
+		chrc->value_handle = val_handle;
+		chrc->properties = properties;
+		chrc->uuid = uuid_store(dm, &val_uuid.uuid);
+		if (!chrc->uuid) {
+			return -ENOMEM;
+		}
+	}
+
+	return 0;
+}
+
+static int cache_decode(struct bt_gatt_dm *dm, uint8_t *data, size_t len)
+{
+	struct net_buf_simple buf;
+	const struct bt_gatt_service_val *service_val;
+	uint16_t attr_cnt;
+	int err;
+
+	net_buf_simple_init_with_data(&buf, data, len);
+
+	if (buf.len < CACHE_HDR_LEN) {
+		return -EINVAL;
+	}
+
+	if (memcmp(net_buf_simple_pull_mem(&buf, CACHE_DB_HASH_LEN),
+		   dm->db_hash, CACHE_DB_HASH_LEN)) {
+		LOG_DBG("Peer database changed");
+		return -ESTALE;
+	}
+
+	attr_cnt = net_buf_simple_pull_le16(&buf);
+	if ((attr_cnt == 0) || (attr_cnt > ARRAY_SIZE(dm->attrs))) {
+		return -EINVAL;
+	}
+
+	for (size_t i = 0; i < attr_cnt; i++) {
+		err = cache_attr_decode(dm, &buf);
+		if (err) {
+			return err;
+		}
+	}
+
+	service_val = bt_gatt_dm_attr_service_val(&dm->attrs[0]);
+	if ((buf.len > 0) || !service_val ||
+	    bt_uuid_cmp(service_val->uuid, dm->discover_params.uuid)) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void cache_key_get(const bt_addr_le_t *addr, const struct bt_uuid *uuid,
+			  char *key)
+{
+	char addr_str[2 * sizeof(*addr) + 1];
+	char uuid_str[2 * UUID_128_LEN + 1];
+
+	bin2hex((const uint8_t *)addr, sizeof(*addr), addr_str,
+		sizeof(addr_str));
+
+	switch (uuid->type) {
+	case BT_UUID_TYPE_16:
+		snprintk(uuid_str, sizeof(uuid_str), "%04x",
+			 BT_UUID_16(uuid)->val);
+		break;
+	case BT_UUID_TYPE_32:
+		snprintk(uuid_str, sizeof(uuid_str), "%08x",
+			 BT_UUID_32(uuid)->val);
+		break;
+	case BT_UUID_TYPE_128:
+		bin2hex(BT_UUID_128(uuid)->val, UUID_128_LEN, uuid_str,
+			sizeof(uuid_str));
+		break;
+	default:
+		uuid_str[0] = '\0';
+		break;
+	}
+
+	snprintk(key, CACHE_KEY_LEN, CACHE_KEY_BASE "/%s/%s",
+		 addr_str, uuid_str);
+}
+
+static int cache_load_cb(const char *key, size_t len,
+			 settings_read_cb read_cb, void *cb_arg, void *param)
+{
+	struct cache_load_ctx *ctx = param;
+	uint8_t *data;
+	ssize_t rc;
+
+	/* Only the exact key is loaded, deleted entries have no value */
+	if (key || (len == 0)) {
+		return 0;
+	}
+
+	data = k_malloc(len);
+	if (!data) {
+		ctx->err = -ENOMEM;
+		return 0;
+	}
+
+	rc = read_cb(cb_arg, data, len);
+	if (rc == len) {
+		ctx->err = cache_decode(ctx->dm, data, len);
+	} else {
+		ctx->err = -EIO;
+	}
+
+	k_free(data);
+
+	return 0;
+}
+
+static int cache_load(struct bt_gatt_dm *dm)
+{
+	char key[CACHE_KEY_LEN];
+	struct cache_load_ctx ctx = {
+		.dm = dm,
+		.err = -ENOENT,
+	};
+
+	cache_key_get(&dm->peer, dm->discover_params.uuid, key);
+
+	int err = settings_load_subtree_direct(key, cache_load_cb, &ctx);
+
+	if (!err) {
+		err = ctx.err;
+	}
+
+	if (err) {
+		/* Drop partially restored attributes. Their memory is
+		 * released together with the discovered ones.
+		 */
+		dm->cur_attr_id = 0;
+	}
+
+	return err;
+}
+
+static void bond_find(const struct bt_bond_info *info, void *user_data)
+{
+	struct bond_find_data *data = user_data;
+
+	if (!bt_addr_le_cmp(&info->addr, data->addr)) {
+		data->found = true;
+	}
+}
+
+static bool cache_peer_bonded(struct bt_gatt_dm *dm)
+{
+	struct bt_conn_info info;
+	struct bond_find_data data = {
+		.found = false,
+	};
+
+	if (bt_conn_get_info(dm->conn, &info) ||
+	    (info.type != BT_CONN_TYPE_LE)) {
+		return false;
+	}
+
+	data.addr = info.le.dst;
+	bt_foreach_bond(info.id, bond_find, &data);
+
+	if (data.found) {
+		bt_addr_le_copy(&dm->peer, info.le.dst);
+	}
+
+	return data.found;
+}
+
+static bool cache_addr_bonded(const bt_addr_le_t *addr)
+{
+	struct bond_find_data data = {
+		.addr = addr,
+		.found = false,
+	};
+
+	for (uint8_t id = 0; (id < CONFIG_BT_ID_MAX) && !data.found; id++) {
+		bt_foreach_bond(id, bond_find, &data);
+	}
+
+	return data.found;
+}
+
+/* Finds the entries of peers that are no longer bonded */
+static int cache_purge_cb(const char *key, size_t len,
+			  settings_read_cb read_cb, void *cb_arg, void *param)
+{
+	sys_slist_t *stale_keys = param;
+	struct cache_stale_key *stale;
+	const char *next;
+	bt_addr_le_t addr;
+
+	/* Deleted entries have no value */
+	if (!key || (len == 0)) {
+		return 0;
+	}
+
+	if ((settings_name_next(key, &next) != 2 * sizeof(addr)) || !next ||
+	    (hex2bin(key, 2 * sizeof(addr), (uint8_t *)&addr,
+		     sizeof(addr)) != sizeof(addr))) {
+		return 0;
+	}
+
+	if (cache_addr_bonded(&addr)) {
+		return 0;
+	}
+
+	stale = k_malloc(sizeof(*stale));
+	if (!stale) {
+		/* The remaining entries are deleted next time */
+		return 1;
+	}
+
+	snprintk(stale->key, sizeof(stale->key), CACHE_KEY_BASE "/%s", key);
+	sys_slist_append(stale_keys, &stale->node);
+
+	return 0;
+}
+
+/* Removes the entries of peers whose bonds were deleted. Bond removal is
+ * not reported by the Bluetooth stack, so the entries are removed before
+ * new discovery data is stored. Settings cannot be deleted while they are
+ * loaded, so the keys are collected first.
+ */
+static void cache_purge(void)
+{
+	sys_slist_t stale_keys = SYS_SLIST_STATIC_INIT(&stale_keys);
+	sys_snode_t *node;
+
+	(void)settings_load_subtree_direct(CACHE_KEY_BASE, cache_purge_cb,
+					   &stale_keys);
+
+	while ((node = sys_slist_get(&stale_keys)) != NULL) {
+		struct cache_stale_key *stale =
+			CONTAINER_OF(node, struct cache_stale_key, node);
+		int err = settings_delete(stale->key);
+
+		if (err) {
+			LOG_ERR("Cannot delete discovery data, error: %d.",
+				err);
+		} else {
+			LOG_DBG("Discovery data deleted: %s",
+				log_strdup(stale->key));
+		}
+
+		k_free(stale);
+	}
+}
+
+static void cache_save_fn(struct k_work *work)
+{
+	struct cache_save_item *item = CONTAINER_OF(work,
+						    struct cache_save_item,
+						    work);
+
+	cache_purge();
+
+	int err = settings_save_one(item->key, item->data, item->len);
+
+	if (err) {
+		LOG_ERR("Cannot store discovery data, error: %d.", err);
+	} else {
+		LOG_DBG("Discovery data stored: %s", log_strdup(item->key));
+	}
+
+	k_free(item);
+}
+
+static void cache_store(struct bt_gatt_dm *dm)
+{
+	struct cache_save_item *item;
+	struct net_buf_simple buf;
+	size_t len = CACHE_HDR_LEN;
+
+	if (!dm->cache_enabled || !dm->db_hash_valid || dm->from_cache) {
+		return;
+	}
+
+	for (size_t i = 0; i < dm->cur_attr_id; i++) {
+		len += cache_attr_size(&dm->attrs[i]);
+	}
+
+	item = k_malloc(sizeof(*item) + len);
+	if (!item) {
+		LOG_WRN("No memory to cache discovery data.");
+		return;
+	}
+
+	net_buf_simple_init_with_data(&buf, item->data, len);
+	net_buf_simple_reset(&buf);
+
+	net_buf_simple_add_mem(&buf, dm->db_hash, CACHE_DB_HASH_LEN);
+	net_buf_simple_add_le16(&buf, dm->cur_attr_id);
+	for (size_t i = 0; i < dm->cur_attr_id; i++) {
+		cache_attr_encode(&buf, &dm->attrs[i]);
+	}
+
+	__ASSERT_NO_MSG(buf.len == len);
+
+	cache_key_get(&dm->peer, dm->discover_params.uuid, item->key);
+	item->len = len;
+
+	/* Settings are not written from the Bluetooth RX thread */
+	k_work_init(&item->work, cache_save_fn);
+	k_work_submit(&item->work);
+}
+
+static void cache_discover(struct bt_gatt_dm *dm)
+{
+	int err = bt_gatt_discover(dm->conn, &dm->discover_params);
+
+	if (err) {
+		LOG_ERR("Discover failed, error: %d.", err);
+		discovery_complete_error(dm, err);
+	}
+}
+
+/* Settings are not read from the Bluetooth RX thread */
+static void cache_load_fn(struct k_work *work)
+{
+	struct bt_gatt_dm *dm = CONTAINER_OF(work, struct bt_gatt_dm,
+					     cache_work);
+
+	if (!cache_load(dm)) {
+		LOG_DBG("Discovery data restored from cache.");
+		dm->from_cache = true;
+		discovery_complete(dm);
+	} else {
+		cache_discover(dm);
+	}
+}
+
+static uint8_t db_hash_read_callback(struct bt_conn *conn, uint8_t err,
+				     struct bt_gatt_read_params *params,
+				     const void *data, uint16_t length)
+{
+	struct bt_gatt_dm *dm = CONTAINER_OF(params, struct bt_gatt_dm,
+					     read_params);
+
+	if (!err && data && (length == sizeof(dm->db_hash))) {
+		memcpy(dm->db_hash, data, length);
+		dm->db_hash_valid = true;
+		k_work_submit(&dm->cache_work);
+	} else {
+		LOG_DBG("Database hash not available, error: %u.", err);
+		cache_discover(dm);
+	}
+
+	return BT_GATT_ITER_STOP;
+}
+
+/* Reads the database hash of a bonded peer before the discovery */
+static int cache_discover_start(struct bt_gatt_dm *dm)
+{
+	dm->cache_enabled = false;
+	dm->db_hash_valid = false;
+	dm->from_cache = false;
+
+	if (!dm->discover_params.uuid || !cache_peer_bonded(dm)) {
+		return bt_gatt_discover(dm->conn, &dm->discover_params);
+	}
+
+	dm->cache_enabled = true;
+	k_work_init(&dm->cache_work, cache_load_fn);
+
+	dm->read_params.func = db_hash_read_callback;
+	dm->read_params.handle_count = 0;
+	dm->read_params.by_uuid.uuid = BT_UUID_GATT_DB_HASH;
+	dm->read_params.by_uuid.start_handle = 0x0001;
+	dm->read_params.by_uuid.end_handle = 0xffff;
+
+	return bt_gatt_read(dm->conn, &dm->read_params);
+}
+
+#else
+
+static void cache_store(struct bt_gatt_dm *dm)
+{
+}
+
+static int cache_discover_start(struct bt_gatt_dm *dm)
+{
+	return bt_gatt_discover(dm->conn, &dm->discover_params);
+}
+
+#endif /* CONFIG_BT_GATT_DM_CACHE */
+
 struct bt_gatt_service_val *bt_gatt_dm_attr_service_val(
 	const struct bt_gatt_dm_attr *attr)
 {
@@ -586,13 +1378,15 @@ int bt_gatt_dm_start(struct bt_conn *conn,
 		return -EINVAL;
 	}
 
-	dm = &bt_gatt_dm_inst;
+	if (!atomic_set(&conn_cb_registered, true)) {
+		bt_conn_cb_register(&conn_callbacks);
+	}
 
-	if (atomic_test_and_set_bit(dm->state_flags, STATE_ATTRS_LOCKED)) {
-		return -EALREADY;
+	err = dm_alloc(conn, &dm);
+	if (err) {
+		return err;
 	}
 
-	dm->conn = conn;
 	dm->context = context;
 	dm->callback = cb;
 	dm->cur_attr_id = 0;
@@ -605,10 +1399,11 @@ int bt_gatt_dm_start(struct bt_conn *conn,
 	dm->discover_params.end_handle = 0xffff;
 	dm->discover_params.type = BT_GATT_DISCOVER_PRIMARY;
 
-	err = bt_gatt_discover(conn, &dm->discover_params);
+	err = cache_discover_start(dm);
 	if (err) {
 		LOG_ERR("Discover failed, error: %d.", err);
-		atomic_clear_bit(dm->state_flags, STATE_ATTRS_LOCKED);
+		svc_attr_memory_release(dm);
+		dm_unlock(dm);
 	}
 
 	return err;
@@ -649,7 +1444,7 @@ int bt_gatt_dm_continue(struct bt_gatt_dm *dm, void *context)
 	err = bt_gatt_discover(dm->conn, &dm->discover_params);
 	if (err) {
 		LOG_ERR("Discover failed, error: %d.", err);
-		atomic_clear_bit(dm->state_flags, STATE_ATTRS_LOCKED);
+		dm_unlock(dm);
 	}
 
 	return err;
@@ -663,7 +1458,7 @@ int bt_gatt_dm_data_release(struct bt_gatt_dm *dm)
 	}
 
 	svc_attr_memory_release(dm);
-	atomic_clear_bit(dm->state_flags, STATE_ATTRS_LOCKED);
+	dm_unlock(dm);
 
 	return 0;
 }
@@ -9,6 +9,8 @@
 #include <string.h>
 #include <bluetooth/scan.h>
 
+#include "scan_filter.h"
+
 #include <logging/log.h>
 LOG_MODULE_REGISTER(nrf_bt_scan, CONFIG_BT_SCAN_LOG_LEVEL);
 
@@ -45,6 +47,14 @@ struct bt_scan_control {
 
 	/* Scan filter status. */
 	struct bt_scan_filter_match filter_status;
+
+#if CONFIG_BT_SCAN_FILTER_COMPILED
+	/* Bitmask of the UUID filters found in the advertising data. */
+	uint32_t uuid_mask;
+
+	/* In the all filters mode, one of the filters cannot match. */
+	bool mismatch;
+#endif /* CONFIG_BT_SCAN_FILTER_COMPILED */
 };
 
 /* Name filter structure.
@@ -266,6 +276,104 @@ static struct bt_scan {
 
 } bt_scan;
 
+#if CONFIG_BT_SCAN_FILTER_COMPILED
+BUILD_ASSERT(CONFIG_BT_SCAN_UUID_CNT <= 32,
+	     "UUID filters are tracked in a 32-bit mask");
+
+/* Lookup structures of the filters. They are updated when a filter is added,
+ * so the advertising data is matched without iterating over the filters.
+ */
+static struct bt_scan_compiled {
+	uint8_t addr_slots[SCAN_FILTER_TABLE_SIZE(CONFIG_BT_SCAN_ADDRESS_CNT)];
+	struct scan_filter_table addr;
+
+	struct scan_filter_uuid_key uuid_keys[CONFIG_BT_SCAN_UUID_CNT];
+	uint8_t uuid_slots[SCAN_FILTER_TABLE_SIZE(CONFIG_BT_SCAN_UUID_CNT)];
+	struct scan_filter_table uuid;
+
+	struct scan_filter_trie_node name_nodes[
+		SCAN_FILTER_TRIE_SIZE(CONFIG_BT_SCAN_NAME_CNT,
+				      CONFIG_BT_SCAN_NAME_MAX_LEN)];
+	struct scan_filter_trie name;
+
+	struct scan_filter_trie_node short_name_nodes[
+		SCAN_FILTER_TRIE_SIZE(CONFIG_BT_SCAN_SHORT_NAME_CNT,
+				      CONFIG_BT_SCAN_SHORT_NAME_MAX_LEN)];
+	struct scan_filter_trie short_name;
+
+#if CONFIG_BT_SCAN_BLOCKLIST
+	uint8_t blocklist_slots[
+		SCAN_FILTER_TABLE_SIZE(CONFIG_BT_SCAN_BLOCKLIST_LEN)];
+	struct scan_filter_table blocklist;
+#endif /* CONFIG_BT_SCAN_BLOCKLIST */
+} compiled = {
+	.addr = {
+		.keys = bt_scan.scan_filters.addr.target_addr,
+		.key_size = sizeof(bt_addr_le_t),
+		.slots = compiled.addr_slots,
+		.slot_cnt = ARRAY_SIZE(compiled.addr_slots),
+	},
+	.uuid = {
+		.keys = compiled.uuid_keys,
+		.key_size = sizeof(struct scan_filter_uuid_key),
+		.slots = compiled.uuid_slots,
+		.slot_cnt = ARRAY_SIZE(compiled.uuid_slots),
+	},
+	.name = {
+		.nodes = compiled.name_nodes,
+		.node_cnt = ARRAY_SIZE(compiled.name_nodes),
+	},
+	.short_name = {
+		.nodes = compiled.short_name_nodes,
+		.node_cnt = ARRAY_SIZE(compiled.short_name_nodes),
+	},
+#if CONFIG_BT_SCAN_BLOCKLIST
+	.blocklist = {
+		.keys = bt_scan.blocklist.addr,
+		.key_size = sizeof(bt_addr_le_t),
+		.slots = compiled.blocklist_slots,
+		.slot_cnt = ARRAY_SIZE(compiled.blocklist_slots),
+	},
+#endif /* CONFIG_BT_SCAN_BLOCKLIST */
+};
+
+static void compiled_filters_clear(void)
+{
+	scan_filter_table_clear(&compiled.addr);
+	scan_filter_table_clear(&compiled.uuid);
+	scan_filter_trie_clear(&compiled.name);
+	scan_filter_trie_clear(&compiled.short_name);
+}
+
+static void filter_mismatch(struct bt_scan_control *control)
+{
+	/* In the all filters mode, a single mismatch rejects the device,
+	 * so the rest of the advertising data does not need to be parsed.
+	 */
+	if (control->all_mode) {
+		control->mismatch = true;
+	}
+}
+
+static bool filter_continue(const struct bt_scan_control *control)
+{
+	return !control->mismatch;
+}
+#else
+static void compiled_filters_clear(void)
+{
+}
+
+static void filter_mismatch(struct bt_scan_control *control)
+{
+}
+
+static bool filter_continue(const struct bt_scan_control *control)
+{
+	return true;
+}
+#endif /* CONFIG_BT_SCAN_FILTER_COMPILED */
+
 static sys_slist_t callback_list;
 
 void bt_scan_cb_register(struct bt_scan_cb *cb)
@@ -333,6 +441,10 @@ static bool blocklist_device_check(const bt_addr_le_t *addr)
 
 	k_mutex_lock(&scan_mutex, K_FOREVER);
 
+#if CONFIG_BT_SCAN_FILTER_COMPILED
+	blocklist_device = (scan_filter_table_find(&compiled.blocklist,
+						   addr) >= 0);
+#else
 	for (size_t i = 0; i < bt_scan.blocklist.count; i++) {
 		if (bt_addr_le_cmp(&bt_scan.blocklist.addr[i], addr) == 0) {
 			blocklist_device = true;
@@ -340,6 +452,7 @@ static bool blocklist_device_check(const bt_addr_le_t *addr)
 			break;
 		}
 	}
+#endif /* CONFIG_BT_SCAN_FILTER_COMPILED */
 
 	k_mutex_unlock(&scan_mutex);
 
@@ -506,6 +619,18 @@ static bool adv_addr_compare(const bt_addr_le_t *target_addr,
 {
 	const bt_addr_le_t *addr =
 			bt_scan.scan_filters.addr.target_addr;
+
+#if CONFIG_BT_SCAN_FILTER_COMPILED
+	int idx = scan_filter_table_find(&compiled.addr, target_addr);
+
+	if (idx >= 0) {
+		control->filter_status.addr.addr = &addr[idx];
+
+		return true;
+	}
+
+	return false;
+#else
 	uint8_t counter = bt_scan.scan_filters.addr.cnt;
 
 	for (size_t i = 0; i < counter; i++) {
@@ -517,6 +642,7 @@ static bool adv_addr_compare(const bt_addr_le_t *target_addr,
 	}
 
 	return false;
+#endif /* CONFIG_BT_SCAN_FILTER_COMPILED */
 }
 
 static bool is_addr_filter_enabled(void)
@@ -534,6 +660,8 @@ static void check_addr(struct bt_scan_control *control,
 			/* Information about the filters matched. */
 			control->filter_status.addr.match = true;
 			control->filter_match = true;
+		} else {
+			filter_mismatch(control);
 		}
 	}
 }
@@ -560,6 +688,14 @@ static int scan_addr_filter_add(const bt_addr_le_t *target_addr)
 	/* Add target address to filter. */
 	bt_addr_le_copy(&addr_filter[counter], target_addr);
 
+#if CONFIG_BT_SCAN_FILTER_COMPILED
+	int err = scan_filter_table_insert(&compiled.addr, counter);
+
+	if (err) {
+		return err;
+	}
+#endif /* CONFIG_BT_SCAN_FILTER_COMPILED */
+
 	LOG_DBG("Filter set on address type %i",
 		addr_filter[counter].type);
 
@@ -585,9 +721,23 @@ static bool adv_name_compare(const struct bt_data *data,
 {
 	struct bt_scan_name_filter const *name_filter =
 			&bt_scan.scan_filters.name;
-	uint8_t counter = bt_scan.scan_filters.name.cnt;
 	uint8_t data_len = data->data_len;
 
+#if CONFIG_BT_SCAN_FILTER_COMPILED
+	int idx = scan_filter_trie_find(&compiled.name, data->data, data_len);
+
+	if (idx >= 0) {
+		control->filter_status.name.name =
+			name_filter->target_name[idx];
+		control->filter_status.name.len = data_len;
+
+		return true;
+	}
+
+	return false;
+#else
+	uint8_t counter = bt_scan.scan_filters.name.cnt;
+
 	/* Compare the name found with the name filter. */
 	for (size_t i = 0; i < counter; i++) {
 		if (adv_name_cmp(data->data,
@@ -603,6 +753,7 @@ static bool adv_name_compare(const struct bt_data *data,
 	}
 
 	return false;
+#endif /* CONFIG_BT_SCAN_FILTER_COMPILED */
 }
 
 static inline bool is_name_filter_enabled(void)
@@ -613,13 +764,16 @@ static inline bool is_name_filter_enabled(void)
 static void name_check(struct bt_scan_control *control,
 		       const struct bt_data *data)
 {
-	if (is_name_filter_enabled()) {
+	/* Filter is counted once, even if the name is repeated. */
+	if (is_name_filter_enabled() && !control->filter_status.name.match) {
 		if (adv_name_compare(data, control)) {
 			control->filter_match_cnt++;
 
 			/* Information about the filters matched. */
 			control->filter_status.name.match = true;
 			control->filter_match = true;
+		} else {
+			filter_mismatch(control);
 		}
 	}
 }
@@ -648,6 +802,14 @@ static int scan_name_filter_add(const char *name)
 		}
 	}
 
+#if CONFIG_BT_SCAN_FILTER_COMPILED
+	int err = scan_filter_trie_add(&compiled.name, name, 0, counter);
+
+	if (err) {
+		return err;
+	}
+#endif /* CONFIG_BT_SCAN_FILTER_COMPILED */
+
 	/* Add name to filter. */
 	memcpy(bt_scan.scan_filters.name.target_name[counter],
 	       name, name_len);
@@ -677,9 +839,24 @@ static bool adv_short_name_compare(const struct bt_data *data,
 {
 	const struct bt_scan_short_name_filter *name_filter =
 			&bt_scan.scan_filters.short_name;
-	uint8_t counter = bt_scan.scan_filters.short_name.cnt;
 	uint8_t data_len = data->data_len;
 
+#if CONFIG_BT_SCAN_FILTER_COMPILED
+	int idx = scan_filter_trie_find(&compiled.short_name, data->data,
+					data_len);
+
+	if (idx >= 0) {
+		control->filter_status.short_name.name =
+			name_filter->name[idx].target_name;
+		control->filter_status.short_name.len = data_len;
+
+		return true;
+	}
+
+	return false;
+#else
+	uint8_t counter = bt_scan.scan_filters.short_name.cnt;
+
 	/* Compare the name found with the name filters. */
 	for (size_t i = 0; i < counter; i++) {
 		if (adv_short_name_cmp(data->data,
@@ -696,6 +873,7 @@ static bool adv_short_name_compare(const struct bt_data *data,
 	}
 
 	return false;
+#endif /* CONFIG_BT_SCAN_FILTER_COMPILED */
 }
 
 static inline bool is_short_name_filter_enabled(void)
@@ -706,13 +884,16 @@ static inline bool is_short_name_filter_enabled(void)
 static void short_name_check(struct bt_scan_control *control,
 			     const struct bt_data *data)
 {
-	if (is_short_name_filter_enabled()) {
+	if (is_short_name_filter_enabled() &&
+	    !control->filter_status.short_name.match) {
 		if (adv_short_name_compare(data, control)) {
 			control->filter_match_cnt++;
 
 			/* Information about the filters matched. */
 			control->filter_status.short_name.match = true;
 			control->filter_match = true;
+		} else {
+			filter_mismatch(control);
 		}
 	}
 }
@@ -746,6 +927,15 @@ static int scan_short_name_filter_add(const struct bt_scan_short_name *short_nam
 		}
 	}
 
+#if CONFIG_BT_SCAN_FILTER_COMPILED
+	int err = scan_filter_trie_add(&compiled.short_name, short_name->name,
+				       short_name->min_len, counter);
+
+	if (err) {
+		return err;
+	}
+#endif /* CONFIG_BT_SCAN_FILTER_COMPILED */
+
 	/* Add name to the filter. */
 	short_name_filter->name[counter].min_len = short_name->min_len;
 	memcpy(short_name_filter->name[counter].target_name,
@@ -798,6 +988,103 @@ static bool find_uuid(const uint8_t *data,
 	return false;
 }
 
+#if CONFIG_BT_SCAN_FILTER_COMPILED
+static void uuid_key_get(const struct bt_uuid *uuid,
+			 struct scan_filter_uuid_key *key)
+{
+	uint8_t val[BT_SCAN_UUID_128_SIZE];
+	size_t len;
+
+	switch (uuid->type) {
+	case BT_UUID_TYPE_16:
+		sys_put_le16(BT_UUID_16(uuid)->val, val);
+		len = sizeof(uint16_t);
+		break;
+
+	case BT_UUID_TYPE_32:
+		sys_put_le32(BT_UUID_32(uuid)->val, val);
+		len = sizeof(uint32_t);
+		break;
+
+	default:
+		memcpy(val, BT_UUID_128(uuid)->val, sizeof(val));
+		len = sizeof(val);
+		break;
+	}
+
+	scan_filter_uuid_key_get(val, len, key);
+}
+
+static void uuid_mask_update(const struct bt_data *data, uint8_t uuid_type,
+			     struct bt_scan_control *control)
+{
+	struct scan_filter_uuid_key key;
+	uint8_t uuid_len;
+
+	switch (uuid_type) {
+	case BT_UUID_TYPE_16:
+		uuid_len = sizeof(uint16_t);
+		break;
+
+	case BT_UUID_TYPE_32:
+		uuid_len = sizeof(uint32_t);
+		break;
+
+	default:
+		uuid_len = BT_SCAN_UUID_128_SIZE;
+		break;
+	}
+
+	for (size_t i = 0; i + uuid_len <= data->data_len; i += uuid_len) {
+		scan_filter_uuid_key_get(&data->data[i], uuid_len, &key);
+
+		int idx = scan_filter_table_find(&compiled.uuid, &key);
+
+		if (idx >= 0) {
+			control->uuid_mask |= BIT(idx);
+		}
+	}
+}
+
+/* UUIDs may be split among multiple advertising data fields, so the UUID
+ * filter is checked after all of the fields are parsed.
+ */
+static bool adv_uuid_mask_compare(struct bt_scan_control *control)
+{
+	const struct bt_scan_uuid_filter *uuid_filter =
+			&bt_scan.scan_filters.uuid;
+	const bool all_filters_mode = bt_scan.scan_filters.all_mode;
+	const uint8_t counter = bt_scan.scan_filters.uuid.cnt;
+	uint8_t uuid_match_cnt = 0;
+
+	if ((control->uuid_mask == 0) ||
+	    (all_filters_mode &&
+	     (control->uuid_mask != BIT_MASK(counter)))) {
+		return false;
+	}
+
+	for (size_t i = 0; i < counter; i++) {
+		if (control->uuid_mask & BIT(i)) {
+			control->filter_status.uuid.uuid[uuid_match_cnt] =
+				uuid_filter->uuid[i].uuid;
+
+			uuid_match_cnt++;
+
+			/* In the normal filter mode,
+			 * only one UUID is reported.
+			 */
+			if (!all_filters_mode) {
+				break;
+			}
+		}
+	}
+
+	control->filter_status.uuid.count = uuid_match_cnt;
+
+	return true;
+}
+#endif /* CONFIG_BT_SCAN_FILTER_COMPILED */
+
 static bool adv_uuid_compare(const struct bt_data *data, uint8_t uuid_type,
 			     struct bt_scan_control *control)
 {
@@ -851,7 +1138,12 @@ static void uuid_check(struct bt_scan_control *control,
 		       const struct bt_data *data,
 		       uint8_t type)
 {
+#if CONFIG_BT_SCAN_FILTER_COMPILED
 	if (is_uuid_filter_enabled()) {
+		uuid_mask_update(data, type, control);
+	}
+#else
+	if (is_uuid_filter_enabled() && !control->filter_status.uuid.match) {
 		if (adv_uuid_compare(data, type, control)) {
 			control->filter_match_cnt++;
 
@@ -860,6 +1152,22 @@ static void uuid_check(struct bt_scan_control *control,
 			control->filter_match = true;
 		}
 	}
+#endif /* CONFIG_BT_SCAN_FILTER_COMPILED */
+}
+
+static void uuid_check_finish(struct bt_scan_control *control)
+{
+#if CONFIG_BT_SCAN_FILTER_COMPILED
+	if (is_uuid_filter_enabled()) {
+		if (adv_uuid_mask_compare(control)) {
+			control->filter_match_cnt++;
+
+			/* Information about the filters matched. */
+			control->filter_status.uuid.match = true;
+			control->filter_match = true;
+		}
+	}
+#endif /* CONFIG_BT_SCAN_FILTER_COMPILED */
 }
 
 static int scan_uuid_filter_add(struct bt_uuid *uuid)
@@ -882,6 +1190,19 @@ static int scan_uuid_filter_add(struct bt_uuid *uuid)
 		}
 	}
 
+#if CONFIG_BT_SCAN_FILTER_COMPILED
+	/* UUIDs of different sizes can have the same key. A second filter
+	 * with the same key would never get its own bit in the UUID mask,
+	 * so the all filters mode could not match.
+	 */
+	uuid_key_get(uuid, &compiled.uuid_keys[counter]);
+
+	if (scan_filter_table_find(&compiled.uuid,
+				   &compiled.uuid_keys[counter]) >= 0) {
+		return 0;
+	}
+#endif /* CONFIG_BT_SCAN_FILTER_COMPILED */
+
 	/* Add UUID to the filter. */
 	switch (uuid->type) {
 	case BT_UUID_TYPE_16:
@@ -912,6 +1233,14 @@ static int scan_uuid_filter_add(struct bt_uuid *uuid)
 		return -EINVAL;
 	}
 
+#if CONFIG_BT_SCAN_FILTER_COMPILED
+	int err = scan_filter_table_insert(&compiled.uuid, counter);
+
+	if (err) {
+		return err;
+	}
+#endif /* CONFIG_BT_SCAN_FILTER_COMPILED */
+
 	bt_scan.scan_filters.uuid.cnt++;
 	LOG_DBG("Added filter on UUID type %x", uuid->type);
 
@@ -971,13 +1300,16 @@ static inline bool is_appearance_filter_enabled(void)
 static void appearance_check(struct bt_scan_control *control,
 			     const struct bt_data *data)
 {
-	if (is_appearance_filter_enabled()) {
+	if (is_appearance_filter_enabled() &&
+	    !control->filter_status.appearance.match) {
 		if (adv_appearance_compare(data, control)) {
 			control->filter_match_cnt++;
 
 			/* Information about the filters matched. */
 			control->filter_status.appearance.match = true;
 			control->filter_match = true;
+		} else {
+			filter_mismatch(control);
 		}
 	}
 }
@@ -1058,7 +1390,8 @@ static inline bool is_manufacturer_data_filter_enabled(void)
 static void manufacturer_data_check(struct bt_scan_control *control,
 				    const struct bt_data *data)
 {
-	if (is_manufacturer_data_filter_enabled()) {
+	if (is_manufacturer_data_filter_enabled() &&
+	    !control->filter_status.manufacturer_data.match) {
 		if (adv_manufacturer_data_compare(data, control)) {
 			control->filter_match_cnt++;
 
@@ -1237,6 +1570,8 @@ void bt_scan_filter_remove_all(void)
 		&bt_scan.scan_filters.manufacturer_data;
 	manufacturer_data_filter->cnt = 0;
 
+	compiled_filters_clear();
+
 	k_mutex_unlock(&scan_mutex);
 }
 
@@ -1331,6 +1666,7 @@ void bt_scan_init(const struct bt_scan_init_param *init)
 
 	/* Disable all scanning filters. */
 	memset(&bt_scan.scan_filters, 0, sizeof(bt_scan.scan_filters));
+	compiled_filters_clear();
 
 	/* If the pointer to the initialization structure exist,
 	 * use it to scan the configuration.
@@ -1445,16 +1781,12 @@ static bool adv_data_found(struct bt_data *data, void *user_data)
 		break;
 	}
 
-	return true;
+	return filter_continue(scan_control);
 }
 
 static void filter_state_check(struct bt_scan_control *control,
 			       const bt_addr_le_t *addr)
 {
-	if (!scan_device_filter_check(addr)) {
-		return;
-	}
-
 	if (control->all_mode &&
 	    (control->filter_match_cnt == control->filter_cnt)) {
 		notify_filter_matched(&control->device_info,
@@ -1483,6 +1815,13 @@ static void scan_recv(const struct bt_le_scan_recv_info *info,
 	struct bt_scan_control scan_control;
 	struct net_buf_simple_state state;
 
+	/* Rejected devices are not reported, so there is no need to
+	 * parse their advertising data.
+	 */
+	if (!scan_device_filter_check(info->addr)) {
+		return;
+	}
+
 	memset(&scan_control, 0, sizeof(scan_control));
 
 	scan_control.all_mode = bt_scan.scan_filters.all_mode;
@@ -1499,9 +1838,13 @@ static void scan_recv(const struct bt_le_scan_recv_info *info,
 	/* Save advertising buffer state to transfer it
 	 * data to application if futher processing is needed.
 	 */
-	net_buf_simple_save(ad, &state);
-	bt_data_parse(ad, adv_data_found, (void *)&scan_control);
-	net_buf_simple_restore(ad, &state);
+	if (filter_continue(&scan_control)) {
+		net_buf_simple_save(ad, &state);
+		bt_data_parse(ad, adv_data_found, (void *)&scan_control);
+		net_buf_simple_restore(ad, &state);
+
+		uuid_check_finish(&scan_control);
+	}
 
 	scan_control.device_info.recv_info = info;
 	scan_control.device_info.conn_param = &bt_scan.conn_param;
@@ -1590,6 +1933,10 @@ int bt_scan_blocklist_device_add(const bt_addr_le_t *addr)
 	} else {
 		bt_addr_le_copy(&bt_scan.blocklist.addr[bt_scan.blocklist.count],
 				addr);
+#if CONFIG_BT_SCAN_FILTER_COMPILED
+		scan_filter_table_insert(&compiled.blocklist,
+					 bt_scan.blocklist.count);
+#endif /* CONFIG_BT_SCAN_FILTER_COMPILED */
 		bt_scan.blocklist.count++;
 		LOG_INF("Device %s added to the scanning blocklist",
 			log_strdup(addr_str));
@@ -1605,6 +1952,9 @@ void bt_scan_blocklist_clear(void)
 {
 	k_mutex_lock(&scan_mutex, K_FOREVER);
 	memset(&bt_scan.blocklist, 0, sizeof(bt_scan.blocklist));
+#if CONFIG_BT_SCAN_FILTER_COMPILED
+	scan_filter_table_clear(&compiled.blocklist);
+#endif /* CONFIG_BT_SCAN_FILTER_COMPILED */
 	k_mutex_unlock(&scan_mutex);
 }
 #endif /* CONFIG_BT_SCAN_BLOCKLIST */
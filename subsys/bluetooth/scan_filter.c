@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "scan_filter.h"
+
+#define FNV_OFFSET_BASIS 2166136261U
+#define FNV_PRIME 16777619U
+
+#define UUID_BASE_LEN 12
+#define UUID_32_LEN 4
+
+#define TRIE_IDX_NONE UINT8_MAX
+
+/* Bluetooth Base UUID without the 32-bit value, little-endian. */
+static const uint8_t uuid_base[UUID_BASE_LEN] = {
+	0xfb, 0x34, 0x9b, 0x5f, 0x80, 0x00, 0x00, 0x80,
+	0x00, 0x10, 0x00, 0x00,
+};
+
+/* FNV-1a hash */
+static uint32_t hash(const uint8_t *data, size_t len)
+{
+	uint32_t h = FNV_OFFSET_BASIS;
+
+	for (size_t i = 0; i < len; i++) {
+		h ^= data[i];
+		h *= FNV_PRIME;
+	}
+
+	return h;
+}
+
+static const uint8_t *table_key(const struct scan_filter_table *table,
+				size_t idx)
+{
+	return (const uint8_t *)table->keys + idx * table->key_size;
+}
+
+void scan_filter_table_clear(struct scan_filter_table *table)
+{
+	memset(table->slots, 0, table->slot_cnt);
+}
+
+int scan_filter_table_insert(struct scan_filter_table *table, size_t idx)
+{
+	if (idx >= UINT8_MAX) {
+		return -EINVAL;
+	}
+
+	size_t slot = hash(table_key(table, idx), table->key_size) %
+		      table->slot_cnt;
+
+	for (size_t i = 0; i < table->slot_cnt; i++) {
+		if (table->slots[slot] == 0) {
+			table->slots[slot] = idx + 1;
+			return 0;
+		}
+
+		slot = (slot + 1 < table->slot_cnt) ? (slot + 1) : 0;
+	}
+
+	return -ENOMEM;
+}
+
+int scan_filter_table_find(const struct scan_filter_table *table,
+			   const void *key)
+{
+	size_t slot = hash(key, table->key_size) % table->slot_cnt;
+
+	for (size_t i = 0; i < table->slot_cnt; i++) {
+		uint8_t entry = table->slots[slot];
+
+		if (entry == 0) {
+			break;
+		}
+
+		if (!memcmp(table_key(table, entry - 1), key,
+			    table->key_size)) {
+			return entry - 1;
+		}
+
+		slot = (slot + 1 < table->slot_cnt) ? (slot + 1) : 0;
+	}
+
+	return -ENOENT;
+}
+
+int scan_filter_uuid_key_get(const uint8_t *data, size_t len,
+			     struct scan_filter_uuid_key *key)
+{
+	memset(key, 0, sizeof(*key));
+
+	switch (len) {
+	case sizeof(uint16_t):
+	case sizeof(uint32_t):
+		key->len = UUID_32_LEN;
+		memcpy(key->val, data, len);
+		break;
+
+	case SCAN_FILTER_UUID_KEY_LEN:
+		if (!memcmp(data, uuid_base, sizeof(uuid_base))) {
+			key->len = UUID_32_LEN;
+			memcpy(key->val, &data[UUID_BASE_LEN], UUID_32_LEN);
+		} else {
+			key->len = SCAN_FILTER_UUID_KEY_LEN;
+			memcpy(key->val, data, len);
+		}
+		break;
+
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void trie_node_init(struct scan_filter_trie_node *node, char c)
+{
+	node->child = 0;
+	node->sibling = 0;
+	node->c = c;
+	node->idx = TRIE_IDX_NONE;
+	node->min_len = UINT8_MAX;
+}
+
+static void trie_node_update(struct scan_filter_trie_node *node,
+			     uint8_t min_len, uint8_t idx)
+{
+	/* On equal minimum lengths, the name added first is reported. */
+	if ((node->idx == TRIE_IDX_NONE) || (min_len < node->min_len)) {
+		node->idx = idx;
+		node->min_len = min_len;
+	}
+}
+
+/* Returns index of the child node with the given character, 0 if none. */
+static uint16_t trie_child_find(const struct scan_filter_trie *trie,
+				uint16_t node, char c)
+{
+	uint16_t i;
+
+	for (i = trie->nodes[node].child; i != 0; i = trie->nodes[i].sibling) {
+		if (trie->nodes[i].c == c) {
+			break;
+		}
+	}
+
+	return i;
+}
+
+void scan_filter_trie_clear(struct scan_filter_trie *trie)
+{
+	trie_node_init(&trie->nodes[0], '\0');
+	trie->used = 1;
+}
+
+int scan_filter_trie_add(struct scan_filter_trie *trie, const char *name,
+			 uint8_t min_len, uint8_t idx)
+{
+	uint16_t node = 0;
+	size_t len = strlen(name);
+
+	if ((idx == TRIE_IDX_NONE) ||
+	    (trie->used + len > trie->node_cnt) ||
+	    (trie->node_cnt > UINT16_MAX)) {
+		return -ENOMEM;
+	}
+
+	trie_node_update(&trie->nodes[node], min_len, idx);
+
+	for (size_t i = 0; i < len; i++) {
+		uint16_t child = trie_child_find(trie, node, name[i]);
+
+		if (child == 0) {
+			child = trie->used++;
+			trie_node_init(&trie->nodes[child], name[i]);
+			trie->nodes[child].sibling = trie->nodes[node].child;
+			trie->nodes[node].child = child;
+		}
+
+		trie_node_update(&trie->nodes[child], min_len, idx);
+		node = child;
+	}
+
+	return 0;
+}
+
+int scan_filter_trie_find(const struct scan_filter_trie *trie,
+			  const uint8_t *data, size_t len)
+{
+	const struct scan_filter_trie_node *node;
+	uint16_t idx = 0;
+
+	for (size_t i = 0; i < len; i++) {
+		idx = trie_child_find(trie, idx, data[i]);
+		if (idx == 0) {
+			return -ENOENT;
+		}
+	}
+
+	node = &trie->nodes[idx];
+	if ((node->idx == TRIE_IDX_NONE) || (len < node->min_len)) {
+		return -ENOENT;
+	}
+
+	return node->idx;
+}
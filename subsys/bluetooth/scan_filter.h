@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef BT_SCAN_FILTER_H_
+#define BT_SCAN_FILTER_H_
+
+/* Lookup structures of the compiled Scan library filters.
+ *
+ * The structures do not depend on the Bluetooth host, so they can also be
+ * built for the host machine, for example in unit tests and benchmarks.
+ */
+
+#include <zephyr/types.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of slots in a hash table for the given number of keys. */
+#define SCAN_FILTER_TABLE_SIZE(cnt) (2 * (cnt) + 1)
+
+/* Number of nodes in a trie for the given number of names. */
+#define SCAN_FILTER_TRIE_SIZE(cnt, max_len) (1 + (cnt) * (max_len))
+
+/* Length of the UUID key value. */
+#define SCAN_FILTER_UUID_KEY_LEN 16
+
+/* Open addressing hash table of fixed-size keys.
+ *
+ * The keys are stored in an external array. Every slot holds the array index
+ * of a key increased by one. Zero marks an empty slot.
+ */
+struct scan_filter_table {
+	/* Array of keys. */
+	const void *keys;
+
+	/* Size of a single key. */
+	size_t key_size;
+
+	/* Table slots. */
+	uint8_t *slots;
+
+	/* Number of table slots. */
+	size_t slot_cnt;
+};
+
+/* UUID in the form used as a hash table key.
+ *
+ * UUIDs derived from the Bluetooth Base UUID are stored as 32-bit values,
+ * so that a 16-bit, 32-bit and 128-bit representation of the same UUID
+ * produce the same key.
+ */
+struct scan_filter_uuid_key {
+	/* Length of the value, 4 or 16 bytes. */
+	uint8_t len;
+
+	/* Little-endian value, unused bytes are zeroed. */
+	uint8_t val[SCAN_FILTER_UUID_KEY_LEN];
+};
+
+/* Trie node. */
+struct scan_filter_trie_node {
+	/* Index of the first child, 0 if none. */
+	uint16_t child;
+
+	/* Index of the next sibling, 0 if none. */
+	uint16_t sibling;
+
+	/* Character of the node. */
+	char c;
+
+	/* Index of the name that continues through this node and has
+	 * the lowest minimum length.
+	 */
+	uint8_t idx;
+
+	/* Minimum length of the name with index idx. */
+	uint8_t min_len;
+};
+
+/* Prefix trie of names. Node 0 is the root. */
+struct scan_filter_trie {
+	/* Trie nodes. */
+	struct scan_filter_trie_node *nodes;
+
+	/* Number of available nodes. */
+	size_t node_cnt;
+
+	/* Number of used nodes. */
+	size_t used;
+};
+
+/* Remove all keys from the hash table. */
+void scan_filter_table_clear(struct scan_filter_table *table);
+
+/* Add the key with the given index in the key array to the hash table.
+ * The caller makes sure that the key is not in the table yet.
+ */
+int scan_filter_table_insert(struct scan_filter_table *table, size_t idx);
+
+/* Find the key in the hash table.
+ *
+ * Returns the index of the key in the key array or a negative error code
+ * if the key is not in the table.
+ */
+int scan_filter_table_find(const struct scan_filter_table *table,
+			   const void *key);
+
+/* Create the UUID key from a little-endian UUID of 2, 4 or 16 bytes. */
+int scan_filter_uuid_key_get(const uint8_t *data, size_t len,
+			     struct scan_filter_uuid_key *key);
+
+/* Remove all names from the trie. */
+void scan_filter_trie_clear(struct scan_filter_trie *trie);
+
+/* Add the name with the given index to the trie. */
+int scan_filter_trie_add(struct scan_filter_trie *trie, const char *name,
+			 uint8_t min_len, uint8_t idx);
+
+/* Find a name that the data is a prefix of.
+ *
+ * Data matches a name if it is the name's prefix and it is at least as
+ * long as the minimum length of the name.
+ *
+ * Returns the index of the matched name or a negative error code if
+ * no name matches.
+ */
+int scan_filter_trie_find(const struct scan_filter_trie *trie,
+			  const uint8_t *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BT_SCAN_FILTER_H_ */
@@ -60,6 +60,18 @@ void bl_boot(const struct fw_info *fw_info)
 	}
 #endif
 
+#ifdef PM_B0_CACHE_ADDRESS
+	/* The validation cache is written during validation, so it cannot be
+	 * protected together with the bootloader.
+	 */
+	int cache_err = fprotect_area(PM_B0_CACHE_ADDRESS, PM_B0_CACHE_SIZE);
+
+	if (cache_err) {
+		printk("Failed to protect validation cache.\n\r");
+		return;
+	}
+#endif
+
 #if CONFIG_ARCH_HAS_USERSPACE
 	__ASSERT(!(CONTROL_nPRIV_Msk & __get_CONTROL()),
 			"Not in Privileged mode");
@@ -54,23 +54,30 @@ static int verify_truncated_hash(const uint8_t *data, uint32_t data_len,
 	return 0;
 }
 
-static int verify_signature(const uint8_t *data, uint32_t data_len,
+static int verify_signature_digest(const uint8_t *digest,
 		const uint8_t *signature, const uint8_t *public_key, bool external)
 {
-	uint8_t hash1[CONFIG_SB_HASH_LEN];
 	uint8_t hash2[CONFIG_SB_HASH_LEN];
 
-	int retval = get_hash(hash1, data, data_len, external);
+	int retval = get_hash(hash2, digest, CONFIG_SB_HASH_LEN, external);
 	if (retval != 0) {
 		return retval;
 	}
 
-	retval = get_hash(hash2, hash1, CONFIG_SB_HASH_LEN, external);
+	return bl_secp256r1_validate(hash2, CONFIG_SB_HASH_LEN, public_key, signature);
+}
+
+static int verify_signature(const uint8_t *data, uint32_t data_len,
+		const uint8_t *signature, const uint8_t *public_key, bool external)
+{
+	uint8_t hash1[CONFIG_SB_HASH_LEN];
+
+	int retval = get_hash(hash1, data, data_len, external);
 	if (retval != 0) {
 		return retval;
 	}
 
-	return bl_secp256r1_validate(hash2, CONFIG_SB_HASH_LEN, public_key, signature);
+	return verify_signature_digest(hash1, signature, public_key, external);
 }
 
 /* Base implementation, with 'external' parameter. */
@@ -91,6 +98,31 @@ static int root_of_trust_verify(
 	return verify_signature(firmware, firmware_len, signature, public_key,
 			external);
 }
+
+
+int bl_sha256_digest(const uint8_t *data, uint32_t data_len, uint8_t *output)
+{
+	return get_hash(output, data, data_len, false);
+}
+
+
+int bl_root_of_trust_verify_digest(const uint8_t *public_key,
+				   const uint8_t *public_key_hash,
+				   const uint8_t *signature,
+				   const uint8_t *firmware_digest)
+{
+	__ASSERT(public_key && public_key_hash && signature && firmware_digest,
+			"A parameter was NULL.");
+	int retval = verify_truncated_hash(public_key, CONFIG_SB_PUBLIC_KEY_LEN,
+			public_key_hash, CONFIG_SB_PUBLIC_KEY_HASH_LEN, false);
+
+	if (retval != 0) {
+		return retval;
+	}
+
+	return verify_signature_digest(firmware_digest, signature, public_key,
+			false);
+}
 #endif
 
 
@@ -71,6 +71,10 @@ bool bl_validate_firmware(uint32_t fw_dst_address, uint32_t fw_src_address)
 #include <pm_config.h>
 #endif
 
+#ifdef CONFIG_SB_VALIDATION_TIMING
+#include <nrf.h>
+#endif
+
 #define PRINT(...) if (!external) printk(__VA_ARGS__)
 
 struct __packed fw_validation_info {
@@ -143,11 +147,188 @@ validation_info_find(uint32_t start_address, uint32_t search_distance)
 	return NULL;
 }
 
+#ifdef CONFIG_SB_VALIDATION_TIMING
+/* Read the DWT cycle counter, enabling it on first use. */
+static uint32_t cycles_get(void)
+{
+	if (!(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk)) {
+		CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+		DWT->CYCCNT = 0;
+		DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	}
+	return DWT->CYCCNT;
+}
+#else
+static inline uint32_t cycles_get(void)
+{
+	return 0;
+}
+#endif
+
 #ifdef CONFIG_SB_VALIDATE_FW_SIGNATURE
-static bool validate_signature(const uint32_t fw_src_address, const uint32_t fw_size,
+#ifdef CONFIG_SB_VALIDATION_CACHE
+#include <nrfx_nvmc.h>
+
+#define VALIDATION_CACHE_MAGIC 0x281ee6de
+#define ERASED_VAL 0xFFFFFFFF
+
+/* Result of a successful signature validation, stored in the B0_CACHE
+ * partition. The partition is write-protected before booting the firmware,
+ * so the entries can only be written by this bootloader.
+ *
+ * An entry only replaces the signature verification. The firmware is still
+ * hashed on every boot and the digest is compared with the cached one.
+ */
+struct __packed validation_cache_entry {
+	/* Written last, so only complete entries are valid. */
+	uint32_t magic;
+	uint32_t address;
+	uint32_t version;
+	uint32_t size;
+	/* Index of the provisioned public key hash that matched. */
+	uint32_t key_idx;
+	uint8_t  digest[CONFIG_SB_HASH_LEN];
+	uint8_t  public_key[CONFIG_SB_PUBLIC_KEY_LEN];
+	uint8_t  signature[CONFIG_SB_SIGNATURE_LEN];
+};
+
+BUILD_ASSERT(sizeof(struct validation_cache_entry) % 4 == 0,
+	"Cache entry must consist of whole words.");
+
+static const struct validation_cache_entry *const cache_entries =
+	(const struct validation_cache_entry *)PM_B0_CACHE_ADDRESS;
+
+/* Only the first page is used, so the cache can be reset with one erase. */
+static size_t cache_entry_cnt(void)
+{
+	return MIN(PM_B0_CACHE_SIZE, nrfx_nvmc_flash_page_size_get())
+		/ sizeof(struct validation_cache_entry);
+}
+
+static bool cache_entry_erased(const struct validation_cache_entry *entry)
+{
+	const uint32_t *words = (const uint32_t *)entry;
+
+	for (size_t i = 0; i < (sizeof(*entry) / 4); i++) {
+		if (words[i] != ERASED_VAL) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/* Find the newest entry for the firmware at the given address. */
+static const struct validation_cache_entry *cache_find(uint32_t address)
+{
+	const struct validation_cache_entry *found = NULL;
+
+	for (size_t i = 0; i < cache_entry_cnt(); i++) {
+		if ((cache_entries[i].magic == VALIDATION_CACHE_MAGIC)
+		    && (cache_entries[i].address == address)) {
+			found = &cache_entries[i];
+		}
+	}
+	return found;
+}
+
+static bool cache_hit(const struct fw_info *fwinfo,
+		      const struct fw_validation_info *fw_val_info,
+		      const uint8_t *digest)
+{
+	const struct validation_cache_entry *entry =
+					cache_find(fwinfo->address);
+	__aligned(4) uint8_t key_data[CONFIG_SB_PUBLIC_KEY_HASH_LEN];
+
+	if (entry == NULL) {
+		return false;
+	}
+
+	if ((entry->version != fwinfo->version)
+	    || (entry->size != fwinfo->size)
+	    || memcmp(entry->public_key, fw_val_info->public_key,
+		      CONFIG_SB_PUBLIC_KEY_LEN)
+	    || memcmp(entry->signature, fw_val_info->signature,
+		      CONFIG_SB_SIGNATURE_LEN)) {
+		return false;
+	}
+
+	/* The key might have been invalidated after the entry was written. */
+	if (public_key_data_read(entry->key_idx, key_data, sizeof(key_data))
+	    != CONFIG_SB_PUBLIC_KEY_HASH_LEN) {
+		return false;
+	}
+
+	return memcmp(entry->digest, digest, CONFIG_SB_HASH_LEN) == 0;
+}
+
+static void cache_store(const struct fw_info *fwinfo,
+			const struct fw_validation_info *fw_val_info,
+			const uint8_t *digest, uint32_t key_idx)
+{
+	struct validation_cache_entry entry = {
+		.magic = VALIDATION_CACHE_MAGIC,
+		.address = fwinfo->address,
+		.version = fwinfo->version,
+		.size = fwinfo->size,
+		.key_idx = key_idx,
+	};
+	size_t cnt = cache_entry_cnt();
+	size_t i;
+
+	memcpy(entry.digest, digest, CONFIG_SB_HASH_LEN);
+	memcpy(entry.public_key, fw_val_info->public_key,
+		CONFIG_SB_PUBLIC_KEY_LEN);
+	memcpy(entry.signature, fw_val_info->signature,
+		CONFIG_SB_SIGNATURE_LEN);
+
+	for (i = 0; i < cnt; i++) {
+		if (cache_entry_erased(&cache_entries[i])) {
+			break;
+		}
+	}
+
+	if (i == cnt) {
+		if (nrfx_nvmc_page_erase(PM_B0_CACHE_ADDRESS) != NRFX_SUCCESS) {
+			printk("Failed to erase validation cache.\n\r");
+			return;
+		}
+		i = 0;
+	}
+
+	nrfx_nvmc_words_write((uint32_t)&cache_entries[i].address,
+			&entry.address, (sizeof(entry) / 4) - 1);
+	nrfx_nvmc_word_write((uint32_t)&cache_entries[i].magic, entry.magic);
+}
+#else
+static inline bool cache_hit(const struct fw_info *fwinfo,
+			     const struct fw_validation_info *fw_val_info,
+			     const uint8_t *digest)
+{
+	return false;
+}
+
+static inline void cache_store(const struct fw_info *fwinfo,
+			       const struct fw_validation_info *fw_val_info,
+			       const uint8_t *digest, uint32_t key_idx)
+{
+}
+#endif /* CONFIG_SB_VALIDATION_CACHE */
+
+static bool validate_signature(const uint32_t fw_src_address,
+			       const struct fw_info *fwinfo,
 			       const struct fw_validation_info *fw_val_info,
 			       bool external)
 {
+	/* The digest is only calculated separately for local calls, since
+	 * the EXT_API must not use the static buffers of the bootloader.
+	 */
+	const bool use_digest = !external &&
+		!IS_ENABLED(CONFIG_BL_ROT_VERIFY_EXT_API_REQUIRED);
+	uint8_t digest[CONFIG_SB_HASH_LEN];
+	uint32_t hash_cycles = 0;
+	uint32_t sig_cycles = 0;
+	uint32_t start;
+
 	int init_retval = bl_crypto_init();
 
 	if (init_retval) {
@@ -155,6 +336,29 @@ static bool validate_signature(const uint32_t fw_src_address, const uint32_t fw_
 		return false;
 	}
 
+	if (use_digest) {
+		start = cycles_get();
+		init_retval = bl_sha256_digest((const uint8_t *)fw_src_address,
+					       fwinfo->size, digest);
+		hash_cycles = cycles_get() - start;
+
+		if (init_retval) {
+			PRINT("bl_sha256_digest() returned %d.\n\r",
+				init_retval);
+			return false;
+		}
+
+		if (IS_ENABLED(CONFIG_SB_VALIDATION_TIMING)) {
+			PRINT("Firmware hashed in %u cycles.\n\r",
+				hash_cycles);
+		}
+
+		if (cache_hit(fwinfo, fw_val_info, digest)) {
+			PRINT("Firmware digest matches validation cache.\n\r");
+			return true;
+		}
+	}
+
 	init_retval = verify_public_keys();
 	if (init_retval) {
 		PRINT("verify_public_keys() returned %d.\n\r", init_retval);
@@ -192,11 +396,23 @@ static bool validate_signature(const uint32_t fw_src_address, const uint32_t fw_
 		PRINT("Verifying signature against key %d.\n\r", key_data_idx);
 		PRINT("Hash: 0x%02x...%02x\r\n", key_data[0],
 			key_data[CONFIG_SB_PUBLIC_KEY_HASH_LEN-1]);
-		int retval = rot_verify(fw_val_info->public_key,
+		int retval;
+
+		if (use_digest) {
+			start = cycles_get();
+			retval = bl_root_of_trust_verify_digest(
+					fw_val_info->public_key,
+					key_data,
+					fw_val_info->signature,
+					digest);
+			sig_cycles += cycles_get() - start;
+		} else {
+			retval = rot_verify(fw_val_info->public_key,
 					key_data,
 					fw_val_info->signature,
 					(const uint8_t *)fw_src_address,
-					fw_size);
+					fwinfo->size);
+		}
 
 		if (retval == 0) {
 			for (uint32_t i = 0; i < key_data_idx; i++) {
@@ -204,6 +420,14 @@ static bool validate_signature(const uint32_t fw_src_address, const uint32_t fw_
 				invalidate_public_key(i);
 			}
 			PRINT("Firmware signature verified.\n\r");
+			if (use_digest) {
+				if (IS_ENABLED(CONFIG_SB_VALIDATION_TIMING)) {
+					PRINT("Signature verified in %u "
+						"cycles.\n\r", sig_cycles);
+				}
+				cache_store(fwinfo, fw_val_info, digest,
+					    key_data_idx);
+			}
 			return true;
 		} else if (retval == -EHASHINV) {
 			PRINT("Public key didn't match, try next.\n\r");
@@ -232,9 +456,13 @@ static bool validate_hash(const uint32_t fw_src_address, const uint32_t fw_size,
 		return false;
 	}
 
+	uint32_t start = cycles_get();
+
 	retval = bl_sha256_verify((const uint8_t *)fw_src_address, fw_size,
 			fw_val_info->hash);
 
+	uint32_t hash_cycles = cycles_get() - start;
+
 	if (retval != 0) {
 		PRINT("Firmware validation failed with error %d.\n\r",
 			    retval);
@@ -242,6 +470,9 @@ static bool validate_hash(const uint32_t fw_src_address, const uint32_t fw_size,
 	}
 
 	PRINT("Firmware hash verified.\n\r");
+	if (IS_ENABLED(CONFIG_SB_VALIDATION_TIMING)) {
+		PRINT("Firmware hashed in %u cycles.\n\r", hash_cycles);
+	}
 
 	return true;
 }
@@ -334,7 +565,7 @@ static bool validate_firmware(uint32_t fw_dst_address, uint32_t fw_src_address,
 	}
 
 #ifdef CONFIG_SB_VALIDATE_FW_SIGNATURE
-	return validate_signature(fw_src_address, fwinfo->size, fw_val_info,
+	return validate_signature(fw_src_address, fwinfo, fw_val_info,
 				external);
 #elif defined(CONFIG_SB_VALIDATE_FW_HASH)
 	return validate_hash(fw_src_address, fwinfo->size, fw_val_info,
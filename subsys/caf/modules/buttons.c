@@ -32,6 +32,10 @@ LOG_MODULE_REGISTER(MODULE, CONFIG_CAF_BUTTONS_LOG_LEVEL);
 /* For directly connected GPIO, scan rows once. */
 #define COLUMNS MAX(ARRAY_SIZE(col), 1)
 
+#ifdef CONFIG_CAF_BUTTONS_SCAN_STATS
+#define SCAN_STATS_COUNT CONFIG_CAF_BUTTONS_SCAN_STATS_COUNT
+#endif
+
 enum state {
 	STATE_IDLE,
 	STATE_ACTIVE,
@@ -39,23 +43,55 @@ enum state {
 	STATE_SUSPENDING
 };
 
+enum col_pin_state {
+	COL_PIN_UNKNOWN,
+	COL_PIN_INPUT,
+	COL_PIN_LOW,
+	COL_PIN_HIGH
+};
+
 static const struct device *gpio_devs[ARRAY_SIZE(port_map)];
 static struct gpio_callback gpio_cb[ARRAY_SIZE(port_map)];
 static struct k_delayed_work matrix_scan;
 static struct k_delayed_work button_pressed;
 static enum state state;
 
+/* Pins of every port that are used as rows, read with a single access. */
+static uint32_t row_port_mask[ARRAY_SIZE(port_map)];
+static enum col_pin_state col_pin_state[MAX(ARRAY_SIZE(col), 1)];
+
 
 static void scan_fn(struct k_work *work);
 
 
+static void col_pins_invalidate(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(col); i++) {
+		col_pin_state[i] = COL_PIN_UNKNOWN;
+	}
+}
+
 static int set_cols(uint32_t mask)
 {
 	for (size_t i = 0; i < ARRAY_SIZE(col); i++) {
 		uint32_t val = (mask & BIT(i)) ? (1) : (0);
+		enum col_pin_state pin_state;
 		int err;
 
 		if (val || !mask) {
+			pin_state = (val) ? (COL_PIN_HIGH) : (COL_PIN_LOW);
+		} else {
+			pin_state = COL_PIN_INPUT;
+		}
+
+		/* Only pins that change are reconfigured, so that moving to
+		 * the next column touches two pins instead of all of them.
+		 */
+		if (pin_state == col_pin_state[i]) {
+			continue;
+		}
+
+		if (pin_state != COL_PIN_INPUT) {
 			if (IS_ENABLED(CONFIG_CAF_BUTTONS_POLARITY_INVERSED)) {
 				val = !val;
 			}
@@ -73,8 +109,11 @@ static int set_cols(uint32_t mask)
 
 		if (err) {
 			LOG_ERR("Cannot set pin");
+			col_pin_state[i] = COL_PIN_UNKNOWN;
 			return -EFAULT;
 		}
+
+		col_pin_state[i] = pin_state;
 	}
 
 	return 0;
@@ -82,24 +121,70 @@ static int set_cols(uint32_t mask)
 
 static int get_rows(uint32_t *mask)
 {
-	for (size_t i = 0; i < ARRAY_SIZE(row); i++) {
-		int val = gpio_pin_get_raw(gpio_devs[row[i].port], row[i].pin);
+	gpio_port_value_t port_val[ARRAY_SIZE(port_map)];
 
-		if (val < 0) {
-			LOG_ERR("Cannot get pin");
+	/* Read every port once instead of every pin separately. */
+	for (size_t i = 0; i < ARRAY_SIZE(port_map); i++) {
+		if (!row_port_mask[i]) {
+			continue;
+		}
+
+		int err = gpio_port_get_raw(gpio_devs[i], &port_val[i]);
+
+		if (err) {
+			LOG_ERR("Cannot get port");
 			return -EFAULT;
 		}
 
 		if (IS_ENABLED(CONFIG_CAF_BUTTONS_POLARITY_INVERSED)) {
-			val = !val;
+			port_val[i] = ~port_val[i];
 		}
+	}
 
-		*mask |= (val << i);
+	for (size_t i = 0; i < ARRAY_SIZE(row); i++) {
+		if (port_val[row[i].port] & BIT(row[i].pin)) {
+			*mask |= BIT(i);
+		}
 	}
 
 	return 0;
 }
 
+#ifdef CONFIG_CAF_BUTTONS_SCAN_STATS
+struct scan_stats {
+	uint32_t cnt;
+	uint32_t min;
+	uint32_t max;
+	uint32_t sum;
+};
+
+static void scan_stats_update(uint32_t start)
+{
+	static struct scan_stats stats = {
+		.min = UINT32_MAX,
+	};
+	uint32_t scan_time = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+
+	stats.cnt++;
+	stats.sum += scan_time;
+	stats.min = MIN(stats.min, scan_time);
+	stats.max = MAX(stats.max, scan_time);
+
+	if (stats.cnt == SCAN_STATS_COUNT) {
+		LOG_INF("Scan time: avg %" PRIu32 " us, min %" PRIu32
+			" us, max %" PRIu32 " us", stats.sum / stats.cnt,
+			stats.min, stats.max);
+
+		memset(&stats, 0, sizeof(stats));
+		stats.min = UINT32_MAX;
+	}
+}
+#else
+static void scan_stats_update(uint32_t start)
+{
+}
+#endif /* CONFIG_CAF_BUTTONS_SCAN_STATS */
+
 static int set_trig_mode(void)
 {
 	gpio_flags_t flags = (IS_ENABLED(CONFIG_CAF_BUTTONS_POLARITY_INVERSED) ?
@@ -221,10 +306,17 @@ static void scan_fn(struct k_work *work)
 	__ASSERT_NO_MSG((state == STATE_SCANNING) ||
 			(state == STATE_SUSPENDING));
 
+	uint32_t scan_start = k_cycle_get_32();
+
 	/* Get current state */
 	uint32_t raw_state[COLUMNS];
 	memset(raw_state, 0, sizeof(raw_state));
 
+	/* Column pins could have been changed from the interrupt handler,
+	 * set all of them on the first column.
+	 */
+	col_pins_invalidate();
+
 	for (size_t i = 0; i < COLUMNS; i++) {
 		int err = set_cols(BIT(i));
 
@@ -304,6 +396,8 @@ static void scan_fn(struct k_work *work)
 			      (cur_state[i] != 0);
 	}
 
+	scan_stats_update(scan_start);
+
 	if (any_pressed) {
 		/* Schedule next scan */
 		k_delayed_work_submit(&matrix_scan, K_MSEC(SCAN_INTERVAL));
@@ -471,6 +565,8 @@ static void init_fn(void)
 		pin_mask[row[i].port] |= BIT(row[i].pin);
 	}
 
+	memcpy(row_port_mask, pin_mask, sizeof(row_port_mask));
+
 	for (size_t i = 0; i < ARRAY_SIZE(port_map); i++) {
 		if (!port_map[i]) {
 			/* Skip non-existing ports */
@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
  */
 
+#include <zephyr.h>
 #include <modem_update_decode.h>
 #include <drivers/flash.h>
 #include <logging/log.h>
@@ -17,8 +18,139 @@ LOG_MODULE_REGISTER(fmfu_fdev, CONFIG_FMFU_FDEV_LOG_LEVEL);
 /* The size of the cbor metadata structure will not exceed this value. */
 #define MAX_META_LEN 1024
 
+#define HASH_LEN 32
+
 static uint8_t meta_buf[MAX_META_LEN];
 
+/* Time spent on reading and writing a segment. */
+struct segment_stats {
+	uint32_t read_ms;
+	uint32_t write_ms;
+};
+
+#ifdef CONFIG_FMFU_FDEV_PIPELINE
+#define PIPELINE_BUF_CNT 2
+
+/* The reader thread reads the blob from the flash device to one half of the
+ * buffer and updates the hash, while the calling thread writes the other
+ * half to the modem.
+ */
+static struct {
+	const struct device *fdev;
+	const struct Segments *seg;
+	size_t blob_offset;
+	uint8_t *buf[PIPELINE_BUF_CNT];
+	size_t chunk_len[PIPELINE_BUF_CNT];
+	size_t buf_len;
+	size_t consumer_idx;
+	mbedtls_sha256_context sha256_ctx;
+	uint8_t expected_hash[HASH_LEN];
+	struct k_sem free_sem;
+	struct k_sem ready_sem;
+	atomic_t abort;
+	int err;
+} pipeline;
+
+static K_THREAD_STACK_DEFINE(reader_stack,
+			     CONFIG_FMFU_FDEV_PIPELINE_STACK_SIZE);
+static struct k_thread reader_thread;
+
+static void reader_fn(void *p1, void *p2, void *p3)
+{
+	size_t read_addr = pipeline.blob_offset;
+	size_t idx = 0;
+
+	for (int i = 0; i < pipeline.seg->_Segments__Segment_count; i++) {
+		size_t bytes_left =
+			pipeline.seg->_Segments__Segment[i]._Segment_len;
+
+		while (bytes_left) {
+			size_t read_len = MIN(pipeline.buf_len, bytes_left);
+			int err;
+
+			k_sem_take(&pipeline.free_sem, K_FOREVER);
+			if (atomic_get(&pipeline.abort)) {
+				return;
+			}
+
+			err = flash_read(pipeline.fdev, read_addr,
+					 pipeline.buf[idx], read_len);
+			if (err == 0) {
+				err = mbedtls_sha256_update_ret(
+					&pipeline.sha256_ctx,
+					pipeline.buf[idx], read_len);
+			}
+
+			if (err != 0) {
+				pipeline.err = err;
+				k_sem_give(&pipeline.ready_sem);
+				return;
+			}
+
+			pipeline.chunk_len[idx] = read_len;
+			k_sem_give(&pipeline.ready_sem);
+
+			idx = (idx + 1) % PIPELINE_BUF_CNT;
+			read_addr += read_len;
+			bytes_left -= read_len;
+		}
+	}
+}
+
+static int pipeline_start(const struct device *fdev,
+			  const struct Segments *seg, size_t blob_offset,
+			  uint8_t *buf, size_t buf_len,
+			  const uint8_t *expected_hash)
+{
+	int err;
+
+	pipeline.buf_len = buf_len / PIPELINE_BUF_CNT;
+	if (pipeline.buf_len == 0) {
+		return -EINVAL;
+	}
+
+	for (size_t i = 0; i < PIPELINE_BUF_CNT; i++) {
+		pipeline.buf[i] = buf + i * pipeline.buf_len;
+	}
+
+	pipeline.fdev = fdev;
+	pipeline.seg = seg;
+	pipeline.blob_offset = blob_offset;
+	pipeline.consumer_idx = 0;
+	pipeline.err = 0;
+	memcpy(pipeline.expected_hash, expected_hash, HASH_LEN);
+	atomic_set(&pipeline.abort, false);
+	k_sem_init(&pipeline.free_sem, PIPELINE_BUF_CNT, PIPELINE_BUF_CNT);
+	k_sem_init(&pipeline.ready_sem, 0, PIPELINE_BUF_CNT);
+
+	mbedtls_sha256_init(&pipeline.sha256_ctx);
+
+	err = mbedtls_sha256_starts_ret(&pipeline.sha256_ctx, false);
+	if (err != 0) {
+		return err;
+	}
+
+	k_thread_create(&reader_thread, reader_stack,
+			K_THREAD_STACK_SIZEOF(reader_stack), reader_fn,
+			NULL, NULL, NULL,
+			k_thread_priority_get(k_current_get()), 0, K_NO_WAIT);
+	k_thread_name_set(&reader_thread, "fmfu_fdev_reader");
+
+	return 0;
+}
+
+static void pipeline_stop(void)
+{
+	/* The reader thread waits for at most one free buffer. */
+	atomic_set(&pipeline.abort, true);
+	k_sem_give(&pipeline.free_sem);
+
+	k_thread_join(&reader_thread, K_FOREVER);
+	mbedtls_sha256_free(&pipeline.sha256_ctx);
+}
+#endif /* CONFIG_FMFU_FDEV_PIPELINE */
+
+#ifndef CONFIG_FMFU_FDEV_PIPELINE
 static int get_hash_from_flash(const struct device *fdev, size_t offset,
 			       size_t data_len, uint8_t *hash, uint8_t *buffer,
 			       size_t buffer_len)
@@ -55,6 +187,65 @@ static int get_hash_from_flash(const struct device *fdev, size_t offset,
 
 	return 0;
 }
+#endif /* CONFIG_FMFU_FDEV_PIPELINE */
+
+/* Get the next chunk of the blob. */
+static int chunk_read(const struct device *fdev, uint32_t read_addr,
+		      size_t read_len, uint8_t *buf, uint8_t **chunk)
+{
+#ifdef CONFIG_FMFU_FDEV_PIPELINE
+	size_t idx = pipeline.consumer_idx;
+
+	ARG_UNUSED(fdev);
+	ARG_UNUSED(read_addr);
+	ARG_UNUSED(buf);
+
+	k_sem_take(&pipeline.ready_sem, K_FOREVER);
+	if (pipeline.err != 0) {
+		return pipeline.err;
+	}
+
+	__ASSERT_NO_MSG(pipeline.chunk_len[idx] == read_len);
+
+	*chunk = pipeline.buf[idx];
+
+	return 0;
+#else
+	*chunk = buf;
+
+	return flash_read(fdev, read_addr, buf, read_len);
+#endif /* CONFIG_FMFU_FDEV_PIPELINE */
+}
+
+/* Return the chunk buffer, once the chunk is written to the modem. */
+static void chunk_release(void)
+{
+#ifdef CONFIG_FMFU_FDEV_PIPELINE
+	pipeline.consumer_idx = (pipeline.consumer_idx + 1) %
+				PIPELINE_BUF_CNT;
+	k_sem_give(&pipeline.free_sem);
+#endif /* CONFIG_FMFU_FDEV_PIPELINE */
+}
+
+/* Verify the hash of the blob calculated while the segments were loaded. */
+static int blob_hash_verify(void)
+{
+#ifdef CONFIG_FMFU_FDEV_PIPELINE
+	uint8_t hash[HASH_LEN];
+	int err = mbedtls_sha256_finish_ret(&pipeline.sha256_ctx, hash);
+
+	if (err != 0) {
+		return err;
+	}
+
+	if (memcmp(pipeline.expected_hash, hash, sizeof(hash)) != 0) {
+		LOG_ERR("Invalid hash");
+		return -EINVAL;
+	}
+#endif /* CONFIG_FMFU_FDEV_PIPELINE */
+
+	return 0;
+}
 
 static int write_chunk(uint8_t *buf, size_t buf_len, uint32_t address,
 		       bool is_bootloader)
@@ -81,7 +272,8 @@ static int write_chunk(uint8_t *buf, size_t buf_len, uint32_t address,
 
 static int load_segment(const struct device *fdev, size_t seg_size,
 			uint32_t seg_target_addr, uint32_t seg_offset,
-			uint8_t *buf, size_t buf_len, bool is_bootloader)
+			uint8_t *buf, size_t buf_len, bool is_bootloader,
+			struct segment_stats *stats)
 {
 	int err;
 	uint32_t read_addr = seg_offset;
@@ -89,20 +281,28 @@ static int load_segment(const struct device *fdev, size_t seg_size,
 
 	while (bytes_left) {
 		uint32_t read_len = MIN(buf_len, bytes_left);
+		uint32_t start = k_uptime_get_32();
+		uint8_t *chunk;
 
-		err = flash_read(fdev, read_addr, buf, read_len);
+		err = chunk_read(fdev, read_addr, read_len, buf, &chunk);
 		if (err != 0) {
 			LOG_ERR("flash_read failed: %d", err);
 			return err;
 		}
 
-		err = write_chunk(buf, read_len, seg_target_addr,
+		stats->read_ms += k_uptime_get_32() - start;
+		start = k_uptime_get_32();
+
+		err = write_chunk(chunk, read_len, seg_target_addr,
 				  is_bootloader);
 		if (err != 0) {
 			LOG_ERR("write_chunk failed: %d", err);
 			return err;
 		}
 
+		stats->write_ms += k_uptime_get_32() - start;
+		chunk_release();
+
 		LOG_DBG("Wrote chunk: offset 0x%x target addr 0x%x size 0x%x",
 			read_addr, seg_target_addr, read_len);
 
@@ -139,18 +339,23 @@ static int load_segments(const struct device *fdev, uint8_t *meta_buf,
 			seg->_Segments__Segment[i]._Segment_target_addr;
 		uint32_t read_addr = blob_offset + prev_segments_len;
 		bool is_bootloader = i == 0;
+		struct segment_stats stats = {0};
 
 		LOG_INF("Writing segment %d/%d, Target addr: 0x%x, size: 0%x",
 			i + 1, seg->_Segments__Segment_count, seg_addr,
 			seg_size);
 
 		err = load_segment(fdev, seg_size, seg_addr, read_addr, buf,
-				   buf_len, is_bootloader);
+				   buf_len, is_bootloader, &stats);
 		if (err != 0) {
 			LOG_ERR("load_segment failed: %d", err);
 			return err;
 		}
 
+		LOG_INF("Segment %d written, flash read: %u ms, "
+			"modem write: %u ms", i + 1, stats.read_ms,
+			stats.write_ms);
+
 		if (i == 0) {
 #ifndef CONFIG_FMFU_FDEV_SKIP_PREVALIDATION
 			/* The IPC-DFU bootloader has been written, we can now
@@ -173,6 +378,11 @@ static int load_segments(const struct device *fdev, uint8_t *meta_buf,
 		prev_segments_len += seg_size;
 	}
 
+	err = blob_hash_verify();
+	if (err != 0) {
+		return err;
+	}
+
 	err = nrf_modem_full_dfu_apply();
 	if (err != 0) {
 		LOG_ERR("nrf_..._full_dfu_apply (fw) failed, errno: %d", errno);
@@ -189,13 +399,11 @@ int fmfu_fdev_load(uint8_t *buf, size_t buf_len, const struct device *fdev,
 {
 	const cbor_string_type_t *segments_string;
 	struct COSE_Sign1_Manifest wrapper;
-	bool hash_len_valid = false;
-	uint8_t expected_hash[32];
-	bool hash_valid = false;
+	uint8_t expected_hash[HASH_LEN];
 	struct Segments segments;
 	size_t blob_offset;
 	size_t wrapper_len;
-	uint8_t hash[32];
+	uint32_t start;
 	size_t blob_len;
 	int err;
 
@@ -250,32 +458,54 @@ int fmfu_fdev_load(uint8_t *buf, size_t buf_len, const struct device *fdev,
 		blob_len += segments._Segments__Segment[i]._Segment_len;
 	}
 
-	if (sizeof(hash) ==
+	if (HASH_LEN !=
 	    wrapper._COSE_Sign1_Manifest_payload_cbor._Manifest_blob_hash.len) {
-		hash_len_valid = true;
-	} else {
 		LOG_ERR("Invalid hash length");
 		return -EINVAL;
 	}
 
+	start = k_uptime_get_32();
+
+#ifdef CONFIG_FMFU_FDEV_PIPELINE
+	/* The hash is calculated while the segments are loaded. The modem
+	 * firmware is applied only if the hash is valid.
+	 */
+	err = pipeline_start(fdev, &segments, blob_offset, buf, buf_len,
+			     expected_hash);
+	if (err != 0) {
+		return err;
+	}
+
+	err = load_segments(fdev, meta_buf, wrapper_len,
+			    (const struct Segments *)&segments, blob_offset,
+			    pipeline.buf[0], pipeline.buf_len);
+
+	pipeline_stop();
+#else
+	uint8_t hash[HASH_LEN];
+
 	err = get_hash_from_flash(fdev, blob_offset, blob_len, hash, buf,
 				  buf_len);
 	if (err != 0) {
 		return err;
 	}
 
-	if (memcmp(expected_hash, hash, sizeof(hash)) == 0) {
-		hash_valid = true;
-	} else {
+	LOG_INF("Hash calculated in %u ms", k_uptime_get_32() - start);
+
+	if (memcmp(expected_hash, hash, sizeof(hash)) != 0) {
 		LOG_ERR("Invalid hash");
 		return -EINVAL;
 	}
 
-	if (hash_len_valid && hash_valid) {
-		return load_segments(fdev, meta_buf, wrapper_len,
-				     (const struct Segments *)&segments,
-				     blob_offset, buf, buf_len);
-	} else {
-		return -EINVAL;
+	err = load_segments(fdev, meta_buf, wrapper_len,
+			    (const struct Segments *)&segments, blob_offset,
+			    buf, buf_len);
+#endif /* CONFIG_FMFU_FDEV_PIPELINE */
+
+	if (err == 0) {
+		LOG_INF("%zu bytes loaded in %u ms", blob_len,
+			k_uptime_get_32() - start);
 	}
+
+	return err;
 }
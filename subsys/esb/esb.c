@@ -5,6 +5,7 @@
  */
 #include <errno.h>
 #include <irq.h>
+#include <kernel.h>
 #include <sys/byteorder.h>
 #include <nrf.h>
 #include <esb.h>
@@ -54,6 +55,11 @@
 
 #define BIT_MASK_UINT_8(x) (0xFF >> (8 - (x)))
 
+/* Length of the fields that precede the payload data in RAM: the length and
+ * S1 fields in DPL mode or the S0 (PID) and S1 fields in legacy ESB mode.
+ */
+#define PDU_HEADER_LEN 2
+
 #define RADIO_SHORTS_COMMON                                                    \
 	(RADIO_SHORTS_READY_START_Msk | RADIO_SHORTS_END_DISABLE_Msk |         \
 	 RADIO_SHORTS_ADDRESS_RSSISTART_Msk |                                  \
@@ -104,10 +110,22 @@ struct pipe_info {
 	bool ack_payload; /* State of the transmission of ACK payloads. */
 };
 
+/* Payload stored in the format used by the radio, so that the radio
+ * transmits from and receives to the FIFO buffers directly.
+ */
+struct payload_buf {
+	uint8_t length;
+	uint8_t pipe;
+	int8_t rssi;
+	uint8_t noack;
+	uint8_t pid;
+	uint8_t pdu[PDU_HEADER_LEN + CONFIG_ESB_MAX_PAYLOAD_LENGTH];
+};
+
 /* Structure used by the PRX to organize ACK payloads for multiple pipes. */
 struct payload_wrap {
 	/* Pointer to the ACK payload. */
-	struct esb_payload  *p_payload;
+	struct payload_buf  *p_payload;
 	/* Value used to determine if the current payload pointer is used. */
 	bool in_use;
 	/* Pointer to the next ACK payload queued on the same pipe. */
@@ -117,7 +135,7 @@ struct payload_wrap {
 /* First-in, first-out queue of payloads to be transmitted. */
 struct payload_tx_fifo {
 	 /* Payload queue */
-	struct esb_payload *payload[CONFIG_ESB_TX_FIFO_SIZE];
+	struct payload_buf *payload[CONFIG_ESB_TX_FIFO_SIZE];
 
 	uint32_t back;	/* Back of the queue (last in). */
 	uint32_t front;	/* Front of queue (first out). */
@@ -127,7 +145,7 @@ struct payload_tx_fifo {
 /* First-in, first-out queue of received payloads. */
 struct payload_rx_fifo {
 	 /* Payload queue */
-	struct esb_payload *payload[CONFIG_ESB_RX_FIFO_SIZE];
+	struct payload_buf *payload[CONFIG_ESB_RX_FIFO_SIZE];
 
 	uint32_t back;	/* Back of the queue (last in). */
 	uint32_t front;	/* Front of queue (first out). */
@@ -171,13 +189,52 @@ static struct esb_address esb_addr = {
 };
 
 static esb_event_handler event_handler;
-static struct esb_payload *current_payload;
+static struct payload_buf *current_payload;
 
 /* FIFOs and buffers */
 static struct payload_tx_fifo tx_fifo;
 static struct payload_rx_fifo rx_fifo;
-static uint8_t tx_payload_buffer[CONFIG_ESB_MAX_PAYLOAD_LENGTH + 2];
-static uint8_t rx_payload_buffer[CONFIG_ESB_MAX_PAYLOAD_LENGTH + 2];
+static struct payload_buf tx_bufs[CONFIG_ESB_TX_FIFO_SIZE];
+static struct payload_buf rx_bufs[CONFIG_ESB_RX_FIFO_SIZE];
+
+/* ACK without payload, sent by the PRX. */
+static uint8_t tx_payload_buffer[PDU_HEADER_LEN];
+/* Used for reception when the RX FIFO is full. */
+static uint8_t rx_payload_buffer[PDU_HEADER_LEN +
+				 CONFIG_ESB_MAX_PAYLOAD_LENGTH];
+
+/* Buffers currently used by the radio EasyDMA. */
+static uint8_t *tx_pdu;
+static uint8_t *rx_pdu = rx_payload_buffer;
+
+/* TX buffer loaned to the application. */
+static struct payload_buf *tx_loan;
+
+#if defined(CONFIG_ESB_TX_BURST)
+/* The radio continues with the next packet right after the current one. */
+static bool tx_burst_active;
+#endif
+
+#if defined(CONFIG_ESB_HOPPING)
+/* Channel used for frequency hopping. */
+struct hop_channel {
+	struct esb_chn_stats stats;
+	uint16_t eval_attempts;	/* TX attempts in the evaluation window. */
+	uint16_t eval_failures;	/* Failed TX attempts in the window. */
+	uint32_t unblock_at;	/* Uptime in milliseconds at which the
+				 * blocked channel is used again.
+				 */
+};
+
+static struct {
+	struct hop_channel chn[CONFIG_ESB_HOP_CHANNELS_MAX];
+	uint8_t count;		/* Number of channels, zero if disabled. */
+	uint8_t current;	/* Index of the current channel. */
+	uint8_t attempts;	/* TX attempts on the current channel. */
+	uint32_t chmap;		/* Channels enabled by the application. */
+	uint32_t blocked;	/* Channels with a high packet error rate. */
+} hop;
+#endif /* defined(CONFIG_ESB_HOPPING) */
 
 /* Random access buffer variables for ACK payload handling */
 struct payload_wrap ack_pl_wrap[CONFIG_ESB_TX_FIFO_SIZE];
@@ -446,6 +503,8 @@ static bool update_radio_parameters(void)
 
 static void reset_fifos(void)
 {
+	tx_loan = NULL;
+
 	tx_fifo.back = 0;
 	tx_fifo.front = 0;
 	tx_fifo.count = 0;
@@ -457,21 +516,18 @@ static void reset_fifos(void)
 
 static void initialize_fifos(void)
 {
-	static struct esb_payload rx_payload[CONFIG_ESB_RX_FIFO_SIZE];
-	static struct esb_payload tx_payload[CONFIG_ESB_TX_FIFO_SIZE];
-
 	reset_fifos();
 
 	for (size_t i = 0; i < CONFIG_ESB_TX_FIFO_SIZE; i++) {
-		tx_fifo.payload[i] = &tx_payload[i];
+		tx_fifo.payload[i] = &tx_bufs[i];
 	}
 
 	for (size_t i = 0; i < CONFIG_ESB_RX_FIFO_SIZE; i++) {
-		rx_fifo.payload[i] = &rx_payload[i];
+		rx_fifo.payload[i] = &rx_bufs[i];
 	}
 
 	for (size_t i = 0; i < CONFIG_ESB_TX_FIFO_SIZE; i++) {
-		ack_pl_wrap[i].p_payload = &tx_payload[i];
+		ack_pl_wrap[i].p_payload = &tx_bufs[i];
 		ack_pl_wrap[i].in_use = false;
 		ack_pl_wrap[i].p_next = 0;
 	}
@@ -497,11 +553,27 @@ static void tx_fifo_remove_last(void)
 	irq_unlock(key);
 }
 
-/*  Function to push the content of the rx_buffer to the RX FIFO.
+/*  Function to point the radio to the buffer for the next received packet.
  *
- *  The module will point the register NRF_RADIO->PACKETPTR to a buffer for
- *  receiving packets. After receiving a packet the module will call this
- *  function to copy the received data to the RX FIFO.
+ *  The radio receives directly to the back of the RX FIFO. If the RX FIFO
+ *  is full, the packet is received to a separate buffer instead.
+ */
+static void rx_pdu_set(void)
+{
+	if (rx_fifo.count < CONFIG_ESB_RX_FIFO_SIZE) {
+		rx_pdu = rx_fifo.payload[rx_fifo.back]->pdu;
+	} else {
+		rx_pdu = rx_payload_buffer;
+	}
+
+	NRF_RADIO->PACKETPTR = (uint32_t)rx_pdu;
+}
+
+/*  Function to push the received packet to the RX FIFO.
+ *
+ *  The module will point the register NRF_RADIO->PACKETPTR to the back of
+ *  the RX FIFO for receiving packets. After receiving a packet the module
+ *  will call this function to add the packet to the RX FIFO.
  *
  *  @param  pipe Pipe number to set for the packet.
  *  @param  pid  Packet ID.
@@ -511,29 +583,35 @@ static void tx_fifo_remove_last(void)
  */
 static bool rx_fifo_push_rfbuf(uint8_t pipe, uint8_t pid)
 {
+	struct payload_buf *buf;
+
 	if (rx_fifo.count >= CONFIG_ESB_RX_FIFO_SIZE) {
 		return false;
 	}
 
+	buf = rx_fifo.payload[rx_fifo.back];
+
 	if (esb_cfg.protocol == ESB_PROTOCOL_ESB_DPL) {
-		if (rx_payload_buffer[0] > CONFIG_ESB_MAX_PAYLOAD_LENGTH) {
+		if (rx_pdu[0] > CONFIG_ESB_MAX_PAYLOAD_LENGTH) {
 			return false;
 		}
-		rx_fifo.payload[rx_fifo.back]->length = rx_payload_buffer[0];
+		buf->length = rx_pdu[0];
 	} else if (esb_cfg.mode == ESB_MODE_PTX) {
 		/* Received packet is an acknowledgment */
-		rx_fifo.payload[rx_fifo.back]->length = 0;
+		buf->length = 0;
 	} else {
-		rx_fifo.payload[rx_fifo.back]->length = esb_cfg.payload_length;
+		buf->length = esb_cfg.payload_length;
 	}
 
-	memcpy(rx_fifo.payload[rx_fifo.back]->data, &rx_payload_buffer[2],
-	       rx_fifo.payload[rx_fifo.back]->length);
+	/* The packet was received while the RX FIFO was full. */
+	if (rx_pdu != buf->pdu) {
+		memcpy(buf->pdu, rx_pdu, PDU_HEADER_LEN + buf->length);
+	}
 
-	rx_fifo.payload[rx_fifo.back]->pipe = pipe;
-	rx_fifo.payload[rx_fifo.back]->rssi = NRF_RADIO->RSSISAMPLE;
-	rx_fifo.payload[rx_fifo.back]->pid = pid;
-	rx_fifo.payload[rx_fifo.back]->noack = !(rx_payload_buffer[1] & 0x01);
+	buf->pipe = pipe;
+	buf->rssi = NRF_RADIO->RSSISAMPLE;
+	buf->pid = pid;
+	buf->noack = !(buf->pdu[1] & 0x01);
 
 	if (++rx_fifo.back >= CONFIG_ESB_RX_FIFO_SIZE) {
 		rx_fifo.back = 0;
@@ -587,6 +665,222 @@ static void ppi_init(void)
 							(1 << ppi_ch_timer_compare0_radio_disable) | (1 << ppi_ch_timer_compare1_radio_txen);
 }
 
+#if defined(CONFIG_ESB_HOPPING)
+/* Channel map with all channels enabled. */
+static uint32_t hop_chmap_all(void)
+{
+	return (hop.count < 32) ? BIT_MASK(hop.count) : UINT32_MAX;
+}
+
+static uint32_t hop_chmap_get(void)
+{
+	uint32_t chmap = hop.chmap & ~hop.blocked;
+
+	/* Use the blocked channels rather than none. */
+	return chmap ? chmap : hop.chmap;
+}
+
+/* Switch to the next enabled channel. The new frequency is used the next
+ * time the radio is enabled.
+ */
+static void hop_next(void)
+{
+	uint32_t chmap = hop_chmap_get();
+	uint8_t idx = hop.current;
+
+	if (chmap == 0) {
+		return;
+	}
+
+	do {
+		if (++idx >= hop.count) {
+			idx = 0;
+		}
+	} while (!(chmap & BIT(idx)));
+
+	hop.current = idx;
+	hop.attempts = 0;
+
+	esb_addr.rf_channel = hop.chn[idx].stats.channel;
+	NRF_RADIO->FREQUENCY = esb_addr.rf_channel;
+}
+
+static void hop_unblock(uint8_t idx)
+{
+	hop.blocked &= ~BIT(idx);
+	hop.chn[idx].eval_attempts = 0;
+	hop.chn[idx].eval_failures = 0;
+	hop.chn[idx].stats.enabled = (hop.chmap & BIT(idx)) != 0;
+}
+
+/* Evaluate the packet error rate of the current channel and block the
+ * channel if the rate is too high. At least CONFIG_ESB_HOP_MIN_CHANNELS
+ * channels stay enabled.
+ */
+static void hop_channel_evaluate(struct hop_channel *chn)
+{
+	if (chn->eval_attempts < CONFIG_ESB_HOP_EVAL_ATTEMPTS) {
+		return;
+	}
+
+	chn->stats.per = (100 * chn->eval_failures) / chn->eval_attempts;
+	chn->eval_attempts = 0;
+	chn->eval_failures = 0;
+
+	if ((chn->stats.per >= CONFIG_ESB_HOP_BLOCK_PER) &&
+	    (popcount(hop_chmap_get()) > CONFIG_ESB_HOP_MIN_CHANNELS)) {
+		hop.blocked |= BIT(hop.current);
+		chn->unblock_at = k_uptime_get_32() +
+				  CONFIG_ESB_HOP_BLOCK_DURATION;
+		chn->stats.enabled = false;
+
+		hop_next();
+	}
+}
+
+/* Update the channel statistics after a TX attempt that required an
+ * acknowledgment. After CONFIG_ESB_HOP_ATTEMPTS failed attempts, the next
+ * attempt is made on the next channel.
+ */
+static void hop_tx_result(bool success)
+{
+	struct hop_channel *chn;
+	uint32_t now;
+
+	if (hop.count == 0) {
+		return;
+	}
+
+	chn = &hop.chn[hop.current];
+	chn->stats.tx_attempts++;
+	chn->eval_attempts++;
+
+	if (success) {
+		chn->stats.tx_success++;
+		hop.attempts = 0;
+	} else {
+		chn->eval_failures++;
+	}
+
+	/* Blocked channels are used again after a while, also when all of
+	 * the other channels fail.
+	 */
+	now = k_uptime_get_32();
+	for (uint8_t i = 0; i < hop.count; i++) {
+		if ((hop.blocked & BIT(i)) &&
+		    ((int32_t)(now - hop.chn[i].unblock_at) >= 0)) {
+			hop_unblock(i);
+		}
+	}
+
+	hop_channel_evaluate(chn);
+
+	if (!success && (++hop.attempts >= CONFIG_ESB_HOP_ATTEMPTS)) {
+		hop_next();
+	}
+}
+#endif /* defined(CONFIG_ESB_HOPPING) */
+
+/* Fill in the packet header in front of the payload data of the current
+ * payload, so that the radio can transmit it directly from the TX FIFO.
+ */
+static void tx_pdu_prepare(void)
+{
+	tx_pdu = current_payload->pdu;
+
+	if (esb_cfg.protocol == ESB_PROTOCOL_ESB_DPL) {
+		tx_pdu[0] = current_payload->length;
+		tx_pdu[1] = current_payload->pid << 1;
+		tx_pdu[1] |= current_payload->noack ? 0x00 : 0x01;
+	} else {
+		tx_pdu[0] = current_payload->pid;
+		tx_pdu[1] = 0;
+	}
+}
+
+#if defined(CONFIG_ESB_TX_BURST)
+static void start_tx_transaction(void);
+
+/* Check if the next payload in the TX FIFO can be sent right after the
+ * current one. The radio then starts the next transmission by itself when
+ * it is disabled, instead of waiting for the interrupt handler.
+ */
+static bool tx_burst_next_available(void)
+{
+	const struct payload_buf *next;
+	uint32_t next_idx;
+
+	if ((tx_fifo.count < 2) || (esb_cfg.tx_mode != ESB_TXMODE_AUTO)) {
+		return false;
+	}
+
+	next_idx = tx_fifo.front + 1;
+	if (next_idx >= CONFIG_ESB_TX_FIFO_SIZE) {
+		next_idx = 0;
+	}
+
+	next = tx_fifo.payload[next_idx];
+
+	/* Only packets that do not need an acknowledgment can be chained,
+	 * and the address cannot change during the radio ramp-up.
+	 */
+	return next->noack && (next->pipe == current_payload->pipe);
+}
+
+static void on_radio_disabled_tx_burst_stop(void)
+{
+	if (tx_fifo.count == 0) {
+		esb_state = ESB_STATE_IDLE;
+	} else {
+		start_tx_transaction();
+	}
+}
+
+/* Stop the burst. The radio is disabled and the next payload in the TX FIFO,
+ * if any, is sent by a new transaction.
+ */
+static void tx_burst_stop(void)
+{
+	NRF_RADIO->SHORTS = radio_shorts_common;
+	NRF_RADIO->EVENTS_DISABLED = 0;
+	NRF_RADIO->TASKS_DISABLE = 1;
+	on_radio_disabled = on_radio_disabled_tx_burst_stop;
+	tx_burst_active = false;
+}
+
+/* The radio is already ramping up for the next packet, only the packet
+ * pointer needs to be updated before the transmission starts.
+ */
+static void tx_burst_continue(void)
+{
+	if ((tx_fifo.count == 0) ||
+	    !tx_fifo.payload[tx_fifo.front]->noack) {
+		/* The TX FIFO was modified during the burst. */
+		tx_burst_stop();
+		return;
+	}
+
+	current_payload = tx_fifo.payload[tx_fifo.front];
+	tx_pdu_prepare();
+	NRF_RADIO->PACKETPTR = (uint32_t)tx_pdu;
+
+	/* The packet pointer is read when the transmission starts. If the
+	 * ramp-up already ended, the radio is sending the previous packet
+	 * again, so the payload is sent by a new transaction instead.
+	 */
+	if ((NRF_RADIO->STATE != RADIO_STATE_STATE_TxRu) ||
+	    NRF_RADIO->EVENTS_DISABLED) {
+		tx_burst_stop();
+		return;
+	}
+
+	tx_burst_active = tx_burst_next_available();
+	if (!tx_burst_active) {
+		NRF_RADIO->SHORTS = radio_shorts_common;
+	}
+}
+#endif /* defined(CONFIG_ESB_TX_BURST) */
+
 static void start_tx_transaction(void)
 {
 	bool ack;
@@ -594,14 +888,11 @@ static void start_tx_transaction(void)
 	last_tx_attempts = 1;
 	/* Prepare the payload */
 	current_payload = tx_fifo.payload[tx_fifo.front];
+	tx_pdu_prepare();
 
 	switch (esb_cfg.protocol) {
 	case ESB_PROTOCOL_ESB:
 		update_rf_payload_format(current_payload->length);
-		tx_payload_buffer[0] = current_payload->pid;
-		tx_payload_buffer[1] = 0;
-		memcpy(&tx_payload_buffer[2], current_payload->data,
-		       current_payload->length);
 
 		NRF_RADIO->SHORTS = radio_shorts_common |
 				    RADIO_SHORTS_DISABLED_RXEN_Msk;
@@ -616,11 +907,6 @@ static void start_tx_transaction(void)
 
 	case ESB_PROTOCOL_ESB_DPL:
 		ack = !current_payload->noack || !esb_cfg.selective_auto_ack;
-		tx_payload_buffer[0] = current_payload->length;
-		tx_payload_buffer[1] = current_payload->pid << 1;
-		tx_payload_buffer[1] |= current_payload->noack ? 0x00 : 0x01;
-		memcpy(&tx_payload_buffer[2], current_payload->data,
-		       current_payload->length);
 
 		/* Handling ack if noack is set to false or if
 		 * selective auto ack is turned off
@@ -637,6 +923,13 @@ static void start_tx_transaction(void)
 			esb_state = ESB_STATE_PTX_TX_ACK;
 		} else {
 			NRF_RADIO->SHORTS = radio_shorts_common;
+#if defined(CONFIG_ESB_TX_BURST)
+			tx_burst_active = tx_burst_next_available();
+			if (tx_burst_active) {
+				NRF_RADIO->SHORTS |=
+					RADIO_SHORTS_DISABLED_TXEN_Msk;
+			}
+#endif
 			NRF_RADIO->INTENSET = RADIO_INTENSET_DISABLED_Msk;
 			on_radio_disabled = on_radio_disabled_tx_noack;
 			esb_state = ESB_STATE_PTX_TX;
@@ -652,7 +945,7 @@ static void start_tx_transaction(void)
 	NRF_RADIO->RXADDRESSES = 1 << current_payload->pipe;
 	NRF_RADIO->FREQUENCY = esb_addr.rf_channel;
 
-	NRF_RADIO->PACKETPTR = (uint32_t)tx_payload_buffer;
+	NRF_RADIO->PACKETPTR = (uint32_t)tx_pdu;
 
 	NVIC_ClearPendingIRQ(RADIO_IRQn);
 	irq_enable(RADIO_IRQn);
@@ -669,6 +962,14 @@ static void on_radio_disabled_tx_noack(void)
 	interrupt_flags |= INT_TX_SUCCESS_MSK;
 	tx_fifo_remove_last();
 
+#if defined(CONFIG_ESB_TX_BURST)
+	if (tx_burst_active) {
+		tx_burst_continue();
+		NVIC_SetPendingIRQ(ESB_EVT_IRQ);
+		return;
+	}
+#endif
+
 	if (tx_fifo.count == 0) {
 		esb_state = ESB_STATE_IDLE;
 		NVIC_SetPendingIRQ(ESB_EVT_IRQ);
@@ -707,7 +1008,7 @@ static void on_radio_disabled_tx(void)
 		update_rf_payload_format(0);
 	}
 
-	NRF_RADIO->PACKETPTR = (uint32_t)rx_payload_buffer;
+	rx_pdu_set();
 	on_radio_disabled = on_radio_disabled_tx_wait_for_ack;
 	esb_state = ESB_STATE_PTX_RX_ACK;
 }
@@ -725,16 +1026,19 @@ static void on_radio_disabled_tx_wait_for_ack(void)
 	if (NRF_RADIO->EVENTS_END && NRF_RADIO->CRCSTATUS != 0) {
 		ESB_SYS_TIMER->TASKS_SHUTDOWN = 1;
 
+#if defined(CONFIG_ESB_HOPPING)
+		hop_tx_result(true);
+#endif
+
 		interrupt_flags |= INT_TX_SUCCESS_MSK;
 		last_tx_attempts = esb_cfg.retransmit_count -
 				   retransmits_remaining + 1;
 
 		tx_fifo_remove_last();
 
-		if (esb_cfg.protocol != ESB_PROTOCOL_ESB &&
-		    rx_payload_buffer[0] > 0) {
+		if (esb_cfg.protocol != ESB_PROTOCOL_ESB && rx_pdu[0] > 0) {
 			if (rx_fifo_push_rfbuf((uint8_t)NRF_RADIO->TXADDRESS,
-					       rx_payload_buffer[1] >> 1)) {
+					       rx_pdu[1] >> 1)) {
 				interrupt_flags |=
 					INT_RX_DATA_RECEIVED_MSK;
 			}
@@ -749,6 +1053,11 @@ static void on_radio_disabled_tx_wait_for_ack(void)
 			start_tx_transaction();
 		}
 	} else {
+#if defined(CONFIG_ESB_HOPPING)
+		/* The next attempt can be made on another channel. */
+		hop_tx_result(false);
+#endif
+
 		if (retransmits_remaining-- == 0) {
 			ESB_SYS_TIMER->TASKS_SHUTDOWN = 1;
 
@@ -768,7 +1077,7 @@ static void on_radio_disabled_tx_wait_for_ack(void)
 			NRF_RADIO->SHORTS = radio_shorts_common |
 					    RADIO_SHORTS_DISABLED_RXEN_Msk;
 			update_rf_payload_format(current_payload->length);
-			NRF_RADIO->PACKETPTR = (uint32_t)tx_payload_buffer;
+			NRF_RADIO->PACKETPTR = (uint32_t)tx_pdu;
 			on_radio_disabled = on_radio_disabled_tx;
 			esb_state = ESB_STATE_PTX_TX_ACK;
 			ESB_SYS_TIMER->TASKS_START = 1;
@@ -784,7 +1093,7 @@ static void clear_events_restart_rx(void)
 {
 	NRF_RADIO->SHORTS = radio_shorts_common;
 	update_rf_payload_format(esb_cfg.payload_length);
-	NRF_RADIO->PACKETPTR = (uint32_t)rx_payload_buffer;
+	rx_pdu_set();
 	NRF_RADIO->EVENTS_DISABLED = 0;
 	NRF_RADIO->TASKS_DISABLE = 1;
 
@@ -799,6 +1108,74 @@ static void clear_events_restart_rx(void)
 	NRF_RADIO->TASKS_RXEN = 1;
 }
 
+#if defined(CONFIG_ESB_HOPPING)
+/* Update the channel statistics after a reception. The PRX stays on the
+ * channel as long as it receives packets. Otherwise, it moves to the next
+ * channel after a dwell time long enough for the PTX to try all channels.
+ */
+static void hop_rx_result(bool crc_ok)
+{
+	struct hop_channel *chn;
+
+	if (hop.count == 0) {
+		return;
+	}
+
+	chn = &hop.chn[hop.current];
+	NRF_RADIO->EVENTS_ADDRESS = 0;
+
+	if (crc_ok) {
+		chn->stats.rx_packets++;
+		ESB_SYS_TIMER->TASKS_CLEAR = 1;
+	} else {
+		chn->stats.rx_crc_errors++;
+	}
+}
+
+static void hop_prx_timer_start(void)
+{
+	uint32_t dwell_time;
+
+	if (hop.count == 0) {
+		return;
+	}
+
+	dwell_time = (uint32_t)(hop.count + 1) * CONFIG_ESB_HOP_ATTEMPTS *
+		     esb_cfg.retransmit_delay;
+
+	ESB_SYS_TIMER->TASKS_SHUTDOWN = 1;
+	ESB_SYS_TIMER->SHORTS = TIMER_SHORTS_COMPARE2_CLEAR_Msk;
+	ESB_SYS_TIMER->CC[2] = MIN(dwell_time, UINT16_MAX);
+	ESB_SYS_TIMER->EVENTS_COMPARE[2] = 0;
+	ESB_SYS_TIMER->INTENSET = TIMER_INTENSET_COMPARE2_Msk;
+	ESB_SYS_TIMER->TASKS_CLEAR = 1;
+	ESB_SYS_TIMER->TASKS_START = 1;
+}
+
+static void hop_prx_timer_stop(void)
+{
+	ESB_SYS_TIMER->TASKS_SHUTDOWN = 1;
+	ESB_SYS_TIMER->INTENCLR = TIMER_INTENCLR_COMPARE2_Msk;
+	ESB_SYS_TIMER->EVENTS_COMPARE[2] = 0;
+	sys_timer_init();
+}
+
+static void hop_prx_dwell_timeout(void)
+{
+	uint32_t key = irq_lock();
+
+	/* Do not interrupt a packet that is being received or an
+	 * acknowledgment that is being sent.
+	 */
+	if ((esb_state == ESB_STATE_PRX) && !NRF_RADIO->EVENTS_ADDRESS) {
+		hop_next();
+		clear_events_restart_rx();
+	}
+
+	irq_unlock(key);
+}
+#endif /* defined(CONFIG_ESB_HOPPING) */
+
 static void on_radio_disabled_rx_dpl(bool retransmit_payload,
 				     struct pipe_info *pipe_info)
 {
@@ -827,30 +1204,35 @@ static void on_radio_disabled_rx_dpl(bool retransmit_payload,
 		if (current_payload != 0) {
 			pipe_info->ack_payload = true;
 			update_rf_payload_format(current_payload->length);
-			tx_payload_buffer[0] = current_payload->length;
-			memcpy(&tx_payload_buffer[2],
-					current_payload->data,
-					current_payload->length);
+			tx_pdu = current_payload->pdu;
+			tx_pdu[0] = current_payload->length;
 		} else {
 			pipe_info->ack_payload = false;
 			update_rf_payload_format(0);
-			tx_payload_buffer[0] = 0;
+			tx_pdu = tx_payload_buffer;
+			tx_pdu[0] = 0;
 		}
 	} else {
 		pipe_info->ack_payload = false;
 		update_rf_payload_format(0);
-		tx_payload_buffer[0] = 0;
+		tx_pdu = tx_payload_buffer;
+		tx_pdu[0] = 0;
 	}
 
-	tx_payload_buffer[1] = rx_payload_buffer[1];
+	tx_pdu[1] = rx_pdu[1];
 }
 
 static void on_radio_disabled_rx(void)
 {
 	bool retransmit_payload = false;
 	bool send_rx_event = true;
+	bool send_ack;
 	struct pipe_info *pipe_info;
 
+#if defined(CONFIG_ESB_HOPPING)
+	hop_rx_result(NRF_RADIO->CRCSTATUS != 0);
+#endif
+
 	if (NRF_RADIO->CRCSTATUS == 0) {
 		clear_events_restart_rx();
 		return;
@@ -863,17 +1245,19 @@ static void on_radio_disabled_rx(void)
 
 	pipe_info = &rx_pipe_info[NRF_RADIO->RXMATCH];
 	if (NRF_RADIO->RXCRC == pipe_info->crc &&
-	    (rx_payload_buffer[1] >> 1) == pipe_info->pid) {
+	    (rx_pdu[1] >> 1) == pipe_info->pid) {
 		retransmit_payload = true;
 		send_rx_event = false;
 	}
 
-	pipe_info->pid = rx_payload_buffer[1] >> 1;
+	pipe_info->pid = rx_pdu[1] >> 1;
 	pipe_info->crc = NRF_RADIO->RXCRC;
 
 	/* Check if an ack should be sent */
-	if ((esb_cfg.selective_auto_ack == false) ||
-	    ((rx_payload_buffer[1] & 0x01) == 1)) {
+	send_ack = (esb_cfg.selective_auto_ack == false) ||
+		   ((rx_pdu[1] & 0x01) == 1);
+
+	if (send_ack) {
 		NRF_RADIO->SHORTS = radio_shorts_common |
 				    RADIO_SHORTS_DISABLED_RXEN_Msk;
 
@@ -884,39 +1268,48 @@ static void on_radio_disabled_rx(void)
 
 		case ESB_PROTOCOL_ESB:
 			update_rf_payload_format(0);
-			tx_payload_buffer[0] = rx_payload_buffer[0];
-			tx_payload_buffer[1] = 0;
+			tx_pdu = tx_payload_buffer;
+			tx_pdu[0] = rx_pdu[0];
+			tx_pdu[1] = 0;
 			break;
 		}
 
 		esb_state = ESB_STATE_PRX_SEND_ACK;
 		NRF_RADIO->TXADDRESS = NRF_RADIO->RXMATCH;
 
-		NRF_RADIO->PACKETPTR = (uint32_t)tx_payload_buffer;
+		NRF_RADIO->PACKETPTR = (uint32_t)tx_pdu;
 		on_radio_disabled = on_radio_disabled_rx_ack;
-	} else {
-		clear_events_restart_rx();
 	}
 
 	if (send_rx_event) {
 		/* Push the new packet to the RX buffer and trigger a received
 		 * event if the operation was
-		 * successful.
+		 * successful. This must be done before the reception is
+		 * restarted, so that the next packet is received to the next
+		 * buffer of the RX FIFO.
 		 */
 		if (rx_fifo_push_rfbuf(NRF_RADIO->RXMATCH, pipe_info->pid)) {
 			interrupt_flags |= INT_RX_DATA_RECEIVED_MSK;
 			NVIC_SetPendingIRQ(ESB_EVT_IRQ);
 		}
 	}
+
+	if (!send_ack) {
+		clear_events_restart_rx();
+	}
 }
 
 static void on_radio_disabled_rx_ack(void)
 {
 	NRF_RADIO->SHORTS = radio_shorts_common |
 			    RADIO_SHORTS_DISABLED_TXEN_Msk;
+	/* The address event of the acknowledgment must not be taken for
+	 * a packet that is being received.
+	 */
+	NRF_RADIO->EVENTS_ADDRESS = 0;
 	update_rf_payload_format(esb_cfg.payload_length);
 
-	NRF_RADIO->PACKETPTR = (uint32_t)rx_payload_buffer;
+	rx_pdu_set();
 	on_radio_disabled = on_radio_disabled_rx;
 
 	esb_state = ESB_STATE_PRX;
@@ -995,6 +1388,12 @@ static void ESB_EVT_IRQHandler(void)
 
 static void ESB_SYS_TIMER_IRQHandler(void)
 {
+#if defined(CONFIG_ESB_HOPPING)
+	if (ESB_SYS_TIMER->EVENTS_COMPARE[2]) {
+		ESB_SYS_TIMER->EVENTS_COMPARE[2] = 0;
+		hop_prx_dwell_timeout();
+	}
+#endif
 }
 
 int esb_init(const struct esb_config *config)
@@ -1072,6 +1471,10 @@ void esb_disable(void)
 	/*  Clear PPI */
 	nrfx_gppi_channels_disable(ppi_all_channels_mask);
 
+#if defined(CONFIG_ESB_HOPPING)
+	hop_prx_timer_stop();
+#endif
+
 	esb_state = ESB_STATE_IDLE;
 	esb_initialized = false;
 
@@ -1102,79 +1505,216 @@ static struct payload_wrap *find_free_payload_cont(void)
 	return 0;
 }
 
-int esb_write_payload(const struct esb_payload *payload)
+static int tx_payload_check(uint8_t length, uint8_t pipe)
 {
-	if (!esb_initialized) {
-		return -EACCES;
-	}
-	if (payload == NULL) {
-		return -EINVAL;
-	}
-	if (payload->length == 0 ||
-	    payload->length > CONFIG_ESB_MAX_PAYLOAD_LENGTH ||
+	if (length == 0 ||
+	    length > CONFIG_ESB_MAX_PAYLOAD_LENGTH ||
 	    (esb_cfg.protocol == ESB_PROTOCOL_ESB &&
-	     payload->length > esb_cfg.payload_length)) {
+	     length > esb_cfg.payload_length)) {
 		return -EMSGSIZE;
 	}
-	if (tx_fifo.count >= CONFIG_ESB_TX_FIFO_SIZE) {
-		return -ENOMEM;
-	}
-	if (payload->pipe >= CONFIG_ESB_PIPE_COUNT) {
+	if (pipe >= CONFIG_ESB_PIPE_COUNT) {
 		return -EINVAL;
 	}
 
-	uint32_t key = irq_lock();
+	return 0;
+}
+
+/* Get a free TX buffer. Must be called with interrupts locked. */
+static struct payload_buf *tx_buf_get(void)
+{
+	struct payload_wrap *wrap;
+
+	if (tx_fifo.count >= CONFIG_ESB_TX_FIFO_SIZE) {
+		return NULL;
+	}
 
 	if (esb_cfg.mode == ESB_MODE_PTX) {
-		memcpy(tx_fifo.payload[tx_fifo.back], payload,
-			sizeof(struct esb_payload));
+		return tx_fifo.payload[tx_fifo.back];
+	}
 
-		pids[payload->pipe] = (pids[payload->pipe] + 1) % (PID_MAX + 1);
-		tx_fifo.payload[tx_fifo.back]->pid = pids[payload->pipe];
+	wrap = find_free_payload_cont();
 
+	return wrap ? wrap->p_payload : NULL;
+}
+
+/* Queue a TX buffer. Must be called with interrupts locked. */
+static void tx_buf_push(struct payload_buf *buf)
+{
+	pids[buf->pipe] = (pids[buf->pipe] + 1) % (PID_MAX + 1);
+	buf->pid = pids[buf->pipe];
+
+	if (esb_cfg.mode == ESB_MODE_PTX) {
 		if (++tx_fifo.back >= CONFIG_ESB_TX_FIFO_SIZE) {
 			tx_fifo.back = 0;
 		}
-
-		tx_fifo.count++;
 	} else {
-		struct payload_wrap *new_ack_payload = find_free_payload_cont();
-
-		if (new_ack_payload != 0) {
-			new_ack_payload->in_use = true;
-			new_ack_payload->p_next = 0;
-			memcpy(new_ack_payload->p_payload, payload, sizeof(struct esb_payload));
+		struct payload_wrap *new_ack_payload =
+			&ack_pl_wrap[buf - tx_bufs];
 
-			pids[payload->pipe] = (pids[payload->pipe] + 1) % (PID_MAX + 1);
-			new_ack_payload->p_payload->pid = pids[payload->pipe];
+		new_ack_payload->in_use = true;
+		new_ack_payload->p_next = 0;
 
-			if (ack_pl_wrap_pipe[payload->pipe] == 0) {
-				ack_pl_wrap_pipe[payload->pipe] = new_ack_payload;
-			} else {
-				struct payload_wrap *pl = ack_pl_wrap_pipe[payload->pipe];
+		if (ack_pl_wrap_pipe[buf->pipe] == 0) {
+			ack_pl_wrap_pipe[buf->pipe] = new_ack_payload;
+		} else {
+			struct payload_wrap *pl = ack_pl_wrap_pipe[buf->pipe];
 
-				while (pl->p_next != 0) {
-					pl = (struct payload_wrap *)pl->p_next;
-				}
-				pl->p_next = (struct payload_wrap *)new_ack_payload;
+			while (pl->p_next != 0) {
+				pl = (struct payload_wrap *)pl->p_next;
 			}
-			tx_fifo.count++;
+			pl->p_next = (struct payload_wrap *)new_ack_payload;
 		}
 	}
 
-	irq_unlock(key);
+	tx_fifo.count++;
+}
 
+static void tx_start_auto(void)
+{
 	if (esb_cfg.mode == ESB_MODE_PTX &&
 	    esb_cfg.tx_mode == ESB_TXMODE_AUTO &&
 	    esb_state == ESB_STATE_IDLE) {
 		start_tx_transaction();
 	}
+}
+
+static void rx_fifo_pop(void)
+{
+	uint32_t key = irq_lock();
+
+	if (++rx_fifo.front >= CONFIG_ESB_RX_FIFO_SIZE) {
+		rx_fifo.front = 0;
+	}
+
+	rx_fifo.count--;
+
+	irq_unlock(key);
+}
+
+int esb_write_payload(const struct esb_payload *payload)
+{
+	struct payload_buf *buf;
+	int err;
+
+	if (!esb_initialized) {
+		return -EACCES;
+	}
+	if (payload == NULL) {
+		return -EINVAL;
+	}
+
+	err = tx_payload_check(payload->length, payload->pipe);
+	if (err) {
+		return err;
+	}
+
+	uint32_t key = irq_lock();
+
+	if (tx_loan) {
+		irq_unlock(key);
+		return -EBUSY;
+	}
+
+	buf = tx_buf_get();
+	if (!buf) {
+		irq_unlock(key);
+		return -ENOMEM;
+	}
+
+	buf->length = payload->length;
+	buf->pipe = payload->pipe;
+	buf->noack = payload->noack;
+	memcpy(&buf->pdu[PDU_HEADER_LEN], payload->data, payload->length);
+
+	tx_buf_push(buf);
+
+	irq_unlock(key);
+
+	tx_start_auto();
+
+	return 0;
+}
+
+int esb_tx_buf_alloc(struct esb_buf *buf)
+{
+	if (!esb_initialized) {
+		return -EACCES;
+	}
+	if (buf == NULL) {
+		return -EINVAL;
+	}
+
+	uint32_t key = irq_lock();
+
+	if (tx_loan) {
+		irq_unlock(key);
+		return -EBUSY;
+	}
+
+	tx_loan = tx_buf_get();
+
+	irq_unlock(key);
+
+	if (!tx_loan) {
+		return -ENOMEM;
+	}
+
+	memset(buf, 0, sizeof(*buf));
+	buf->data = &tx_loan->pdu[PDU_HEADER_LEN];
+
+	return 0;
+}
+
+int esb_tx_buf_submit(const struct esb_buf *buf)
+{
+	int err;
+
+	if (!esb_initialized) {
+		return -EACCES;
+	}
+	if ((buf == NULL) || !tx_loan ||
+	    (buf->data != &tx_loan->pdu[PDU_HEADER_LEN])) {
+		return -EINVAL;
+	}
+
+	err = tx_payload_check(buf->length, buf->pipe);
+	if (err) {
+		return err;
+	}
+
+	uint32_t key = irq_lock();
+
+	tx_loan->length = buf->length;
+	tx_loan->pipe = buf->pipe;
+	tx_loan->noack = buf->noack;
+
+	tx_buf_push(tx_loan);
+	tx_loan = NULL;
+
+	irq_unlock(key);
+
+	tx_start_auto();
+
+	return 0;
+}
+
+int esb_tx_buf_discard(const struct esb_buf *buf)
+{
+	if ((buf == NULL) || !tx_loan ||
+	    (buf->data != &tx_loan->pdu[PDU_HEADER_LEN])) {
+		return -EINVAL;
+	}
+
+	tx_loan = NULL;
 
 	return 0;
 }
 
 int esb_read_rx_payload(struct esb_payload *payload)
 {
+	const struct payload_buf *buf;
+
 	if (!esb_initialized) {
 		return -EACCES;
 	}
@@ -1186,23 +1726,60 @@ int esb_read_rx_payload(struct esb_payload *payload)
 		return -ENODATA;
 	}
 
-	uint32_t key = irq_lock();
+	buf = rx_fifo.payload[rx_fifo.front];
 
-	payload->length = rx_fifo.payload[rx_fifo.front]->length;
-	payload->pipe = rx_fifo.payload[rx_fifo.front]->pipe;
-	payload->rssi = rx_fifo.payload[rx_fifo.front]->rssi;
-	payload->pid = rx_fifo.payload[rx_fifo.front]->pid;
-	payload->noack = rx_fifo.payload[rx_fifo.front]->noack;
-	memcpy(payload->data, rx_fifo.payload[rx_fifo.front]->data,
-	       payload->length);
+	payload->length = buf->length;
+	payload->pipe = buf->pipe;
+	payload->rssi = buf->rssi;
+	payload->pid = buf->pid;
+	payload->noack = buf->noack;
+	memcpy(payload->data, &buf->pdu[PDU_HEADER_LEN], payload->length);
 
-	if (++rx_fifo.front >= CONFIG_ESB_RX_FIFO_SIZE) {
-		rx_fifo.front = 0;
+	rx_fifo_pop();
+
+	return 0;
+}
+
+int esb_rx_buf_get(struct esb_buf *buf)
+{
+	struct payload_buf *rx_buf;
+
+	if (!esb_initialized) {
+		return -EACCES;
+	}
+	if (buf == NULL) {
+		return -EINVAL;
 	}
 
-	rx_fifo.count--;
+	if (rx_fifo.count == 0) {
+		return -ENODATA;
+	}
 
-	irq_unlock(key);
+	rx_buf = rx_fifo.payload[rx_fifo.front];
+
+	buf->data = &rx_buf->pdu[PDU_HEADER_LEN];
+	buf->length = rx_buf->length;
+	buf->pipe = rx_buf->pipe;
+	buf->rssi = rx_buf->rssi;
+	buf->pid = rx_buf->pid;
+	buf->noack = rx_buf->noack;
+
+	return 0;
+}
+
+int esb_rx_buf_release(const struct esb_buf *buf)
+{
+	const struct payload_buf *rx_buf = rx_fifo.payload[rx_fifo.front];
+
+	if (!esb_initialized) {
+		return -EACCES;
+	}
+	if ((buf == NULL) || (rx_fifo.count == 0) ||
+	    (buf->data != &rx_buf->pdu[PDU_HEADER_LEN])) {
+		return -EINVAL;
+	}
+
+	rx_fifo_pop();
 
 	return 0;
 }
@@ -1239,7 +1816,7 @@ int esb_start_rx(void)
 
 	NRF_RADIO->RXADDRESSES = esb_addr.rx_pipes_enabled;
 	NRF_RADIO->FREQUENCY = esb_addr.rf_channel;
-	NRF_RADIO->PACKETPTR = (uint32_t)rx_payload_buffer;
+	rx_pdu_set();
 
 	NVIC_ClearPendingIRQ(RADIO_IRQn);
 	irq_enable(RADIO_IRQn);
@@ -1250,6 +1827,10 @@ int esb_start_rx(void)
 
 	NRF_RADIO->TASKS_RXEN = 1;
 
+#if defined(CONFIG_ESB_HOPPING)
+	hop_prx_timer_start();
+#endif
+
 	return 0;
 }
 
@@ -1268,6 +1849,10 @@ int esb_stop_rx(void)
 		/* wait for register to settle */
 	}
 
+#if defined(CONFIG_ESB_HOPPING)
+	hop_prx_timer_stop();
+#endif
+
 	esb_state = ESB_STATE_IDLE;
 
 	return 0;
@@ -1281,6 +1866,8 @@ int esb_flush_tx(void)
 
 	uint32_t key = irq_lock();
 
+	tx_loan = NULL;
+
 	tx_fifo.count = 0;
 	tx_fifo.back = 0;
 	tx_fifo.front = 0;
@@ -1301,6 +1888,8 @@ int esb_pop_tx(void)
 
 	uint32_t key = irq_lock();
 
+	tx_loan = NULL;
+
 	if (++tx_fifo.back >= CONFIG_ESB_TX_FIFO_SIZE) {
 		tx_fifo.back = 0;
 	}
@@ -1518,3 +2107,99 @@ int esb_reuse_pid(uint8_t pipe)
 
 	return 0;
 }
+
+#if defined(CONFIG_ESB_HOPPING)
+int esb_hop_channels_set(const uint8_t *channels, uint8_t count)
+{
+	if (esb_state != ESB_STATE_IDLE) {
+		return -EBUSY;
+	}
+	if ((count > CONFIG_ESB_HOP_CHANNELS_MAX) ||
+	    ((count > 0) && (channels == NULL))) {
+		return -EINVAL;
+	}
+
+	for (uint8_t i = 0; i < count; i++) {
+		if (channels[i] > 100) {
+			return -EINVAL;
+		}
+	}
+
+	memset(&hop, 0, sizeof(hop));
+
+	for (uint8_t i = 0; i < count; i++) {
+		hop.chn[i].stats.channel = channels[i];
+		hop.chn[i].stats.enabled = true;
+	}
+
+	hop.count = count;
+	hop.chmap = hop_chmap_all();
+
+	if (count > 0) {
+		esb_addr.rf_channel = channels[0];
+	}
+
+	return 0;
+}
+
+int esb_hop_chmap_set(uint32_t chmap)
+{
+	if (esb_state != ESB_STATE_IDLE) {
+		return -EBUSY;
+	}
+	if ((hop.count == 0) || (chmap == 0) || (chmap & ~hop_chmap_all())) {
+		return -EINVAL;
+	}
+
+	hop.chmap = chmap;
+	hop.blocked &= chmap;
+
+	for (uint8_t i = 0; i < hop.count; i++) {
+		hop.chn[i].stats.enabled = (hop_chmap_get() & BIT(i)) != 0;
+	}
+
+	/* Make sure that the current channel is enabled. */
+	if (!(hop_chmap_get() & BIT(hop.current))) {
+		hop_next();
+	}
+
+	return 0;
+}
+
+uint32_t esb_hop_chmap_get(void)
+{
+	return hop_chmap_get();
+}
+
+int esb_chn_stats_get(uint8_t idx, struct esb_chn_stats *stats)
+{
+	if ((idx >= hop.count) || (stats == NULL)) {
+		return -EINVAL;
+	}
+
+	uint32_t key = irq_lock();
+
+	*stats = hop.chn[idx].stats;
+
+	irq_unlock(key);
+
+	return 0;
+}
+
+void esb_chn_stats_reset(void)
+{
+	uint32_t key = irq_lock();
+
+	for (uint8_t i = 0; i < hop.count; i++) {
+		struct esb_chn_stats *stats = &hop.chn[i].stats;
+
+		stats->tx_attempts = 0;
+		stats->tx_success = 0;
+		stats->rx_packets = 0;
+		stats->rx_crc_errors = 0;
+		stats->per = 0;
+	}
+
+	irq_unlock(key);
+}
+#endif /* defined(CONFIG_ESB_HOPPING) */
@@ -8,6 +8,7 @@
 #include <device.h>
 #include <drivers/gps.h>
 #include <net/socket.h>
+#include <sys/byteorder.h>
 #include <nrf_socket.h>
 
 #include <cJSON.h>
@@ -47,6 +48,7 @@ extern void agps_print(enum nrf_cloud_agps_type type, void *data);
 
 static int fd = -1;
 static bool agps_print_enabled;
+static nrf_cloud_agps_data_handler_t data_handler;
 static const struct device *gps_dev;
 static bool json_initialized;
 
@@ -80,6 +82,11 @@ void agps_print_enable(bool enable)
 	agps_print_enabled = enable;
 }
 
+void nrf_cloud_agps_data_handler_set(nrf_cloud_agps_data_handler_t handler)
+{
+	data_handler = handler;
+}
+
 static int get_modem_info(struct modem_param_info *const modem_info)
 {
 	__ASSERT_NO_MSG(modem_info != NULL);
@@ -455,8 +462,13 @@ static int send_to_modem(void *data, size_t data_len,
 
 	/* At this point, GPS driver or app-provided socket is assumed. */
 	if (gps_dev) {
-		return gps_agps_write(gps_dev, type_socket2gps(type), data,
-				      data_len);
+		err = gps_agps_write(gps_dev, type_socket2gps(type), data,
+				     data_len);
+		if ((err == 0) && data_handler) {
+			data_handler(type_socket2gps(type), data, data_len);
+		}
+
+		return err;
 	}
 
 	err = nrf_sendto(fd, data, data_len, 0, &type, sizeof(type));
@@ -465,6 +477,10 @@ static int send_to_modem(void *data, size_t data_len,
 		err = -errno;
 	} else {
 		err = 0;
+
+		if (data_handler) {
+			data_handler(type_socket2gps(type), data, data_len);
+		}
 	}
 
 	LOG_DBG("A-GSP data sent to modem");
@@ -693,74 +709,318 @@ static int agps_send_to_modem(struct nrf_cloud_apgs_element *agps_data)
 	return 0;
 }
 
-static size_t get_next_agps_element(struct nrf_cloud_apgs_element *element,
-				    const char *buf)
+/* Size of the binary header preceding each array of A-GPS elements. */
+#define AGPS_BIN_HEADER_SIZE \
+	(NRF_CLOUD_AGPS_BIN_TYPE_SIZE + NRF_CLOUD_AGPS_BIN_COUNT_SIZE)
+
+/* Largest single element in the binary A-GPS schema. */
+#define AGPS_BIN_ELEMENT_MAX_SIZE sizeof(struct nrf_cloud_agps_ephemeris)
+
+/* Size of the buffer reassembling units split across chunks. Can be
+ * overridden to exercise the oversized element handling in tests.
+ */
+#ifndef AGPS_STREAM_CARRY_SIZE
+#define AGPS_STREAM_CARRY_SIZE \
+	MAX(AGPS_BIN_HEADER_SIZE, AGPS_BIN_ELEMENT_MAX_SIZE)
+#endif
+
+BUILD_ASSERT(AGPS_STREAM_CARRY_SIZE >= AGPS_BIN_HEADER_SIZE,
+	     "Carry buffer cannot hold an array header");
+
+enum agps_stream_state {
+	AGPS_STREAM_IDLE,
+	AGPS_STREAM_VERSION,
+	AGPS_STREAM_HEADER,
+	AGPS_STREAM_ELEMENT,
+	AGPS_STREAM_DONE,
+};
+
+/* Resumable parser state. Elements that are split across two chunks are
+ * reassembled in the carry buffer, everything else is parsed in place.
+ */
+static struct {
+	enum agps_stream_state state;
+	enum nrf_cloud_agps_type element_type;
+	uint16_t elements_left;
+	size_t carry_len;
+	uint8_t carry[AGPS_STREAM_CARRY_SIZE];
+	struct nrf_cloud_agps_system_time sys_time;
+} stream;
+
+static size_t agps_element_size(enum nrf_cloud_agps_type type)
 {
-	static uint16_t elements_left_to_process;
-	static enum nrf_cloud_agps_type element_type;
-	size_t len = 0;
+	switch (type) {
+	case NRF_CLOUD_AGPS_UTC_PARAMETERS:
+		return sizeof(struct nrf_cloud_agps_utc);
+	case NRF_CLOUD_AGPS_EPHEMERIDES:
+		return sizeof(struct nrf_cloud_agps_ephemeris);
+	case NRF_CLOUD_AGPS_ALMANAC:
+		return sizeof(struct nrf_cloud_agps_almanac);
+	case NRF_CLOUD_AGPS_KLOBUCHAR_CORRECTION:
+		return sizeof(struct nrf_cloud_agps_klobuchar);
+	case NRF_CLOUD_AGPS_GPS_SYSTEM_CLOCK:
+		return sizeof(stream.sys_time) -
+		       sizeof(stream.sys_time.sv_tow) + 4;
+	case NRF_CLOUD_AGPS_GPS_TOWS:
+		return sizeof(struct nrf_cloud_agps_tow_element);
+	case NRF_CLOUD_AGPS_LOCATION:
+		return sizeof(struct nrf_cloud_agps_location);
+	case NRF_CLOUD_AGPS_INTEGRITY:
+		return sizeof(struct nrf_cloud_agps_integrity);
+	default:
+		return 0;
+	}
+}
 
-	/* Check if there are more elements left in the array to process.
-	 * The element type is only given once before the array, and not for
-	 * each element.
-	 */
-	if (elements_left_to_process == 0) {
-		element->type =
-			(enum nrf_cloud_agps_type)buf[NRF_CLOUD_AGPS_BIN_TYPE_OFFSET];
-		element_type = element->type;
-		elements_left_to_process =
-			*(uint16_t *)&buf[NRF_CLOUD_AGPS_BIN_COUNT_OFFSET] - 1;
-		len += NRF_CLOUD_AGPS_BIN_TYPE_SIZE +
-			NRF_CLOUD_AGPS_BIN_COUNT_SIZE;
-	} else {
-		element->type = element_type;
-		elements_left_to_process -= 1;
+/* Number of bytes needed to complete the next parsing unit. */
+static size_t stream_unit_size(void)
+{
+	switch (stream.state) {
+	case AGPS_STREAM_VERSION:
+		return NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION_SIZE;
+	case AGPS_STREAM_HEADER:
+		return AGPS_BIN_HEADER_SIZE;
+	case AGPS_STREAM_ELEMENT:
+		return agps_element_size(stream.element_type);
+	default:
+		return 0;
 	}
+}
+
+static void get_agps_element(struct nrf_cloud_apgs_element *element,
+			     const char *buf)
+{
+	element->type = stream.element_type;
 
 	switch (element->type) {
 	case NRF_CLOUD_AGPS_UTC_PARAMETERS:
-		element->utc = (struct nrf_cloud_agps_utc *)(buf + len);
-		len += sizeof(struct nrf_cloud_agps_utc);
+		element->utc = (struct nrf_cloud_agps_utc *)buf;
 		break;
 	case NRF_CLOUD_AGPS_EPHEMERIDES:
-		element->ephemeris = (struct nrf_cloud_agps_ephemeris *)(buf + len);
-		len += sizeof(struct nrf_cloud_agps_ephemeris);
+		element->ephemeris = (struct nrf_cloud_agps_ephemeris *)buf;
 		break;
 	case NRF_CLOUD_AGPS_ALMANAC:
-		element->almanac = (struct nrf_cloud_agps_almanac *)(buf + len);
-		len += sizeof(struct nrf_cloud_agps_almanac);
+		element->almanac = (struct nrf_cloud_agps_almanac *)buf;
 		break;
 	case NRF_CLOUD_AGPS_KLOBUCHAR_CORRECTION:
 		element->ion_correction.klobuchar =
-			(struct nrf_cloud_agps_klobuchar *)(buf + len);
-		len += sizeof(struct nrf_cloud_agps_klobuchar);
+			(struct nrf_cloud_agps_klobuchar *)buf;
 		break;
 	case NRF_CLOUD_AGPS_GPS_SYSTEM_CLOCK:
 		element->time_and_tow =
-			(struct nrf_cloud_agps_system_time *)(buf + len);
-		len += sizeof(struct nrf_cloud_agps_system_time) -
-			sizeof(element->time_and_tow->sv_tow) + 4;
+			(struct nrf_cloud_agps_system_time *)buf;
 		break;
 	case NRF_CLOUD_AGPS_GPS_TOWS:
-		element->tow =
-			(struct nrf_cloud_agps_tow_element *)(buf + len);
-		len += sizeof(struct nrf_cloud_agps_tow_element);
+		element->tow = (struct nrf_cloud_agps_tow_element *)buf;
 		break;
 	case NRF_CLOUD_AGPS_LOCATION:
-		element->location = (struct nrf_cloud_agps_location *)(buf + len);
-		len += sizeof(struct nrf_cloud_agps_location);
+		element->location = (struct nrf_cloud_agps_location *)buf;
 		break;
 	case NRF_CLOUD_AGPS_INTEGRITY:
-		element->integrity =
-			(struct nrf_cloud_agps_integrity *)(buf + len);
-		len += sizeof(struct nrf_cloud_agps_integrity);
+		element->integrity = (struct nrf_cloud_agps_integrity *)buf;
 		break;
 	default:
-		LOG_DBG("Unhandled A-GPS data type: %d", element->type);
+		break;
+	}
+}
+
+static int process_agps_element(const char *buf)
+{
+	struct nrf_cloud_apgs_element element;
+
+	get_agps_element(&element, buf);
+
+	if (element.type == NRF_CLOUD_AGPS_GPS_TOWS) {
+		if ((element.tow->sv_id == 0) ||
+		    (element.tow->sv_id > NRF_CLOUD_AGPS_MAX_SV_TOW)) {
+			LOG_WRN("Invalid TOW SV ID: %d", element.tow->sv_id);
+			return 0;
+		}
+
+		memcpy(&stream.sys_time.sv_tow[element.tow->sv_id - 1],
+		       element.tow,
+		       sizeof(stream.sys_time.sv_tow[0]));
+
+		LOG_DBG("TOW %d copied", element.tow->sv_id - 1);
+
 		return 0;
+	} else if (element.type == NRF_CLOUD_AGPS_GPS_SYSTEM_CLOCK) {
+		memcpy(&stream.sys_time, element.time_and_tow,
+		       sizeof(stream.sys_time) - sizeof(stream.sys_time.sv_tow));
+
+		LOG_DBG("TOWs copied, bitmask: 0x%08x",
+			stream.sys_time.sv_mask);
+
+		/* The element may live in a transient chunk or carry buffer,
+		 * inject the assembled system time with the collected TOWs.
+		 */
+		element.time_and_tow = &stream.sys_time;
+	}
+
+	return agps_send_to_modem(&element);
+}
+
+/* Consumes one complete parsing unit and advances the parser state. */
+static int stream_unit_process(const char *buf)
+{
+	uint8_t version;
+
+	switch (stream.state) {
+	case AGPS_STREAM_VERSION:
+		version = buf[NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION_INDEX];
+
+		if (version != NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION) {
+			LOG_ERR("Cannot parse schema version: %d", version);
+			return -EBADMSG;
+		}
+
+		LOG_DBG("Received A-GPS data. Schema version: %d", version);
+
+		stream.state = AGPS_STREAM_HEADER;
+		return 0;
+	case AGPS_STREAM_HEADER:
+		/* The element type is only given once before the array,
+		 * and not for each element.
+		 */
+		stream.element_type =
+			(enum nrf_cloud_agps_type)buf[NRF_CLOUD_AGPS_BIN_TYPE_OFFSET];
+		stream.elements_left =
+			sys_get_le16(&buf[NRF_CLOUD_AGPS_BIN_COUNT_OFFSET]);
+
+		if (agps_element_size(stream.element_type) == 0) {
+			LOG_DBG("Unhandled A-GPS data type: %d",
+				stream.element_type);
+			LOG_DBG("Parsing finished");
+			stream.state = AGPS_STREAM_DONE;
+			return 0;
+		}
+
+		/* Elements are reassembled in the carry buffer when split,
+		 * reject them up front regardless of how they are chunked.
+		 */
+		if (agps_element_size(stream.element_type) >
+		    sizeof(stream.carry)) {
+			LOG_ERR("A-GPS element of type %d is too large: %d",
+				stream.element_type,
+				agps_element_size(stream.element_type));
+			return -EMSGSIZE;
+		}
+
+		if (stream.elements_left > 0) {
+			stream.state = AGPS_STREAM_ELEMENT;
+		}
+
+		return 0;
+	case AGPS_STREAM_ELEMENT:
+		stream.elements_left -= 1;
+		if (stream.elements_left == 0) {
+			stream.state = AGPS_STREAM_HEADER;
+		}
+
+		return process_agps_element(buf);
+	default:
+		return 0;
+	}
+}
+
+int nrf_cloud_agps_process_start(const int *socket)
+{
+	if (socket) {
+		gps_dev = NULL;
+		fd = *socket;
+
+		LOG_DBG("Using user-provided socket, fd %d", fd);
+	} else if (gps_dev == NULL) {
+		gps_dev = device_get_binding("NRF9160_GPS");
+		if (gps_dev == NULL) {
+			LOG_ERR("GPS is not enabled, A-GPS response unhandled");
+			return -ENODEV;
+		}
+	}
+
+	memset(&stream, 0, sizeof(stream));
+	stream.state = AGPS_STREAM_VERSION;
+
+	return 0;
+}
+
+int nrf_cloud_agps_process_chunk(const char *buf, size_t buf_len)
+{
+	int err;
+	size_t unit_size;
+	size_t copy_len;
+
+	if ((buf == NULL) && (buf_len > 0)) {
+		return -EINVAL;
+	}
+
+	if (stream.state == AGPS_STREAM_IDLE) {
+		return -EPERM;
+	}
+
+	while ((buf_len > 0) && (stream.state != AGPS_STREAM_DONE)) {
+		unit_size = stream_unit_size();
+
+		__ASSERT_NO_MSG(unit_size <= sizeof(stream.carry));
+
+		/* Parse in place if the whole unit is available. */
+		if ((stream.carry_len == 0) && (buf_len >= unit_size)) {
+			err = stream_unit_process(buf);
+			if (err) {
+				goto error;
+			}
+
+			buf += unit_size;
+			buf_len -= unit_size;
+			continue;
+		}
+
+		/* Otherwise, reassemble the unit across chunks. */
+		copy_len = MIN(unit_size - stream.carry_len, buf_len);
+		memcpy(&stream.carry[stream.carry_len], buf, copy_len);
+		stream.carry_len += copy_len;
+		buf += copy_len;
+		buf_len -= copy_len;
+
+		if (stream.carry_len < unit_size) {
+			LOG_DBG("Carrying over %d bytes of partial element",
+				stream.carry_len);
+			break;
+		}
+
+		stream.carry_len = 0;
+
+		err = stream_unit_process((const char *)stream.carry);
+		if (err) {
+			goto error;
+		}
 	}
 
-	return len;
+	return 0;
+
+error:
+	LOG_ERR("Failed to process A-GPS data, error: %d", err);
+	stream.state = AGPS_STREAM_IDLE;
+
+	return err;
+}
+
+int nrf_cloud_agps_process_finish(void)
+{
+	int err = 0;
+
+	if (stream.state == AGPS_STREAM_IDLE) {
+		return -EPERM;
+	}
+
+	if ((stream.carry_len > 0) || (stream.state == AGPS_STREAM_ELEMENT)) {
+		LOG_WRN("A-GPS data ended within an element");
+		err = -EBADMSG;
+	}
+
+	stream.state = AGPS_STREAM_IDLE;
+
+	return err;
 }
 
 int nrf_cloud_agps_request_cell_location(enum cell_based_location_type type,
@@ -825,10 +1085,6 @@ int nrf_cloud_agps_get_last_cell_location(double *const lat,
 int nrf_cloud_agps_process(const char *buf, size_t buf_len, const int *socket)
 {
 	int err;
-	struct nrf_cloud_apgs_element element = {};
-	struct nrf_cloud_agps_system_time sys_time;
-	size_t parsed_len = 0;
-	uint8_t version;
 
 	err = parse_cell_location_response(buf);
 	if (err <= 0) {
@@ -844,63 +1100,20 @@ int nrf_cloud_agps_process(const char *buf, size_t buf_len, const int *socket)
 	return -EOPNOTSUPP;
 #endif
 
-	version = buf[NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION_INDEX];
-	parsed_len += NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION_SIZE;
-
-	__ASSERT(version == NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION,
-		 "Cannot parse schema version: %d", version);
-
-	LOG_DBG("Receievd AGPS data. Schema version: %d, length: %d",
-		version, buf_len);
+	LOG_DBG("Received A-GPS data, length: %d", buf_len);
 
-	if (socket) {
-		LOG_DBG("Using user-provided socket, fd %d", fd);
-
-		gps_dev = NULL;
-		fd = *socket;
-	} else if (gps_dev == NULL) {
-		gps_dev = device_get_binding("NRF9160_GPS");
-		if (gps_dev == NULL) {
-			LOG_ERR("GPS is not enabled, A-GPS response unhandled");
-			return -ENODEV;
-		}
+	err = nrf_cloud_agps_process_start(socket);
+	if (err) {
+		return err;
 	}
 
-	while (parsed_len < buf_len) {
-		size_t element_size =
-			get_next_agps_element(&element, &buf[parsed_len]);
-
-		if (element_size == 0) {
-			LOG_DBG("Parsing finished\n");
-			break;
-		}
-
-		parsed_len += element_size;
-
-		LOG_DBG("Parsed_len: %d\n", parsed_len);
-
-		if (element.type == NRF_CLOUD_AGPS_GPS_TOWS) {
-			memcpy(&sys_time.sv_tow[element.tow->sv_id - 1],
-				element.tow,
-				sizeof(sys_time.sv_tow[0]));
-
-			LOG_DBG("TOW %d copied", element.tow->sv_id - 1);
-
-			continue;
-		} else if (element.type == NRF_CLOUD_AGPS_GPS_SYSTEM_CLOCK) {
-			memcpy(&sys_time, element.time_and_tow,
-				sizeof(sys_time) - sizeof(sys_time.sv_tow));
-
-			LOG_DBG("TOWs copied, bitmask: 0x%08x",
-				element.time_and_tow->sv_mask);
-		}
-
-		err = agps_send_to_modem(&element);
-		if (err) {
-			LOG_ERR("Failed to send data to modem, error: %d", err);
-			return err;
-		}
+	err = nrf_cloud_agps_process_chunk(buf, buf_len);
+	if (err) {
+		return err;
 	}
 
+	/* A trailing partial element has always been ignored here. */
+	(void)nrf_cloud_agps_process_finish();
+
 	return 0;
 }
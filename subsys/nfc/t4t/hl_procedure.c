@@ -26,6 +26,9 @@ LOG_MODULE_REGISTER(nfc_t4t_hl_procedure,
 #define NFC_T4T_APDU_SELECT_DATA {0xD2, 0x76, 0x00, 0x00, 0x85, 0x01, 0x01}
 #define APDU_LE_MAP_2_MAX_VALUE 0xFF
 #define NFC_T4T_APDU_RSP_ALL 256
+#define CAPDU_HEADER_SIZE 4
+#define CAPDU_LC_SHORT_SIZE 1
+#define CAPDU_LC_EXTENDED_SIZE 3
 
 enum nfc_t4t_hl_transaction_type {
 	NFC_T4T_HL_SELECT,
@@ -63,6 +66,63 @@ struct t4t_hl_procedure {
 static struct t4t_hl_procedure t4t_hl;
 static const struct nfc_t4t_hl_procedure_cb *hl_cb;
 
+BUILD_ASSERT(sizeof(t4t_hl.apdu_buff) >
+	     (CAPDU_HEADER_SIZE + CAPDU_LC_EXTENDED_SIZE),
+	     "APDU buffer is too small");
+
+/* Maximum data length of one READ BINARY command. Extended length Le
+ * is used only if the tag accepts responses longer than 255 bytes.
+ */
+static uint16_t read_len_max(const struct nfc_t4t_cc_file *cc)
+{
+#if defined(CONFIG_NFC_T4T_HL_PROCEDURE_EXT_APDU)
+	if (cc->max_rapdu_size > APDU_LE_MAP_2_MAX_VALUE) {
+		return MIN(cc->max_rapdu_size,
+			   CONFIG_NFC_T4T_HL_PROCEDURE_EXT_APDU_MAX_LEN);
+	}
+#endif /* defined(CONFIG_NFC_T4T_HL_PROCEDURE_EXT_APDU) */
+
+	return MIN(APDU_LE_MAP_2_MAX_VALUE, cc->max_rapdu_size);
+}
+
+/* Maximum data length of one UPDATE BINARY command, limited also by
+ * the C-APDU buffer.
+ */
+static uint16_t update_len_max(const struct nfc_t4t_cc_file *cc)
+{
+	uint16_t len = MIN(APDU_LE_MAP_2_MAX_VALUE, cc->max_capdu_size);
+	size_t header_size = CAPDU_HEADER_SIZE + CAPDU_LC_SHORT_SIZE;
+
+#if defined(CONFIG_NFC_T4T_HL_PROCEDURE_EXT_APDU)
+	if (cc->max_capdu_size > APDU_LE_MAP_2_MAX_VALUE) {
+		len = cc->max_capdu_size;
+		header_size = CAPDU_HEADER_SIZE + CAPDU_LC_EXTENDED_SIZE;
+	}
+#endif /* defined(CONFIG_NFC_T4T_HL_PROCEDURE_EXT_APDU) */
+
+	return MIN(len, sizeof(t4t_hl.apdu_buff) - header_size);
+}
+
+/* NLEN is read together with the beginning of the NDEF message, as long
+ * as the read does not go beyond the NDEF file.
+ */
+static uint16_t nlen_read_len(struct nfc_t4t_cc_file *cc, uint16_t buff_size)
+{
+	struct nfc_t4t_tlv_block *tlv_block;
+	uint32_t len;
+
+	tlv_block = nfc_t4t_cc_file_content_get(cc,
+						sys_get_be16(t4t_hl.ndef.file_id));
+	if (!tlv_block) {
+		return NDEF_FILE_NLEN_SIZE;
+	}
+
+	len = MIN(tlv_block->value.max_file_size, buff_size);
+	len = MIN(len, read_len_max(cc));
+
+	return MAX(len, NDEF_FILE_NLEN_SIZE);
+}
+
 static int t4t_hl_data_exchange(struct nfc_t4t_apdu_comm *comm)
 {
 	int err;
@@ -134,8 +194,8 @@ static int on_ndef_nlen_read(const struct nfc_t4t_apdu_resp *resp)
 	const uint8_t *data = resp->data.buff;
 	uint16_t len = resp->data.len;
 
-	if (len != NDEF_FILE_NLEN_SIZE) {
-		LOG_ERR("NDEF NLEN response is to long");
+	if (len < NDEF_FILE_NLEN_SIZE) {
+		LOG_ERR("NDEF NLEN response is to short");
 		return -EINVAL;
 	}
 
@@ -165,6 +225,12 @@ static int ndef_file_chunk_read(const struct nfc_t4t_apdu_resp *resp)
 	struct nfc_t4t_apdu_comm apdu_comm;
 	const uint8_t *data = resp->data.buff;
 	uint16_t len = resp->data.len;
+	uint32_t file_len = t4t_hl.ndef.nlen + NDEF_FILE_NLEN_SIZE;
+
+	/* The first response can contain data beyond the NDEF message. */
+	if (t4t_hl.file_offset + len > file_len) {
+		len = file_len - t4t_hl.file_offset;
+	}
 
 	if (t4t_hl.ndef.buff_size < t4t_hl.file_offset + len) {
 		return -ENOMEM;
@@ -174,13 +240,13 @@ static int ndef_file_chunk_read(const struct nfc_t4t_apdu_resp *resp)
 
 	t4t_hl.file_offset += len;
 
-	if (t4t_hl.file_offset < (t4t_hl.ndef.nlen + NDEF_FILE_NLEN_SIZE)) {
+	if (t4t_hl.file_offset < file_len) {
 		nfc_t4t_apdu_comm_clear(&apdu_comm);
 
 		apdu_comm.instruction = NFC_T4T_APDU_COMM_INS_READ;
 		apdu_comm.parameter = t4t_hl.file_offset;
-		apdu_comm.resp_len = MIN(t4t_hl.ndef.nlen - (t4t_hl.file_offset - NDEF_FILE_NLEN_SIZE),
-				MIN(APDU_LE_MAP_2_MAX_VALUE, t4t_hl.ndef.cc->max_rapdu_size));
+		apdu_comm.resp_len = MIN(file_len - t4t_hl.file_offset,
+					 read_len_max(t4t_hl.ndef.cc));
 
 		t4t_hl.transaction_type = NFC_T4T_HL_NDEF_READ;
 
@@ -215,7 +281,7 @@ static int ndef_file_chunk_update(void)
 		apdu_comm.parameter = t4t_hl.file_offset;
 		apdu_comm.data.buff = t4t_hl.ndef.buff + t4t_hl.file_offset;
 		apdu_comm.data.len = MIN(t4t_hl.ndef.buff_size - t4t_hl.file_offset,
-				MIN(APDU_LE_MAP_2_MAX_VALUE, t4t_hl.ndef.cc->max_capdu_size));
+					 update_len_max(t4t_hl.ndef.cc));
 
 		t4t_hl.file_offset += apdu_comm.data.len;
 		t4t_hl.transaction_type = NFC_T4T_HL_NDEF_UPDATE;
@@ -415,7 +481,7 @@ int nfc_t4t_hl_procedure_ndef_read(struct nfc_t4t_cc_file *cc,
 
 	apdu_comm.instruction = NFC_T4T_APDU_COMM_INS_READ;
 	apdu_comm.parameter = 0;
-	apdu_comm.resp_len = NDEF_FILE_NLEN_SIZE;
+	apdu_comm.resp_len = nlen_read_len(cc, ndef_len);
 
 	t4t_hl.ndef.buff = ndef_buff;
 	t4t_hl.ndef.buff_size = ndef_len;
@@ -66,6 +66,7 @@ LOG_MODULE_REGISTER(nfc_t4t_isodep, CONFIG_NFC_T4T_ISODEP_LOG_LEVEL);
 #define T4T_ATS_T0_TC_PRESENT BIT(6)
 #define T4T_ATS_TA_EQUAL_DIVISOR BIT(7)
 #define T4T_ATS_T0_FSCI_MASK 0x0F
+#define T4T_ATS_FSCI_RFU_DEFAULT NFC_T4T_ISODEP_FSD_256
 #define T4T_ATS_TA_DIVISOR_PL 0x07
 #define T4T_ATS_TA_DIVISOR_PL_OFFSET 1
 #define T4T_ATS_TA_DIVISOR_LP_OFFSET 3
@@ -131,8 +132,11 @@ struct nfc_t4t_isodep {
 	bool first_transfer;
 };
 
-/* Map FSD value in terms of FSDI according to NFC Forum Digital Specification 2.0 14.16.1 */
-static const uint16_t fsd_value_map[] = {16, 24, 32, 40, 48, 64, 96, 128, 256};
+/* Map FSD value in terms of FSDI according to NFC Forum Digital Specification 2.0 14.16.1,
+ * extended with the frame sizes above 256 bytes from ISO/IEC 14443-4:2016.
+ */
+static const uint16_t fsd_value_map[] = {16, 24, 32, 40, 48, 64, 96, 128, 256,
+					 512, 1024, 2048, 4096};
 
 static struct nfc_t4t_isodep t4t_isodep;
 static const struct nfc_t4t_isodep_cb *t4t_isodep_cb;
@@ -203,6 +207,11 @@ static int ats_parse(const uint8_t *data, size_t len)
 
 	fsci = t0 & T4T_ATS_T0_FSCI_MASK;
 
+	/* RFU values are interpreted as 256 bytes. */
+	if (fsci >= ARRAY_SIZE(fsd_value_map)) {
+		fsci = T4T_ATS_FSCI_RFU_DEFAULT;
+	}
+
 	/* FSC is mapped from FSCI in the same way like FSD.
 	 * NFC Forum Digital Specification 2.0 14.6.2.
 	 */
@@ -288,6 +297,7 @@ static int ats_parse(const uint8_t *data, size_t len)
 static void isodep_chunk_send(void)
 {
 	size_t data_len;
+	size_t frame_size;
 	uint32_t fdt;
 	size_t index = 0;
 	const uint8_t *data = t4t_isodep.transmit_data;
@@ -296,6 +306,9 @@ static void isodep_chunk_send(void)
 	__ASSERT_NO_MSG(data);
 	__ASSERT_NO_MSG(tx_data);
 
+	/* The Listener frame size can be larger than the Tx buffer. */
+	frame_size = MIN(t4t_isodep.tag.fsc, t4t_isodep.tx_data.buf_size);
+
 	/* Prepare first chunk. */
 	tx_data[index] = ISODEP_I_BLOCK | (t4t_isodep.block_num & 1);
 
@@ -303,10 +316,10 @@ static void isodep_chunk_send(void)
 	index = did_include(tx_data, index);
 
 	/* Use chaining when data is to long. */
-	if ((t4t_isodep.tag.fsc - index) <
+	if ((frame_size - index) <
 	    (t4t_isodep.transmit_len - t4t_isodep.transmitted_len)) {
 		tx_data[0] |= I_BLOCK_CHAINING_BIT;
-		data_len = t4t_isodep.tag.fsc - index;
+		data_len = frame_size - index;
 		t4t_isodep.chaining = true;
 	} else {
 		data_len = t4t_isodep.transmit_len - t4t_isodep.transmitted_len;
@@ -723,6 +736,12 @@ int nfc_t4t_isodep_rats_send(enum nfc_t4t_isodep_fsd fsd, uint8_t did)
 		return -EINVAL;
 	}
 
+	if (fsd >= ARRAY_SIZE(fsd_value_map)) {
+		LOG_ERR("Invalid FSD value.");
+
+		return -EINVAL;
+	}
+
 	if (t4t_isodep.tx_data.buf_size < fsd_value_map[fsd]) {
 		LOG_ERR("Invalid FSD value. Increase Tx buffer size or decrease FSD");
 
@@ -757,6 +776,18 @@ int nfc_t4t_isodep_rats_send(enum nfc_t4t_isodep_fsd fsd, uint8_t did)
 	return 0;
 }
 
+enum nfc_t4t_isodep_fsd nfc_t4t_isodep_fsd_max_get(void)
+{
+	enum nfc_t4t_isodep_fsd fsd = NFC_T4T_ISODEP_FSD_16;
+
+	while ((fsd + 1 < ARRAY_SIZE(fsd_value_map)) &&
+	       (fsd_value_map[fsd + 1] <= t4t_isodep.tx_data.buf_size)) {
+		fsd++;
+	}
+
+	return fsd;
+}
+
 int nfc_t4t_isodep_tag_deselect(void)
 {
 	size_t index = 0;
@@ -7,8 +7,8 @@
 #include <zephyr.h>
 #include <device.h>
 #include <dfu/pcd.h>
+#include <drivers/flash.h>
 #include <logging/log.h>
-#include <storage/stream_flash.h>
 
 LOG_MODULE_REGISTER(pcd, CONFIG_PCD_LOG_LEVEL);
 
@@ -27,14 +27,34 @@ LOG_MODULE_REGISTER(pcd, CONFIG_PCD_LOG_LEVEL);
 #define NET_CORE_APP_OFFSET PM_CPUNET_B0N_CONTAINER_SIZE
 #endif
 
+/** Interval of polling the stream slot counters. */
+#define PCD_STREAM_POLL_INTERVAL_US 1000
+
+/** Erased flash byte value used to pad the last write. */
+#define FLASH_ERASE_VALUE 0xff
+
 struct pcd_cmd {
 	uint32_t magic; /* Magic value to identify this structure in memory */
-	const void *data;     /* Data to copy*/
+	const void *data;     /* Data to copy, NULL if the data is streamed */
 	size_t len;           /* Number of bytes to copy */
 	off_t offset;         /* Offset to store the flash image in */
+	size_t progress;      /* Number of bytes copied so far */
+	uint32_t wr_cnt;      /* Number of stream slots written */
+	uint32_t rd_cnt;      /* Number of stream slots copied */
 } __aligned(4);
 
-static struct pcd_cmd *cmd = (struct pcd_cmd *)PCD_CMD_ADDRESS;
+/* Layout of the shared RAM. Streamed data is passed through the slots,
+ * so that the network core does not need access to the whole image.
+ */
+struct pcd_shared {
+	struct pcd_cmd cmd;
+	uint8_t slot[PCD_STREAM_SLOT_CNT][PCD_STREAM_SLOT_SIZE] __aligned(4);
+};
+
+static volatile struct pcd_shared *shared =
+	(volatile struct pcd_shared *)PCD_CMD_ADDRESS;
+static volatile struct pcd_cmd *cmd =
+	&((volatile struct pcd_shared *)PCD_CMD_ADDRESS)->cmd;
 
 void pcd_fw_copy_invalidate(void)
 {
@@ -57,28 +77,167 @@ const void *pcd_cmd_data_ptr_get(void)
 	return cmd->data;
 }
 
-int pcd_fw_copy(const struct device *fdev)
+size_t pcd_fw_copy_progress_get(void)
+{
+	return cmd->progress;
+}
+
+/* Check if the flash page already holds the data. */
+static bool page_matches(const struct device *fdev, off_t offset,
+			 const uint8_t *src, size_t len, uint8_t *buf)
 {
-	struct stream_flash_ctx stream;
+	for (size_t pos = 0; pos < len; pos += CONFIG_PCD_BUF_SIZE) {
+		size_t chunk = MIN(len - pos, CONFIG_PCD_BUF_SIZE);
+
+		if (flash_read(fdev, offset + pos, buf, chunk) != 0) {
+			return false;
+		}
+
+		if (memcmp(buf, &src[pos], chunk) != 0) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Program a single flash page with the data. Pages which already hold the
+ * data are skipped, so an interrupted update continues where it stopped.
+ */
+static int page_copy(const struct device *fdev, off_t offset,
+		     size_t page_size, const uint8_t *src, size_t len)
+{
+	size_t block_size = flash_get_write_block_size(fdev);
 	uint8_t buf[CONFIG_PCD_BUF_SIZE];
 	int rc;
 
-	if (cmd->magic != PCD_CMD_MAGIC_COPY) {
-		return -EFAULT;
+	if (page_matches(fdev, offset, src, len, buf)) {
+		return 0;
 	}
 
-	rc = stream_flash_init(&stream, fdev, buf, sizeof(buf),
-			       cmd->offset, 0, NULL);
+	rc = flash_write_protection_set(fdev, false);
 	if (rc != 0) {
-		LOG_ERR("stream_flash_init failed: %d", rc);
 		return rc;
 	}
 
-	rc = stream_flash_buffered_write(&stream, (uint8_t *)cmd->data,
-					 cmd->len, true);
+	rc = flash_erase(fdev, offset, page_size);
 	if (rc != 0) {
-		LOG_ERR("stream_flash_buffered_write fail: %d", rc);
-		return rc;
+		LOG_ERR("flash_erase failed: %d", rc);
+		goto out;
+	}
+
+	for (size_t pos = 0; pos < len; pos += CONFIG_PCD_BUF_SIZE) {
+		size_t chunk = MIN(len - pos, CONFIG_PCD_BUF_SIZE);
+		size_t write_len = ROUND_UP(chunk, block_size);
+
+		memcpy(buf, &src[pos], chunk);
+		memset(&buf[chunk], FLASH_ERASE_VALUE, write_len - chunk);
+
+		rc = flash_write(fdev, offset + pos, buf, write_len);
+		if (rc != 0) {
+			LOG_ERR("flash_write failed: %d", rc);
+			goto out;
+		}
+	}
+
+out:
+	(void)flash_write_protection_set(fdev, true);
+
+	return rc;
+}
+
+/* Wait until the application core has written the next stream slot. */
+static const uint8_t *stream_slot_get(void)
+{
+	while (cmd->wr_cnt == cmd->rd_cnt) {
+		if (cmd->magic != PCD_CMD_MAGIC_COPY) {
+			return NULL;
+		}
+
+		k_busy_wait(PCD_STREAM_POLL_INTERVAL_US);
+	}
+
+	/* Read the slot only after the counter. */
+	__DMB();
+
+	return (const uint8_t *)shared->slot[cmd->rd_cnt %
+					     PCD_STREAM_SLOT_CNT];
+}
+
+static void stream_slot_release(void)
+{
+	/* Finish reading the slot before it is returned. */
+	__DMB();
+
+	cmd->rd_cnt++;
+}
+
+int pcd_fw_copy(const struct device *fdev)
+{
+	const bool stream = (cmd->data == NULL);
+	struct flash_pages_info info;
+	const uint8_t *slot = NULL;
+	size_t len = cmd->len;
+	off_t offset = cmd->offset;
+	size_t pos = 0;
+	int rc;
+
+	if (cmd->magic != PCD_CMD_MAGIC_COPY) {
+		return -EFAULT;
+	}
+
+	if (CONFIG_PCD_BUF_SIZE % flash_get_write_block_size(fdev) != 0) {
+		return -EINVAL;
+	}
+
+	while (pos < len) {
+		off_t page_offset = offset + (off_t)pos;
+		const uint8_t *src;
+		size_t chunk;
+
+		rc = flash_get_page_info_by_offs(fdev, page_offset, &info);
+		if (rc != 0) {
+			LOG_ERR("flash_get_page_info_by_offs failed: %d", rc);
+			return rc;
+		}
+
+		if (info.start_offset != page_offset) {
+			LOG_ERR("Image offset not aligned to flash page");
+			return -EINVAL;
+		}
+
+		chunk = MIN(len - pos, info.size);
+
+		if (stream) {
+			/* Every slot must hold whole flash pages. */
+			if (PCD_STREAM_SLOT_SIZE % info.size != 0) {
+				return -EINVAL;
+			}
+
+			if ((pos % PCD_STREAM_SLOT_SIZE) == 0) {
+				slot = stream_slot_get();
+				if (slot == NULL) {
+					return -ECANCELED;
+				}
+			}
+
+			src = slot + (pos % PCD_STREAM_SLOT_SIZE);
+		} else {
+			src = (const uint8_t *)cmd->data + pos;
+		}
+
+		rc = page_copy(fdev, page_offset, info.size, src, chunk);
+		if (rc != 0) {
+			return rc;
+		}
+
+		pos += chunk;
+		cmd->progress = pos;
+
+		if (stream && (((pos % PCD_STREAM_SLOT_SIZE) == 0) ||
+			       (pos == len))) {
+			stream_slot_release();
+		}
 	}
 
 	LOG_INF("Transfer done");
@@ -94,6 +253,11 @@ void pcd_fw_copy_done(void)
 
 #if defined(CONFIG_SOC_NRF5340_CPUAPP) && defined(CONFIG_MCUBOOT)
 
+#ifdef PM_PCD_SRAM_SIZE
+BUILD_ASSERT(sizeof(struct pcd_shared) <= PM_PCD_SRAM_SIZE,
+	     "PCD stream slots do not fit in the shared RAM");
+#endif
+
 /** @brief Construct a PCD CMD for copying data/firmware.
  *
  * @param data   The data to copy.
@@ -105,7 +269,7 @@ void pcd_fw_copy_done(void)
  */
 static int pcd_cmd_write(const void *data, size_t len, off_t offset)
 {
-	if (data == NULL || len == 0) {
+	if (len == 0) {
 		return -EINVAL;
 	}
 
@@ -113,14 +277,15 @@ static int pcd_cmd_write(const void *data, size_t len, off_t offset)
 	cmd->data = data;
 	cmd->len = len;
 	cmd->offset = offset;
+	cmd->progress = 0;
+	cmd->wr_cnt = 0;
+	cmd->rd_cnt = 0;
 
 	return 0;
 }
 
-int pcd_network_core_update(const void *src_addr, size_t len)
+static void network_core_start(void)
 {
-	int err;
-
 	/* Retain nRF5340 Network MCU in Secure domain (bus
 	 * accesses by Network MCU will have Secure attribute set).
 	 * This is needed for the network core to be able to read the
@@ -130,15 +295,11 @@ int pcd_network_core_update(const void *src_addr, size_t len)
 
 	/* Ensure that the network core is turned off */
 	nrf_reset_network_force_off(NRF_RESET, true);
+}
 
-	err = pcd_cmd_write(src_addr, len, NET_CORE_APP_OFFSET);
-	if (err != 0) {
-		LOG_INF("Error while writing PCD cmd: %d", err);
-		return err;
-	}
-
-	nrf_reset_network_force_off(NRF_RESET, false);
-	LOG_INF("Turned on network core");
+static int network_core_finish(void)
+{
+	int err;
 
 	do {
 		/* Wait for 1 second to avoid issue where network core
@@ -147,6 +308,9 @@ int pcd_network_core_update(const void *src_addr, size_t len)
 		k_busy_wait(1 * USEC_PER_SEC);
 
 		err = pcd_fw_copy_status_get();
+
+		LOG_INF("Network core update: %zu/%zu bytes",
+			pcd_fw_copy_progress_get(), cmd->len);
 	} while (err == PCD_STATUS_COPY);
 
 	if (err == PCD_STATUS_COPY_FAILED) {
@@ -160,6 +324,86 @@ int pcd_network_core_update(const void *src_addr, size_t len)
 	return 0;
 }
 
+int pcd_network_core_update(const void *src_addr, size_t len)
+{
+	int err;
+
+	if (src_addr == NULL) {
+		return -EINVAL;
+	}
+
+	network_core_start();
+
+	err = pcd_cmd_write(src_addr, len, NET_CORE_APP_OFFSET);
+	if (err != 0) {
+		LOG_INF("Error while writing PCD cmd: %d", err);
+		return err;
+	}
+
+	nrf_reset_network_force_off(NRF_RESET, false);
+	LOG_INF("Turned on network core");
+
+	return network_core_finish();
+}
+
+int pcd_network_core_update_stream(pcd_stream_read_t read, void *ctx,
+				   size_t len)
+{
+	size_t pos = 0;
+	int err;
+
+	if (read == NULL) {
+		return -EINVAL;
+	}
+
+	network_core_start();
+
+	err = pcd_cmd_write(NULL, len, NET_CORE_APP_OFFSET);
+	if (err != 0) {
+		LOG_INF("Error while writing PCD cmd: %d", err);
+		return err;
+	}
+
+	nrf_reset_network_force_off(NRF_RESET, false);
+	LOG_INF("Turned on network core");
+
+	while (pos < len) {
+		size_t chunk = MIN(len - pos, PCD_STREAM_SLOT_SIZE);
+		uint8_t *slot;
+
+		/* Wait for a free slot. */
+		while ((cmd->wr_cnt - cmd->rd_cnt) >= PCD_STREAM_SLOT_CNT) {
+			if (pcd_fw_copy_status_get() != PCD_STATUS_COPY) {
+				LOG_ERR("Network core update failed");
+				return -EIO;
+			}
+
+			k_busy_wait(PCD_STREAM_POLL_INTERVAL_US);
+		}
+
+		/* Read the counters before the slot is reused. */
+		__DMB();
+
+		slot = (uint8_t *)shared->slot[cmd->wr_cnt %
+					       PCD_STREAM_SLOT_CNT];
+		err = read(ctx, pos, slot, chunk);
+		if (err != 0) {
+			LOG_ERR("Unable to read update data: %d", err);
+			pcd_fw_copy_invalidate();
+			nrf_reset_network_force_off(NRF_RESET, true);
+			return err;
+		}
+
+		/* Make the slot data visible before the counter. */
+		__DMB();
+
+		cmd->wr_cnt++;
+		pos += chunk;
+	}
+
+	return network_core_finish();
+}
+
 void pcd_lock_ram(void)
 {
 	uint32_t region = PCD_CMD_ADDRESS/CONFIG_NRF_SPU_RAM_REGION_SIZE;
@@ -10,14 +10,17 @@
 #include <sys/util.h>
 #include <sys/byteorder.h>
 #include <zephyr.h>
-#include <SEGGER_RTT.h>
 #include <profiler.h>
 #include <string.h>
 
+#include "profiler_nordic_backend.h"
+
 
 /* By default, when there is no shell, all events are profiled. */
 #ifndef CONFIG_SHELL
-uint32_t profiler_enabled_events = 0xffffffff;
+uint32_t profiler_enabled_events[PROFILER_ENABLED_EVENTS_WORDS] = {
+	[0 ... (PROFILER_ENABLED_EVENTS_WORDS - 1)] = 0xffffffff
+};
 #endif
 
 
@@ -44,69 +47,72 @@ static char *arg_types_encodings[] = {
 					"t"    /* time */
 				     };
 
-uint8_t profiler_num_events;
+uint16_t profiler_num_events;
 
-static uint8_t buffer_data[CONFIG_PROFILER_NORDIC_DATA_BUFFER_SIZE];
-static uint8_t buffer_info[CONFIG_PROFILER_NORDIC_INFO_BUFFER_SIZE];
-static uint8_t buffer_commands[CONFIG_PROFILER_NORDIC_COMMAND_BUFFER_SIZE];
+#ifdef CONFIG_PROFILER_NORDIC_COMPACT_ENCODING
+#define COMPACT_ENCODING	true
 
-static k_tid_t protocol_thread_id;
+/* Header holds varint encoded 16-bit event type ID and zigzag varint encoded
+ * 32-bit timestamp delta.
+ */
+#define HEADER_MAX_SIZE		(3 + 5)
 
-static K_THREAD_STACK_DEFINE(profiler_nordic_stack,
-			     CONFIG_PROFILER_NORDIC_STACK_SIZE);
-static struct k_thread profiler_nordic_thread;
+#define VARINT_VALUE_BITS	7
+#define VARINT_VALUE_MASK	BIT_MASK(VARINT_VALUE_BITS)
+#define VARINT_CONTINUE_FLAG	BIT(VARINT_VALUE_BITS)
 
-static int send_info_data(const char *data, size_t data_len)
-{
-	uint8_t retry_cnt = 0;
-	static const uint8_t retry_cnt_max = 100;
+/* Event type ID reserved for reporting events dropped by the profiler. */
+#define DROPPED_EVENTS_ID	UINT16_MAX
 
-	size_t num_bytes_send;
+static uint32_t last_timestamp;
+static uint32_t dropped_events;
+#else
+#define COMPACT_ENCODING	false
 
-	num_bytes_send = SEGGER_RTT_WriteNoLock(
-				  CONFIG_PROFILER_NORDIC_RTT_CHANNEL_INFO,
-				  data, data_len);
+/* Header holds 8-bit event type ID and 32-bit timestamp. */
+#define HEADER_MAX_SIZE		(sizeof(uint8_t) + sizeof(uint32_t))
+#endif
 
-	while (num_bytes_send == 0) {
-		/* Give host time to read the data and free some space
-		 * in the buffer. */
-		k_sleep(K_MSEC(100));
-		num_bytes_send = SEGGER_RTT_WriteNoLock(
-				  CONFIG_PROFILER_NORDIC_RTT_CHANNEL_INFO,
-				  data, data_len);
+#ifdef CONFIG_ARCH_POSIX
+#define MEMORY_BARRIER()	compiler_barrier()
+#else
+#define MEMORY_BARRIER()	__DMB()
+#endif
 
-		/* Avoid being blocked in while loop if host does not read
-		 * the RTT data.
-		 */
-		retry_cnt++;
-		if (retry_cnt > retry_cnt_max) {
-			return -ENOBUFS;
-		}
-	}
+static k_tid_t protocol_thread_id;
 
-	return 0;
-}
+static K_THREAD_STACK_DEFINE(profiler_nordic_stack,
+			     CONFIG_PROFILER_NORDIC_STACK_SIZE);
+static struct k_thread profiler_nordic_thread;
 
-static void send_system_description(void)
+void profiler_nordic_system_description_send(void)
 {
 	/* Memory barrier to make sure that data is visible
 	 * before being accessed
 	 */
-	uint8_t ne = profiler_num_events;
+	uint16_t ne = profiler_num_events;
 
-	__DMB();
+	MEMORY_BARRIER();
 	char end_line = '\n';
 	int err = 0;
 
+	if (IS_ENABLED(CONFIG_PROFILER_NORDIC_COMPACT_ENCODING)) {
+		static const char encoding_descr[] = "#encoding,compact\n";
+
+		err = profiler_nordic_backend_info_write(
+				encoding_descr, strlen(encoding_descr));
+	}
+
 	for (size_t t = 0; ((t < ne) && !err); t++) {
-		err = send_info_data(descr[t], strlen(descr[t]));
+		err = profiler_nordic_backend_info_write(descr[t],
+							 strlen(descr[t]));
 		if (!err) {
-			err = send_info_data(&end_line, 1);
+			err = profiler_nordic_backend_info_write(&end_line, 1);
 		}
 	}
 
 	if (!err) {
-		err = send_info_data(&end_line, 1);
+		err = profiler_nordic_backend_info_write(&end_line, 1);
 	}
 }
 
@@ -116,19 +122,22 @@ static void profiler_nordic_thread_fn(void)
 		uint8_t read_data;
 		enum nordic_command command;
 
-		if (SEGGER_RTT_Read(
-		     CONFIG_PROFILER_NORDIC_RTT_CHANNEL_COMMANDS,
-		     &read_data, sizeof(read_data))) {
+		if (profiler_nordic_backend_command_read(&read_data,
+							 sizeof(read_data))) {
 			command = (enum nordic_command)read_data;
 			switch (command) {
 			case NORDIC_COMMAND_START:
+#ifdef CONFIG_PROFILER_NORDIC_COMPACT_ENCODING
+				/* Host accumulates timestamps from zero. */
+				last_timestamp = 0;
+#endif
 				sending_events = true;
 				break;
 			case NORDIC_COMMAND_STOP:
 				sending_events = false;
 				break;
 			case NORDIC_COMMAND_INFO:
-				send_system_description();
+				profiler_nordic_system_description_send();
 				break;
 			default:
 				__ASSERT_NO_MSG(false);
@@ -142,36 +151,25 @@ static void profiler_nordic_thread_fn(void)
 
 int profiler_init(void)
 {
-	protocol_running = true;
-	if (IS_ENABLED(CONFIG_PROFILER_NORDIC_START_LOGGING_ON_SYSTEM_START)) {
+	int ret;
+
+	/* Backends without a command channel cannot be started by the host. */
+	if (IS_ENABLED(CONFIG_PROFILER_NORDIC_START_LOGGING_ON_SYSTEM_START) ||
+	    !IS_ENABLED(CONFIG_PROFILER_NORDIC_BACKEND_HAS_COMMANDS)) {
 		sending_events = true;
 	}
-	int ret;
 
-	ret = SEGGER_RTT_ConfigUpBuffer(
-		CONFIG_PROFILER_NORDIC_RTT_CHANNEL_DATA,
-		"Nordic profiler data",
-		buffer_data,
-		CONFIG_PROFILER_NORDIC_DATA_BUFFER_SIZE,
-		SEGGER_RTT_MODE_NO_BLOCK_SKIP);
-	__ASSERT_NO_MSG(ret >= 0);
-
-	ret = SEGGER_RTT_ConfigUpBuffer(
-		CONFIG_PROFILER_NORDIC_RTT_CHANNEL_INFO,
-		"Nordic profiler info",
-		buffer_info,
-		CONFIG_PROFILER_NORDIC_INFO_BUFFER_SIZE,
-		SEGGER_RTT_MODE_NO_BLOCK_SKIP);
-	__ASSERT_NO_MSG(ret >= 0);
-
-	ret = SEGGER_RTT_ConfigDownBuffer(
-		CONFIG_PROFILER_NORDIC_RTT_CHANNEL_COMMANDS,
-		"Nordic profiler command",
-		buffer_commands,
-		CONFIG_PROFILER_NORDIC_COMMAND_BUFFER_SIZE,
-		SEGGER_RTT_MODE_NO_BLOCK_SKIP);
-	__ASSERT_NO_MSG(ret >= 0);
+	ret = profiler_nordic_backend_init();
+	if (ret) {
+		sending_events = false;
+		return ret;
+	}
+
+	if (!IS_ENABLED(CONFIG_PROFILER_NORDIC_BACKEND_HAS_COMMANDS)) {
+		return 0;
+	}
 
+	protocol_running = true;
 	protocol_thread_id =  k_thread_create(&profiler_nordic_thread,
 			profiler_nordic_stack,
 			K_THREAD_STACK_SIZEOF(profiler_nordic_stack),
@@ -184,6 +182,10 @@ int profiler_init(void)
 void profiler_term(void)
 {
 	sending_events = false;
+	if (!protocol_running) {
+		return;
+	}
+
 	protocol_running = false;
 	k_wakeup(protocol_thread_id);
 	k_sem_take(&profiler_sem, K_FOREVER);
@@ -202,7 +204,9 @@ uint16_t profiler_register_event_type(const char *name, const char **args,
 	 * from multiple threads
 	 */
 	k_sched_lock();
-	uint8_t ne = profiler_num_events;
+	uint16_t ne = profiler_num_events;
+
+	__ASSERT_NO_MSG(ne < CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS);
 	size_t temp = snprintf(descr[ne],
 			CONFIG_MAX_LENGTH_OF_CUSTOM_EVENTS_DESCRIPTIONS,
 			"%s,%d", name, ne);
@@ -233,37 +237,195 @@ uint16_t profiler_register_event_type(const char *name, const char **args,
 	/* Memory barrier to make sure that data is visible
 	 * before being accessed
 	 */
-	__DMB();
+	MEMORY_BARRIER();
 	profiler_num_events++;
 	k_sched_unlock();
 
 	return ne;
 }
 
+#ifdef CONFIG_PROFILER_NORDIC_COMPACT_ENCODING
+static void encode_varint(struct log_event_buf *buf, uint32_t data)
+{
+	do {
+		__ASSERT_NO_MSG(buf->payload - buf->payload_start + 1
+				 <= CONFIG_PROFILER_CUSTOM_EVENT_BUF_LEN);
+		uint8_t byte = data & VARINT_VALUE_MASK;
+
+		data >>= VARINT_VALUE_BITS;
+		if (data) {
+			byte |= VARINT_CONTINUE_FLAG;
+		}
+		*buf->payload++ = byte;
+	} while (data);
+}
+
+static uint32_t zigzag_encode(int32_t data)
+{
+	return ((uint32_t)data << 1) ^ (uint32_t)(data >> 31);
+}
+#endif /* CONFIG_PROFILER_NORDIC_COMPACT_ENCODING */
+
 void profiler_log_start(struct log_event_buf *buf)
 {
+	__ASSERT_NO_MSG(HEADER_MAX_SIZE <= CONFIG_PROFILER_CUSTOM_EVENT_BUF_LEN);
+#ifdef CONFIG_PROFILER_NORDIC_COMPACT_ENCODING
+	/* Raw timestamp is kept in the space reserved for the header.
+	 * The header is encoded when the event is sent.
+	 */
+	sys_put_le32(k_cycle_get_32(), buf->payload_start);
+	buf->payload = buf->payload_start + HEADER_MAX_SIZE;
+#else
 	/* Adding one to pointer to make space for event type ID */
-	__ASSERT_NO_MSG(sizeof(uint8_t) <= CONFIG_PROFILER_CUSTOM_EVENT_BUF_LEN);
 	buf->payload = buf->payload_start + sizeof(uint8_t);
 	profiler_log_encode_u32(buf, k_cycle_get_32());
+#endif
 }
 
 void profiler_log_encode_u32(struct log_event_buf *buf, uint32_t data)
 {
+#ifdef CONFIG_PROFILER_NORDIC_COMPACT_ENCODING
+	encode_varint(buf, data);
+#else
 	__ASSERT_NO_MSG(buf->payload - buf->payload_start + sizeof(data)
 			 <= CONFIG_PROFILER_CUSTOM_EVENT_BUF_LEN);
 	sys_put_le32(data, buf->payload);
 	buf->payload += sizeof(data);
+#endif
+}
+
+/* With the compact encoding, the host truncates every integer field to the
+ * width of the registered data type. Values of narrow types are truncated
+ * before encoding to use as few bytes as possible. Otherwise, all fields
+ * are sent as 32-bit values.
+ */
+void profiler_log_encode_u8(struct log_event_buf *buf, uint8_t data)
+{
+	profiler_log_encode_u32(buf, data);
+}
+
+void profiler_log_encode_s8(struct log_event_buf *buf, int8_t data)
+{
+	profiler_log_encode_u32(buf, COMPACT_ENCODING ? (uint8_t)data :
+							(uint32_t)data);
+}
+
+void profiler_log_encode_u16(struct log_event_buf *buf, uint16_t data)
+{
+	profiler_log_encode_u32(buf, data);
+}
+
+void profiler_log_encode_s16(struct log_event_buf *buf, int16_t data)
+{
+	profiler_log_encode_u32(buf, COMPACT_ENCODING ? (uint16_t)data :
+							(uint32_t)data);
+}
+
+void profiler_log_encode_s32(struct log_event_buf *buf, int32_t data)
+{
+	profiler_log_encode_u32(buf, (uint32_t)data);
+}
+
+void profiler_log_encode_string(struct log_event_buf *buf, const char *string)
+{
+	/* String is encoded as one byte of length followed by characters. */
+	size_t max_len = CONFIG_PROFILER_CUSTOM_EVENT_BUF_LEN -
+			 (buf->payload - buf->payload_start) - 1;
+	size_t len = strlen(string);
+
+	__ASSERT_NO_MSG(buf->payload - buf->payload_start + 1
+			 <= CONFIG_PROFILER_CUSTOM_EVENT_BUF_LEN);
+
+	len = MIN(len, MIN(max_len, UINT8_MAX));
+	*buf->payload++ = len;
+	memcpy(buf->payload, string, len);
+	buf->payload += len;
 }
 
 void profiler_log_add_mem_address(struct log_event_buf *buf,
 				  const void *mem_address)
 {
-	profiler_log_encode_u32(buf, (uint32_t)mem_address);
+	uint32_t address = (uint32_t)mem_address;
+
+#if defined(CONFIG_PROFILER_NORDIC_COMPACT_ENCODING) && \
+    defined(CONFIG_SRAM_BASE_ADDRESS)
+	/* Address is only used to identify the event. Relative address
+	 * needs fewer bytes to encode.
+	 */
+	address -= CONFIG_SRAM_BASE_ADDRESS;
+#endif
+
+	profiler_log_encode_u32(buf, address);
+}
+
+#ifdef CONFIG_PROFILER_NORDIC_COMPACT_ENCODING
+static uint8_t *encode_header(struct log_event_buf *buf,
+			      uint16_t event_type_id, uint32_t timestamp)
+{
+	struct log_event_buf header;
+	size_t header_len;
+	int32_t delta = (int32_t)(timestamp - last_timestamp);
+
+	/* Header is encoded in a temporary buffer and placed right before
+	 * the event payload.
+	 */
+	header.payload = header.payload_start;
+	encode_varint(&header, event_type_id);
+	encode_varint(&header, zigzag_encode(delta));
+
+	header_len = header.payload - header.payload_start;
+	__ASSERT_NO_MSG(header_len <= HEADER_MAX_SIZE);
+
+	uint8_t *start = buf->payload_start + HEADER_MAX_SIZE - header_len;
+
+	memcpy(start, header.payload_start, header_len);
+
+	return start;
+}
+
+static void send_dropped_events(uint32_t timestamp)
+{
+	struct log_event_buf buf;
+	uint8_t *start;
+
+	buf.payload = buf.payload_start + HEADER_MAX_SIZE;
+	encode_varint(&buf, dropped_events);
+	start = encode_header(&buf, DROPPED_EVENTS_ID, timestamp);
+
+	if (profiler_nordic_backend_data_write(start, buf.payload - start)) {
+		dropped_events = 0;
+		last_timestamp = timestamp;
+	}
 }
+#endif /* CONFIG_PROFILER_NORDIC_COMPACT_ENCODING */
 
 void profiler_log_send(struct log_event_buf *buf, uint16_t event_type_id)
 {
+#ifdef CONFIG_PROFILER_NORDIC_COMPACT_ENCODING
+	__ASSERT_NO_MSG(event_type_id != DROPPED_EVENTS_ID);
+	if (sending_events) {
+		uint32_t timestamp = sys_get_le32(buf->payload_start);
+		int key = irq_lock();
+
+		if (dropped_events > 0) {
+			send_dropped_events(timestamp);
+		}
+
+		uint8_t *start = encode_header(buf, event_type_id, timestamp);
+
+		/* Event is dropped if there is no space in the backend.
+		 * The host is informed about the number of dropped events
+		 * before the next event that is sent.
+		 */
+		if (profiler_nordic_backend_data_write(start,
+						       buf->payload - start)) {
+			last_timestamp = timestamp;
+		} else if (dropped_events < UINT32_MAX) {
+			dropped_events++;
+		}
+		irq_unlock(key);
+	}
+#else
 	__ASSERT_NO_MSG(event_type_id <= UCHAR_MAX);
 	if (sending_events) {
 		uint8_t type_id = event_type_id & UCHAR_MAX;
@@ -271,12 +433,12 @@ void profiler_log_send(struct log_event_buf *buf, uint16_t event_type_id)
 		buf->payload_start[0] = type_id;
 		int key = irq_lock();
 
-		uint8_t num_bytes_send = SEGGER_RTT_WriteNoLock(
-				CONFIG_PROFILER_NORDIC_RTT_CHANNEL_DATA,
+		bool sent = profiler_nordic_backend_data_write(
 				buf->payload_start,
 				buf->payload - buf->payload_start);
-		ARG_UNUSED(num_bytes_send);
+		ARG_UNUSED(sent);
 		irq_unlock(key);
-		__ASSERT_NO_MSG(num_bytes_send > 0);
+		__ASSERT_NO_MSG(sent);
 	}
+#endif
 }
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _PROFILER_NORDIC_BACKEND_H_
+#define _PROFILER_NORDIC_BACKEND_H_
+
+#include <zephyr/types.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Transport used by the Nordic profiler to exchange data with the host.
+ *
+ * The backend provides three logical channels: data (event occurrences),
+ * info (event type descriptions) and commands (sent by the host).
+ * Exactly one backend is linked, as selected in Kconfig.
+ */
+
+/** Initialize the backend. */
+int profiler_nordic_backend_init(void);
+
+/** Write data of a single event.
+ *
+ * Called with interrupts locked. The function must not block and must
+ * either write all of the data or nothing.
+ *
+ * @return True if data was written, false if it was dropped.
+ */
+bool profiler_nordic_backend_data_write(const uint8_t *data, size_t len);
+
+/** Write a part of the system description.
+ *
+ * Called from thread context. The function may block for a limited time.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int profiler_nordic_backend_info_write(const char *data, size_t len);
+
+/** Read command from the host.
+ *
+ * Used only if the backend selects PROFILER_NORDIC_BACKEND_HAS_COMMANDS.
+ *
+ * @return Number of bytes read.
+ */
+size_t profiler_nordic_backend_command_read(uint8_t *data, size_t len);
+
+/** Send the system description using the backend's info channel.
+ *
+ * Implemented by the Nordic profiler. Backends without a command channel
+ * call it when the host needs the description.
+ */
+void profiler_nordic_system_description_send(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PROFILER_NORDIC_BACKEND_H_ */
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <stdio.h>
+#include <zephyr.h>
+#include "soc.h"
+
+#include "profiler_nordic_backend.h"
+
+/* Backend for the native_posix board. Event data is written to a binary
+ * file and the system description to a text file when the executable
+ * exits. Both files can be processed by the host tools.
+ */
+
+static FILE *data_file;
+static FILE *info_file;
+
+
+int profiler_nordic_backend_init(void)
+{
+	data_file = fopen(CONFIG_PROFILER_NORDIC_BACKEND_FILE_DATA_PATH, "wb");
+	if (!data_file) {
+		return -EIO;
+	}
+
+	return 0;
+}
+
+bool profiler_nordic_backend_data_write(const uint8_t *data, size_t len)
+{
+	if (!data_file) {
+		return false;
+	}
+
+	return fwrite(data, 1, len, data_file) == len;
+}
+
+int profiler_nordic_backend_info_write(const char *data, size_t len)
+{
+	if (!info_file) {
+		return -EIO;
+	}
+
+	if (fwrite(data, 1, len, info_file) != len) {
+		return -EIO;
+	}
+
+	return 0;
+}
+
+size_t profiler_nordic_backend_command_read(uint8_t *data, size_t len)
+{
+	return 0;
+}
+
+static void backend_file_cleanup(void)
+{
+	if (!data_file) {
+		return;
+	}
+
+	fclose(data_file);
+	data_file = NULL;
+
+	info_file = fopen(CONFIG_PROFILER_NORDIC_BACKEND_FILE_INFO_PATH, "w");
+	if (info_file) {
+		profiler_nordic_system_description_send();
+		fclose(info_file);
+		info_file = NULL;
+	}
+}
+
+NATIVE_TASK(backend_file_cleanup, ON_EXIT, 1);
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <sys/ring_buffer.h>
+#include <shell/shell.h>
+
+#include "profiler_nordic_backend.h"
+
+/* Number of data bytes printed in a single line of the dump. */
+#define DUMP_LINE_BYTES		32
+
+/* The ring buffer is not lock-free. Events are produced with interrupts
+ * locked and the shell dump command locks interrupts as well while it takes
+ * the data out of the ring buffer, so the buffer is never accessed
+ * concurrently.
+ */
+RING_BUF_DECLARE(data_ring, CONFIG_PROFILER_NORDIC_BACKEND_RAM_BUFFER_SIZE);
+
+static const struct shell *dump_shell;
+
+
+int profiler_nordic_backend_init(void)
+{
+	return 0;
+}
+
+bool profiler_nordic_backend_data_write(const uint8_t *data, size_t len)
+{
+	if (ring_buf_space_get(&data_ring) < len) {
+		return false;
+	}
+
+	uint32_t written = ring_buf_put(&data_ring, data, len);
+
+	__ASSERT_NO_MSG(written == len);
+	ARG_UNUSED(written);
+
+	return true;
+}
+
+int profiler_nordic_backend_info_write(const char *data, size_t len)
+{
+	if (!dump_shell) {
+		return -EIO;
+	}
+
+	shell_fprintf(dump_shell, SHELL_NORMAL, "%.*s", (int)len, data);
+
+	return 0;
+}
+
+size_t profiler_nordic_backend_command_read(uint8_t *data, size_t len)
+{
+	return 0;
+}
+
+static int dump_data(const struct shell *shell, size_t argc, char **argv)
+{
+	uint8_t buf[DUMP_LINE_BYTES];
+	char line[2 * DUMP_LINE_BYTES + 1];
+	uint32_t len;
+	int key;
+
+	/* The dump is parsed by the host tools. Event type descriptions are
+	 * printed first, followed by the binary event data in hex format.
+	 */
+	shell_print(shell, "profiler_info_start");
+	dump_shell = shell;
+	profiler_nordic_system_description_send();
+	dump_shell = NULL;
+
+	shell_print(shell, "profiler_data_start");
+	while (true) {
+		key = irq_lock();
+		len = ring_buf_get(&data_ring, buf, sizeof(buf));
+		irq_unlock(key);
+
+		if (len == 0) {
+			break;
+		}
+
+		for (size_t i = 0; i < len; i++) {
+			snprintk(&line[2 * i], 3, "%02x", buf[i]);
+		}
+		shell_print(shell, "%s", line);
+	}
+	shell_print(shell, "profiler_data_end");
+
+	return 0;
+}
+
+SHELL_CMD_REGISTER(profiler_dump, NULL,
+		   "Dump events stored by profiler in RAM", dump_data);
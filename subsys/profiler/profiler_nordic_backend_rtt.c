@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <SEGGER_RTT.h>
+
+#include "profiler_nordic_backend.h"
+
+
+static uint8_t buffer_data[CONFIG_PROFILER_NORDIC_DATA_BUFFER_SIZE];
+static uint8_t buffer_info[CONFIG_PROFILER_NORDIC_INFO_BUFFER_SIZE];
+static uint8_t buffer_commands[CONFIG_PROFILER_NORDIC_COMMAND_BUFFER_SIZE];
+
+int profiler_nordic_backend_init(void)
+{
+	int ret;
+
+	ret = SEGGER_RTT_ConfigUpBuffer(
+		CONFIG_PROFILER_NORDIC_RTT_CHANNEL_DATA,
+		"Nordic profiler data",
+		buffer_data,
+		CONFIG_PROFILER_NORDIC_DATA_BUFFER_SIZE,
+		SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+	__ASSERT_NO_MSG(ret >= 0);
+
+	ret = SEGGER_RTT_ConfigUpBuffer(
+		CONFIG_PROFILER_NORDIC_RTT_CHANNEL_INFO,
+		"Nordic profiler info",
+		buffer_info,
+		CONFIG_PROFILER_NORDIC_INFO_BUFFER_SIZE,
+		SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+	__ASSERT_NO_MSG(ret >= 0);
+
+	ret = SEGGER_RTT_ConfigDownBuffer(
+		CONFIG_PROFILER_NORDIC_RTT_CHANNEL_COMMANDS,
+		"Nordic profiler command",
+		buffer_commands,
+		CONFIG_PROFILER_NORDIC_COMMAND_BUFFER_SIZE,
+		SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+	__ASSERT_NO_MSG(ret >= 0);
+
+	return 0;
+}
+
+bool profiler_nordic_backend_data_write(const uint8_t *data, size_t len)
+{
+	/* In SEGGER_RTT_MODE_NO_BLOCK_SKIP mode, data is written only if
+	 * it fits in the buffer.
+	 */
+	return SEGGER_RTT_WriteNoLock(CONFIG_PROFILER_NORDIC_RTT_CHANNEL_DATA,
+				      data, len) > 0;
+}
+
+int profiler_nordic_backend_info_write(const char *data, size_t len)
+{
+	uint8_t retry_cnt = 0;
+	static const uint8_t retry_cnt_max = 100;
+
+	size_t num_bytes_send;
+
+	num_bytes_send = SEGGER_RTT_WriteNoLock(
+				  CONFIG_PROFILER_NORDIC_RTT_CHANNEL_INFO,
+				  data, len);
+
+	while (num_bytes_send == 0) {
+		/* Give host time to read the data and free some space
+		 * in the buffer. */
+		k_sleep(K_MSEC(100));
+		num_bytes_send = SEGGER_RTT_WriteNoLock(
+				  CONFIG_PROFILER_NORDIC_RTT_CHANNEL_INFO,
+				  data, len);
+
+		/* Avoid being blocked in while loop if host does not read
+		 * the RTT data.
+		 */
+		retry_cnt++;
+		if (retry_cnt > retry_cnt_max) {
+			return -ENOBUFS;
+		}
+	}
+
+	return 0;
+}
+
+size_t profiler_nordic_backend_command_read(uint8_t *data, size_t len)
+{
+	return SEGGER_RTT_Read(CONFIG_PROFILER_NORDIC_RTT_CHANNEL_COMMANDS,
+			       data, len);
+}
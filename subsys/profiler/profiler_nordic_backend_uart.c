@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <device.h>
+#include <drivers/uart.h>
+#include <sys/ring_buffer.h>
+
+#include "profiler_nordic_backend.h"
+
+/* Data and info channels share the UART. Every write is sent as a frame
+ * consisting of a channel ID, payload length and the payload.
+ */
+#define FRAME_HEADER_SIZE	2
+#define FRAME_MAX_PAYLOAD	UINT8_MAX
+
+enum frame_channel {
+	FRAME_CHANNEL_DATA	= 1,
+	FRAME_CHANNEL_INFO	= 2,
+};
+
+RING_BUF_DECLARE(tx_ring, CONFIG_PROFILER_NORDIC_BACKEND_UART_TX_BUFFER_SIZE);
+RING_BUF_DECLARE(rx_ring, CONFIG_PROFILER_NORDIC_COMMAND_BUFFER_SIZE);
+
+static const struct device *uart_dev;
+
+
+static void handle_tx_ready(const struct device *dev)
+{
+	uint8_t *data;
+	uint32_t len;
+	int sent;
+
+	len = ring_buf_get_claim(&tx_ring, &data, UINT32_MAX);
+	if (len == 0) {
+		uart_irq_tx_disable(dev);
+		return;
+	}
+
+	sent = uart_fifo_fill(dev, data, len);
+	ring_buf_get_finish(&tx_ring, MAX(sent, 0));
+}
+
+static void handle_rx_ready(const struct device *dev)
+{
+	uint8_t byte;
+
+	while (uart_fifo_read(dev, &byte, sizeof(byte)) > 0) {
+		/* Commands that do not fit are dropped. */
+		(void)ring_buf_put(&rx_ring, &byte, sizeof(byte));
+	}
+}
+
+static void uart_isr(const struct device *dev, void *user_data)
+{
+	ARG_UNUSED(user_data);
+
+	while (uart_irq_update(dev) && uart_irq_is_pending(dev)) {
+		if (uart_irq_rx_ready(dev)) {
+			handle_rx_ready(dev);
+		}
+
+		if (uart_irq_tx_ready(dev)) {
+			handle_tx_ready(dev);
+		}
+	}
+}
+
+static bool frame_put(enum frame_channel channel, const uint8_t *data,
+		      size_t len)
+{
+	uint8_t header[FRAME_HEADER_SIZE] = {channel, len};
+	bool written = false;
+	int key = irq_lock();
+
+	__ASSERT_NO_MSG(len <= FRAME_MAX_PAYLOAD);
+
+	if (ring_buf_space_get(&tx_ring) >= sizeof(header) + len) {
+		ring_buf_put(&tx_ring, header, sizeof(header));
+		ring_buf_put(&tx_ring, data, len);
+		uart_irq_tx_enable(uart_dev);
+		written = true;
+	}
+
+	irq_unlock(key);
+
+	return written;
+}
+
+int profiler_nordic_backend_init(void)
+{
+	uart_dev = device_get_binding(
+			CONFIG_PROFILER_NORDIC_BACKEND_UART_DEV_NAME);
+	if (!uart_dev) {
+		return -ENXIO;
+	}
+
+	uart_irq_callback_user_data_set(uart_dev, uart_isr, NULL);
+	uart_irq_rx_enable(uart_dev);
+
+	return 0;
+}
+
+bool profiler_nordic_backend_data_write(const uint8_t *data, size_t len)
+{
+	return frame_put(FRAME_CHANNEL_DATA, data, len);
+}
+
+int profiler_nordic_backend_info_write(const char *data, size_t len)
+{
+	uint8_t retry_cnt = 0;
+	static const uint8_t retry_cnt_max = 100;
+
+	while (len > 0) {
+		size_t frame_len = MIN(len, FRAME_MAX_PAYLOAD);
+
+		if (!frame_put(FRAME_CHANNEL_INFO, data, frame_len)) {
+			/* Give UART time to send the data and free some
+			 * space in the buffer.
+			 */
+			k_sleep(K_MSEC(10));
+
+			retry_cnt++;
+			if (retry_cnt > retry_cnt_max) {
+				return -ENOBUFS;
+			}
+			continue;
+		}
+
+		data += frame_len;
+		len -= frame_len;
+	}
+
+	return 0;
+}
+
+size_t profiler_nordic_backend_command_read(uint8_t *data, size_t len)
+{
+	int key = irq_lock();
+	size_t read = ring_buf_get(&rx_ring, data, len);
+
+	irq_unlock(key);
+
+	return read;
+}
@@ -11,13 +11,15 @@
 
 /* By default, when there is no shell, all events are profiled. */
 #ifndef CONFIG_SHELL
-uint32_t profiler_enabled_events = 0xffffffff;
+uint32_t profiler_enabled_events[PROFILER_ENABLED_EVENTS_WORDS] = {
+	[0 ... (PROFILER_ENABLED_EVENTS_WORDS - 1)] = 0xffffffff
+};
 #endif
 
 static char descr[CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS]
 		 [CONFIG_MAX_LENGTH_OF_CUSTOM_EVENTS_DESCRIPTIONS];
 
-uint8_t profiler_num_events;
+uint16_t profiler_num_events;
 
 static char *arg_types_encodings[] = {
 					"%u",	/* uint8_t */
@@ -89,6 +91,7 @@ uint16_t profiler_register_event_type(const char *name, const char **args,
 	k_sched_lock();
 	uint32_t ne = events.NumEvents;
 
+	__ASSERT_NO_MSG(ne < CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS);
 	size_t temp = snprintf(descr[ne],
 			CONFIG_MAX_LENGTH_OF_CUSTOM_EVENTS_DESCRIPTIONS,
 			"%u %s", ne, name);
@@ -133,6 +136,43 @@ void profiler_log_encode_u32(struct log_event_buf *buf, uint32_t data)
 	buf->payload = SEGGER_SYSVIEW_EncodeU32(buf->payload, data);
 }
 
+void profiler_log_encode_u8(struct log_event_buf *buf, uint8_t data)
+{
+	profiler_log_encode_u32(buf, data);
+}
+
+void profiler_log_encode_s8(struct log_event_buf *buf, int8_t data)
+{
+	profiler_log_encode_u32(buf, (uint32_t)data);
+}
+
+void profiler_log_encode_u16(struct log_event_buf *buf, uint16_t data)
+{
+	profiler_log_encode_u32(buf, data);
+}
+
+void profiler_log_encode_s16(struct log_event_buf *buf, int16_t data)
+{
+	profiler_log_encode_u32(buf, (uint32_t)data);
+}
+
+void profiler_log_encode_s32(struct log_event_buf *buf, int32_t data)
+{
+	profiler_log_encode_u32(buf, (uint32_t)data);
+}
+
+void profiler_log_encode_string(struct log_event_buf *buf, const char *string)
+{
+	/* SysView encodes the string length in one byte. */
+	size_t max_len = CONFIG_PROFILER_CUSTOM_EVENT_BUF_LEN -
+			 (buf->payload - buf->payload_start) - 1;
+
+	__ASSERT_NO_MSG(buf->payload - buf->payload_start + 1
+		 <= CONFIG_PROFILER_CUSTOM_EVENT_BUF_LEN);
+	buf->payload = SEGGER_SYSVIEW_EncodeString(buf->payload, string,
+						   max_len);
+}
+
 void profiler_log_add_mem_address(struct log_event_buf *buf,
 				  const void *event_mem_address)
 {
@@ -0,0 +1,485 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/* Throughput and latency benchmark of the cryptographic operations.
+ *
+ * Every result is printed as a single line starting with BENCH_TAG,
+ * followed by a JSON object, so that it can be extracted from the log:
+ *
+ * BENCH {"backend":"oberon","alg":"sha256","op":"hash","size":1024,...}
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <kernel.h>
+#include <sys/printk.h>
+
+#include <common_test.h>
+
+#include <mbedtls/ccm.h>
+#include <mbedtls/gcm.h>
+#include <mbedtls/chachapoly.h>
+#include <mbedtls/sha256.h>
+#include <mbedtls/sha512.h>
+#include <mbedtls/md.h>
+#include <mbedtls/ecdh.h>
+#include <mbedtls/ecdsa.h>
+
+#if defined(CONFIG_BOARD_NATIVE_POSIX)
+#include <time.h>
+#endif
+
+#define BENCH_TAG "BENCH"
+
+#define BENCH_MIN_TIME_NS ((uint64_t)CONFIG_CRYPTO_TEST_BENCHMARK_MIN_TIME_MS * \
+			   NSEC_PER_MSEC)
+#define BENCH_MAX_ITERATIONS CONFIG_CRYPTO_TEST_BENCHMARK_MAX_ITERATIONS
+
+#define BENCH_BUF_SIZE 4096
+#define BENCH_KEY_SIZE 32
+#define BENCH_NONCE_SIZE 12
+#define BENCH_CCM_NONCE_SIZE 13
+#define BENCH_TAG_SIZE 16
+#define BENCH_HASH_SIZE 32
+
+static const size_t msg_sizes[] = {16, 64, 256, 1024, BENCH_BUF_SIZE};
+
+static uint8_t m_in[BENCH_BUF_SIZE];
+static uint8_t m_out[BENCH_BUF_SIZE];
+static uint8_t m_dec[BENCH_BUF_SIZE];
+static uint8_t m_key[BENCH_KEY_SIZE];
+static uint8_t m_nonce[BENCH_CCM_NONCE_SIZE];
+static uint8_t m_tag[BENCH_TAG_SIZE];
+static uint8_t m_digest[MBEDTLS_MD_MAX_SIZE];
+
+typedef int (*bench_fn_t)(void *ctx, size_t size);
+
+static const char *backend_name(void)
+{
+	if (IS_ENABLED(CONFIG_CC3XX_BACKEND) &&
+	    (IS_ENABLED(CONFIG_OBERON_BACKEND) ||
+	     IS_ENABLED(CONFIG_MBEDTLS_VANILLA_BACKEND))) {
+		return "multi";
+	} else if (IS_ENABLED(CONFIG_CC3XX_BACKEND)) {
+		return "cc3xx";
+	} else if (IS_ENABLED(CONFIG_OBERON_BACKEND) &&
+		   IS_ENABLED(CONFIG_MBEDTLS_VANILLA_BACKEND)) {
+		return "oberon_vanilla";
+	} else if (IS_ENABLED(CONFIG_OBERON_BACKEND)) {
+		return "oberon";
+	}
+
+	return "vanilla";
+}
+
+/* On native_posix code runs in zero simulated time, use the host clock. */
+#if defined(CONFIG_BOARD_NATIVE_POSIX)
+typedef uint64_t bench_time_t;
+
+static bench_time_t bench_time_get(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static uint64_t bench_time_ns(bench_time_t start)
+{
+	return bench_time_get() - start;
+}
+#else
+typedef uint32_t bench_time_t;
+
+static bench_time_t bench_time_get(void)
+{
+	return k_cycle_get_32();
+}
+
+static uint64_t bench_time_ns(bench_time_t start)
+{
+	return k_cyc_to_ns_floor64(k_cycle_get_32() - start);
+}
+#endif /* CONFIG_BOARD_NATIVE_POSIX */
+
+/* Run the operation until the minimum time or the maximum number of
+ * iterations is reached, and print the average latency and the throughput.
+ * The whole loop is timed, as a single operation can be shorter than
+ * the resolution of the system clock.
+ * The size is zero for operations that do not process a message.
+ */
+static void bench_run(const char *alg, const char *op, bench_fn_t fn,
+		      void *ctx, size_t size)
+{
+	uint64_t total_ns = 0;
+	uint32_t iterations = 0;
+	bench_time_t start;
+	int err;
+
+	/* Warm-up run, not measured. */
+	err = fn(ctx, size);
+	zassert_equal(err, 0, "%s %s failed: -0x%04X", alg, op, -err);
+
+	start = bench_time_get();
+
+	while ((total_ns < BENCH_MIN_TIME_NS) &&
+	       (iterations < BENCH_MAX_ITERATIONS)) {
+		err = fn(ctx, size);
+		zassert_equal(err, 0, "%s %s failed: -0x%04X", alg, op, -err);
+
+		iterations++;
+		total_ns = bench_time_ns(start);
+	}
+
+	uint64_t avg_ns = total_ns / iterations;
+	uint64_t kib_per_s = 0;
+
+	if (size && total_ns) {
+		kib_per_s = ((uint64_t)size * iterations * NSEC_PER_SEC) /
+			    (total_ns * 1024);
+	}
+
+	printk(BENCH_TAG " {\"backend\":\"%s\",\"alg\":\"%s\",\"op\":\"%s\","
+	       "\"size\":%u,\"iterations\":%u,\"total_ns\":%llu,"
+	       "\"avg_ns\":%llu,\"kib_per_s\":%llu}\n",
+	       backend_name(), alg, op, (unsigned int)size, iterations,
+	       (unsigned long long)total_ns, (unsigned long long)avg_ns,
+	       (unsigned long long)kib_per_s);
+}
+
+static void bench_setup(void)
+{
+	for (size_t i = 0; i < sizeof(m_in); i++) {
+		m_in[i] = (uint8_t)i;
+	}
+
+	memset(m_key, 0xA5, sizeof(m_key));
+	memset(m_nonce, 0x5A, sizeof(m_nonce));
+}
+
+static void test_bench_state_reset(void)
+{
+	/* Reallocate the heap to avoid the fragmentation left by the
+	 * previous suites, and seed the DRBG used for the EC operations.
+	 */
+	_heap_free();
+	_heap_init();
+
+	zassert_equal(init_drbg(NULL, 0), 0, "Cannot initialize DRBG");
+
+	bench_setup();
+}
+
+#if defined(MBEDTLS_CCM_C)
+static int ccm_encrypt(void *ctx, size_t size)
+{
+	return mbedtls_ccm_encrypt_and_tag(ctx, size, m_nonce,
+					   BENCH_CCM_NONCE_SIZE, NULL, 0,
+					   m_in, m_out, m_tag, BENCH_TAG_SIZE);
+}
+
+static int ccm_decrypt(void *ctx, size_t size)
+{
+	return mbedtls_ccm_auth_decrypt(ctx, size, m_nonce,
+					BENCH_CCM_NONCE_SIZE, NULL, 0,
+					m_out, m_dec, m_tag, BENCH_TAG_SIZE);
+}
+
+static void test_bench_aes_ccm(void)
+{
+	mbedtls_ccm_context ctx;
+
+	mbedtls_ccm_init(&ctx);
+	zassert_equal(mbedtls_ccm_setkey(&ctx, MBEDTLS_CIPHER_ID_AES, m_key,
+					 128), 0, "Cannot set key");
+
+	for (size_t i = 0; i < ARRAY_SIZE(msg_sizes); i++) {
+		bench_run("aes128_ccm", "encrypt", ccm_encrypt, &ctx,
+			  msg_sizes[i]);
+		bench_run("aes128_ccm", "decrypt", ccm_decrypt, &ctx,
+			  msg_sizes[i]);
+	}
+
+	mbedtls_ccm_free(&ctx);
+}
+#else
+static void test_bench_aes_ccm(void)
+{
+	ztest_test_skip();
+}
+#endif /* MBEDTLS_CCM_C */
+
+#if defined(MBEDTLS_GCM_C)
+static int gcm_encrypt(void *ctx, size_t size)
+{
+	return mbedtls_gcm_crypt_and_tag(ctx, MBEDTLS_GCM_ENCRYPT, size,
+					 m_nonce, BENCH_NONCE_SIZE, NULL, 0,
+					 m_in, m_out, BENCH_TAG_SIZE, m_tag);
+}
+
+static int gcm_decrypt(void *ctx, size_t size)
+{
+	return mbedtls_gcm_auth_decrypt(ctx, size, m_nonce, BENCH_NONCE_SIZE,
+					NULL, 0, m_tag, BENCH_TAG_SIZE, m_out,
+					m_dec);
+}
+
+static void test_bench_aes_gcm(void)
+{
+	mbedtls_gcm_context ctx;
+
+	mbedtls_gcm_init(&ctx);
+	zassert_equal(mbedtls_gcm_setkey(&ctx, MBEDTLS_CIPHER_ID_AES, m_key,
+					 128), 0, "Cannot set key");
+
+	for (size_t i = 0; i < ARRAY_SIZE(msg_sizes); i++) {
+		bench_run("aes128_gcm", "encrypt", gcm_encrypt, &ctx,
+			  msg_sizes[i]);
+		bench_run("aes128_gcm", "decrypt", gcm_decrypt, &ctx,
+			  msg_sizes[i]);
+	}
+
+	mbedtls_gcm_free(&ctx);
+}
+#else
+static void test_bench_aes_gcm(void)
+{
+	ztest_test_skip();
+}
+#endif /* MBEDTLS_GCM_C */
+
+#if defined(MBEDTLS_CHACHAPOLY_C)
+static int chachapoly_encrypt(void *ctx, size_t size)
+{
+	return mbedtls_chachapoly_encrypt_and_tag(ctx, size, m_nonce, NULL, 0,
+						  m_in, m_out, m_tag);
+}
+
+static int chachapoly_decrypt(void *ctx, size_t size)
+{
+	return mbedtls_chachapoly_auth_decrypt(ctx, size, m_nonce, NULL, 0,
+					       m_tag, m_out, m_dec);
+}
+
+static void test_bench_chachapoly(void)
+{
+	mbedtls_chachapoly_context ctx;
+
+	mbedtls_chachapoly_init(&ctx);
+	zassert_equal(mbedtls_chachapoly_setkey(&ctx, m_key), 0,
+		      "Cannot set key");
+
+	for (size_t i = 0; i < ARRAY_SIZE(msg_sizes); i++) {
+		bench_run("chachapoly", "encrypt", chachapoly_encrypt, &ctx,
+			  msg_sizes[i]);
+		bench_run("chachapoly", "decrypt", chachapoly_decrypt, &ctx,
+			  msg_sizes[i]);
+	}
+
+	mbedtls_chachapoly_free(&ctx);
+}
+#else
+static void test_bench_chachapoly(void)
+{
+	ztest_test_skip();
+}
+#endif /* MBEDTLS_CHACHAPOLY_C */
+
+#if defined(CONFIG_CRYPTO_TEST_HASH) && defined(MBEDTLS_SHA256_C)
+static int sha256_hash(void *ctx, size_t size)
+{
+	return mbedtls_sha256_ret(m_in, size, m_digest, 0);
+}
+
+static void test_bench_sha256(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(msg_sizes); i++) {
+		bench_run("sha256", "hash", sha256_hash, NULL, msg_sizes[i]);
+	}
+}
+#else
+static void test_bench_sha256(void)
+{
+	ztest_test_skip();
+}
+#endif /* CONFIG_CRYPTO_TEST_HASH && MBEDTLS_SHA256_C */
+
+#if defined(CONFIG_CRYPTO_TEST_HASH) && defined(MBEDTLS_SHA512_C)
+static int sha512_hash(void *ctx, size_t size)
+{
+	return mbedtls_sha512_ret(m_in, size, m_digest, 0);
+}
+
+static void test_bench_sha512(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(msg_sizes); i++) {
+		bench_run("sha512", "hash", sha512_hash, NULL, msg_sizes[i]);
+	}
+}
+#else
+static void test_bench_sha512(void)
+{
+	ztest_test_skip();
+}
+#endif /* CONFIG_CRYPTO_TEST_HASH && MBEDTLS_SHA512_C */
+
+#if defined(CONFIG_CRYPTO_TEST_HASH) && defined(MBEDTLS_MD_C) && \
+	defined(MBEDTLS_SHA256_C)
+static int hmac_sha256(void *ctx, size_t size)
+{
+	return mbedtls_md_hmac(ctx, m_key, sizeof(m_key), m_in, size,
+			       m_digest);
+}
+
+static void test_bench_hmac(void)
+{
+	const mbedtls_md_info_t *md_info =
+		mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
+
+	zassert_not_null(md_info, "SHA-256 not available");
+
+	for (size_t i = 0; i < ARRAY_SIZE(msg_sizes); i++) {
+		bench_run("hmac_sha256", "mac", hmac_sha256, (void *)md_info,
+			  msg_sizes[i]);
+	}
+}
+#else
+static void test_bench_hmac(void)
+{
+	ztest_test_skip();
+}
+#endif /* CONFIG_CRYPTO_TEST_HASH && MBEDTLS_MD_C && MBEDTLS_SHA256_C */
+
+#if defined(MBEDTLS_ECDH_C) && defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
+struct ecdh_bench {
+	mbedtls_ecp_group grp;
+	mbedtls_mpi d;
+	mbedtls_ecp_point q;
+	mbedtls_mpi peer_d;
+	mbedtls_ecp_point peer_q;
+	mbedtls_mpi z;
+};
+
+static int ecdh_gen_public(void *ctx, size_t size)
+{
+	struct ecdh_bench *b = ctx;
+
+	return mbedtls_ecdh_gen_public(&b->grp, &b->d, &b->q, drbg_random,
+				       &drbg_ctx);
+}
+
+static int ecdh_compute_shared(void *ctx, size_t size)
+{
+	struct ecdh_bench *b = ctx;
+
+	return mbedtls_ecdh_compute_shared(&b->grp, &b->z, &b->peer_q, &b->d,
+					   drbg_random, &drbg_ctx);
+}
+
+static void test_bench_ecdh(void)
+{
+	static struct ecdh_bench b;
+
+	mbedtls_ecp_group_init(&b.grp);
+	mbedtls_mpi_init(&b.d);
+	mbedtls_ecp_point_init(&b.q);
+	mbedtls_mpi_init(&b.peer_d);
+	mbedtls_ecp_point_init(&b.peer_q);
+	mbedtls_mpi_init(&b.z);
+
+	zassert_equal(mbedtls_ecp_group_load(&b.grp, MBEDTLS_ECP_DP_SECP256R1),
+		      0, "Cannot load group");
+	zassert_equal(mbedtls_ecdh_gen_public(&b.grp, &b.peer_d, &b.peer_q,
+					      drbg_random, &drbg_ctx),
+		      0, "Cannot generate peer key");
+
+	bench_run("ecdh_secp256r1", "gen_public", ecdh_gen_public, &b, 0);
+	bench_run("ecdh_secp256r1", "compute_shared", ecdh_compute_shared,
+		  &b, 0);
+
+	mbedtls_mpi_free(&b.z);
+	mbedtls_ecp_point_free(&b.peer_q);
+	mbedtls_mpi_free(&b.peer_d);
+	mbedtls_ecp_point_free(&b.q);
+	mbedtls_mpi_free(&b.d);
+	mbedtls_ecp_group_free(&b.grp);
+}
+#else
+static void test_bench_ecdh(void)
+{
+	ztest_test_skip();
+}
+#endif /* MBEDTLS_ECDH_C && MBEDTLS_ECP_DP_SECP256R1_ENABLED */
+
+#if defined(MBEDTLS_ECDSA_C) && defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
+struct ecdsa_bench {
+	mbedtls_ecdsa_context key;
+	mbedtls_mpi r;
+	mbedtls_mpi s;
+};
+
+static int ecdsa_sign(void *ctx, size_t size)
+{
+	struct ecdsa_bench *b = ctx;
+
+	return mbedtls_ecdsa_sign(&b->key.grp, &b->r, &b->s, &b->key.d,
+				  m_digest, BENCH_HASH_SIZE, drbg_random,
+				  &drbg_ctx);
+}
+
+static int ecdsa_verify(void *ctx, size_t size)
+{
+	struct ecdsa_bench *b = ctx;
+
+	return mbedtls_ecdsa_verify(&b->key.grp, m_digest, BENCH_HASH_SIZE,
+				    &b->key.Q, &b->r, &b->s);
+}
+
+static void test_bench_ecdsa(void)
+{
+	static struct ecdsa_bench b;
+
+	mbedtls_ecdsa_init(&b.key);
+	mbedtls_mpi_init(&b.r);
+	mbedtls_mpi_init(&b.s);
+
+	memset(m_digest, 0x3C, BENCH_HASH_SIZE);
+
+	zassert_equal(mbedtls_ecdsa_genkey(&b.key, MBEDTLS_ECP_DP_SECP256R1,
+					   drbg_random, &drbg_ctx),
+		      0, "Cannot generate key");
+
+	bench_run("ecdsa_secp256r1", "sign", ecdsa_sign, &b, 0);
+	bench_run("ecdsa_secp256r1", "verify", ecdsa_verify, &b, 0);
+
+	mbedtls_mpi_free(&b.s);
+	mbedtls_mpi_free(&b.r);
+	mbedtls_ecdsa_free(&b.key);
+}
+#else
+static void test_bench_ecdsa(void)
+{
+	ztest_test_skip();
+}
+#endif /* MBEDTLS_ECDSA_C && MBEDTLS_ECP_DP_SECP256R1_ENABLED */
+
+void run_benchmarks(void)
+{
+	ztest_test_suite(crypto_benchmark,
+			 ztest_unit_test(test_bench_state_reset),
+			 ztest_unit_test(test_bench_aes_ccm),
+			 ztest_unit_test(test_bench_aes_gcm),
+			 ztest_unit_test(test_bench_chachapoly),
+			 ztest_unit_test(test_bench_sha256),
+			 ztest_unit_test(test_bench_sha512),
+			 ztest_unit_test(test_bench_hmac),
+			 ztest_unit_test(test_bench_ecdh),
+			 ztest_unit_test(test_bench_ecdsa));
+
+	ztest_run_test_suite(crypto_benchmark);
+}
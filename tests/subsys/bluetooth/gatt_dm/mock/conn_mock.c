@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+#include <bluetooth/bluetooth.h>
+#include <bluetooth/conn.h>
+#include <kernel.h>
+
+
+static bt_addr_le_t peer_addr;
+
+void bt_conn_mock_peer_set(const bt_addr_le_t *peer)
+{
+	bt_addr_le_copy(&peer_addr, peer);
+}
+
+/* The dummy connection object used by the tests is not reference counted */
+struct bt_conn *__wrap_bt_conn_ref(struct bt_conn *conn)
+{
+	return conn;
+}
+
+void __wrap_bt_conn_unref(struct bt_conn *conn)
+{
+}
+
+int __wrap_bt_conn_get_info(const struct bt_conn *conn,
+			    struct bt_conn_info *info)
+{
+	memset(info, 0, sizeof(*info));
+	info->type = BT_CONN_TYPE_LE;
+	info->id = BT_ID_DEFAULT;
+	info->le.dst = &peer_addr;
+
+	return 0;
+}
+
+/* Only the connected peer is bonded */
+void __wrap_bt_foreach_bond(uint8_t id,
+			    void (*func)(const struct bt_bond_info *info,
+					 void *user_data),
+			    void *user_data)
+{
+	struct bt_bond_info info;
+
+	if ((id != BT_ID_DEFAULT) ||
+	    !bt_addr_le_cmp(&peer_addr, BT_ADDR_LE_ANY)) {
+		return;
+	}
+
+	bt_addr_le_copy(&info.addr, &peer_addr);
+	func(&info, user_data);
+}
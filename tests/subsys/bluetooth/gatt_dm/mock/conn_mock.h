@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef BT_CONN_MOCK_H_
+#define BT_CONN_MOCK_H_
+
+#include <bluetooth/addr.h>
+
+
+/**
+ * @file
+ * @defgroup bt_conn_mock API
+ * @{
+ * @brief The API used to setup the mock for the connection functions
+ *
+ * The connection functions are replaced using the linker --wrap option,
+ * so the tests can use a dummy connection object.
+ */
+
+/**
+ * @brief Connection mock setup
+ *
+ * Sets the address of the peer that is connected and bonded.
+ * Previously set peers are no longer bonded.
+ *
+ * @param peer The identity address of the peer.
+ */
+void bt_conn_mock_peer_set(const bt_addr_le_t *peer);
+
+/** @} */
+#endif /* #define BT_CONN_MOCK_H_ */
@@ -5,6 +5,7 @@
  */
 #include <stdbool.h>
 #include <inttypes.h>
+#include <bluetooth/att.h>
 #include <bluetooth/gatt.h>
 #include <bluetooth/uuid.h>
 #include <kernel.h>
@@ -19,13 +20,35 @@ static struct bt_discover_mock {
 	struct bt_conn *conn;
 	struct bt_gatt_discover_params *params;
 	struct k_delayed_work work;
+	size_t call_cnt;
 } discover_mock_data;
 
+/* Settings of the read mock */
+static struct bt_read_mock {
+	const uint8_t *data;
+	size_t len;
+	struct bt_conn *conn;
+	struct bt_gatt_read_params *params;
+	struct k_delayed_work work;
+} read_mock_data;
+
 
 void bt_gatt_discover_mock_setup(const struct bt_gatt_attr *attr, size_t len)
 {
 	discover_mock_data.attr = attr;
 	discover_mock_data.len  = len;
+	discover_mock_data.call_cnt = 0;
+}
+
+size_t bt_gatt_discover_mock_call_cnt(void)
+{
+	return discover_mock_data.call_cnt;
+}
+
+void bt_gatt_read_mock_setup(const uint8_t *data, size_t len)
+{
+	read_mock_data.data = data;
+	read_mock_data.len  = len;
 }
 
 static bool bt_gatt_primary_check(const struct bt_gatt_attr *attr_cur,
@@ -125,8 +148,39 @@ int bt_gatt_discover(struct bt_conn *conn,
 	printk("Running %s mock\n", __func__);
 	discover_mock_data.conn = conn;
 	discover_mock_data.params = params;
+	discover_mock_data.call_cnt++;
 
 	k_delayed_work_init(&(discover_mock_data.work), bt_gatt_discover_work);
 	k_delayed_work_submit(&(discover_mock_data.work), K_MSEC(5));
 	return 0;
 }
+
+static void bt_gatt_read_work(struct k_work *work)
+{
+	struct bt_read_mock *mock_data =
+		CONTAINER_OF(work, struct bt_read_mock, work);
+
+	if (mock_data->data) {
+		(void)mock_data->params->func(mock_data->conn, 0,
+					      mock_data->params,
+					      mock_data->data,
+					      mock_data->len);
+	} else {
+		(void)mock_data->params->func(mock_data->conn,
+					      BT_ATT_ERR_ATTRIBUTE_NOT_FOUND,
+					      mock_data->params, NULL, 0);
+	}
+}
+
+/* Mocked version of the bt_gatt_read */
+/* Call the bt_gatt_read_mock_setup function first */
+int bt_gatt_read(struct bt_conn *conn, struct bt_gatt_read_params *params)
+{
+	printk("Running %s mock\n", __func__);
+	read_mock_data.conn = conn;
+	read_mock_data.params = params;
+
+	k_delayed_work_init(&(read_mock_data.work), bt_gatt_read_work);
+	k_delayed_work_submit(&(read_mock_data.work), K_MSEC(5));
+	return 0;
+}
@@ -90,5 +90,25 @@
  */
 void bt_gatt_discover_mock_setup(const struct bt_gatt_attr *attr, size_t len);
 
+/**
+ * @brief Get the number of bt_gatt_discover calls
+ *
+ * @return Number of @ref bt_gatt_discover calls since the last
+ *         @ref bt_gatt_discover_mock_setup call.
+ */
+size_t bt_gatt_discover_mock_call_cnt(void);
+
+/**
+ * @brief GATT read mock setup
+ *
+ * This function setups the mock for @ref bt_gatt_read function.
+ * The mock responds to every read with the given value.
+ *
+ * @param data The value of the read attribute or NULL if the attribute
+ *             is not found.
+ * @param len  The size of the value.
+ */
+void bt_gatt_read_mock_setup(const uint8_t *data, size_t len);
+
 /** @} */
 #endif /* #define BT_GATT_DISCOVERY_MOCK_H_ */
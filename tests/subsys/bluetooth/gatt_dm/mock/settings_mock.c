@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+#include <string.h>
+#include <kernel.h>
+#include <settings/settings.h>
+#include <sys/util.h>
+
+#define ENTRY_CNT	4
+#define NAME_LEN	64
+#define VALUE_LEN	256
+
+static struct settings_mock_entry {
+	char name[NAME_LEN];
+	uint8_t value[VALUE_LEN];
+	size_t len;
+	bool used;
+} entries[ENTRY_CNT];
+
+static K_SEM_DEFINE(save_sem, 0, ENTRY_CNT);
+
+
+static struct settings_mock_entry *entry_find(const char *name)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(entries); i++) {
+		if (entries[i].used && !strcmp(entries[i].name, name)) {
+			return &entries[i];
+		}
+	}
+
+	return NULL;
+}
+
+void settings_mock_reset(void)
+{
+	memset(entries, 0, sizeof(entries));
+	k_sem_reset(&save_sem);
+}
+
+int settings_mock_wait_for_save(k_timeout_t timeout)
+{
+	return k_sem_take(&save_sem, timeout);
+}
+
+size_t settings_mock_entry_cnt(void)
+{
+	size_t cnt = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(entries); i++) {
+		if (entries[i].used) {
+			cnt++;
+		}
+	}
+
+	return cnt;
+}
+
+const uint8_t *settings_mock_entry_get(const char *name, size_t *len)
+{
+	struct settings_mock_entry *entry = entry_find(name);
+
+	if (!entry) {
+		return NULL;
+	}
+
+	*len = entry->len;
+
+	return entry->value;
+}
+
+static ssize_t entry_read(void *cb_arg, void *data, size_t len)
+{
+	struct settings_mock_entry *entry = cb_arg;
+
+	len = MIN(len, entry->len);
+	memcpy(data, entry->value, len);
+
+	return len;
+}
+
+int __wrap_settings_save_one(const char *name, const void *value,
+			     size_t val_len)
+{
+	struct settings_mock_entry *entry = entry_find(name);
+
+	for (size_t i = 0; !entry && (i < ARRAY_SIZE(entries)); i++) {
+		if (!entries[i].used) {
+			entry = &entries[i];
+		}
+	}
+
+	if (!entry || (strlen(name) >= NAME_LEN) || (val_len > VALUE_LEN)) {
+		return -ENOMEM;
+	}
+
+	strcpy(entry->name, name);
+	memcpy(entry->value, value, val_len);
+	entry->len = val_len;
+	entry->used = true;
+
+	k_sem_give(&save_sem);
+
+	return 0;
+}
+
+int __wrap_settings_delete(const char *name)
+{
+	struct settings_mock_entry *entry = entry_find(name);
+
+	if (entry) {
+		entry->used = false;
+	}
+
+	return 0;
+}
+
+int __wrap_settings_load_subtree_direct(const char *subtree,
+					settings_load_direct_cb cb,
+					void *param)
+{
+	size_t subtree_len = strlen(subtree);
+
+	for (size_t i = 0; i < ARRAY_SIZE(entries); i++) {
+		struct settings_mock_entry *entry = &entries[i];
+		const char *next;
+
+		if (!entry->used ||
+		    strncmp(entry->name, subtree, subtree_len)) {
+			continue;
+		}
+
+		if (entry->name[subtree_len] == '\0') {
+			next = NULL;
+		} else if (entry->name[subtree_len] == '/') {
+			next = &entry->name[subtree_len + 1];
+		} else {
+			continue;
+		}
+
+		if (cb(next, entry->len, entry_read, entry, param)) {
+			break;
+		}
+	}
+
+	return 0;
+}
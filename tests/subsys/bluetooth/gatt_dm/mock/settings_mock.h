@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef SETTINGS_MOCK_H_
+#define SETTINGS_MOCK_H_
+
+#include <kernel.h>
+
+
+/**
+ * @file
+ * @defgroup settings_mock API
+ * @{
+ * @brief The API used to setup the mock for the settings
+ *
+ * The settings functions are replaced using the linker --wrap option.
+ * The entries are stored in RAM.
+ */
+
+/**
+ * @brief Remove all the settings entries
+ */
+void settings_mock_reset(void);
+
+/**
+ * @brief Wait until an entry is stored
+ *
+ * @param timeout Waiting period.
+ *
+ * @retval 0 If an entry was stored.
+ * @retval -EAGAIN If the waiting period timed out.
+ */
+int settings_mock_wait_for_save(k_timeout_t timeout);
+
+/**
+ * @brief Get the number of stored entries
+ *
+ * @return Number of entries.
+ */
+size_t settings_mock_entry_cnt(void);
+
+/**
+ * @brief Get the value of an entry
+ *
+ * @param name Name of the entry.
+ * @param len  Pointer to the variable where the value length is stored.
+ *
+ * @return Pointer to the value or NULL if the entry is not found.
+ */
+const uint8_t *settings_mock_entry_get(const char *name, size_t *len);
+
+/** @} */
+#endif /* #define SETTINGS_MOCK_H_ */
@@ -10,6 +10,10 @@
 #include <bluetooth/uuid.h>
 #include <bluetooth/gatt_dm.h>
 #include "../mock/gatt_discover_mock.h"
+#include "../mock/conn_mock.h"
+#if CONFIG_BT_GATT_DM_CACHE
+#include "../mock/settings_mock.h"
+#endif
 
 /* Timeout for the discovery in ms */
 #define SERVICE_DISCOVERY_TIMEOUT 2000
@@ -376,6 +380,170 @@ void test_gatt_generic_serv(void)
 	/* No cleanup here - cleanup is done in run_dm_next */
 }
 
+#if CONFIG_BT_GATT_DM_CACHE
+
+/* Timeout for storing the discovery data in ms */
+#define CACHE_SAVE_TIMEOUT 1000
+/* Time after which no data is expected to be stored in ms */
+#define CACHE_NO_SAVE_TIMEOUT 100
+
+/* Settings key of the HIDS cached for peer_1 */
+#define CACHE_KEY_PEER_1_HIDS "gatt_dm/00010203040506/1812"
+/* Settings key of the DIS cached for peer_1 */
+#define CACHE_KEY_PEER_1_DIS "gatt_dm/00010203040506/180a"
+
+static const uint8_t db_hash_1[16] = { [0 ... 15] = 0x11 };
+static const uint8_t db_hash_2[16] = { [0 ... 15] = 0x22 };
+
+static const bt_addr_le_t peer_1 = {
+	.type = BT_ADDR_LE_PUBLIC,
+	.a.val = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06 },
+};
+
+static const bt_addr_le_t peer_2 = {
+	.type = BT_ADDR_LE_PUBLIC,
+	.a.val = { 0x06, 0x05, 0x04, 0x03, 0x02, 0x01 },
+};
+
+void test_cache_setup(void)
+{
+	test_setup();
+	settings_mock_reset();
+	bt_conn_mock_peer_set(&peer_1);
+	bt_gatt_read_mock_setup(db_hash_1, sizeof(db_hash_1));
+}
+
+void test_cache_teardown(void)
+{
+	bt_conn_mock_peer_set(BT_ADDR_LE_ANY);
+	bt_gatt_read_mock_setup(NULL, 0);
+}
+
+/* Runs HIDS discovery and checks if the service was discovered or
+ * restored from the cache.
+ */
+static void run_dm_hids_cached(bool discovery_expected)
+{
+	size_t discover_cnt = bt_gatt_discover_mock_call_cnt();
+	const struct bt_gatt_dm_attr *attr_chrc;
+	const struct bt_gatt_chrc *chrc_val;
+	struct bt_gatt_dm *dm = run_dm(BT_UUID_HIDS);
+
+	zassert_not_null(dm, "Device Manager pointer not set");
+
+	if (discovery_expected) {
+		zassert_true(bt_gatt_discover_mock_call_cnt() > discover_cnt,
+			     "Service not discovered");
+	} else {
+		zassert_equal(discover_cnt, bt_gatt_discover_mock_call_cnt(),
+			      "Service not restored from the cache");
+	}
+
+	zassert_equal(11,
+		      bt_gatt_dm_attr_cnt(dm),
+		      "Unexpected number of attributes detected: %d",
+		      bt_gatt_dm_attr_cnt(dm));
+
+	attr_chrc = bt_gatt_dm_char_by_uuid(dm, BT_UUID_HIDS_REPORT);
+	zassert_not_null(attr_chrc, "Unexpected NULL");
+	zassert_equal(6, attr_chrc->handle, "Unexpected handle: %d", attr_chrc->handle);
+	chrc_val = bt_gatt_dm_attr_chrc_val(attr_chrc);
+	zassert_not_null(chrc_val, "Unexpected NULL instead HIDS_REPORT value");
+	zassert_equal(BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY,
+		      chrc_val->properties,
+		      "Unexpected HIDS_REPORT properties");
+	zassert_not_null(bt_gatt_dm_desc_by_uuid(dm, attr_chrc, BT_UUID_GATT_CCC),
+			 "Unexpected NULL");
+
+	bt_gatt_dm_data_release(dm);
+}
+
+static void cache_save_wait(void)
+{
+	zassert_equal(0, settings_mock_wait_for_save(K_MSEC(CACHE_SAVE_TIMEOUT)),
+		      "Discovery data not stored");
+}
+
+static void cache_no_save_check(void)
+{
+	zassert_equal(-EAGAIN,
+		      settings_mock_wait_for_save(K_MSEC(CACHE_NO_SAVE_TIMEOUT)),
+		      "Unexpected discovery data stored");
+}
+
+void test_gatt_cache_miss(void)
+{
+	run_dm_hids_cached(true);
+	cache_save_wait();
+	zassert_equal(1, settings_mock_entry_cnt(), "Unexpected number of entries");
+}
+
+void test_gatt_cache_hit(void)
+{
+	run_dm_hids_cached(true);
+	cache_save_wait();
+
+	run_dm_hids_cached(false);
+	cache_no_save_check();
+}
+
+void test_gatt_cache_db_hash_changed(void)
+{
+	const uint8_t *data;
+	size_t len;
+
+	run_dm_hids_cached(true);
+	cache_save_wait();
+
+	/* Stored data is invalidated by the database hash change */
+	bt_gatt_read_mock_setup(db_hash_2, sizeof(db_hash_2));
+	run_dm_hids_cached(true);
+	cache_save_wait();
+
+	zassert_equal(1, settings_mock_entry_cnt(), "Unexpected number of entries");
+	data = settings_mock_entry_get(CACHE_KEY_PEER_1_HIDS, &len);
+	zassert_not_null(data, "Entry not found");
+	zassert_true(len > sizeof(db_hash_2), "Entry too short");
+	zassert_mem_equal(data, db_hash_2, sizeof(db_hash_2), "Hash not updated");
+
+	run_dm_hids_cached(false);
+}
+
+void test_gatt_cache_no_db_hash(void)
+{
+	bt_gatt_read_mock_setup(NULL, 0);
+
+	run_dm_hids_cached(true);
+	cache_no_save_check();
+}
+
+void test_gatt_cache_bond_deleted(void)
+{
+	size_t len;
+
+	run_dm_hids_cached(true);
+	cache_save_wait();
+
+	bt_gatt_dm_data_release(run_dm(BT_UUID_DIS));
+	cache_save_wait();
+	zassert_equal(2, settings_mock_entry_cnt(), "Unexpected number of entries");
+
+	/* Bond of peer_1 is removed, all of its data is deleted when data of
+	 * another peer is stored.
+	 */
+	bt_conn_mock_peer_set(&peer_2);
+	run_dm_hids_cached(true);
+	cache_save_wait();
+
+	zassert_equal(1, settings_mock_entry_cnt(), "Unexpected number of entries");
+	zassert_is_null(settings_mock_entry_get(CACHE_KEY_PEER_1_HIDS, &len),
+			"Data of the removed bond not deleted");
+	zassert_is_null(settings_mock_entry_get(CACHE_KEY_PEER_1_DIS, &len),
+			"Data of the removed bond not deleted");
+}
+
+#endif /* CONFIG_BT_GATT_DM_CACHE */
+
 void test_main(void)
 {
 	ztest_test_suite(
@@ -391,4 +559,17 @@ void test_main(void)
 	);
 
 	ztest_run_test_suite(test_gatt);
+
+#if CONFIG_BT_GATT_DM_CACHE
+	ztest_test_suite(
+		test_gatt_cache,
+		ztest_unit_test_setup_teardown(test_gatt_cache_miss, test_cache_setup, test_cache_teardown),
+		ztest_unit_test_setup_teardown(test_gatt_cache_hit, test_cache_setup, test_cache_teardown),
+		ztest_unit_test_setup_teardown(test_gatt_cache_db_hash_changed, test_cache_setup, test_cache_teardown),
+		ztest_unit_test_setup_teardown(test_gatt_cache_no_db_hash, test_cache_setup, test_cache_teardown),
+		ztest_unit_test_setup_teardown(test_gatt_cache_bond_deleted, test_cache_setup, test_cache_teardown)
+	);
+
+	ztest_run_test_suite(test_gatt_cache);
+#endif
 }
@@ -0,0 +1,296 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+#include <ztest.h>
+#include <kernel.h>
+#include <string.h>
+#include <sys/util.h>
+#include <bluetooth/bluetooth.h>
+#include <bluetooth/uuid.h>
+#include <bluetooth/scan.h>
+
+#define TEST_NAME "Test device"
+#define OTHER_NAME "Other device"
+
+static const bt_addr_le_t peer_addr = {
+	.type = BT_ADDR_LE_RANDOM,
+	.a = { .val = {0x01, 0x02, 0x03, 0x04, 0x05, 0xc6} },
+};
+
+static const bt_addr_le_t other_addr = {
+	.type = BT_ADDR_LE_RANDOM,
+	.a = { .val = {0x11, 0x12, 0x13, 0x14, 0x15, 0xd6} },
+};
+
+static struct bt_uuid_16 uuid_hrs = BT_UUID_INIT_16(0x180d);
+static struct bt_uuid_16 uuid_bas = BT_UUID_INIT_16(0x180f);
+
+/* The Heart Rate Service UUID built on the Bluetooth Base UUID. */
+static struct bt_uuid_128 uuid_hrs_128 = BT_UUID_INIT_128(
+	0xfb, 0x34, 0x9b, 0x5f, 0x80, 0x00, 0x00, 0x80,
+	0x00, 0x10, 0x00, 0x00, 0x0d, 0x18, 0x00, 0x00);
+
+/* Name and both UUIDs. */
+static const uint8_t adv_full[] = {
+	12, BT_DATA_NAME_COMPLETE,
+	'T', 'e', 's', 't', ' ', 'd', 'e', 'v', 'i', 'c', 'e',
+	5, BT_DATA_UUID16_ALL, 0x0d, 0x18, 0x0f, 0x18,
+};
+
+/* Name and both UUIDs, with the UUIDs split among two fields. */
+static const uint8_t adv_split[] = {
+	12, BT_DATA_NAME_COMPLETE,
+	'T', 'e', 's', 't', ' ', 'd', 'e', 'v', 'i', 'c', 'e',
+	3, BT_DATA_UUID16_SOME, 0x0d, 0x18,
+	3, BT_DATA_UUID16_ALL, 0x0f, 0x18,
+};
+
+/* Name and only one of the UUIDs. */
+static const uint8_t adv_one_uuid[] = {
+	12, BT_DATA_NAME_COMPLETE,
+	'T', 'e', 's', 't', ' ', 'd', 'e', 'v', 'i', 'c', 'e',
+	3, BT_DATA_UUID16_ALL, 0x0d, 0x18,
+};
+
+static const struct bt_le_scan_cb *scan_cb;
+
+static struct {
+	size_t match_cnt;
+	size_t no_match_cnt;
+	struct bt_scan_filter_match filter_match;
+} result;
+
+void __wrap_bt_le_scan_cb_register(struct bt_le_scan_cb *cb)
+{
+	scan_cb = cb;
+}
+
+static void scan_filter_match(struct bt_scan_device_info *device_info,
+			      struct bt_scan_filter_match *filter_match,
+			      bool connectable)
+{
+	result.match_cnt++;
+	result.filter_match = *filter_match;
+}
+
+static void scan_filter_no_match(struct bt_scan_device_info *device_info,
+				 bool connectable)
+{
+	result.no_match_cnt++;
+}
+
+BT_SCAN_CB_INIT(scan_cb_data, scan_filter_match, scan_filter_no_match,
+		NULL, NULL);
+
+static void adv_report(const bt_addr_le_t *addr, const uint8_t *data,
+		       size_t len)
+{
+	struct bt_le_scan_recv_info info = {
+		.addr = addr,
+		.adv_props = BT_GAP_ADV_PROP_CONNECTABLE,
+	};
+	struct net_buf_simple ad;
+
+	net_buf_simple_init_with_data(&ad, (void *)data, len);
+
+	memset(&result, 0, sizeof(result));
+
+	zassert_not_null(scan_cb, "Scan callback not registered");
+	scan_cb->recv(&info, &ad);
+}
+
+static void filter_add(enum bt_scan_filter_type type, const void *data)
+{
+	zassert_equal(bt_scan_filter_add(type, data), 0,
+		      "Adding filter failed");
+}
+
+static void test_setup(void)
+{
+	bt_scan_init(NULL);
+	bt_scan_blocklist_clear();
+}
+
+static void test_teardown(void)
+{
+	bt_scan_filter_disable();
+	bt_scan_filter_remove_all();
+}
+
+static void test_all_mode_match(void)
+{
+	filter_add(BT_SCAN_FILTER_TYPE_NAME, TEST_NAME);
+	filter_add(BT_SCAN_FILTER_TYPE_UUID, &uuid_hrs);
+	filter_add(BT_SCAN_FILTER_TYPE_UUID, &uuid_bas);
+
+	zassert_equal(bt_scan_filter_enable(BT_SCAN_NAME_FILTER |
+					    BT_SCAN_UUID_FILTER, true), 0,
+		      "Enabling filters failed");
+
+	adv_report(&peer_addr, adv_full, sizeof(adv_full));
+
+	zassert_equal(result.match_cnt, 1, "Device not matched");
+	zassert_true(result.filter_match.name.match, "Name not matched");
+	zassert_true(result.filter_match.uuid.match, "UUIDs not matched");
+	zassert_equal(result.filter_match.uuid.count, 2,
+		      "Wrong number of UUIDs matched");
+}
+
+static void test_all_mode_uuid_split(void)
+{
+	/* Only the compiled filters collect the UUIDs from all fields. */
+	if (!IS_ENABLED(CONFIG_BT_SCAN_FILTER_COMPILED)) {
+		ztest_test_skip();
+	}
+
+	filter_add(BT_SCAN_FILTER_TYPE_NAME, TEST_NAME);
+	filter_add(BT_SCAN_FILTER_TYPE_UUID, &uuid_hrs);
+	filter_add(BT_SCAN_FILTER_TYPE_UUID, &uuid_bas);
+
+	zassert_equal(bt_scan_filter_enable(BT_SCAN_NAME_FILTER |
+					    BT_SCAN_UUID_FILTER, true), 0,
+		      "Enabling filters failed");
+
+	adv_report(&peer_addr, adv_split, sizeof(adv_split));
+
+	zassert_equal(result.match_cnt, 1, "Device not matched");
+	zassert_equal(result.filter_match.uuid.count, 2,
+		      "UUIDs split among fields not matched");
+}
+
+static void test_all_mode_no_match(void)
+{
+	filter_add(BT_SCAN_FILTER_TYPE_NAME, TEST_NAME);
+	filter_add(BT_SCAN_FILTER_TYPE_UUID, &uuid_hrs);
+	filter_add(BT_SCAN_FILTER_TYPE_UUID, &uuid_bas);
+
+	zassert_equal(bt_scan_filter_enable(BT_SCAN_NAME_FILTER |
+					    BT_SCAN_UUID_FILTER, true), 0,
+		      "Enabling filters failed");
+
+	adv_report(&peer_addr, adv_one_uuid, sizeof(adv_one_uuid));
+
+	zassert_equal(result.match_cnt, 0, "Missing UUID matched");
+	zassert_equal(result.no_match_cnt, 1, "No match not reported");
+}
+
+static void test_all_mode_addr_mismatch(void)
+{
+	filter_add(BT_SCAN_FILTER_TYPE_NAME, TEST_NAME);
+	filter_add(BT_SCAN_FILTER_TYPE_ADDR, &peer_addr);
+
+	zassert_equal(bt_scan_filter_enable(BT_SCAN_NAME_FILTER |
+					    BT_SCAN_ADDR_FILTER, true), 0,
+		      "Enabling filters failed");
+
+	/* The address does not match, so the advertising data
+	 * cannot make the device match.
+	 */
+	adv_report(&other_addr, adv_full, sizeof(adv_full));
+
+	zassert_equal(result.match_cnt, 0, "Other address matched");
+	zassert_equal(result.no_match_cnt, 1, "No match not reported");
+
+	adv_report(&peer_addr, adv_full, sizeof(adv_full));
+
+	zassert_equal(result.match_cnt, 1, "Device not matched");
+	zassert_true(result.filter_match.addr.match, "Address not matched");
+	zassert_true(result.filter_match.name.match, "Name not matched");
+}
+
+static void test_normal_mode_match(void)
+{
+	filter_add(BT_SCAN_FILTER_TYPE_NAME, OTHER_NAME);
+	filter_add(BT_SCAN_FILTER_TYPE_UUID, &uuid_bas);
+
+	zassert_equal(bt_scan_filter_enable(BT_SCAN_NAME_FILTER |
+					    BT_SCAN_UUID_FILTER, false), 0,
+		      "Enabling filters failed");
+
+	adv_report(&peer_addr, adv_full, sizeof(adv_full));
+
+	zassert_equal(result.match_cnt, 1, "Device not matched");
+	zassert_false(result.filter_match.name.match, "Other name matched");
+	zassert_true(result.filter_match.uuid.match, "UUID not matched");
+
+	adv_report(&peer_addr, adv_one_uuid, sizeof(adv_one_uuid));
+
+	zassert_equal(result.match_cnt, 0, "Device without filters matched");
+	zassert_equal(result.no_match_cnt, 1, "No match not reported");
+}
+
+static void test_uuid_duplicate(void)
+{
+	struct bt_filter_status status;
+
+	filter_add(BT_SCAN_FILTER_TYPE_UUID, &uuid_hrs);
+	filter_add(BT_SCAN_FILTER_TYPE_UUID, &uuid_hrs_128);
+
+	zassert_equal(bt_scan_filter_status(&status), 0,
+		      "Reading filter status failed");
+	zassert_equal(status.uuid.cnt, 1, "Duplicated UUID filter added");
+
+	zassert_equal(bt_scan_filter_enable(BT_SCAN_UUID_FILTER, true), 0,
+		      "Enabling filters failed");
+
+	adv_report(&peer_addr, adv_one_uuid, sizeof(adv_one_uuid));
+
+	zassert_equal(result.match_cnt, 1, "Device not matched");
+	zassert_equal(result.filter_match.uuid.count, 1,
+		      "Wrong number of UUIDs matched");
+}
+
+static void test_blocklist(void)
+{
+	filter_add(BT_SCAN_FILTER_TYPE_NAME, TEST_NAME);
+
+	zassert_equal(bt_scan_filter_enable(BT_SCAN_NAME_FILTER, false), 0,
+		      "Enabling filters failed");
+	zassert_equal(bt_scan_blocklist_device_add(&peer_addr), 0,
+		      "Adding device to blocklist failed");
+
+	adv_report(&peer_addr, adv_full, sizeof(adv_full));
+
+	zassert_equal(result.match_cnt, 0, "Blocklisted device matched");
+	zassert_equal(result.no_match_cnt, 0, "Blocklisted device reported");
+
+	adv_report(&other_addr, adv_full, sizeof(adv_full));
+
+	zassert_equal(result.match_cnt, 1, "Device not matched");
+}
+
+void test_main(void)
+{
+	bt_scan_init(NULL);
+	bt_scan_cb_register(&scan_cb_data);
+
+	ztest_test_suite(scan_tests,
+			 ztest_unit_test_setup_teardown(test_all_mode_match,
+							test_setup,
+							test_teardown),
+			 ztest_unit_test_setup_teardown(
+				test_all_mode_uuid_split,
+				test_setup,
+				test_teardown),
+			 ztest_unit_test_setup_teardown(test_all_mode_no_match,
+							test_setup,
+							test_teardown),
+			 ztest_unit_test_setup_teardown(
+				test_all_mode_addr_mismatch,
+				test_setup,
+				test_teardown),
+			 ztest_unit_test_setup_teardown(test_normal_mode_match,
+							test_setup,
+							test_teardown),
+			 ztest_unit_test_setup_teardown(test_uuid_duplicate,
+							test_setup,
+							test_teardown),
+			 ztest_unit_test_setup_teardown(test_blocklist,
+							test_setup,
+							test_teardown)
+			 );
+
+	ztest_run_test_suite(scan_tests);
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/* Advertising reports modeled on the data that is typically seen when
+ * scanning in an office environment: beacons, HID peripherals, sensors and
+ * phone accessories. Most of the reports do not match any filter.
+ */
+
+#include "adv_corpus.h"
+
+#define AD(type, ...) \
+	(sizeof((uint8_t[]){__VA_ARGS__}) + 1), (type), __VA_ARGS__
+
+#define ADV_REPORT(_addr, ...)						\
+	{								\
+		.addr = _addr,						\
+		.len = sizeof((uint8_t[]){__VA_ARGS__}),		\
+		.data = {__VA_ARGS__},					\
+	}
+
+#define ADDR(type, ...) {type, __VA_ARGS__}
+
+#define STR_HIDS_MOUSE 'N', 'o', 'r', 'd', 'i', 'c', '_', 'H', 'I', 'D', \
+	'S', '_', 'm', 'o', 'u', 's', 'e'
+#define STR_HIDS_KBD 'N', 'o', 'r', 'd', 'i', 'c', '_', 'H', 'I', 'D', \
+	'S', '_', 'k', 'e', 'y', 'b', 'o', 'a', 'r', 'd'
+#define STR_DESKTOP_MOUSE 'n', 'R', 'F', ' ', 'D', 'e', 's', 'k', 't', \
+	'o', 'p', ' ', 'M', 'o', 'u', 's', 'e'
+
+/* Nordic UART Service UUID, little-endian. */
+#define UUID_NUS 0x9e, 0xca, 0xdc, 0x24, 0x0e, 0xe5, 0xa9, 0xe0, \
+	0x93, 0xf3, 0xa3, 0xb5, 0x01, 0x00, 0x40, 0x6e
+
+/* Heart Rate Service UUID as 128-bit value, little-endian. */
+#define UUID_HRS_128 0xfb, 0x34, 0x9b, 0x5f, 0x80, 0x00, 0x00, 0x80, \
+	0x00, 0x10, 0x00, 0x00, 0x0d, 0x18, 0x00, 0x00
+
+const struct adv_report adv_corpus[] = {
+	/* iBeacon */
+	ADV_REPORT(ADDR(1, 0x11, 0x22, 0x33, 0x44, 0x55, 0xc1),
+		   AD(AD_TYPE_FLAGS, 0x06),
+		   AD(AD_TYPE_MANUFACTURER_DATA, 0x4c, 0x00, 0x02, 0x15,
+		      0xe2, 0xc5, 0x6d, 0xb5, 0xdf, 0xfb, 0x48, 0xd2,
+		      0xb0, 0x60, 0xd0, 0xf5, 0xa7, 0x10, 0x96, 0xe0,
+		      0x00, 0x01, 0x00, 0x02, 0xc5)),
+	/* Eddystone URL */
+	ADV_REPORT(ADDR(1, 0x02, 0x13, 0x24, 0x35, 0x46, 0xd7),
+		   AD(AD_TYPE_FLAGS, 0x06),
+		   AD(AD_TYPE_UUID16_ALL, 0xaa, 0xfe),
+		   AD(AD_TYPE_SVC_DATA16, 0xaa, 0xfe, 0x10, 0x00, 0x03,
+		      'n', 'o', 'r', 'd', 'i', 'c', 's', 'e', 'm', 'i',
+		      0x07)),
+	/* HID mouse */
+	ADV_REPORT(ADDR(1, 0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xe5),
+		   AD(AD_TYPE_FLAGS, 0x05),
+		   AD(AD_TYPE_GAP_APPEARANCE, 0xc2, 0x03),
+		   AD(AD_TYPE_UUID16_ALL, 0x12, 0x18),
+		   AD(AD_TYPE_NAME_COMPLETE, STR_HIDS_MOUSE)),
+	/* HID keyboard with the name in the scan response */
+	ADV_REPORT(ADDR(1, 0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xf5),
+		   AD(AD_TYPE_FLAGS, 0x05),
+		   AD(AD_TYPE_GAP_APPEARANCE, 0xc1, 0x03),
+		   AD(AD_TYPE_UUID16_ALL, 0x12, 0x18, 0x0f, 0x18)),
+	ADV_REPORT(ADDR(1, 0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xf5),
+		   AD(AD_TYPE_NAME_COMPLETE, STR_HIDS_KBD)),
+	/* Desktop mouse with a shortened name */
+	ADV_REPORT(ADDR(0, 0x10, 0x20, 0x30, 0x40, 0x50, 0x60),
+		   AD(AD_TYPE_FLAGS, 0x05),
+		   AD(AD_TYPE_UUID16_SOME, 0x12, 0x18),
+		   AD(AD_TYPE_NAME_SHORTENED, 'n', 'R', 'F', ' ', 'D', 'e',
+		      's', 'k')),
+	/* Desktop mouse scan response */
+	ADV_REPORT(ADDR(0, 0x10, 0x20, 0x30, 0x40, 0x50, 0x60),
+		   AD(AD_TYPE_NAME_COMPLETE, STR_DESKTOP_MOUSE)),
+	/* Peripheral UART */
+	ADV_REPORT(ADDR(1, 0x5a, 0x4b, 0x3c, 0x2d, 0x1e, 0xcf),
+		   AD(AD_TYPE_FLAGS, 0x06),
+		   AD(AD_TYPE_UUID128_ALL, UUID_NUS)),
+	/* Heart rate sensor with the 128-bit UUID form */
+	ADV_REPORT(ADDR(1, 0x61, 0x62, 0x63, 0x64, 0x65, 0xe6),
+		   AD(AD_TYPE_FLAGS, 0x06),
+		   AD(AD_TYPE_UUID128_SOME, UUID_HRS_128),
+		   AD(AD_TYPE_NAME_SHORTENED, 'H', 'R', 'M')),
+	/* Heart rate sensor with the 16-bit UUID form */
+	ADV_REPORT(ADDR(1, 0x71, 0x72, 0x73, 0x74, 0x75, 0xf6),
+		   AD(AD_TYPE_FLAGS, 0x06),
+		   AD(AD_TYPE_UUID16_ALL, 0x0d, 0x18, 0x0a, 0x18),
+		   AD(AD_TYPE_NAME_COMPLETE, 'Z', 'e', 'p', 'h', 'y', 'r',
+		      ' ', 'H', 'e', 'a', 'r', 't', 'r', 'a', 't', 'e')),
+	/* Environmental sensor with a 32-bit UUID */
+	ADV_REPORT(ADDR(1, 0x81, 0x82, 0x83, 0x84, 0x85, 0xc6),
+		   AD(AD_TYPE_FLAGS, 0x06),
+		   AD(AD_TYPE_UUID32_ALL, 0x1a, 0x18, 0x00, 0x00),
+		   AD(AD_TYPE_NAME_COMPLETE, 'T', 'h', 'i', 'n', 'g', 'y')),
+	/* Phone accessory, non-resolvable address */
+	ADV_REPORT(ADDR(1, 0x3e, 0x9a, 0x41, 0x07, 0xb3, 0x2c),
+		   AD(AD_TYPE_FLAGS, 0x1a),
+		   AD(AD_TYPE_TX_POWER, 0x0c),
+		   AD(AD_TYPE_MANUFACTURER_DATA, 0x4c, 0x00, 0x10, 0x05,
+		      0x01, 0x18, 0x3b, 0x4f, 0x2d)),
+	/* Earbuds */
+	ADV_REPORT(ADDR(1, 0x4f, 0x12, 0x8c, 0x6e, 0x20, 0x51),
+		   AD(AD_TYPE_FLAGS, 0x1a),
+		   AD(AD_TYPE_MANUFACTURER_DATA, 0x75, 0x00, 0x42, 0x09,
+		      0x81, 0x02, 0x14, 0x15, 0x03, 0x21, 0x01, 0x09),
+		   AD(AD_TYPE_NAME_COMPLETE, 'G', 'a', 'l', 'a', 'x', 'y',
+		      ' ', 'B', 'u', 'd', 's')),
+	/* Third party mouse */
+	ADV_REPORT(ADDR(1, 0xd3, 0x44, 0x9e, 0x01, 0x7a, 0xc8),
+		   AD(AD_TYPE_FLAGS, 0x05),
+		   AD(AD_TYPE_GAP_APPEARANCE, 0xc2, 0x03),
+		   AD(AD_TYPE_UUID16_SOME, 0x12, 0x18),
+		   AD(AD_TYPE_NAME_COMPLETE, 'M', 'X', ' ', 'M', 'a', 's',
+		      't', 'e', 'r', ' ', '3')),
+	/* Name that is a prefix of a filter name */
+	ADV_REPORT(ADDR(1, 0x91, 0x92, 0x93, 0x94, 0x95, 0xd6),
+		   AD(AD_TYPE_FLAGS, 0x06),
+		   AD(AD_TYPE_NAME_COMPLETE, 'N', 'o', 'r', 'd', 'i', 'c')),
+	/* Button with a shortened name below the minimum length */
+	ADV_REPORT(ADDR(1, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6),
+		   AD(AD_TYPE_FLAGS, 0x06),
+		   AD(AD_TYPE_NAME_SHORTENED, 'n', 'R', 'F')),
+	/* Connectable beacon without any data */
+	ADV_REPORT(ADDR(1, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6),
+		   AD(AD_TYPE_FLAGS, 0x04)),
+};
+
+const size_t adv_corpus_size = sizeof(adv_corpus) / sizeof(adv_corpus[0]);
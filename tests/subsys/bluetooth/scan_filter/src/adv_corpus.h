@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef ADV_CORPUS_H_
+#define ADV_CORPUS_H_
+
+#include <zephyr/types.h>
+#include <stddef.h>
+
+#define ADV_ADDR_LEN 7
+#define ADV_DATA_MAX_LEN 31
+
+#define AD_TYPE_FLAGS 0x01
+#define AD_TYPE_UUID16_SOME 0x02
+#define AD_TYPE_UUID16_ALL 0x03
+#define AD_TYPE_UUID32_SOME 0x04
+#define AD_TYPE_UUID32_ALL 0x05
+#define AD_TYPE_UUID128_SOME 0x06
+#define AD_TYPE_UUID128_ALL 0x07
+#define AD_TYPE_NAME_SHORTENED 0x08
+#define AD_TYPE_NAME_COMPLETE 0x09
+#define AD_TYPE_TX_POWER 0x0a
+#define AD_TYPE_SVC_DATA16 0x16
+#define AD_TYPE_GAP_APPEARANCE 0x19
+#define AD_TYPE_MANUFACTURER_DATA 0xff
+
+/* Advertising report: address in the bt_addr_le_t layout and data. */
+struct adv_report {
+	uint8_t addr[ADV_ADDR_LEN];
+	uint8_t len;
+	uint8_t data[ADV_DATA_MAX_LEN];
+};
+
+extern const struct adv_report adv_corpus[];
+extern const size_t adv_corpus_size;
+
+#endif /* ADV_CORPUS_H_ */
@@ -0,0 +1,608 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <sys/util.h>
+#include <string.h>
+#include <time.h>
+
+#include "scan_filter.h"
+#include "adv_corpus.h"
+
+#define NAME_MAX_LEN 32
+#define UUID_128_LEN 16
+
+/* Maximum number of filters of a single type. */
+#define FILTER_MAX_CNT 128
+
+/* UUID filters are tracked in a 32-bit mask. */
+#define UUID_MAX_CNT 32
+
+/* Number of passes over the advertising corpus in the benchmark. */
+#define BENCHMARK_PASSES 20000
+
+struct short_name {
+	const char *name;
+	uint8_t min_len;
+};
+
+struct uuid {
+	uint8_t len;
+	uint8_t val[UUID_128_LEN];
+};
+
+/* Filter set modeled on a central that connects to a number of known
+ * peripheral types. It is extended with generated filters to measure
+ * the matching time for bigger filter sets.
+ */
+static const char * const base_names[] = {
+	"Nordic_HIDS_keyboard",
+	"Nordic_HIDS_mouse",
+	"Nordic_UART_Service",
+	"Nordic_Blinky",
+	"Thingy",
+	"nRF Desktop Mouse",
+	"nRF Desktop Keyboard",
+	"Zephyr Heartrate Sensor",
+};
+
+static const struct short_name base_short_names[] = {
+	{ .name = "nRF Desktop Mouse", .min_len = 5 },
+	{ .name = "nRF Desktop Keyboard", .min_len = 5 },
+	{ .name = "HRM Sensor", .min_len = 3 },
+	{ .name = "Nordic_Blinky", .min_len = 6 },
+};
+
+static const uint8_t base_addrs[][ADV_ADDR_LEN] = {
+	{1, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0xcf},
+	{1, 0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xf5},
+	{1, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0xdf},
+	{0, 0x10, 0x20, 0x30, 0x40, 0x50, 0x60},
+	{1, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0xef},
+	{1, 0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0xff},
+	{1, 0x81, 0x82, 0x83, 0x84, 0x85, 0xc6},
+	{0, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f},
+};
+
+/* UUIDs in the form used by the advertising data, little-endian. */
+static const struct uuid base_uuids[] = {
+	/* Nordic UART Service */
+	{ 16, {0x9e, 0xca, 0xdc, 0x24, 0x0e, 0xe5, 0xa9, 0xe0,
+	       0x93, 0xf3, 0xa3, 0xb5, 0x01, 0x00, 0x40, 0x6e} },
+	/* LED Button Service */
+	{ 16, {0x23, 0xd1, 0xbc, 0xea, 0x5f, 0x78, 0x23, 0x15,
+	       0xde, 0xef, 0x12, 0x12, 0x23, 0x15, 0x00, 0x00} },
+	/* Heart Rate Service */
+	{ 2, {0x0d, 0x18} },
+	/* Environmental Sensing Service */
+	{ 2, {0x1a, 0x18} },
+	/* Cycling Speed and Cadence Service */
+	{ 2, {0x16, 0x18} },
+	/* Human Interface Device Service */
+	{ 2, {0x12, 0x18} },
+	/* Running Speed and Cadence Service */
+	{ 4, {0x14, 0x18, 0x00, 0x00} },
+	/* Thingy Configuration Service */
+	{ 16, {0x42, 0x00, 0x74, 0xa9, 0xff, 0x52, 0x10, 0x9b,
+	       0x33, 0x49, 0x35, 0x9b, 0x00, 0x01, 0x68, 0xef} },
+};
+
+/* Bluetooth Base UUID, little-endian. */
+static const uint8_t uuid_base[UUID_128_LEN] = {
+	0xfb, 0x34, 0x9b, 0x5f, 0x80, 0x00, 0x00, 0x80,
+	0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+struct match {
+	int name;
+	int short_name;
+	int addr;
+	uint32_t uuid_mask;
+};
+
+static char names[FILTER_MAX_CNT][NAME_MAX_LEN + 1];
+static size_t name_cnt;
+
+static char short_names[FILTER_MAX_CNT][NAME_MAX_LEN + 1];
+static uint8_t short_name_min_lens[FILTER_MAX_CNT];
+static size_t short_name_cnt;
+
+static uint8_t addrs[FILTER_MAX_CNT][ADV_ADDR_LEN];
+static size_t addr_cnt;
+
+static struct uuid uuids[UUID_MAX_CNT];
+static size_t uuid_cnt;
+
+static struct scan_filter_trie_node
+	name_nodes[SCAN_FILTER_TRIE_SIZE(FILTER_MAX_CNT, NAME_MAX_LEN)];
+static struct scan_filter_trie name_trie = {
+	.nodes = name_nodes,
+	.node_cnt = ARRAY_SIZE(name_nodes),
+};
+
+static struct scan_filter_trie_node
+	short_name_nodes[SCAN_FILTER_TRIE_SIZE(FILTER_MAX_CNT, NAME_MAX_LEN)];
+static struct scan_filter_trie short_name_trie = {
+	.nodes = short_name_nodes,
+	.node_cnt = ARRAY_SIZE(short_name_nodes),
+};
+
+static uint8_t addr_slots[SCAN_FILTER_TABLE_SIZE(FILTER_MAX_CNT)];
+static struct scan_filter_table addr_table = {
+	.keys = addrs,
+	.key_size = ADV_ADDR_LEN,
+	.slots = addr_slots,
+	.slot_cnt = ARRAY_SIZE(addr_slots),
+};
+
+static struct scan_filter_uuid_key uuid_keys[UUID_MAX_CNT];
+static uint8_t uuid_slots[SCAN_FILTER_TABLE_SIZE(UUID_MAX_CNT)];
+static struct scan_filter_table uuid_table = {
+	.keys = uuid_keys,
+	.key_size = sizeof(struct scan_filter_uuid_key),
+	.slots = uuid_slots,
+	.slot_cnt = ARRAY_SIZE(uuid_slots),
+};
+
+/* Set up the given number of filters of every type. The base filters come
+ * first and generated filters, that do not match the corpus, fill the rest.
+ */
+static void filters_set(size_t cnt)
+{
+	zassert_true(cnt >= ARRAY_SIZE(base_names), "Too few filters");
+
+	name_cnt = cnt;
+	for (size_t i = 0; i < name_cnt; i++) {
+		if (i < ARRAY_SIZE(base_names)) {
+			strcpy(names[i], base_names[i]);
+		} else {
+			snprintf(names[i], sizeof(names[i]),
+				 "Nordic_Sensor_%03zu", i);
+		}
+	}
+
+	short_name_cnt = cnt;
+	for (size_t i = 0; i < short_name_cnt; i++) {
+		if (i < ARRAY_SIZE(base_short_names)) {
+			strcpy(short_names[i], base_short_names[i].name);
+			short_name_min_lens[i] = base_short_names[i].min_len;
+		} else {
+			snprintf(short_names[i], sizeof(short_names[i]),
+				 "nRF Tag %03zu", i);
+			short_name_min_lens[i] = 9;
+		}
+	}
+
+	addr_cnt = cnt;
+	for (size_t i = 0; i < addr_cnt; i++) {
+		if (i < ARRAY_SIZE(base_addrs)) {
+			memcpy(addrs[i], base_addrs[i], ADV_ADDR_LEN);
+		} else {
+			const uint8_t addr[ADV_ADDR_LEN] = {
+				1, i, 0x5a, 0xa5, 0x3c, 0x96, 0xc0
+			};
+
+			memcpy(addrs[i], addr, ADV_ADDR_LEN);
+		}
+	}
+
+	uuid_cnt = MIN(cnt, UUID_MAX_CNT);
+	for (size_t i = 0; i < uuid_cnt; i++) {
+		if (i < ARRAY_SIZE(base_uuids)) {
+			uuids[i] = base_uuids[i];
+		} else {
+			uuids[i].len = UUID_128_LEN;
+			memset(uuids[i].val, 0xa5, UUID_128_LEN);
+			uuids[i].val[12] = i;
+		}
+	}
+}
+
+static void compiled_setup(void)
+{
+	int err;
+
+	scan_filter_trie_clear(&name_trie);
+	for (size_t i = 0; i < name_cnt; i++) {
+		err = scan_filter_trie_add(&name_trie, names[i], 0, i);
+		zassert_equal(err, 0, "Adding name failed");
+	}
+
+	scan_filter_trie_clear(&short_name_trie);
+	for (size_t i = 0; i < short_name_cnt; i++) {
+		err = scan_filter_trie_add(&short_name_trie, short_names[i],
+					   short_name_min_lens[i], i);
+		zassert_equal(err, 0, "Adding short name failed");
+	}
+
+	scan_filter_table_clear(&addr_table);
+	for (size_t i = 0; i < addr_cnt; i++) {
+		err = scan_filter_table_insert(&addr_table, i);
+		zassert_equal(err, 0, "Adding address failed");
+	}
+
+	scan_filter_table_clear(&uuid_table);
+	for (size_t i = 0; i < uuid_cnt; i++) {
+		err = scan_filter_uuid_key_get(uuids[i].val, uuids[i].len,
+					       &uuid_keys[i]);
+		zassert_equal(err, 0, "Invalid UUID");
+
+		err = scan_filter_table_insert(&uuid_table, i);
+		zassert_equal(err, 0, "Adding UUID failed");
+	}
+}
+
+static size_t uuid_len_get(uint8_t type)
+{
+	switch (type) {
+	case AD_TYPE_UUID16_SOME:
+	case AD_TYPE_UUID16_ALL:
+		return sizeof(uint16_t);
+
+	case AD_TYPE_UUID32_SOME:
+	case AD_TYPE_UUID32_ALL:
+		return sizeof(uint32_t);
+
+	case AD_TYPE_UUID128_SOME:
+	case AD_TYPE_UUID128_ALL:
+		return UUID_128_LEN;
+
+	default:
+		return 0;
+	}
+}
+
+static void uuid_to_128(const uint8_t *data, size_t len, uint8_t *uuid)
+{
+	if (len == UUID_128_LEN) {
+		memcpy(uuid, data, len);
+	} else {
+		memcpy(uuid, uuid_base, sizeof(uuid_base));
+		memcpy(&uuid[12], data, len);
+	}
+}
+
+/* Filter matching as done by the Scan library without the compiled
+ * filters: every filter is compared with every advertising data field.
+ */
+static void linear_match(const struct adv_report *report, struct match *m)
+{
+	const uint8_t *data = report->data;
+	size_t len = report->len;
+
+	m->name = -ENOENT;
+	m->short_name = -ENOENT;
+	m->addr = -ENOENT;
+	m->uuid_mask = 0;
+
+	for (size_t i = 0; i < addr_cnt; i++) {
+		if (!memcmp(addrs[i], report->addr, ADV_ADDR_LEN)) {
+			m->addr = i;
+			break;
+		}
+	}
+
+	while (len > 1) {
+		uint8_t field_len = data[0];
+		uint8_t type = data[1];
+		const uint8_t *field = &data[2];
+		uint8_t field_data_len;
+
+		if ((field_len == 0) || (field_len + 1 > len)) {
+			break;
+		}
+
+		field_data_len = field_len - 1;
+
+		if ((type == AD_TYPE_NAME_COMPLETE) && (m->name < 0)) {
+			for (size_t i = 0; i < name_cnt; i++) {
+				if (!strncmp(names[i], (const char *)field,
+					     field_data_len)) {
+					m->name = i;
+					break;
+				}
+			}
+		}
+
+		if ((type == AD_TYPE_NAME_SHORTENED) && (m->short_name < 0)) {
+			for (size_t i = 0; i < short_name_cnt; i++) {
+				if ((field_data_len >=
+				     short_name_min_lens[i]) &&
+				    !strncmp(short_names[i],
+					     (const char *)field,
+					     field_data_len)) {
+					m->short_name = i;
+					break;
+				}
+			}
+		}
+
+		size_t uuid_len = uuid_len_get(type);
+
+		for (size_t j = 0; uuid_len && (j + uuid_len <= field_data_len);
+		     j += uuid_len) {
+			uint8_t adv_uuid[UUID_128_LEN];
+
+			uuid_to_128(&field[j], uuid_len, adv_uuid);
+
+			for (size_t i = 0; i < uuid_cnt; i++) {
+				uint8_t filter_uuid[UUID_128_LEN];
+
+				uuid_to_128(uuids[i].val, uuids[i].len,
+					    filter_uuid);
+				if (!memcmp(adv_uuid, filter_uuid,
+					    UUID_128_LEN)) {
+					m->uuid_mask |= BIT(i);
+				}
+			}
+		}
+
+		data += field_len + 1;
+		len -= field_len + 1;
+	}
+}
+
+static void compiled_match(const struct adv_report *report, struct match *m)
+{
+	const uint8_t *data = report->data;
+	size_t len = report->len;
+
+	m->name = -ENOENT;
+	m->short_name = -ENOENT;
+	m->addr = scan_filter_table_find(&addr_table, report->addr);
+	m->uuid_mask = 0;
+
+	while (len > 1) {
+		uint8_t field_len = data[0];
+		uint8_t type = data[1];
+		const uint8_t *field = &data[2];
+		uint8_t field_data_len;
+
+		if ((field_len == 0) || (field_len + 1 > len)) {
+			break;
+		}
+
+		field_data_len = field_len - 1;
+
+		if ((type == AD_TYPE_NAME_COMPLETE) && (m->name < 0)) {
+			m->name = scan_filter_trie_find(&name_trie, field,
+							field_data_len);
+		}
+
+		if ((type == AD_TYPE_NAME_SHORTENED) && (m->short_name < 0)) {
+			m->short_name = scan_filter_trie_find(&short_name_trie,
+							      field,
+							      field_data_len);
+		}
+
+		size_t uuid_len = uuid_len_get(type);
+
+		for (size_t j = 0; uuid_len && (j + uuid_len <= field_data_len);
+		     j += uuid_len) {
+			struct scan_filter_uuid_key key;
+			int idx;
+
+			scan_filter_uuid_key_get(&field[j], uuid_len, &key);
+			idx = scan_filter_table_find(&uuid_table, &key);
+			if (idx >= 0) {
+				m->uuid_mask |= BIT(idx);
+			}
+		}
+
+		data += field_len + 1;
+		len -= field_len + 1;
+	}
+}
+
+static uint64_t time_ns_get(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void test_table(void)
+{
+	static const uint8_t missing[ADV_ADDR_LEN] = {
+		1, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0xce
+	};
+
+	filters_set(ARRAY_SIZE(base_names));
+	compiled_setup();
+
+	for (size_t i = 0; i < addr_cnt; i++) {
+		zassert_equal(scan_filter_table_find(&addr_table, addrs[i]), i,
+			      "Address not found");
+	}
+
+	zassert_equal(scan_filter_table_find(&addr_table, missing), -ENOENT,
+		      "Unexpected address match");
+
+	scan_filter_table_clear(&addr_table);
+	zassert_equal(scan_filter_table_find(&addr_table, addrs[0]), -ENOENT,
+		      "Address found after clear");
+}
+
+static void test_uuid_key(void)
+{
+	static const uint8_t uuid_16[] = {0x0d, 0x18};
+	static const uint8_t uuid_32[] = {0x0d, 0x18, 0x00, 0x00};
+	struct scan_filter_uuid_key key_16;
+	struct scan_filter_uuid_key key_32;
+	struct scan_filter_uuid_key key_128;
+	uint8_t uuid_128[UUID_128_LEN];
+
+	uuid_to_128(uuid_16, sizeof(uuid_16), uuid_128);
+
+	zassert_equal(scan_filter_uuid_key_get(uuid_16, sizeof(uuid_16),
+					       &key_16), 0, "Invalid UUID");
+	zassert_equal(scan_filter_uuid_key_get(uuid_32, sizeof(uuid_32),
+					       &key_32), 0, "Invalid UUID");
+	zassert_equal(scan_filter_uuid_key_get(uuid_128, sizeof(uuid_128),
+					       &key_128), 0, "Invalid UUID");
+
+	zassert_mem_equal(&key_16, &key_32, sizeof(key_16),
+			  "16-bit and 32-bit keys differ");
+	zassert_mem_equal(&key_16, &key_128, sizeof(key_16),
+			  "16-bit and 128-bit keys differ");
+
+	zassert_equal(scan_filter_uuid_key_get(uuid_16, 3, &key_16), -EINVAL,
+		      "Invalid UUID length accepted");
+}
+
+static int trie_find(const struct scan_filter_trie *trie, const char *name)
+{
+	return scan_filter_trie_find(trie, (const uint8_t *)name,
+				     strlen(name));
+}
+
+static void test_trie(void)
+{
+	filters_set(ARRAY_SIZE(base_names));
+	compiled_setup();
+
+	/* Advertised name must be a prefix of the filter name. */
+	zassert_equal(trie_find(&name_trie, "Thingy"), 4, "Name not found");
+	zassert_equal(trie_find(&name_trie, "Nordic_HIDS_m"), 1,
+		      "Name prefix not found");
+	zassert_equal(trie_find(&name_trie, "Nordic_HIDS"), 0,
+		      "First name not reported");
+	zassert_equal(trie_find(&name_trie, "Thingy:52"), -ENOENT,
+		      "Too long name matched");
+	zassert_equal(trie_find(&name_trie, "Zephyr"), 7,
+		      "Name prefix not found");
+
+	/* Shortened name must be at least of the minimum length. */
+	zassert_equal(trie_find(&short_name_trie, "HRM"), 2,
+		      "Short name not found");
+	zassert_equal(trie_find(&short_name_trie, "HR"), -ENOENT,
+		      "Too short name matched");
+	zassert_equal(trie_find(&short_name_trie, "Nordi"), -ENOENT,
+		      "Too short name matched");
+	zassert_equal(trie_find(&short_name_trie, "nRF D"), 0,
+		      "Short name not found");
+
+	scan_filter_trie_clear(&name_trie);
+	zassert_equal(trie_find(&name_trie, "Thingy"), -ENOENT,
+		      "Name found after clear");
+}
+
+static void test_trie_no_mem(void)
+{
+	struct scan_filter_trie_node nodes[SCAN_FILTER_TRIE_SIZE(1, 4)];
+	struct scan_filter_trie trie = {
+		.nodes = nodes,
+		.node_cnt = ARRAY_SIZE(nodes),
+	};
+
+	scan_filter_trie_clear(&trie);
+
+	zassert_equal(scan_filter_trie_add(&trie, "abcd", 0, 0), 0,
+		      "Adding name failed");
+	zassert_equal(scan_filter_trie_add(&trie, "b", 0, 1), -ENOMEM,
+		      "Trie capacity exceeded");
+}
+
+static const size_t filter_cnts[] = {8, 32, FILTER_MAX_CNT};
+
+static void test_corpus_match(void)
+{
+	for (size_t cnt_idx = 0; cnt_idx < ARRAY_SIZE(filter_cnts); cnt_idx++) {
+		size_t matched = 0;
+
+		filters_set(filter_cnts[cnt_idx]);
+		compiled_setup();
+
+		for (size_t i = 0; i < adv_corpus_size; i++) {
+			struct match linear;
+			struct match compiled;
+
+			linear_match(&adv_corpus[i], &linear);
+			compiled_match(&adv_corpus[i], &compiled);
+
+			zassert_equal(linear.name, compiled.name,
+				      "Name mismatch in report %zu", i);
+			zassert_equal(linear.short_name, compiled.short_name,
+				      "Short name mismatch in report %zu", i);
+			zassert_equal(linear.addr, compiled.addr,
+				      "Address mismatch in report %zu", i);
+			zassert_equal(linear.uuid_mask, compiled.uuid_mask,
+				      "UUID mismatch in report %zu", i);
+
+			if ((linear.name >= 0) || (linear.short_name >= 0) ||
+			    (linear.addr >= 0) || linear.uuid_mask) {
+				matched++;
+			}
+		}
+
+		zassert_true(matched > 0, "No report matched");
+		zassert_true(matched < adv_corpus_size, "All reports matched");
+	}
+}
+
+static uint64_t benchmark_run(void (*match)(const struct adv_report *report,
+					    struct match *m))
+{
+	volatile uint32_t sink = 0;
+	uint64_t start = time_ns_get();
+
+	for (size_t pass = 0; pass < BENCHMARK_PASSES; pass++) {
+		for (size_t i = 0; i < adv_corpus_size; i++) {
+			struct match m;
+
+			match(&adv_corpus[i], &m);
+			sink += m.name + m.short_name + m.addr + m.uuid_mask;
+		}
+	}
+
+	return time_ns_get() - start;
+}
+
+/* The benchmark takes a while, it is run only in the benchmark scenario. */
+static void test_benchmark(void)
+{
+	size_t reports = BENCHMARK_PASSES * adv_corpus_size;
+
+	if (!IS_ENABLED(SCAN_FILTER_BENCHMARK)) {
+		ztest_test_skip();
+	}
+
+	TC_PRINT("Reports: %zu (%zu in corpus)\n", reports, adv_corpus_size);
+	TC_PRINT("Average time per report:\n");
+	TC_PRINT(" filters | uuids | linear [ns] | compiled [ns]\n");
+
+	for (size_t i = 0; i < ARRAY_SIZE(filter_cnts); i++) {
+		uint64_t linear_ns;
+		uint64_t compiled_ns;
+
+		filters_set(filter_cnts[i]);
+		compiled_setup();
+
+		linear_ns = benchmark_run(linear_match);
+		compiled_ns = benchmark_run(compiled_match);
+
+		TC_PRINT("%8zu | %5zu | %11llu | %13llu\n",
+			 filter_cnts[i], uuid_cnt,
+			 (unsigned long long)(linear_ns / reports),
+			 (unsigned long long)(compiled_ns / reports));
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(scan_filter_tests,
+			 ztest_unit_test(test_table),
+			 ztest_unit_test(test_uuid_key),
+			 ztest_unit_test(test_trie),
+			 ztest_unit_test(test_trie_no_mem),
+			 ztest_unit_test(test_corpus_match),
+			 ztest_unit_test(test_benchmark)
+			 );
+
+	ztest_run_test_suite(scan_filter_tests);
+}
@@ -0,0 +1,359 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+#include <string.h>
+#include <stddef.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <sys/byteorder.h>
+#include <nrf_socket.h>
+#include <modem/modem_info.h>
+#include <net/nrf_cloud_agps.h>
+
+#include "nrf_cloud_transport.h"
+#include "nrf_cloud_agps_schema_v1.h"
+
+#define TEST_SOCKET_FD 1
+
+/* Size of the test payload, see payload_build(). */
+#define PAYLOAD_SIZE 92
+
+/* The system time element is sent without TOWs, see agps_element_size(). */
+#define SYS_TIME_ELEMENT_SIZE \
+	(offsetof(struct nrf_cloud_agps_system_time, sv_tow) + 4)
+
+/* Every message sent to the modem is logged as its type, length and data. */
+#define SENT_LOG_SIZE 1024
+
+struct sent_log {
+	size_t len;
+	uint8_t data[SENT_LOG_SIZE];
+};
+
+/* Stubs and mocks */
+static int nrf_sendto_calls;
+static struct sent_log sent_log;
+
+int modem_info_init(void)
+{
+	return 0;
+}
+
+int modem_info_params_init(struct modem_param_info *modem)
+{
+	return 0;
+}
+
+int modem_info_params_get(struct modem_param_info *modem)
+{
+	return 0;
+}
+
+int nct_dc_send(const struct nct_dc_data *dc)
+{
+	return 0;
+}
+
+ssize_t nrf_sendto(int socket, const void *message, size_t length,
+		   int flags, const void *dest_addr, nrf_socklen_t dest_len)
+{
+	size_t entry_len = dest_len + sizeof(length) + length;
+
+	nrf_sendto_calls++;
+
+	zassert_true(sent_log.len + entry_len <= sizeof(sent_log.data),
+		     "Sent data log is full");
+
+	memcpy(&sent_log.data[sent_log.len], dest_addr, dest_len);
+	sent_log.len += dest_len;
+	memcpy(&sent_log.data[sent_log.len], &length, sizeof(length));
+	sent_log.len += sizeof(length);
+	memcpy(&sent_log.data[sent_log.len], message, length);
+	sent_log.len += length;
+
+	return length;
+}
+
+void agps_print(enum nrf_cloud_agps_type type, void *data)
+{
+}
+
+static void process_start(void)
+{
+	static const int fd = TEST_SOCKET_FD;
+
+	nrf_sendto_calls = 0;
+	sent_log.len = 0;
+	zassert_equal(nrf_cloud_agps_process_start(&fd), 0,
+		      "Failed to start A-GPS processing");
+}
+
+static void test_schema_version_supported(void)
+{
+	/* Schema version followed by a header of an unhandled type,
+	 * which ends parsing without injecting anything.
+	 */
+	const char buf[] = {
+		NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION,
+		NRF_CLOUD_AGPS_NEQUICK_CORRECTION, 0x00, 0x00,
+	};
+
+	process_start();
+
+	zassert_equal(nrf_cloud_agps_process_chunk(buf, sizeof(buf)), 0,
+		      "Supported schema version was rejected");
+	zassert_equal(nrf_cloud_agps_process_finish(), 0,
+		      "Parsing did not finish cleanly");
+	zassert_equal(nrf_sendto_calls, 0, "Unexpected data sent to modem");
+}
+
+static void test_schema_version_unsupported(void)
+{
+	const char buf[] = {
+		NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION + 1,
+		NRF_CLOUD_AGPS_UTC_PARAMETERS, 0x01, 0x00,
+	};
+
+	process_start();
+
+	zassert_equal(nrf_cloud_agps_process_chunk(buf, sizeof(buf)),
+		      -EBADMSG, "Unsupported schema version was accepted");
+	zassert_equal(nrf_sendto_calls, 0, "Unexpected data sent to modem");
+
+	/* The parser is reset after an error. */
+	zassert_equal(nrf_cloud_agps_process_chunk(buf, sizeof(buf)), -EPERM,
+		      "Parser was not reset after an error");
+	zassert_equal(nrf_cloud_agps_process_finish(), -EPERM,
+		      "Parser was not reset after an error");
+}
+
+static void test_schema_version_split_chunk(void)
+{
+	const char version = NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION + 1;
+
+	process_start();
+
+	/* A zero-length chunk must not consume the version byte. */
+	zassert_equal(nrf_cloud_agps_process_chunk(NULL, 0), 0,
+		      "Empty chunk was rejected");
+	zassert_equal(nrf_cloud_agps_process_chunk(&version, 1), -EBADMSG,
+		      "Unsupported schema version was accepted");
+}
+
+static size_t header_add(uint8_t *buf, enum nrf_cloud_agps_type type,
+			 uint16_t count)
+{
+	buf[NRF_CLOUD_AGPS_BIN_TYPE_OFFSET] = type;
+	sys_put_le16(count, &buf[NRF_CLOUD_AGPS_BIN_COUNT_OFFSET]);
+
+	return NRF_CLOUD_AGPS_BIN_TYPE_SIZE + NRF_CLOUD_AGPS_BIN_COUNT_SIZE;
+}
+
+static size_t element_add(uint8_t *buf, size_t len)
+{
+	static uint8_t value;
+
+	for (size_t i = 0; i < len; i++) {
+		buf[i] = ++value;
+	}
+
+	return len;
+}
+
+static size_t tow_add(uint8_t *buf, uint8_t sv_id)
+{
+	element_add(buf, sizeof(struct nrf_cloud_agps_tow_element));
+	buf[0] = sv_id;
+
+	return sizeof(struct nrf_cloud_agps_tow_element);
+}
+
+/* Builds a payload of several element arrays, which injects six messages.
+ * None of the elements is larger than the reduced carry buffer of the
+ * small carry test configuration.
+ */
+static void payload_build(uint8_t *buf)
+{
+	size_t len = 0;
+
+	buf[len++] = NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION;
+
+	len += header_add(&buf[len], NRF_CLOUD_AGPS_UTC_PARAMETERS, 1);
+	len += element_add(&buf[len], sizeof(struct nrf_cloud_agps_utc));
+
+	len += header_add(&buf[len], NRF_CLOUD_AGPS_KLOBUCHAR_CORRECTION, 2);
+	len += element_add(&buf[len], sizeof(struct nrf_cloud_agps_klobuchar));
+	len += element_add(&buf[len], sizeof(struct nrf_cloud_agps_klobuchar));
+
+	len += header_add(&buf[len], NRF_CLOUD_AGPS_LOCATION, 1);
+	len += element_add(&buf[len], sizeof(struct nrf_cloud_agps_location));
+
+	len += header_add(&buf[len], NRF_CLOUD_AGPS_INTEGRITY, 1);
+	len += element_add(&buf[len], sizeof(struct nrf_cloud_agps_integrity));
+
+	/* TOWs are collected and injected along with the system time. */
+	len += header_add(&buf[len], NRF_CLOUD_AGPS_GPS_TOWS, 2);
+	len += tow_add(&buf[len], 1);
+	len += tow_add(&buf[len], 2);
+
+	len += header_add(&buf[len], NRF_CLOUD_AGPS_GPS_SYSTEM_CLOCK, 1);
+	len += element_add(&buf[len], SYS_TIME_ELEMENT_SIZE);
+
+	zassert_equal(len, PAYLOAD_SIZE, "Unexpected test payload size");
+}
+
+/* Processes the payload in chunks of the given sizes, repeated cyclically. */
+static void payload_process(const uint8_t *buf, size_t len,
+			    const size_t *chunk_sizes, size_t chunk_cnt)
+{
+	size_t chunk_len;
+
+	process_start();
+
+	for (size_t i = 0; len > 0; i = (i + 1) % chunk_cnt) {
+		chunk_len = MIN(chunk_sizes[i], len);
+
+		zassert_equal(nrf_cloud_agps_process_chunk(buf, chunk_len), 0,
+			      "Failed to process chunk");
+
+		buf += chunk_len;
+		len -= chunk_len;
+	}
+
+	zassert_equal(nrf_cloud_agps_process_finish(), 0,
+		      "Parsing did not finish cleanly");
+}
+
+static void payload_reference_get(const uint8_t *payload,
+				  struct sent_log *reference)
+{
+	const size_t chunk_size = PAYLOAD_SIZE;
+
+	payload_process(payload, PAYLOAD_SIZE, &chunk_size, 1);
+
+	zassert_equal(nrf_sendto_calls, 6, "Wrong number of messages sent");
+	memcpy(reference, &sent_log, sizeof(sent_log));
+}
+
+static void sent_log_check(const struct sent_log *reference)
+{
+	zassert_equal(sent_log.len, reference->len,
+		      "Sent data differs from single buffer processing");
+	zassert_mem_equal(sent_log.data, reference->data, reference->len,
+			  "Sent data differs from single buffer processing");
+}
+
+static void test_stream_byte_by_byte(void)
+{
+	static uint8_t payload[PAYLOAD_SIZE];
+	static struct sent_log reference;
+	const size_t chunk_size = 1;
+
+	payload_build(payload);
+	payload_reference_get(payload, &reference);
+
+	payload_process(payload, sizeof(payload), &chunk_size, 1);
+	sent_log_check(&reference);
+}
+
+static void test_stream_arbitrary_splits(void)
+{
+	static uint8_t payload[PAYLOAD_SIZE];
+	static struct sent_log reference;
+	const size_t chunk_sizes[] = {7, 1, 13, 2, 5, 30, 3};
+	size_t split[2];
+
+	payload_build(payload);
+	payload_reference_get(payload, &reference);
+
+	payload_process(payload, sizeof(payload), chunk_sizes,
+			ARRAY_SIZE(chunk_sizes));
+	sent_log_check(&reference);
+
+	/* Split the payload in two at every possible offset. */
+	for (size_t i = 1; i < sizeof(payload); i++) {
+		split[0] = i;
+		split[1] = sizeof(payload) - i;
+
+		payload_process(payload, sizeof(payload), split,
+				ARRAY_SIZE(split));
+		sent_log_check(&reference);
+	}
+}
+
+static void test_stream_truncated(void)
+{
+	static uint8_t payload[PAYLOAD_SIZE];
+	/* Offset of the location array in the payload. */
+	const size_t location_offset =
+		1 + (3 + sizeof(struct nrf_cloud_agps_utc)) +
+		(3 + 2 * sizeof(struct nrf_cloud_agps_klobuchar));
+	/* Ends within the location element. */
+	const size_t partial_len = location_offset + 3 + 5;
+	/* Ends right after the header of the location array. */
+	const size_t header_len = location_offset + 3;
+
+	payload_build(payload);
+
+	process_start();
+	zassert_equal(nrf_cloud_agps_process_chunk(payload, partial_len), 0,
+		      "Failed to process chunk");
+	zassert_equal(nrf_cloud_agps_process_finish(), -EBADMSG,
+		      "Stream ending within an element was accepted");
+	zassert_equal(nrf_sendto_calls, 3, "Partial element was sent");
+
+	process_start();
+	zassert_equal(nrf_cloud_agps_process_chunk(payload, header_len), 0,
+		      "Failed to process chunk");
+	zassert_equal(nrf_cloud_agps_process_finish(), -EBADMSG,
+		      "Stream ending before announced elements was accepted");
+}
+
+static void test_element_too_large(void)
+{
+	uint8_t buf[1 + 3 + sizeof(struct nrf_cloud_agps_ephemeris)];
+	size_t len = 0;
+
+#ifdef AGPS_STREAM_CARRY_SIZE
+	if (sizeof(struct nrf_cloud_agps_ephemeris) <= AGPS_STREAM_CARRY_SIZE) {
+		ztest_test_skip();
+	}
+#else
+	/* Every element fits the default carry buffer. */
+	ztest_test_skip();
+#endif
+
+	buf[len++] = NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION;
+	len += header_add(&buf[len], NRF_CLOUD_AGPS_EPHEMERIDES, 1);
+	len += element_add(&buf[len], sizeof(struct nrf_cloud_agps_ephemeris));
+
+	/* The element must be rejected even if it arrives in one chunk. */
+	process_start();
+	zassert_equal(nrf_cloud_agps_process_chunk(buf, len), -EMSGSIZE,
+		      "Oversized element was accepted");
+	zassert_equal(nrf_sendto_calls, 0, "Oversized element was sent");
+
+	process_start();
+	zassert_equal(nrf_cloud_agps_process_chunk(buf, 10), -EMSGSIZE,
+		      "Oversized element was accepted");
+	zassert_equal(nrf_cloud_agps_process_finish(), -EPERM,
+		      "Parser was not reset after an error");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(nrf_cloud_agps_test,
+			 ztest_unit_test(test_schema_version_supported),
+			 ztest_unit_test(test_schema_version_unsupported),
+			 ztest_unit_test(test_schema_version_split_chunk),
+			 ztest_unit_test(test_stream_byte_by_byte),
+			 ztest_unit_test(test_stream_arbitrary_splits),
+			 ztest_unit_test(test_stream_truncated),
+			 ztest_unit_test(test_element_too_large)
+			 );
+
+	ztest_run_test_suite(nrf_cloud_agps_test);
+}
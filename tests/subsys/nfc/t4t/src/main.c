@@ -0,0 +1,361 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <string.h>
+#include <zephyr/types.h>
+#include <sys/byteorder.h>
+#include <nfc/t4t/apdu.h>
+#include <nfc/t4t/isodep.h>
+#include <nfc/t4t/hl_procedure.h>
+
+#include "sim_tag.h"
+
+#define NDEF_MSG_LEN 2500
+#define NDEF_NLEN_LEN 2
+#define NDEF_FILE_LEN (NDEF_MSG_LEN + NDEF_NLEN_LEN)
+#define NDEF_FILE_SIZE 3000
+
+#define ISODEP_TX_BUF_SIZE 1024
+#define ISODEP_RX_BUF_SIZE 2048
+#define FRAME_BUF_SIZE 4096
+
+#define MAX_TLV_BLOCKS 4
+
+/* Short APDUs carry up to 255 bytes of data. */
+#define SHORT_APDU_DATA_LEN 255
+#define EXT_APDU_DATA_LEN 1024
+
+/* C-APDU header with extended Lc. */
+#define EXT_UPDATE_DATA_LEN \
+	(CONFIG_NFC_T4T_HL_PROCEDURE_APDU_BUF_SIZE - 4 - 3)
+
+#define EXCHANGE_TIMEOUT K_MSEC(50)
+
+static const struct sim_tag_config tag_short = {
+	.fsci = NFC_T4T_ISODEP_FSD_256,
+	.mle = SHORT_APDU_DATA_LEN,
+	.mlc = SHORT_APDU_DATA_LEN,
+	.ndef_file_size = NDEF_FILE_SIZE,
+};
+
+static const struct sim_tag_config tag_ext = {
+	.fsci = NFC_T4T_ISODEP_FSD_1024,
+	.mle = EXT_APDU_DATA_LEN,
+	.mlc = EXT_APDU_DATA_LEN,
+	.ndef_file_size = NDEF_FILE_SIZE,
+};
+
+NFC_T4T_CC_DESC_DEF(t4t_cc, MAX_TLV_BLOCKS);
+
+static uint8_t isodep_tx_buf[ISODEP_TX_BUF_SIZE];
+static uint8_t isodep_rx_buf[ISODEP_RX_BUF_SIZE];
+
+static uint8_t frame[FRAME_BUF_SIZE];
+static size_t frame_len;
+static uint8_t rsp[FRAME_BUF_SIZE];
+static K_SEM_DEFINE(frame_sem, 0, 1);
+
+static uint8_t ndef_file[NDEF_FILE_LEN];
+static uint8_t ndef_buf[NDEF_FILE_SIZE];
+
+static struct {
+	bool isodep_selected;
+	enum nfc_t4t_hl_procedure_select hl_selected;
+	struct nfc_t4t_cc_file *cc;
+	size_t ndef_read_len;
+	bool ndef_updated;
+	int err;
+} result;
+
+static void isodep_selected(const struct nfc_t4t_isodep_tag *t4t_tag)
+{
+	result.isodep_selected = true;
+}
+
+static void isodep_error(int err)
+{
+	result.err = err;
+}
+
+static void isodep_ready_to_send(uint8_t *data, size_t data_len, uint32_t ftd)
+{
+	zassert_true(data_len <= sizeof(frame), "Frame too long");
+
+	memcpy(frame, data, data_len);
+	frame_len = data_len;
+
+	k_sem_give(&frame_sem);
+}
+
+static void isodep_data_received(const uint8_t *data, size_t data_len)
+{
+	int err;
+
+	err = nfc_t4t_hl_procedure_on_data_received(data, data_len);
+	if (err) {
+		result.err = err;
+	}
+}
+
+static const struct nfc_t4t_isodep_cb isodep_cb = {
+	.selected = isodep_selected,
+	.error = isodep_error,
+	.ready_to_send = isodep_ready_to_send,
+	.data_received = isodep_data_received
+};
+
+static void hl_selected(enum nfc_t4t_hl_procedure_select type)
+{
+	result.hl_selected = type;
+}
+
+static void hl_cc_read(struct nfc_t4t_cc_file *cc)
+{
+	result.cc = cc;
+}
+
+static void hl_ndef_read(uint16_t file_id, const uint8_t *data, size_t len)
+{
+	result.ndef_read_len = len;
+}
+
+static void hl_ndef_updated(uint16_t file_id)
+{
+	result.ndef_updated = true;
+}
+
+static const struct nfc_t4t_hl_procedure_cb hl_cb = {
+	.selected = hl_selected,
+	.cc_read = hl_cc_read,
+	.ndef_read = hl_ndef_read,
+	.ndef_updated = hl_ndef_updated
+};
+
+/* Pass the frames between the Reader/Writer and the simulated tag until
+ * the Reader/Writer has nothing more to send.
+ */
+static void exchange_run(void)
+{
+	size_t rsp_len;
+	int err;
+
+	while (k_sem_take(&frame_sem, EXCHANGE_TIMEOUT) == 0) {
+		rsp_len = sim_tag_frame_process(frame, frame_len, rsp,
+						sizeof(rsp));
+
+		err = nfc_t4t_isodep_data_received(rsp, rsp_len, 0);
+		zassert_equal(err, 0, "ISO-DEP data handling failed");
+	}
+
+	zassert_equal(result.err, 0, "Exchange failed: %d", result.err);
+}
+
+static void tag_select(const struct sim_tag_config *config,
+		       enum nfc_t4t_isodep_fsd fsd)
+{
+	int err;
+
+	memset(&result, 0, sizeof(result));
+
+	sim_tag_init(config, ndef_file, sizeof(ndef_file));
+
+	err = nfc_t4t_isodep_rats_send(fsd, 0);
+	zassert_equal(err, 0, "RATS send failed");
+	exchange_run();
+	zassert_true(result.isodep_selected, "Tag not selected");
+
+	err = nfc_t4t_hl_procedure_ndef_tag_app_select();
+	zassert_equal(err, 0, "NDEF application select failed");
+	exchange_run();
+
+	err = nfc_t4t_hl_procedure_cc_select();
+	zassert_equal(err, 0, "CC select failed");
+	exchange_run();
+
+	err = nfc_t4t_hl_procedure_cc_read(&t4t_cc_type_4_tag);
+	zassert_equal(err, 0, "CC read failed");
+	exchange_run();
+	zassert_not_null(result.cc, "CC not read");
+
+	err = nfc_t4t_hl_procedure_ndef_file_select(SIM_TAG_NDEF_FILE_ID);
+	zassert_equal(err, 0, "NDEF file select failed");
+	exchange_run();
+	zassert_equal(result.hl_selected, NFC_T4T_HL_PROCEDURE_NDEF_FILE_SELECT,
+		      "NDEF file not selected");
+
+	sim_tag_stats_reset();
+}
+
+static void ndef_read(struct sim_tag_stats *stats)
+{
+	int err;
+
+	memset(ndef_buf, 0, sizeof(ndef_buf));
+
+	err = nfc_t4t_hl_procedure_ndef_read(result.cc, ndef_buf,
+					     sizeof(ndef_buf));
+	zassert_equal(err, 0, "NDEF read failed");
+	exchange_run();
+
+	zassert_equal(result.ndef_read_len, NDEF_FILE_LEN,
+		      "Invalid NDEF file length");
+	zassert_mem_equal(ndef_buf, ndef_file, NDEF_FILE_LEN,
+			  "Invalid NDEF file content");
+
+	sim_tag_stats_get(stats);
+}
+
+static void ndef_update(struct sim_tag_stats *stats)
+{
+	int err;
+
+	/* Write the message in the reverse order. */
+	sys_put_be16(NDEF_MSG_LEN, ndef_buf);
+
+	for (size_t i = 0; i < NDEF_MSG_LEN; i++) {
+		ndef_buf[NDEF_NLEN_LEN + i] =
+			ndef_file[NDEF_FILE_LEN - 1 - i];
+	}
+
+	err = nfc_t4t_hl_procedure_ndef_update(result.cc, ndef_buf,
+					       NDEF_FILE_LEN);
+	zassert_equal(err, 0, "NDEF update failed");
+	exchange_run();
+
+	zassert_true(result.ndef_updated, "NDEF not updated");
+	zassert_mem_equal(sim_tag_ndef_file_get(), ndef_buf, NDEF_FILE_LEN,
+			  "Invalid NDEF file content");
+
+	sim_tag_stats_get(stats);
+}
+
+static void test_ndef_read(void)
+{
+	struct sim_tag_stats stats_short;
+	struct sim_tag_stats stats_ext;
+
+	tag_select(&tag_short, NFC_T4T_ISODEP_FSD_256);
+	ndef_read(&stats_short);
+
+	tag_select(&tag_ext, nfc_t4t_isodep_fsd_max_get());
+	ndef_read(&stats_ext);
+
+	TC_PRINT("NDEF read of %d bytes, short APDUs: %u APDUs, %u frames\n",
+		 NDEF_FILE_LEN, stats_short.apdus, stats_short.frames);
+	TC_PRINT("NDEF read of %d bytes, extended APDUs: %u APDUs, %u frames\n",
+		 NDEF_FILE_LEN, stats_ext.apdus, stats_ext.frames);
+
+	/* NLEN is read together with the first part of the message. */
+	zassert_equal(stats_short.apdus,
+		      ceiling_fraction(NDEF_FILE_LEN, SHORT_APDU_DATA_LEN),
+		      "Unexpected number of READ BINARY commands");
+	zassert_equal(stats_ext.apdus,
+		      ceiling_fraction(NDEF_FILE_LEN, EXT_APDU_DATA_LEN),
+		      "Unexpected number of READ BINARY commands");
+	zassert_true(stats_ext.frames < stats_short.frames,
+		     "Larger frames did not reduce the number of frames");
+}
+
+static void test_ndef_update(void)
+{
+	struct sim_tag_stats stats_short;
+	struct sim_tag_stats stats_ext;
+
+	tag_select(&tag_short, NFC_T4T_ISODEP_FSD_256);
+	ndef_update(&stats_short);
+
+	tag_select(&tag_ext, nfc_t4t_isodep_fsd_max_get());
+	ndef_update(&stats_ext);
+
+	TC_PRINT("NDEF update of %d bytes, short APDUs: %u APDUs, %u frames\n",
+		 NDEF_FILE_LEN, stats_short.apdus, stats_short.frames);
+	TC_PRINT("NDEF update of %d bytes, extended APDUs: %u APDUs, %u frames\n",
+		 NDEF_FILE_LEN, stats_ext.apdus, stats_ext.frames);
+
+	/* NLEN is cleared before and written after the message. */
+	zassert_equal(stats_short.apdus,
+		      ceiling_fraction(NDEF_MSG_LEN, SHORT_APDU_DATA_LEN) + 2,
+		      "Unexpected number of UPDATE BINARY commands");
+	zassert_equal(stats_ext.apdus,
+		      ceiling_fraction(NDEF_MSG_LEN, EXT_UPDATE_DATA_LEN) + 2,
+		      "Unexpected number of UPDATE BINARY commands");
+	zassert_true(stats_ext.frames < stats_short.frames,
+		     "Larger frames did not reduce the number of frames");
+}
+
+static void test_isodep_fsd_max(void)
+{
+	zassert_equal(nfc_t4t_isodep_fsd_max_get(), NFC_T4T_ISODEP_FSD_1024,
+		      "Unexpected maximum frame size");
+}
+
+static void test_apdu_ext_encode(void)
+{
+	static const uint8_t read_expected[] = {
+		0x00, 0xB0, 0x01, 0x02, 0x00, 0x04, 0x00
+	};
+	static const uint8_t update_expected_hdr[] = {
+		0x00, 0xD6, 0x00, 0x02, 0x00, 0x01, 0x00
+	};
+	struct nfc_t4t_apdu_comm comm;
+	uint8_t buf[300];
+	uint16_t len;
+	int err;
+
+	nfc_t4t_apdu_comm_clear(&comm);
+	comm.instruction = NFC_T4T_APDU_COMM_INS_READ;
+	comm.parameter = 0x0102;
+	comm.resp_len = 1024;
+
+	len = sizeof(buf);
+	err = nfc_t4t_apdu_comm_encode(&comm, buf, &len);
+	zassert_equal(err, 0, "Encoding failed");
+	zassert_equal(len, sizeof(read_expected), "Invalid length");
+	zassert_mem_equal(buf, read_expected, len, "Invalid C-APDU");
+
+	nfc_t4t_apdu_comm_clear(&comm);
+	comm.instruction = NFC_T4T_APDU_COMM_INS_UPDATE;
+	comm.parameter = 0x0002;
+	comm.data.buff = ndef_file;
+	comm.data.len = 256;
+
+	len = sizeof(buf);
+	err = nfc_t4t_apdu_comm_encode(&comm, buf, &len);
+	zassert_equal(err, 0, "Encoding failed");
+	zassert_equal(len, sizeof(update_expected_hdr) + 256,
+		      "Invalid length");
+	zassert_mem_equal(buf, update_expected_hdr,
+			  sizeof(update_expected_hdr), "Invalid C-APDU");
+}
+
+void test_main(void)
+{
+	int err;
+
+	sys_put_be16(NDEF_MSG_LEN, ndef_file);
+
+	for (size_t i = NDEF_NLEN_LEN; i < sizeof(ndef_file); i++) {
+		ndef_file[i] = (uint8_t)i;
+	}
+
+	err = nfc_t4t_isodep_init(isodep_tx_buf, sizeof(isodep_tx_buf),
+				  isodep_rx_buf, sizeof(isodep_rx_buf),
+				  &isodep_cb);
+	zassert_equal(err, 0, "ISO-DEP initialization failed");
+
+	err = nfc_t4t_hl_procedure_cb_register(&hl_cb);
+	zassert_equal(err, 0, "HL procedure initialization failed");
+
+	ztest_test_suite(nfc_t4t_test,
+			 ztest_unit_test(test_isodep_fsd_max),
+			 ztest_unit_test(test_apdu_ext_encode),
+			 ztest_unit_test(test_ndef_read),
+			 ztest_unit_test(test_ndef_update)
+			 );
+
+	ztest_run_test_suite(nfc_t4t_test);
+}
@@ -0,0 +1,368 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/* Simulated Type 4 Tag. It answers the RATS command and the ISO-DEP blocks
+ * sent by the Reader/Writer, and handles the SELECT, READ BINARY and
+ * UPDATE BINARY commands for the Capability Container and the NDEF file.
+ */
+
+#include <string.h>
+#include <ztest.h>
+#include <sys/byteorder.h>
+
+#include "sim_tag.h"
+
+#define RATS_CMD 0xE0
+#define RATS_FSDI_OFFSET 4
+
+#define ATS_LEN 5
+#define ATS_T0_INTERFACE_BYTES 0x70
+
+#define PCB_LEN 1
+#define CRC_LEN 2
+#define PCB_BLOCK_NUM BIT(0)
+#define PCB_CHAINING BIT(4)
+#define PCB_I_BLOCK 0x02
+#define PCB_R_BLOCK 0xA2
+#define PCB_S_BLOCK 0xC2
+#define PCB_I_BLOCK_MASK 0xE2
+#define PCB_R_BLOCK_MASK 0xE6
+
+#define INS_SELECT 0xA4
+#define INS_READ 0xB0
+#define INS_UPDATE 0xD6
+#define SELECT_BY_NAME 0x0400
+#define SELECT_BY_FILE_ID 0x000C
+#define CC_FILE_ID 0xE103
+
+#define SW_OK 0x9000
+#define SW_WRONG_LENGTH 0x6700
+#define SW_NOT_ALLOWED 0x6986
+#define SW_NOT_FOUND 0x6A82
+#define SW_WRONG_PARAMETERS 0x6B00
+#define SW_LEN 2
+
+#define CAPDU_HEADER_LEN 4
+#define SHORT_LE_MAX 256
+#define EXT_LE_MAX 65536
+#define CAPDU_MAX_LEN (CAPDU_HEADER_LEN + 3 + SIM_TAG_NDEF_FILE_MAX_SIZE + 2)
+#define RAPDU_MAX_LEN (SIM_TAG_NDEF_FILE_MAX_SIZE + SW_LEN)
+
+#define CC_FILE_LEN 15
+#define CC_MAPPING_VERSION 0x20
+#define CC_NDEF_FILE_CONTROL_TLV 0x04
+#define CC_NDEF_FILE_CONTROL_TLV_LEN 0x06
+
+static const uint16_t fs_map[] = {16, 24, 32, 40, 48, 64, 96, 128, 256,
+				  512, 1024, 2048, 4096};
+
+static struct {
+	struct sim_tag_config config;
+	struct sim_tag_stats stats;
+	uint16_t fsd;
+	uint8_t cc_file[CC_FILE_LEN];
+	uint8_t ndef_file[SIM_TAG_NDEF_FILE_MAX_SIZE];
+	uint8_t *file;
+	size_t file_len;
+	uint8_t capdu[CAPDU_MAX_LEN];
+	size_t capdu_len;
+	uint8_t rapdu[RAPDU_MAX_LEN];
+	size_t rapdu_len;
+	size_t rapdu_sent;
+} tag;
+
+static void cc_file_build(void)
+{
+	uint8_t *cc = tag.cc_file;
+
+	sys_put_be16(CC_FILE_LEN, cc);
+	cc[2] = CC_MAPPING_VERSION;
+	sys_put_be16(tag.config.mle, &cc[3]);
+	sys_put_be16(tag.config.mlc, &cc[5]);
+	cc[7] = CC_NDEF_FILE_CONTROL_TLV;
+	cc[8] = CC_NDEF_FILE_CONTROL_TLV_LEN;
+	sys_put_be16(SIM_TAG_NDEF_FILE_ID, &cc[9]);
+	sys_put_be16(tag.config.ndef_file_size, &cc[11]);
+
+	/* Read and write access granted. */
+	cc[13] = 0x00;
+	cc[14] = 0x00;
+}
+
+static void rapdu_set(const uint8_t *data, size_t len, uint16_t status)
+{
+	zassert_true(len + SW_LEN <= sizeof(tag.rapdu), "R-APDU too long");
+
+	if (len) {
+		memcpy(tag.rapdu, data, len);
+	}
+
+	sys_put_be16(status, &tag.rapdu[len]);
+
+	tag.rapdu_len = len + SW_LEN;
+	tag.rapdu_sent = 0;
+}
+
+static void select_process(uint16_t param, const uint8_t *data, uint16_t lc)
+{
+	uint16_t file_id;
+
+	if (param == SELECT_BY_NAME) {
+		rapdu_set(NULL, 0, SW_OK);
+		return;
+	}
+
+	if ((param != SELECT_BY_FILE_ID) || (lc != sizeof(file_id))) {
+		rapdu_set(NULL, 0, SW_WRONG_PARAMETERS);
+		return;
+	}
+
+	file_id = sys_get_be16(data);
+
+	if (file_id == CC_FILE_ID) {
+		tag.file = tag.cc_file;
+		tag.file_len = sizeof(tag.cc_file);
+	} else if (file_id == SIM_TAG_NDEF_FILE_ID) {
+		tag.file = tag.ndef_file;
+		tag.file_len = tag.config.ndef_file_size;
+	} else {
+		rapdu_set(NULL, 0, SW_NOT_FOUND);
+		return;
+	}
+
+	rapdu_set(NULL, 0, SW_OK);
+}
+
+static void read_process(uint16_t offset, uint32_t le)
+{
+	if (!tag.file) {
+		rapdu_set(NULL, 0, SW_NOT_ALLOWED);
+		return;
+	}
+
+	if (le > tag.config.mle) {
+		rapdu_set(NULL, 0, SW_WRONG_LENGTH);
+		return;
+	}
+
+	if (offset > tag.file_len) {
+		rapdu_set(NULL, 0, SW_WRONG_PARAMETERS);
+		return;
+	}
+
+	rapdu_set(&tag.file[offset], MIN(le, tag.file_len - offset), SW_OK);
+}
+
+static void update_process(uint16_t offset, const uint8_t *data, uint16_t lc)
+{
+	if (tag.file != tag.ndef_file) {
+		rapdu_set(NULL, 0, SW_NOT_ALLOWED);
+		return;
+	}
+
+	if (lc > tag.config.mlc) {
+		rapdu_set(NULL, 0, SW_WRONG_LENGTH);
+		return;
+	}
+
+	if ((offset + lc) > tag.file_len) {
+		rapdu_set(NULL, 0, SW_WRONG_PARAMETERS);
+		return;
+	}
+
+	memcpy(&tag.file[offset], data, lc);
+
+	rapdu_set(NULL, 0, SW_OK);
+}
+
+static void apdu_process(void)
+{
+	const uint8_t *capdu = tag.capdu;
+	size_t len = tag.capdu_len;
+	size_t idx = CAPDU_HEADER_LEN;
+	const uint8_t *data = NULL;
+	uint16_t param;
+	uint16_t lc = 0;
+	uint32_t le = 0;
+
+	tag.stats.apdus++;
+
+	zassert_true(len >= CAPDU_HEADER_LEN, "C-APDU too short");
+
+	param = sys_get_be16(&capdu[2]);
+
+	/* Decode Lc and Le fields, ISO/IEC 7816-4 5.1. */
+	if ((len > (idx + 2)) && (capdu[idx] == 0)) {
+		/* Extended length fields. */
+		if (len == (idx + 3)) {
+			le = sys_get_be16(&capdu[idx + 1]);
+			le = le ? le : EXT_LE_MAX;
+			idx += 3;
+		} else {
+			lc = sys_get_be16(&capdu[idx + 1]);
+			idx += 3;
+			data = &capdu[idx];
+			idx += lc;
+
+			if (len == (idx + 2)) {
+				le = sys_get_be16(&capdu[idx]);
+				le = le ? le : EXT_LE_MAX;
+				idx += 2;
+			}
+		}
+	} else if (len == (idx + 1)) {
+		le = capdu[idx] ? capdu[idx] : SHORT_LE_MAX;
+		idx++;
+	} else if (len > idx) {
+		lc = capdu[idx];
+		idx++;
+		data = &capdu[idx];
+		idx += lc;
+
+		if (len == (idx + 1)) {
+			le = capdu[idx] ? capdu[idx] : SHORT_LE_MAX;
+			idx++;
+		}
+	}
+
+	zassert_true(idx <= len, "Invalid C-APDU length");
+
+	switch (capdu[1]) {
+	case INS_SELECT:
+		select_process(param, data, lc);
+		break;
+
+	case INS_READ:
+		read_process(param, le);
+		break;
+
+	case INS_UPDATE:
+		update_process(param, data, lc);
+		break;
+
+	default:
+		zassert_unreachable("Unexpected instruction 0x%02x", capdu[1]);
+		break;
+	}
+}
+
+static size_t rapdu_chunk_send(uint8_t block_num, uint8_t *rsp,
+			       size_t rsp_size)
+{
+	size_t len = MIN(tag.fsd - CRC_LEN - PCB_LEN,
+			 tag.rapdu_len - tag.rapdu_sent);
+
+	zassert_true(len + PCB_LEN <= rsp_size, "Response buffer too small");
+
+	rsp[0] = PCB_I_BLOCK | block_num;
+
+	if ((tag.rapdu_sent + len) < tag.rapdu_len) {
+		rsp[0] |= PCB_CHAINING;
+	}
+
+	memcpy(&rsp[PCB_LEN], &tag.rapdu[tag.rapdu_sent], len);
+	tag.rapdu_sent += len;
+
+	return len + PCB_LEN;
+}
+
+static size_t rats_process(const uint8_t *frame, size_t len, uint8_t *rsp)
+{
+	zassert_equal(len, 2, "Invalid RATS length");
+
+	tag.fsd = fs_map[frame[1] >> RATS_FSDI_OFFSET];
+
+	/* TA, TB and TC present: only 106 kbit/s, FWI and SFGI 0,
+	 * no DID and NAD.
+	 */
+	rsp[0] = ATS_LEN;
+	rsp[1] = ATS_T0_INTERFACE_BYTES | tag.config.fsci;
+	rsp[2] = 0x00;
+	rsp[3] = 0x00;
+	rsp[4] = 0x00;
+
+	return ATS_LEN;
+}
+
+void sim_tag_init(const struct sim_tag_config *config,
+		  const uint8_t *ndef_file, size_t len)
+{
+	zassert_true(config->ndef_file_size <= sizeof(tag.ndef_file),
+		     "NDEF file too large");
+	zassert_true(len <= config->ndef_file_size, "NDEF message too large");
+
+	memset(&tag, 0, sizeof(tag));
+
+	tag.config = *config;
+
+	memcpy(tag.ndef_file, ndef_file, len);
+
+	cc_file_build();
+}
+
+size_t sim_tag_frame_process(const uint8_t *frame, size_t len,
+			     uint8_t *rsp, size_t rsp_size)
+{
+	uint8_t pcb = frame[0];
+	uint8_t block_num = pcb & PCB_BLOCK_NUM;
+
+	tag.stats.frames++;
+
+	if (pcb == RATS_CMD) {
+		return rats_process(frame, len, rsp);
+	}
+
+	/* I-block, the C-APDU can be chained. */
+	if ((pcb & PCB_I_BLOCK_MASK) == PCB_I_BLOCK) {
+		zassert_true(tag.capdu_len + len - PCB_LEN <= sizeof(tag.capdu),
+			     "C-APDU too long");
+		zassert_true(len <= fs_map[tag.config.fsci] - CRC_LEN,
+			     "Frame exceeds FSC");
+
+		memcpy(&tag.capdu[tag.capdu_len], &frame[PCB_LEN],
+		       len - PCB_LEN);
+		tag.capdu_len += len - PCB_LEN;
+
+		if (pcb & PCB_CHAINING) {
+			rsp[0] = PCB_R_BLOCK | block_num;
+			return PCB_LEN;
+		}
+
+		apdu_process();
+		tag.capdu_len = 0;
+
+		return rapdu_chunk_send(block_num, rsp, rsp_size);
+	}
+
+	/* R(ACK), the next part of the chained R-APDU is requested. */
+	if ((pcb & PCB_R_BLOCK_MASK) == PCB_R_BLOCK) {
+		zassert_true(tag.rapdu_sent < tag.rapdu_len,
+			     "Unexpected R(ACK)");
+
+		return rapdu_chunk_send(block_num, rsp, rsp_size);
+	}
+
+	/* S(DESELECT) */
+	zassert_equal(pcb, PCB_S_BLOCK, "Unexpected frame 0x%02x", pcb);
+	rsp[0] = PCB_S_BLOCK;
+
+	return PCB_LEN;
+}
+
+const uint8_t *sim_tag_ndef_file_get(void)
+{
+	return tag.ndef_file;
+}
+
+void sim_tag_stats_get(struct sim_tag_stats *stats)
+{
+	*stats = tag.stats;
+}
+
+void sim_tag_stats_reset(void)
+{
+	memset(&tag.stats, 0, sizeof(tag.stats));
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef SIM_TAG_H_
+#define SIM_TAG_H_
+
+#include <zephyr/types.h>
+#include <stddef.h>
+
+#define SIM_TAG_NDEF_FILE_ID 0xE104
+#define SIM_TAG_NDEF_FILE_MAX_SIZE 4096
+
+/* Simulated Type 4 Tag parameters. */
+struct sim_tag_config {
+	/* Frame size for proximity card integer sent in the ATS. */
+	uint8_t fsci;
+
+	/* Maximum R-APDU data size (MLe). */
+	uint16_t mle;
+
+	/* Maximum C-APDU data size (MLc). */
+	uint16_t mlc;
+
+	/* NDEF file size reported in the Capability Container. */
+	uint16_t ndef_file_size;
+};
+
+/* Number of frames and commands received by the tag. */
+struct sim_tag_stats {
+	uint32_t frames;
+	uint32_t apdus;
+};
+
+/* Initialize the tag with the NDEF file content, which starts with NLEN. */
+void sim_tag_init(const struct sim_tag_config *config,
+		  const uint8_t *ndef_file, size_t len);
+
+/* Process a frame from the Reader/Writer. Returns the response length. */
+size_t sim_tag_frame_process(const uint8_t *frame, size_t len,
+			     uint8_t *rsp, size_t rsp_size);
+
+const uint8_t *sim_tag_ndef_file_get(void);
+
+void sim_tag_stats_get(struct sim_tag_stats *stats);
+
+void sim_tag_stats_reset(void);
+
+#endif /* SIM_TAG_H_ */
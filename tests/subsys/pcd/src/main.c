@@ -34,11 +34,60 @@ static void test_pcd_network_core_update(void)
 	zassert_equal(status, PCD_STATUS_COPY_FAILED, "Unexpected success");
 }
 
+static int stream_read(void *ctx, size_t offset, void *buf, size_t len)
+{
+	const uint8_t *src = ctx;
+
+	zassert_true(offset + len <= BUF_LEN, "Read out of bounds");
+	zassert_true(len <= PCD_STREAM_SLOT_SIZE, "Read too long");
+
+	memcpy(buf, &src[offset], len);
+
+	return 0;
+}
+
+static int stream_read_fail(void *ctx, size_t offset, void *buf, size_t len)
+{
+	return -EIO;
+}
+
+static void test_pcd_network_core_update_stream(void)
+{
+	enum pcd_status status;
+	int err;
+
+	err = pcd_network_core_update_stream(stream_read, (void *)data,
+					     sizeof(data));
+	zassert_equal(err, 0, "Unexpected failure");
+
+	status = pcd_fw_copy_status_get();
+	zassert_equal(status, PCD_STATUS_COPY_DONE, "Unexpected failure");
+	zassert_equal(pcd_fw_copy_progress_get(), sizeof(data),
+		      "Unexpected progress");
+
+	pcd_fw_copy_invalidate();
+}
+
+static void test_pcd_network_core_update_stream_read_fail(void)
+{
+	enum pcd_status status;
+	int err;
+
+	err = pcd_network_core_update_stream(stream_read_fail, NULL,
+					     sizeof(data));
+	zassert_equal(err, -EIO, "Unexpected success");
+
+	status = pcd_fw_copy_status_get();
+	zassert_equal(status, PCD_STATUS_COPY_FAILED, "Unexpected success");
+}
 
 void test_main(void)
 {
 	ztest_test_suite(pcd_test,
-			 ztest_unit_test(test_pcd_network_core_update)
+			 ztest_unit_test(test_pcd_network_core_update),
+			 ztest_unit_test(test_pcd_network_core_update_stream),
+			 ztest_unit_test(
+				test_pcd_network_core_update_stream_read_fail)
 			 );
 
 	ztest_run_test_suite(pcd_test);